@@ -32,6 +32,9 @@ namespace llarp
 
   constexpr int DefaultPublicPort = 1090;
 
+  // the kernel's limit on queues for one tun interface
+  constexpr int MaxTunQueues = 256;
+
   using namespace config;
 
   void
@@ -40,6 +43,8 @@ namespace llarp
     constexpr Default DefaultJobQueueSize{1024 * 8};
     constexpr Default DefaultWorkerThreads{0};
     constexpr Default DefaultBlockBogons{true};
+    constexpr Default DefaultPeerDbCacheSize{10000};
+    constexpr Default DefaultMaxPendingPathBuilds{1024};
 
     conf.defineOption<int>(
         "router", "job-queue-size", DefaultJobQueueSize, Hidden, [this](int arg) {
@@ -187,11 +192,87 @@ namespace llarp
           m_workerThreads = arg;
         });
 
+    conf.defineOption<int>(
+        "router",
+        "crypto-lanes",
+        Default{0},
+        Comment{
+            "The number of threads that encrypt and decrypt link layer packets. Each peer's",
+            "packets are always handled by the same thread, in order, and on linux each thread",
+            "is pinned to its own core.",
+            "0 means pick a number based on the number of logical CPU cores detected at startup.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("crypto-lanes must be >= 0");
+
+          m_cryptoLanes = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "event-loops",
+        Default{1},
+        Comment{
+            "The number of event loops that move link layer packets in and out of our udp",
+            "sockets. Each extra loop runs on its own thread with its own socket on the same",
+            "port, and each peer's packets always go through the same loop. Only has an effect",
+            "on linux.",
+            "0 means one loop per logical CPU core detected at startup.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("event-loops must be >= 0");
+
+          m_eventLoops = arg;
+        });
+
     // Hidden option because this isn't something that should ever be turned off occasionally when
     // doing dev/testing work.
     conf.defineOption<bool>(
         "router", "block-bogons", DefaultBlockBogons, Hidden, AssignmentAcceptor(m_blockBogons));
 
+    conf.defineOption<bool>(
+        "router",
+        "nodedb-single-file",
+        Default{false},
+        AssignmentAcceptor(m_nodedbSingleFile),
+        Comment{
+            "Keep the nodedb in a single append-only file instead of one file per router. This",
+            "starts up faster on large networks and does not re-check signatures of routers that",
+            "were already checked on an earlier run. An existing nodedb is carried over the first",
+            "time this is enabled and its per router files are removed.",
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "peerdb-cache-size",
+        RelayOnly,
+        DefaultPeerDbCacheSize,
+        Comment{
+            "The number of peers whose connection stats are kept in memory. Stats for other peers",
+            "are read back from the peer stats database when they are next needed.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument("peerdb-cache-size must be >= 1");
+
+          m_peerDbCacheSize = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "max-pending-path-builds",
+        RelayOnly,
+        DefaultMaxPendingPathBuilds,
+        Hidden,
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument("max-pending-path-builds must be >= 1");
+
+          m_maxPendingPathBuilds = arg;
+        });
+
     constexpr auto relative_to_datadir =
         "An absolute path is used as-is, otherwise relative to 'data-dir'.";
 
@@ -502,6 +583,34 @@ namespace llarp
         },
         AssignmentAcceptor(m_ifname));
 
+    conf.defineOption<int>(
+        "network",
+        "tun-queues",
+        Default{1},
+        Comment{
+            "Number of queues to open on the tun interface (linux only). With more than one, each",
+            "queue is read and classified on its own thread pinned to a core, which helps exits",
+            "and busy clients whose tun traffic saturates a single core.",
+        },
+        [this](int arg) {
+          if (arg < 1 or arg > MaxTunQueues)
+            throw std::invalid_argument{
+                stringify("[network]:tun-queues must be between 1 and ", MaxTunQueues)};
+          m_tunQueues = arg;
+        });
+
+    conf.defineOption<bool>(
+        "network",
+        "tun-offload",
+        Default{false},
+        AssignmentAcceptor(m_tunOffload),
+        Comment{
+            "Let the tun interface exchange TCP packets of up to 64KiB with the kernel (linux",
+            "only). Lokinet splits them into regular packets as they enter the network and merges",
+            "consecutive TCP segments it writes back, saving syscalls and checksum work on bulk",
+            "transfers.",
+        });
+
     conf.defineOption<std::string>(
         "network",
         "ifaddr",
@@ -52,10 +52,18 @@ namespace llarp
 
     bool m_blockBogons = false;
 
+    bool m_nodedbSingleFile = false;
+
+    size_t m_peerDbCacheSize = 0;
+
+    size_t m_maxPendingPathBuilds = 0;
+
     IpAddress m_publicAddress;
 
     int m_workerThreads = -1;
     int m_numNetThreads = -1;
+    int m_cryptoLanes = 0;
+    int m_eventLoops = 1;
 
     size_t m_JobQueueSize = 0;
 
@@ -95,6 +103,8 @@ namespace llarp
     std::string m_strictConnect;
     std::string m_ifname;
     IPRange m_ifaddr;
+    size_t m_tunQueues = 1;
+    bool m_tunOffload = false;
 
     std::optional<fs::path> m_keyfile;
     std::string m_endpointType;
@@ -76,7 +76,9 @@ namespace llarp
     router = makeRouter(loop);
 
     nodedb = std::make_shared<NodeDB>(
-        nodedb_dir, [r = router.get()](auto call) { r->QueueDiskIO(std::move(call)); });
+        nodedb_dir,
+        [r = router.get()](auto call) { r->QueueDiskIO(std::move(call)); },
+        config->router.m_nodedbSingleFile);
 
     if (!router->Configure(config, opts.isRouter, nodedb))
       throw std::runtime_error("Failed to configure router");
@@ -3,4 +3,28 @@
 namespace llarp
 {
   Crypto* CryptoManager::m_crypto = nullptr;
-}
+
+  bool
+  Crypto::xchacha20_many(XChaCha20Job* jobs, size_t num)
+  {
+    bool ok = true;
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      const llarp_buffer_t buf{jobs[idx].buf, jobs[idx].sz};
+      ok = xchacha20_alt(buf, buf, *jobs[idx].key, jobs[idx].nonce) and ok;
+    }
+    return ok;
+  }
+
+  bool
+  Crypto::hmac_many(HMACJob* jobs, size_t num)
+  {
+    bool ok = true;
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      const llarp_buffer_t buf{jobs[idx].buf, jobs[idx].sz};
+      ok = hmac(jobs[idx].result, buf, *jobs[idx].key) and ok;
+    }
+    return ok;
+  }
+}  // namespace llarp
@@ -18,6 +18,25 @@
 
 namespace llarp
 {
+  /// one buffer for Crypto::xchacha20_many, xor'd in place with the keystream for key and the
+  /// first 24 bytes of nonce
+  struct XChaCha20Job
+  {
+    byte_t* buf;
+    size_t sz;
+    const SharedSecret* key;
+    const byte_t* nonce;
+  };
+
+  /// one buffer for Crypto::hmac_many, HMACSIZE bytes of keyed hash of buf are put in result
+  struct HMACJob
+  {
+    byte_t* result;
+    const byte_t* buf;
+    size_t sz;
+    const SharedSecret* key;
+  };
+
   /// library crypto configuration
   struct Crypto
   {
@@ -36,6 +55,11 @@ namespace llarp
     xchacha20_alt(
         const llarp_buffer_t&, const llarp_buffer_t&, const SharedSecret&, const byte_t*) = 0;
 
+    /// xchacha symmetric cipher over many independent buffers at once, does them one at a time
+    /// unless overridden
+    virtual bool
+    xchacha20_many(XChaCha20Job* jobs, size_t num);
+
     /// path dh creator's side
     virtual bool
     dh_client(SharedSecret&, const PubKey&, const SecretKey&, const TunnelNonce&) = 0;
@@ -54,6 +78,9 @@ namespace llarp
     /// blake2s 256 bit "hmac" (keyed hash)
     virtual bool
     hmac(byte_t*, const llarp_buffer_t&, const SharedSecret&) = 0;
+    /// keyed hash of many independent buffers at once, does them one at a time unless overridden
+    virtual bool
+    hmac_many(HMACJob* jobs, size_t num);
     /// ed25519 sign
     virtual bool
     sign(Signature&, const SecretKey&, const llarp_buffer_t&) = 0;
@@ -1,4 +1,5 @@
 #include "crypto_libsodium.hpp"
+#include "multibuffer.hpp"
 #include <sodium/crypto_generichash.h>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_scalarmult.h>
@@ -85,10 +86,12 @@ namespace llarp
       if (avx2 && std::string(avx2) == "1")
       {
         ntru_init(1);
+        multibuffer::Init(true);
       }
       else
       {
         ntru_init(0);
+        multibuffer::Init(false);
       }
       int seed = 0;
       randombytes(reinterpret_cast<unsigned char*>(&seed), sizeof(seed));
@@ -144,6 +147,12 @@ namespace llarp
       return crypto_stream_xchacha20_xor(out.base, in.base, in.sz, n, k.data()) == 0;
     }
 
+    bool
+    CryptoLibSodium::xchacha20_many(XChaCha20Job* jobs, size_t num)
+    {
+      return multibuffer::xchacha20(jobs, num);
+    }
+
     bool
     CryptoLibSodium::dh_client(
         llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
@@ -188,6 +197,12 @@ namespace llarp
           != -1;
     }
 
+    bool
+    CryptoLibSodium::hmac_many(HMACJob* jobs, size_t num)
+    {
+      return multibuffer::hmac(jobs, num);
+    }
+
     static bool
     hash(uint8_t* result, const llarp_buffer_t& buff)
     {
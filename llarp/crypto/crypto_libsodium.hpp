@@ -29,6 +29,10 @@ namespace llarp
           const SharedSecret&,
           const byte_t*) override;
 
+      /// xchacha symmetric cipher over many buffers, in simd lanes where the cpu can
+      bool
+      xchacha20_many(XChaCha20Job* jobs, size_t num) override;
+
       /// path dh creator's side
       bool
       dh_client(SharedSecret&, const PubKey&, const SecretKey&, const TunnelNonce&) override;
@@ -49,6 +53,9 @@ namespace llarp
       /// blake2s 256 bit hmac
       bool
       hmac(byte_t*, const llarp_buffer_t&, const SharedSecret&) override;
+      /// blake2b 256 bit hmac over many buffers, in simd lanes where the cpu can
+      bool
+      hmac_many(HMACJob* jobs, size_t num) override;
       /// ed25519 sign
       bool
       sign(Signature&, const SecretKey&, const llarp_buffer_t&) override;
@@ -4,6 +4,9 @@
 #include <llarp/util/logging/logger.hpp>
 #include <llarp/util/mem.hpp>
 
+#include <algorithm>
+#include <vector>
+
 namespace llarp
 {
   bool
@@ -153,4 +156,62 @@ namespace llarp
 
     return DoDecrypt(shared);
   }
+
+  void
+  EncryptedFrame::DecryptManyInPlace(
+      EncryptedFrame* const* frames, size_t num, const SecretKey& ourSecretKey, bool* ok)
+  {
+    auto crypto = CryptoManager::instance();
+
+    std::vector<SharedSecret> shared(num);
+    std::vector<ShortHash> digests(num);
+    std::vector<HMACJob> hashes;
+    hashes.reserve(num);
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      auto& frame = *frames[idx];
+      const byte_t* noncePtr = frame.data() + SHORTHASHSIZE;
+      const TunnelNonce nonce(noncePtr);
+      const PubKey otherPubkey(noncePtr + TUNNONCESIZE);
+      ok[idx] = crypto->dh_server(shared[idx], otherPubkey, ourSecretKey, nonce);
+      if (not ok[idx])
+      {
+        llarp::LogError("DH failed");
+        continue;
+      }
+      hashes.push_back(
+          HMACJob{digests[idx].data(), noncePtr, frame.size() - SHORTHASHSIZE, &shared[idx]});
+    }
+    if (not crypto->hmac_many(hashes.data(), hashes.size()))
+    {
+      llarp::LogError("Digest failed");
+      std::fill_n(ok, num, false);
+      return;
+    }
+
+    std::vector<XChaCha20Job> ciphers;
+    ciphers.reserve(num);
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      if (not ok[idx])
+        continue;
+      auto& frame = *frames[idx];
+      if (not std::equal(digests[idx].begin(), digests[idx].end(), frame.data()))
+      {
+        llarp::LogError("message authentication failed");
+        ok[idx] = false;
+        continue;
+      }
+      ciphers.push_back(XChaCha20Job{
+          frame.data() + EncryptedFrameOverheadSize,
+          frame.size() - EncryptedFrameOverheadSize,
+          &shared[idx],
+          frame.data() + SHORTHASHSIZE});
+    }
+    if (not crypto->xchacha20_many(ciphers.data(), ciphers.size()))
+    {
+      llarp::LogError("decrypt failed");
+      std::fill_n(ok, num, false);
+    }
+  }
 }  // namespace llarp
@@ -43,44 +43,12 @@ namespace llarp
 
     bool
     EncryptInPlace(const SecretKey& seckey, const PubKey& other);
-  };
-
-  /// TODO: can only handle 1 frame at a time
-  template <typename User>
-  struct AsyncFrameDecrypter
-  {
-    using User_ptr = std::shared_ptr<User>;
-    using DecryptHandler = std::function<void(llarp_buffer_t*, User_ptr)>;
-
-    void
-    Decrypt(User_ptr user)
-    {
-      if (target.DecryptInPlace(seckey))
-      {
-        auto buf = target.Buffer();
-        buf->cur = buf->base + EncryptedFrameOverheadSize;
-        result(buf, user);
-      }
-      else
-        result(nullptr, user);
-    }
-
-    AsyncFrameDecrypter(const SecretKey& secretkey, DecryptHandler h)
-        : result(std::move(h)), seckey(secretkey)
-    {}
-
-    DecryptHandler result;
-    const SecretKey& seckey;
-    EncryptedFrame target;
 
-    using WorkFunc_t = std::function<void(void)>;
-    using WorkerFunction_t = std::function<void(WorkFunc_t)>;
-
-    void
-    AsyncDecrypt(const EncryptedFrame& frame, User_ptr u, WorkerFunction_t worker)
-    {
-      target = frame;
-      worker(std::bind(&AsyncFrameDecrypter<User>::Decrypt, this, std::move(u)));
-    }
+    /// DecryptInPlace num frames that were all sent to seckey.  the keyed hashes and then the
+    /// bodies of all of them are done in one go so the multibuffer crypto can take several at
+    /// once.  ok[i] is set to whether frames[i] decrypted.
+    static void
+    DecryptManyInPlace(
+        EncryptedFrame* const* frames, size_t num, const SecretKey& seckey, bool* ok);
   };
 }  // namespace llarp
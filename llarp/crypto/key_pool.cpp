@@ -0,0 +1,73 @@
+#include "key_pool.hpp"
+
+#include "crypto.hpp"
+
+namespace llarp
+{
+  EphemeralKeyPool::EphemeralKeyPool(Work_t work, size_t capacity)
+      : m_Work{std::move(work)}, m_Keys{capacity}
+  {}
+
+  SecretKey
+  EphemeralKeyPool::Take()
+  {
+    SecretKey key;
+    if (auto pooled = m_Keys.tryPopFront())
+    {
+      key = *pooled;
+      pooled->Zero();
+    }
+    else
+    {
+      m_Missed++;
+      CryptoManager::instance()->encryption_keygen(key);
+    }
+    m_Taken++;
+    if (m_Keys.size() < m_Keys.capacity() / 4)
+      Refill();
+    return key;
+  }
+
+  void
+  EphemeralKeyPool::Refill()
+  {
+    if (m_Refilling.exchange(true))
+      return;
+    m_Work([weak = weak_from_this()] {
+      if (auto self = weak.lock())
+        self->Fill();
+    });
+  }
+
+  void
+  EphemeralKeyPool::Fill()
+  {
+    auto crypto = CryptoManager::instance();
+    while (m_Keys.size() < m_Keys.capacity())
+    {
+      SecretKey key;
+      crypto->encryption_keygen(key);
+      if (m_Keys.tryPushBack(key) != thread::QueueReturn::Success)
+        break;
+      m_Made++;
+    }
+    m_Refilling = false;
+  }
+
+  size_t
+  EphemeralKeyPool::Size() const
+  {
+    return m_Keys.size();
+  }
+
+  util::StatusObject
+  EphemeralKeyPool::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"size", m_Keys.size()},
+        {"capacity", m_Keys.capacity()},
+        {"taken", m_Taken.load()},
+        {"missed", m_Missed.load()},
+        {"made", m_Made.load()}};
+  }
+}  // namespace llarp
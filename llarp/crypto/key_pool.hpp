@@ -0,0 +1,58 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <llarp/util/status.hpp>
+#include <llarp/util/thread/queue.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace llarp
+{
+  /// x25519 key pairs made ahead of time, so a path build does not wait on generating the two
+  /// ephemeral keys it needs per hop.
+  ///
+  /// keys are handed out at most once.  whenever the pool runs below a quarter full it is topped
+  /// back up by a job on the worker queue; when it runs dry a key is made on the spot instead, so
+  /// taking a key never fails.  safe to use from any thread.
+  class EphemeralKeyPool : public std::enable_shared_from_this<EphemeralKeyPool>
+  {
+   public:
+    using Work_t = std::function<void(std::function<void(void)>)>;
+
+    static constexpr size_t DefaultCapacity = 256;
+
+    /// work runs the refill jobs in the background
+    explicit EphemeralKeyPool(Work_t work, size_t capacity = DefaultCapacity);
+
+    /// a key pair nobody else gets
+    SecretKey
+    Take();
+
+    /// fill the pool up in the background, does nothing if that is already under way
+    void
+    Refill();
+
+    size_t
+    Size() const;
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    /// make keys until the pool is full; runs on a worker
+    void
+    Fill();
+
+    const Work_t m_Work;
+    thread::Queue<SecretKey> m_Keys;
+    std::atomic<bool> m_Refilling{false};
+
+    std::atomic<uint64_t> m_Taken{0};
+    /// keys made on the spot because the pool was empty
+    std::atomic<uint64_t> m_Missed{0};
+    std::atomic<uint64_t> m_Made{0};
+  };
+}  // namespace llarp
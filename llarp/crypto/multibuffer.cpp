@@ -0,0 +1,115 @@
+#include "multibuffer.hpp"
+
+#include <sodium/crypto_generichash.h>
+#include <sodium/crypto_stream_xchacha20.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace llarp::multibuffer
+{
+  static std::atomic<const Kernel*> g_Kernel{nullptr};
+
+  static const Kernel*
+  BestKernel()
+  {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#ifdef LOKINET_MULTIBUFFER_AVX512
+    if (__builtin_cpu_supports("avx512f"))
+      return &avx512_kernel;
+#endif
+#ifdef LOKINET_MULTIBUFFER_AVX2
+    if (__builtin_cpu_supports("avx2"))
+      return &avx2_kernel;
+#endif
+#endif
+    return nullptr;
+  }
+
+  void
+  Init(bool force_scalar)
+  {
+    g_Kernel = force_scalar ? nullptr : BestKernel();
+  }
+
+  std::string_view
+  KernelName()
+  {
+    const auto* kernel = g_Kernel.load();
+    return kernel ? kernel->name : "scalar";
+  }
+
+  static bool
+  xchacha20_one(XChaCha20Job& job)
+  {
+    return crypto_stream_xchacha20_xor(job.buf, job.buf, job.sz, job.nonce, job.key->data()) == 0;
+  }
+
+  static bool
+  hmac_one(HMACJob& job)
+  {
+    return crypto_generichash_blake2b(
+               job.result, HMACSIZE, job.buf, job.sz, job.key->data(), HMACSECSIZE)
+        != -1;
+  }
+
+  /// run the jobs through a kernel group function lanes at a time, longest first so the lanes of
+  /// a group finish at about the same time.  a group is only worth it when at least half of its
+  /// lanes are used, whatever is left over after that is done one at a time.
+  template <typename Job_t, typename Group_t, typename One_t>
+  static bool
+  Run(Job_t* jobs, size_t num, size_t lanes, Group_t group, One_t one)
+  {
+    bool ok = true;
+    if (group == nullptr or num < lanes / 2)
+    {
+      for (size_t idx = 0; idx < num; ++idx)
+        ok = one(jobs[idx]) and ok;
+      return ok;
+    }
+    std::vector<Job_t*> order(num);
+    for (size_t idx = 0; idx < num; ++idx)
+      order[idx] = &jobs[idx];
+    std::sort(order.begin(), order.end(), [](const auto* left, const auto* right) {
+      return left->sz > right->sz;
+    });
+    size_t idx = 0;
+    while (num - idx >= lanes / 2 and idx < num)
+    {
+      std::array<Job_t*, MaxLanes> lane{};
+      const size_t count = std::min(lanes, num - idx);
+      std::copy_n(order.begin() + idx, count, lane.begin());
+      group(lane.data());
+      idx += count;
+    }
+    for (; idx < num; ++idx)
+      ok = one(*order[idx]) and ok;
+    return ok;
+  }
+
+  bool
+  xchacha20(XChaCha20Job* jobs, size_t num)
+  {
+    const auto* kernel = g_Kernel.load();
+    return Run(
+        jobs,
+        num,
+        kernel ? kernel->chachaLanes : 0,
+        kernel ? kernel->xchacha20_group : nullptr,
+        xchacha20_one);
+  }
+
+  bool
+  hmac(HMACJob* jobs, size_t num)
+  {
+    const auto* kernel = g_Kernel.load();
+    return Run(
+        jobs,
+        num,
+        kernel ? kernel->hashLanes : 0,
+        kernel ? kernel->hmac_group : nullptr,
+        hmac_one);
+  }
+}  // namespace llarp::multibuffer
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "crypto.hpp"
+
+#include <string_view>
+
+/**
+ * multibuffer.hpp
+ *
+ * xchacha20 and keyed blake2b over many independent buffers at once.  each simd lane does a
+ * different buffer with its own key and nonce, so a queue of packets costs about as much as one
+ * packet per lane-width.  the simd kernels live in their own translation units compiled with
+ * -mavx2 / -mavx512f and are picked at runtime by cpu support, anything the kernels don't do is
+ * done one at a time with libsodium.
+ */
+
+namespace llarp::multibuffer
+{
+  /// the most buffers any kernel does in one go
+  static constexpr size_t MaxLanes = 16;
+
+  /// a simd kernel, the group functions take exactly chachaLanes / hashLanes jobs where unused
+  /// lanes are nullptr
+  struct Kernel
+  {
+    std::string_view name;
+    size_t chachaLanes;
+    void (*xchacha20_group)(XChaCha20Job* const* jobs);
+    size_t hashLanes;
+    void (*hmac_group)(HMACJob* const* jobs);
+  };
+
+  /// only defined when the compiler can build them, see LOKINET_MULTIBUFFER_AVX2/AVX512
+  extern const Kernel avx2_kernel;
+  extern const Kernel avx512_kernel;
+
+  /// pick the widest kernel this cpu can run, or none at all if force_scalar is set
+  void
+  Init(bool force_scalar);
+
+  /// name of the kernel in use, "scalar" if there is none
+  std::string_view
+  KernelName();
+
+  /// xchacha20 every job, in place
+  bool
+  xchacha20(XChaCha20Job* jobs, size_t num);
+
+  /// keyed hash every job
+  bool
+  hmac(HMACJob* jobs, size_t num);
+}  // namespace llarp::multibuffer
@@ -0,0 +1,41 @@
+// compiled with -mavx2, only called when the cpu has it
+#include "multibuffer_kernel.hpp"
+
+#include <immintrin.h>
+
+namespace llarp::multibuffer
+{
+  namespace
+  {
+    struct AVX2
+    {
+      typedef uint32_t u32v __attribute__((vector_size(32)));
+      typedef uint64_t u64v __attribute__((vector_size(32)));
+
+      static inline u32v
+      rotl16(u32v x)
+      {
+        const auto mask = _mm256_setr_epi8(
+            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+        return (u32v)_mm256_shuffle_epi8((__m256i)x, mask);
+      }
+
+      static inline u32v
+      rotl8(u32v x)
+      {
+        const auto mask = _mm256_setr_epi8(
+            3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+            3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+        return (u32v)_mm256_shuffle_epi8((__m256i)x, mask);
+      }
+    };
+  }  // namespace
+
+  const Kernel avx2_kernel{
+      "avx2",
+      kernel::ChaCha<AVX2>::Lanes,
+      &kernel::ChaCha<AVX2>::XChaCha20Group,
+      kernel::Blake2b<AVX2>::Lanes,
+      &kernel::Blake2b<AVX2>::HMACGroup};
+}  // namespace llarp::multibuffer
@@ -0,0 +1,34 @@
+// compiled with -mavx512f, only called when the cpu has it
+#include "multibuffer_kernel.hpp"
+
+namespace llarp::multibuffer
+{
+  namespace
+  {
+    struct AVX512
+    {
+      typedef uint32_t u32v __attribute__((vector_size(64)));
+      typedef uint64_t u64v __attribute__((vector_size(64)));
+
+      // both of these are a single vprold
+      static inline u32v
+      rotl16(u32v x)
+      {
+        return (x << 16) | (x >> 16);
+      }
+
+      static inline u32v
+      rotl8(u32v x)
+      {
+        return (x << 8) | (x >> 24);
+      }
+    };
+  }  // namespace
+
+  const Kernel avx512_kernel{
+      "avx512",
+      kernel::ChaCha<AVX512>::Lanes,
+      &kernel::ChaCha<AVX512>::XChaCha20Group,
+      kernel::Blake2b<AVX512>::Lanes,
+      &kernel::Blake2b<AVX512>::HMACGroup};
+}  // namespace llarp::multibuffer
@@ -0,0 +1,351 @@
+#pragma once
+
+/**
+ * multibuffer_kernel.hpp
+ *
+ * the lane-parallel xchacha20 and keyed blake2b-256 bodies, written with gcc/clang vector
+ * extensions so the same code becomes avx2 or avx-512 depending on the flags of the translation
+ * unit including it.  Traits gives the vector types and the 32 bit rotates by whole bytes, which
+ * are a single byte shuffle on avx2 where a rotate would otherwise be two shifts and an or:
+ *
+ *   struct Traits
+ *   {
+ *     typedef uint32_t u32v __attribute__((vector_size(N)));
+ *     typedef uint64_t u64v __attribute__((vector_size(N)));
+ *     static u32v rotl16(u32v);
+ *     static u32v rotl8(u32v);
+ *   };
+ *
+ * only include this from the kernel translation units.  those only exist on x86, so words are
+ * loaded from and stored to memory as they are, little endian.
+ */
+
+#include "multibuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace llarp::multibuffer::kernel
+{
+  template <typename Traits>
+  struct ChaCha
+  {
+    using V = typename Traits::u32v;
+    static constexpr size_t Lanes = sizeof(V) / sizeof(uint32_t);
+    static constexpr size_t BlockSize = 64;
+    static constexpr uint32_t Sigma[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+
+    static inline V
+    splat(uint32_t x)
+    {
+      return V{} + x;
+    }
+
+    static inline V
+    rotl(V x, int n)
+    {
+      return (x << n) | (x >> (32 - n));
+    }
+
+    static inline void
+    QuarterRound(V& a, V& b, V& c, V& d)
+    {
+      a += b;
+      d = Traits::rotl16(d ^ a);
+      c += d;
+      b = rotl(b ^ c, 12);
+      a += b;
+      d = Traits::rotl8(d ^ a);
+      c += d;
+      b = rotl(b ^ c, 7);
+    }
+
+    static inline void
+    Rounds(V* x)
+    {
+      for (int round = 0; round < 10; ++round)
+      {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+      }
+    }
+
+    static inline uint32_t
+    load32(const byte_t* ptr)
+    {
+      uint32_t x;
+      std::memcpy(&x, ptr, sizeof(x));
+      return x;
+    }
+
+    /// load word w of every lane from a word major array
+    static inline V
+    load(const uint32_t (&words)[Lanes])
+    {
+      V v;
+      std::memcpy(&v, words, sizeof(V));
+      return v;
+    }
+
+    /// hchacha20 the key and first 16 nonce bytes of each lane into the subkey, then run
+    /// chacha20 (64 bit counter from 0, 64 bit nonce) with that subkey and the last 8 nonce bytes
+    /// over every lane a block at a time until the longest lane is done
+    static void
+    XChaCha20Group(XChaCha20Job* const* jobs)
+    {
+      static const byte_t zero[32] = {};
+      alignas(64) uint32_t in[16][Lanes];
+      alignas(64) uint32_t tail[2][Lanes];
+      size_t blocks = 0;
+      for (size_t lane = 0; lane < Lanes; ++lane)
+      {
+        const auto* job = jobs[lane];
+        const byte_t* key = job ? job->key->data() : zero;
+        const byte_t* nonce = job ? job->nonce : zero;
+        for (size_t word = 0; word < 8; ++word)
+          in[4 + word][lane] = load32(key + word * 4);
+        for (size_t word = 0; word < 4; ++word)
+          in[12 + word][lane] = load32(nonce + word * 4);
+        tail[0][lane] = load32(nonce + 16);
+        tail[1][lane] = load32(nonce + 20);
+        if (job)
+          blocks = std::max(blocks, (job->sz + BlockSize - 1) / BlockSize);
+      }
+
+      V state[16];
+      {
+        V x[16];
+        for (size_t word = 0; word < 4; ++word)
+          x[word] = splat(Sigma[word]);
+        for (size_t word = 4; word < 16; ++word)
+          x[word] = load(in[word]);
+        Rounds(x);
+        for (size_t word = 0; word < 4; ++word)
+        {
+          state[word] = splat(Sigma[word]);
+          state[4 + word] = x[word];
+          state[8 + word] = x[12 + word];
+        }
+        state[13] = splat(0);
+        state[14] = load(tail[0]);
+        state[15] = load(tail[1]);
+      }
+
+      alignas(64) uint32_t stream[16][Lanes];
+      for (size_t block = 0; block < blocks; ++block)
+      {
+        state[12] = splat(block);
+        V x[16];
+        std::copy_n(state, 16, x);
+        Rounds(x);
+        for (size_t word = 0; word < 16; ++word)
+        {
+          x[word] += state[word];
+          std::memcpy(stream[word], &x[word], sizeof(V));
+        }
+        const size_t offset = block * BlockSize;
+        for (size_t lane = 0; lane < Lanes; ++lane)
+        {
+          auto* job = jobs[lane];
+          if (job == nullptr or offset >= job->sz)
+            continue;
+          byte_t* ptr = job->buf + offset;
+          if (job->sz - offset >= BlockSize)
+          {
+            for (size_t word = 0; word < 16; ++word)
+            {
+              uint32_t data;
+              std::memcpy(&data, ptr + word * 4, 4);
+              data ^= stream[word][lane];
+              std::memcpy(ptr + word * 4, &data, 4);
+            }
+            continue;
+          }
+          alignas(16) uint32_t keystream[16];
+          for (size_t word = 0; word < 16; ++word)
+            keystream[word] = stream[word][lane];
+          const auto* ks = reinterpret_cast<const byte_t*>(keystream);
+          for (size_t idx = 0; idx < job->sz - offset; ++idx)
+            ptr[idx] ^= ks[idx];
+        }
+      }
+    }
+  };
+
+  template <typename Traits>
+  struct Blake2b
+  {
+    using V = typename Traits::u64v;
+    static constexpr size_t Lanes = sizeof(V) / sizeof(uint64_t);
+    static constexpr size_t BlockSize = 128;
+
+    static constexpr uint64_t IV[8] = {
+        0x6a09e667f3bcc908ULL,
+        0xbb67ae8584caa73bULL,
+        0x3c6ef372fe94f82bULL,
+        0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL,
+        0x9b05688c2b3e6c1fULL,
+        0x1f83d9abfb41bd6bULL,
+        0x5be0cd19137e2179ULL};
+
+    static constexpr uint8_t Sigma[12][16] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+        {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+        {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+        {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+        {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+        {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+        {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+        {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+        {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+        {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3}};
+
+    static inline V
+    splat(uint64_t x)
+    {
+      return V{} + x;
+    }
+
+    static inline V
+    rotr(V x, int n)
+    {
+      return (x >> n) | (x << (64 - n));
+    }
+
+    static inline void
+    G(V& a, V& b, V& c, V& d, const V& x, const V& y)
+    {
+      a += b + x;
+      d = rotr(d ^ a, 32);
+      c += d;
+      b = rotr(b ^ c, 24);
+      a += b + y;
+      d = rotr(d ^ a, 16);
+      c += d;
+      b = rotr(b ^ c, 63);
+    }
+
+    static inline V
+    load(const uint64_t (&words)[Lanes])
+    {
+      V v;
+      std::memcpy(&v, words, sizeof(V));
+      return v;
+    }
+
+    /// number of compressions a lane needs, the key block plus the message blocks
+    static inline size_t
+    NumBlocks(const HMACJob* job)
+    {
+      return job ? 1 + (job->sz + BlockSize - 1) / BlockSize : 0;
+    }
+
+    /// keyed blake2b with a 32 byte key and a 32 byte digest, one message per lane.  lanes that
+    /// are already done keep running but have their chaining value masked back.
+    static void
+    HMACGroup(HMACJob* const* jobs)
+    {
+      static_assert(HMACSIZE == 32 and HMACSECSIZE == 32);
+      V h[8];
+      for (size_t word = 0; word < 8; ++word)
+        h[word] = splat(IV[word]);
+      // digest length 32, key length 32, fanout 1, depth 1
+      h[0] ^= splat(0x01010000ULL | (HMACSECSIZE << 8) | HMACSIZE);
+
+      size_t blocks = 0;
+      for (size_t lane = 0; lane < Lanes; ++lane)
+        blocks = std::max(blocks, NumBlocks(jobs[lane]));
+
+      alignas(64) uint64_t msg[16][Lanes];
+      alignas(64) uint64_t counter[Lanes];
+      alignas(64) uint64_t last[Lanes];
+      alignas(64) uint64_t active[Lanes];
+      for (size_t block = 0; block < blocks; ++block)
+      {
+        for (size_t lane = 0; lane < Lanes; ++lane)
+        {
+          const auto* job = jobs[lane];
+          const size_t laneBlocks = NumBlocks(job);
+          byte_t padded[BlockSize] = {};
+          const byte_t* data = padded;
+          if (block >= laneBlocks)
+          {
+            counter[lane] = 0;
+            last[lane] = 0;
+            active[lane] = 0;
+          }
+          else if (block == 0)
+          {
+            std::copy_n(job->key->data(), HMACSECSIZE, padded);
+            counter[lane] = BlockSize;
+            last[lane] = laneBlocks == 1 ? ~uint64_t{0} : 0;
+            active[lane] = ~uint64_t{0};
+          }
+          else
+          {
+            const size_t offset = (block - 1) * BlockSize;
+            const size_t len = std::min(BlockSize, job->sz - offset);
+            if (len == BlockSize)
+              data = job->buf + offset;
+            else
+              std::copy_n(job->buf + offset, len, padded);
+            counter[lane] = BlockSize + offset + len;
+            last[lane] = block + 1 == laneBlocks ? ~uint64_t{0} : 0;
+            active[lane] = ~uint64_t{0};
+          }
+          for (size_t word = 0; word < 16; ++word)
+            std::memcpy(&msg[word][lane], data + word * 8, 8);
+        }
+
+        V m[16];
+        for (size_t word = 0; word < 16; ++word)
+          m[word] = load(msg[word]);
+        V v[16];
+        for (size_t word = 0; word < 8; ++word)
+        {
+          v[word] = h[word];
+          v[8 + word] = splat(IV[word]);
+        }
+        v[12] ^= load(counter);
+        v[14] ^= load(last);
+        for (size_t round = 0; round < 12; ++round)
+        {
+          const auto& s = Sigma[round];
+          G(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+          G(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+          G(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+          G(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+          G(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+          G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+          G(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+          G(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+        }
+        const V mask = load(active);
+        for (size_t word = 0; word < 8; ++word)
+          h[word] = ((h[word] ^ v[word] ^ v[8 + word]) & mask) | (h[word] & ~mask);
+      }
+
+      alignas(64) uint64_t out[4][Lanes];
+      for (size_t word = 0; word < 4; ++word)
+        std::memcpy(out[word], &h[word], sizeof(V));
+      for (size_t lane = 0; lane < Lanes; ++lane)
+      {
+        auto* job = jobs[lane];
+        if (job == nullptr)
+          continue;
+        for (size_t word = 0; word < 4; ++word)
+          for (size_t idx = 0; idx < 8; ++idx)
+            job->result[word * 8 + idx] = out[word][lane] >> (idx * 8);
+      }
+    }
+  };
+}  // namespace llarp::multibuffer::kernel
@@ -2,32 +2,42 @@
 
 #include "kademlia.hpp"
 #include "key.hpp"
+#include <llarp/util/endian.hpp>
 #include <llarp/util/status.hpp>
 
-#include <map>
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <set>
+#include <stdexcept>
 #include <vector>
 
 namespace llarp
 {
   namespace dht
   {
+    /// the dht nodes we know of, in 256 prefix buckets keyed by the first byte of their key.
+    ///
+    /// every key in the bucket for byte b is at an xor distance from a target whose top byte is
+    /// b ^ target[0], so visiting buckets in that order finds the closest keys after scanning only
+    /// the first few buckets. each bucket keeps its keys in one contiguous array, apart from the
+    /// values, so a scan touches nothing but keys.
     template <typename Val_t>
     struct Bucket
     {
-      using BucketStorage_t = std::map<Key_t, Val_t, XorMetric>;
       using Random_t = std::function<uint64_t()>;
 
-      Bucket(const Key_t& us, Random_t r) : nodes(XorMetric(us)), random(std::move(r))
+      explicit Bucket(Random_t r) : random(std::move(r))
       {}
 
       util::StatusObject
       ExtractStatus() const
       {
         util::StatusObject obj{};
-        for (const auto& item : nodes)
+        for (const auto& bucket : m_Buckets)
         {
-          obj[item.first.ToString()] = item.second.ExtractStatus();
+          for (size_t idx = 0; idx < bucket.keys.size(); ++idx)
+            obj[bucket.keys[idx].ToString()] = bucket.vals[idx].ExtractStatus();
         }
         return obj;
       }
@@ -35,85 +45,56 @@ namespace llarp
       size_t
       size() const
       {
-        return nodes.size();
+        return m_Size;
       }
 
-      struct SetIntersector
+      /// pick a random node not in exclude, a small container of keys such as a std::array
+      template <typename Keys_t>
+      bool
+      GetRandomNodeExcluding(Key_t& result, const Keys_t& exclude) const
       {
-        bool
-        operator()(const typename BucketStorage_t::value_type& lhs, const Key_t& rhs)
-        {
-          return lhs.first < rhs;
-        }
-
-        bool
-        operator()(const Key_t& lhs, const typename BucketStorage_t::value_type& rhs)
+        std::vector<const Key_t*> candidates;
+        candidates.reserve(m_Size);
+        for (const auto& bucket : m_Buckets)
         {
-          return lhs < rhs.first;
+          for (const auto& key : bucket.keys)
+          {
+            if (not Excluded(exclude, key))
+              candidates.push_back(&key);
+          }
         }
-      };
-
-      bool
-      GetRandomNodeExcluding(Key_t& result, const std::set<Key_t>& exclude) const
-      {
-        std::vector<typename BucketStorage_t::value_type> candidates;
-        std::set_difference(
-            nodes.begin(),
-            nodes.end(),
-            exclude.begin(),
-            exclude.end(),
-            std::back_inserter(candidates),
-            SetIntersector());
-
         if (candidates.empty())
         {
           return false;
         }
-        result = candidates[random() % candidates.size()].first;
+        result = *candidates[random() % candidates.size()];
         return true;
       }
 
       bool
       FindClosest(const Key_t& target, Key_t& result) const
       {
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for (const auto& item : nodes)
-        {
-          auto curDist = item.first ^ target;
-          if (curDist < mindist)
-          {
-            mindist = curDist;
-            result = item.first;
-          }
-        }
-        return nodes.size() > 0;
+        return FindCloseExcluding(target, result, std::array<Key_t, 0>{});
       }
 
       bool
       GetManyRandom(std::set<Key_t>& result, size_t N) const
       {
-        if (nodes.size() < N || nodes.empty())
+        if (m_Size < N || m_Size == 0)
         {
-          llarp::LogWarn("Not enough dht nodes, have ", nodes.size(), " want ", N);
+          llarp::LogWarn("Not enough dht nodes, have ", m_Size, " want ", N);
           return false;
         }
-        if (nodes.size() == N)
+        if (m_Size == N)
         {
-          std::transform(
-              nodes.begin(), nodes.end(), std::inserter(result, result.end()), [](const auto& a) {
-                return a.first;
-              });
-
+          for (const auto& bucket : m_Buckets)
+            result.insert(bucket.keys.begin(), bucket.keys.end());
           return true;
         }
         size_t expecting = N;
-        size_t sz = nodes.size();
         while (N)
         {
-          auto itr = nodes.begin();
-          std::advance(itr, random() % sz);
-          if (result.insert(itr->first).second)
+          if (result.insert(KeyAt(random() % m_Size)).second)
           {
             --N;
           }
@@ -121,76 +102,69 @@ namespace llarp
         return result.size() == expecting;
       }
 
+      template <typename Keys_t>
       bool
-      FindCloseExcluding(const Key_t& target, Key_t& result, const std::set<Key_t>& exclude) const
+      FindCloseExcluding(const Key_t& target, Key_t& result, const Keys_t& exclude) const
       {
-        Key_t maxdist;
-        maxdist.Fill(0xff);
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for (const auto& item : nodes)
-        {
-          if (exclude.count(item.first))
-          {
-            continue;
-          }
-
-          auto curDist = item.first ^ target;
-          if (curDist < mindist)
-          {
-            mindist = curDist;
-            result = item.first;
-          }
-        }
-        return mindist < maxdist;
+        const auto closest = Closest(target, 1, exclude);
+        if (closest.empty())
+          return false;
+        result = *closest.front();
+        return true;
       }
 
+      template <typename Keys_t>
       bool
       GetManyNearExcluding(
-          const Key_t& target,
-          std::set<Key_t>& result,
-          size_t N,
-          const std::set<Key_t>& exclude) const
+          const Key_t& target, std::set<Key_t>& result, size_t N, const Keys_t& exclude) const
       {
-        std::set<Key_t> s(exclude.begin(), exclude.end());
-
-        Key_t peer;
-        while (N--)
-        {
-          if (!FindCloseExcluding(target, peer, s))
-          {
-            return false;
-          }
-          s.insert(peer);
-          result.insert(peer);
-        }
-        return true;
+        const auto closest = Closest(target, N, exclude);
+        for (const auto* key : closest)
+          result.insert(*key);
+        return closest.size() == N;
       }
 
       void
       PutNode(const Val_t& val)
       {
-        auto itr = nodes.find(val.ID);
-        if (itr == nodes.end() || itr->second < val)
+        auto& bucket = BucketFor(val.ID);
+        const auto itr = std::find(bucket.keys.begin(), bucket.keys.end(), val.ID);
+        if (itr == bucket.keys.end())
         {
-          nodes[val.ID] = val;
+          bucket.keys.push_back(val.ID);
+          bucket.vals.push_back(val);
+          m_Size++;
+          return;
         }
+        auto& existing = bucket.vals[itr - bucket.keys.begin()];
+        if (existing < val)
+          existing = val;
       }
 
       void
       DelNode(const Key_t& key)
       {
-        auto itr = nodes.find(key);
-        if (itr != nodes.end())
-        {
-          nodes.erase(itr);
-        }
+        auto& bucket = BucketFor(key);
+        const auto itr = std::find(bucket.keys.begin(), bucket.keys.end(), key);
+        if (itr != bucket.keys.end())
+          Erase(bucket, itr - bucket.keys.begin());
       }
 
       bool
       HasNode(const Key_t& key) const
       {
-        return nodes.find(key) != nodes.end();
+        return GetNode(key) != nullptr;
+      }
+
+      /// the value stored for key or nullptr if we have none
+      const Val_t*
+      GetNode(const Key_t& key) const
+      {
+        const auto& bucket = BucketFor(key);
+        const auto itr = std::find(bucket.keys.begin(), bucket.keys.end(), key);
+        if (itr == bucket.keys.end())
+          return nullptr;
+        return &bucket.vals[itr - bucket.keys.begin()];
       }
 
       // remove all nodes who's key matches a predicate
@@ -198,13 +172,34 @@ namespace llarp
       void
       RemoveIf(Predicate pred)
       {
-        auto itr = nodes.begin();
-        while (itr != nodes.end())
+        for (auto& bucket : m_Buckets)
+        {
+          size_t idx = 0;
+          while (idx < bucket.keys.size())
+          {
+            if (pred(bucket.keys[idx]))
+              Erase(bucket, idx);
+            else
+              ++idx;
+          }
+        }
+      }
+
+      // remove all nodes who's value matches a predicate
+      template <typename Predicate>
+      void
+      RemoveNodesIf(Predicate pred)
+      {
+        for (auto& bucket : m_Buckets)
         {
-          if (pred(itr->first))
-            itr = nodes.erase(itr);
-          else
-            ++itr;
+          size_t idx = 0;
+          while (idx < bucket.keys.size())
+          {
+            if (pred(bucket.vals[idx]))
+              Erase(bucket, idx);
+            else
+              ++idx;
+          }
         }
       }
 
@@ -212,20 +207,122 @@ namespace llarp
       void
       ForEachNode(Visit_t visit)
       {
-        for (const auto& item : nodes)
+        for (const auto& bucket : m_Buckets)
         {
-          visit(item.second);
+          for (const auto& val : bucket.vals)
+            visit(val);
         }
       }
 
       void
       Clear()
       {
-        nodes.clear();
+        for (auto& bucket : m_Buckets)
+        {
+          bucket.keys.clear();
+          bucket.vals.clear();
+        }
+        m_Size = 0;
       }
 
-      BucketStorage_t nodes;
       Random_t random;
+
+     private:
+      /// keys[i] is the key of vals[i]
+      struct Prefix
+      {
+        std::vector<Key_t> keys;
+        std::vector<Val_t> vals;
+      };
+
+      /// xor distance as big endian words, which compare in the same order as the bytes do
+      using Distance_t = std::array<uint64_t, Key_t::SIZE / 8>;
+
+      static Distance_t
+      Distance(const Key_t& a, const Key_t& b)
+      {
+        Distance_t dist;
+        for (size_t idx = 0; idx < dist.size(); ++idx)
+          dist[idx] = bufbe64toh(a.data() + idx * 8) ^ bufbe64toh(b.data() + idx * 8);
+        return dist;
+      }
+
+      template <typename Keys_t>
+      static bool
+      Excluded(const Keys_t& exclude, const Key_t& key)
+      {
+        return std::find(std::begin(exclude), std::end(exclude), key) != std::end(exclude);
+      }
+
+      Prefix&
+      BucketFor(const Key_t& key)
+      {
+        return m_Buckets[key[0]];
+      }
+
+      const Prefix&
+      BucketFor(const Key_t& key) const
+      {
+        return m_Buckets[key[0]];
+      }
+
+      /// order does not matter within a bucket so the last entry fills the hole
+      void
+      Erase(Prefix& bucket, size_t idx)
+      {
+        if (idx + 1 != bucket.keys.size())
+        {
+          bucket.keys[idx] = std::move(bucket.keys.back());
+          bucket.vals[idx] = std::move(bucket.vals.back());
+        }
+        bucket.keys.pop_back();
+        bucket.vals.pop_back();
+        m_Size--;
+      }
+
+      const Key_t&
+      KeyAt(size_t idx) const
+      {
+        for (const auto& bucket : m_Buckets)
+        {
+          if (idx < bucket.keys.size())
+            return bucket.keys[idx];
+          idx -= bucket.keys.size();
+        }
+        throw std::out_of_range{"dht bucket index out of range"};
+      }
+
+      /// up to N keys not in exclude closest to target, closest first
+      template <typename Keys_t>
+      std::vector<const Key_t*>
+      Closest(const Key_t& target, size_t N, const Keys_t& exclude) const
+      {
+        std::vector<std::pair<Distance_t, const Key_t*>> found;
+        if (N == 0)
+          return {};
+        // every key in a later bucket is further away than all of the keys in this one, so once
+        // a whole bucket has been taken in and we have N we are done
+        for (size_t prefix = 0; prefix < m_Buckets.size() and found.size() < N; ++prefix)
+        {
+          for (const auto& key : m_Buckets[prefix ^ target[0]].keys)
+          {
+            if (not Excluded(exclude, key))
+              found.emplace_back(Distance(key, target), &key);
+          }
+        }
+        const auto mid = found.begin() + std::min(N, found.size());
+        std::partial_sort(found.begin(), mid, found.end(), [](const auto& a, const auto& b) {
+          return a.first < b.first;
+        });
+        std::vector<const Key_t*> closest;
+        closest.reserve(mid - found.begin());
+        for (auto itr = found.begin(); itr != mid; ++itr)
+          closest.push_back(itr->second);
+        return closest;
+      }
+
+      std::array<Prefix, 256> m_Buckets;
+      size_t m_Size = 0;
     };
   }  // namespace dht
 }  // namespace llarp
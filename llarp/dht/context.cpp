@@ -338,17 +338,8 @@ namespace llarp
       if (_services)
       {
         // expire intro sets
-        auto& nodes = _services->nodes;
-        auto itr = nodes.begin();
-        while (itr != nodes.end())
-        {
-          if (itr->second.introset.IsExpired(now))
-          {
-            itr = nodes.erase(itr);
-          }
-          else
-            ++itr;
-        }
+        _services->RemoveNodesIf(
+            [now](const ISNode& node) { return node.introset.IsExpired(now); });
       }
     }
 
@@ -415,10 +406,10 @@ namespace llarp
     std::optional<llarp::service::EncryptedIntroSet>
     Context::GetIntroSetByLocation(const Key_t& key) const
     {
-      auto itr = _services->nodes.find(key);
-      if (itr == _services->nodes.end())
+      const auto* node = _services->GetNode(key);
+      if (node == nullptr)
         return {};
-      return itr->second.introset;
+      return node->introset;
     }
 
     void
@@ -450,8 +441,8 @@ namespace llarp
     {
       router = r;
       ourKey = us;
-      _nodes = std::make_unique<Bucket<RCNode>>(ourKey, llarp::randint);
-      _services = std::make_unique<Bucket<ISNode>>(ourKey, llarp::randint);
+      _nodes = std::make_unique<Bucket<RCNode>>(llarp::randint);
+      _services = std::make_unique<Bucket<ISNode>>(llarp::randint);
       llarp::LogDebug("initialize dht with key ", ourKey);
       // start cleanup timer
       _timer_keepalive = std::make_shared<int>(0);
@@ -590,7 +581,7 @@ namespace llarp
       // requester is likely in the connected list
       // 4 or connection nodes (minus a potential requestor), whatever is less
       if (!_nodes->GetManyNearExcluding(
-              t, foundRouters, std::min(nodeCount, size_t{4}), std::set<Key_t>{ourKey, requester}))
+              t, foundRouters, std::min(nodeCount, size_t{4}), std::array<Key_t, 2>{ourKey, requester}))
       {
         llarp::LogError(
             "not enough dht nodes to handle exploritory router lookup, "
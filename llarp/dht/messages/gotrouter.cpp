@@ -117,22 +117,22 @@ namespace llarp
           dht.pendingRouterLookups().Found(owner, foundRCs[0].pubkey, foundRCs);
         return true;
       }
-      // store if valid
-      for (const auto& rc : foundRCs)
-      {
-        if (not dht.GetRouter()->rcLookupHandler().CheckRC(rc))
-          return false;
-        if (txid == 0)  // txid == 0 on gossip
-        {
-          auto* router = dht.GetRouter();
-          router->NotifyRouterEvent<tooling::RCGossipReceivedEvent>(router->pubkey(), rc);
-          router->GossipRCIfNeeded(rc);
+      // store the valid ones, checked all together off the logic thread
+      auto* router = dht.GetRouter();
+      router->rcLookupHandler().CheckRCs(
+          foundRCs, [router, gossip = txid == 0](std::vector<RouterContact> valid) {
+            if (not gossip)
+              return;
+            for (const auto& rc : valid)
+            {
+              router->NotifyRouterEvent<tooling::RCGossipReceivedEvent>(router->pubkey(), rc);
+              router->GossipRCIfNeeded(rc);
 
-          auto peerDb = router->peerDb();
-          if (peerDb)
-            peerDb->handleGossipedRC(rc);
-        }
-      }
+              auto peerDb = router->peerDb();
+              if (peerDb)
+                peerDb->handleGossipedRC(rc);
+            }
+          });
       return true;
     }
   }  // namespace dht
@@ -0,0 +1,159 @@
+#include "xor_index.hpp"
+
+namespace llarp
+{
+  namespace dht
+  {
+    const Key_t&
+    XorIndex::BestMatch(const Key_t& key) const
+    {
+      Ref ref = m_Root;
+      while (not IsLeaf(ref))
+      {
+        const auto& inner = m_Inner[ref];
+        ref = inner.child[BitOf(key, inner.bit)];
+      }
+      return m_Leaves[ref & ~LeafBit];
+    }
+
+    XorIndex::Ref
+    XorIndex::NewLeaf(const Key_t& key)
+    {
+      if (m_FreeLeaves.empty())
+      {
+        m_Leaves.emplace_back(key);
+        return (m_Leaves.size() - 1) | LeafBit;
+      }
+      const auto idx = m_FreeLeaves.back();
+      m_FreeLeaves.pop_back();
+      m_Leaves[idx] = key;
+      return idx | LeafBit;
+    }
+
+    XorIndex::Ref
+    XorIndex::NewInner(const Inner& inner)
+    {
+      if (m_FreeInner.empty())
+      {
+        m_Inner.emplace_back(inner);
+        return m_Inner.size() - 1;
+      }
+      const auto idx = m_FreeInner.back();
+      m_FreeInner.pop_back();
+      m_Inner[idx] = inner;
+      return idx;
+    }
+
+    bool
+    XorIndex::Insert(const Key_t& key)
+    {
+      if (m_Root == None)
+      {
+        m_Root = NewLeaf(key);
+        m_Size = 1;
+        return true;
+      }
+
+      // the new inner node splits on the first bit where key differs from its best match
+      const auto& match = BestMatch(key);
+      size_t byte = 0;
+      while (byte < Key_t::SIZE and key[byte] == match[byte])
+        ++byte;
+      if (byte == Key_t::SIZE)
+        return false;
+      uint16_t bit = byte * 8;
+      for (byte_t diff = key[byte] ^ match[byte]; not(diff & 0x80); diff <<= 1)
+        ++bit;
+
+      // and goes above the first node down that path that splits on a later bit
+      const Ref leaf = NewLeaf(key);
+      const Ref added = NewInner(Inner{{None, None}, bit});
+      Ref* where = &m_Root;
+      while (not IsLeaf(*where) and m_Inner[*where].bit < bit)
+      {
+        auto& inner = m_Inner[*where];
+        where = &inner.child[BitOf(key, inner.bit)];
+      }
+      auto& split = m_Inner[added];
+      const int side = BitOf(key, bit);
+      split.child[side] = leaf;
+      split.child[1 - side] = *where;
+      *where = added;
+      m_Size++;
+      return true;
+    }
+
+    bool
+    XorIndex::Remove(const Key_t& key)
+    {
+      if (m_Root == None)
+        return false;
+      Ref* where = &m_Root;
+      Ref* parentWhere = nullptr;
+      while (not IsLeaf(*where))
+      {
+        parentWhere = where;
+        auto& inner = m_Inner[*where];
+        where = &inner.child[BitOf(key, inner.bit)];
+      }
+      const auto leaf = *where & ~LeafBit;
+      if (not(m_Leaves[leaf] == key))
+        return false;
+      m_FreeLeaves.push_back(leaf);
+      m_Size--;
+      if (parentWhere == nullptr)
+      {
+        m_Root = None;
+        return true;
+      }
+      // the leaf's sibling takes the place of their parent
+      const auto parent = *parentWhere;
+      const auto& inner = m_Inner[parent];
+      *parentWhere = inner.child[0] == *where ? inner.child[1] : inner.child[0];
+      m_FreeInner.push_back(parent);
+      return true;
+    }
+
+    bool
+    XorIndex::Contains(const Key_t& key) const
+    {
+      return m_Root != None and BestMatch(key) == key;
+    }
+
+    void
+    XorIndex::Clear()
+    {
+      m_Root = None;
+      m_Inner.clear();
+      m_Leaves.clear();
+      m_FreeInner.clear();
+      m_FreeLeaves.clear();
+      m_Size = 0;
+    }
+
+    void
+    XorIndex::FindClosest(const Key_t& target, size_t n, std::vector<Key_t>& out) const
+    {
+      if (m_Root == None or n == 0)
+        return;
+      const auto wanted = out.size() + n;
+      // at most one pending sibling per level on the way down
+      std::vector<Ref> stack;
+      stack.reserve(64);
+      stack.push_back(m_Root);
+      while (not stack.empty() and out.size() < wanted)
+      {
+        Ref ref = stack.back();
+        stack.pop_back();
+        while (not IsLeaf(ref))
+        {
+          const auto& inner = m_Inner[ref];
+          const int side = BitOf(target, inner.bit);
+          stack.push_back(inner.child[1 - side]);
+          ref = inner.child[side];
+        }
+        out.push_back(m_Leaves[ref & ~LeafBit]);
+      }
+    }
+  }  // namespace dht
+}  // namespace llarp
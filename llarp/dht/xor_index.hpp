@@ -0,0 +1,96 @@
+#pragma once
+
+#include "key.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// a set of keys that can hand out the ones closest to any location by xor distance.
+    ///
+    /// this is a crit-bit tree: every inner node splits its keys on the first bit they do not all
+    /// share, so there is one inner node per key and a lookup only tests the bits that matter.
+    /// walking it depth first and always taking the side that agrees with the target's bit first
+    /// visits keys in order of increasing xor distance, so the k closest cost O(k log n) for
+    /// random keys such as router ids instead of a sort of the whole set.
+    class XorIndex
+    {
+     public:
+      /// add a key, false if it was already there
+      bool
+      Insert(const Key_t& key);
+
+      /// drop a key, false if it was not there
+      bool
+      Remove(const Key_t& key);
+
+      bool
+      Contains(const Key_t& key) const;
+
+      void
+      Clear();
+
+      size_t
+      Size() const
+      {
+        return m_Size;
+      }
+
+      bool
+      Empty() const
+      {
+        return m_Size == 0;
+      }
+
+      /// append up to n keys closest to target to out, closest first
+      void
+      FindClosest(const Key_t& target, size_t n, std::vector<Key_t>& out) const;
+
+     private:
+      /// a reference to a child: an inner node index, or a leaf index with LeafBit set
+      using Ref = uint32_t;
+      static constexpr Ref LeafBit = 0x80000000u;
+      static constexpr Ref None = 0xffffffffu;
+
+      struct Inner
+      {
+        Ref child[2];
+        /// which bit of the key picks the child, 0 being the top bit of the first byte
+        uint16_t bit;
+      };
+
+      static bool
+      IsLeaf(Ref ref)
+      {
+        return ref & LeafBit;
+      }
+
+      static int
+      BitOf(const Key_t& key, uint16_t bit)
+      {
+        return (key[bit >> 3] >> (7 - (bit & 7))) & 1;
+      }
+
+      /// the leaf we end up at following key's bits, which shares the longest prefix with key
+      /// of all the leaves
+      const Key_t&
+      BestMatch(const Key_t& key) const;
+
+      Ref
+      NewLeaf(const Key_t& key);
+
+      Ref
+      NewInner(const Inner& inner);
+
+      Ref m_Root = None;
+      std::vector<Inner> m_Inner;
+      std::vector<Key_t> m_Leaves;
+      std::vector<Ref> m_FreeInner;
+      std::vector<Ref> m_FreeLeaves;
+      size_t m_Size = 0;
+    };
+  }  // namespace dht
+}  // namespace llarp
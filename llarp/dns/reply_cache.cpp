@@ -0,0 +1,139 @@
+#include "reply_cache.hpp"
+
+#include "dns.hpp"
+#include <llarp/util/endian.hpp>
+
+namespace llarp
+{
+  namespace dns
+  {
+    namespace
+    {
+      /// the header and question of a message with one question, anything after it is ignored
+      std::optional<QueryView>
+      ViewMessage(const byte_t* buf, size_t sz)
+      {
+        if (sz < MessageHeader::Size)
+          return std::nullopt;
+        if (bufbe16toh(buf + 4) != 1)
+          return std::nullopt;
+        // the name is a run of labels ending in an empty one; we only take uncompressed names
+        size_t pos = MessageHeader::Size;
+        while (pos < sz and buf[pos] != 0)
+        {
+          if (buf[pos] > 63)
+            return std::nullopt;
+          pos += buf[pos] + 1;
+        }
+        // the end of the name, then qtype and qclass
+        pos += 5;
+        if (pos > sz or pos - MessageHeader::Size > 255 + 4)
+          return std::nullopt;
+        return QueryView{
+            bufbe16toh(buf),
+            bufbe16toh(buf + 2),
+            std::string_view{
+                reinterpret_cast<const char*>(buf) + MessageHeader::Size,
+                pos - MessageHeader::Size}};
+      }
+    }  // namespace
+
+    std::optional<QueryView>
+    ViewQuery(const byte_t* buf, size_t sz)
+    {
+      auto view = ViewMessage(buf, sz);
+      if (not view)
+        return std::nullopt;
+      // a standard query (opcode 0) with no answers or authorities; additional records such as
+      // edns options are left alone like the full decode does
+      if (view->fields & (flags_QR | 0x7800))
+        return std::nullopt;
+      if (bufbe16toh(buf + 6) != 0 or bufbe16toh(buf + 8) != 0)
+        return std::nullopt;
+      return view;
+    }
+
+    std::optional<size_t>
+    ReplyCache::Answer(const byte_t* buf, size_t sz, byte_t* out, size_t outsz, llarp_time_t now)
+    {
+      const auto query = ViewQuery(buf, sz);
+      if (not query)
+        return std::nullopt;
+      auto itr = m_Entries.find(query->question);
+      if (itr == m_Entries.end())
+        return std::nullopt;
+      const auto& entry = itr->second;
+      if (entry.expires <= now)
+      {
+        m_Entries.erase(itr);
+        return std::nullopt;
+      }
+      if (entry.wire.size() > outsz)
+        return std::nullopt;
+      std::copy(entry.wire.begin(), entry.wire.end(), out);
+      htobe16buf(out, query->id);
+      htobe16buf(out + 2, (query->fields & ~entry.clearFields) | entry.setFields);
+      return entry.wire.size();
+    }
+
+    bool
+    ReplyCache::Has(const byte_t* buf, size_t sz, llarp_time_t now) const
+    {
+      const auto query = ViewQuery(buf, sz);
+      if (not query)
+        return false;
+      const auto itr = m_Entries.find(query->question);
+      return itr != m_Entries.end() and itr->second.expires > now;
+    }
+
+    void
+    ReplyCache::Put(
+        const llarp_buffer_t& reply, Fields_t queryFields, llarp_time_t now, llarp_time_t lifetime)
+    {
+      const auto view = ViewMessage(reply.base, reply.sz);
+      if (not view)
+        return;
+      m_Entries.erase(view->question);
+      if (m_Entries.size() >= MaxEntries)
+      {
+        ExpireOld(now);
+        if (m_Entries.size() >= MaxEntries)
+          m_Entries.clear();
+      }
+      Entry entry{
+          std::vector<byte_t>{reply.base, reply.base + reply.sz},
+          Fields_t(view->fields & ~queryFields),
+          Fields_t(queryFields & ~view->fields),
+          now + lifetime};
+      // the key points into the entry's own copy, which stays put when the vector is moved
+      const std::string_view key{
+          reinterpret_cast<const char*>(entry.wire.data()) + MessageHeader::Size,
+          view->question.size()};
+      m_Entries.emplace(key, std::move(entry));
+    }
+
+    void
+    ReplyCache::ExpireOld(llarp_time_t now)
+    {
+      for (auto itr = m_Entries.begin(); itr != m_Entries.end();)
+      {
+        if (itr->second.expires <= now)
+          itr = m_Entries.erase(itr);
+        else
+          ++itr;
+      }
+    }
+
+    void
+    ReplyCache::Clear()
+    {
+      m_Entries.clear();
+    }
+
+    size_t
+    ReplyCache::Size() const
+    {
+      return m_Entries.size();
+    }
+  }  // namespace dns
+}  // namespace llarp
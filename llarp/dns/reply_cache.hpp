@@ -0,0 +1,77 @@
+#pragma once
+
+#include "message.hpp"
+
+#include <llarp/util/buffer.hpp>
+#include <llarp/util/time.hpp>
+
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp
+{
+  namespace dns
+  {
+    /// the parts of a single question query we need, read in place off the wire
+    struct QueryView
+    {
+      MsgID_t id;
+      Fields_t fields;
+      /// the wire encoded question: name, qtype and qclass
+      std::string_view question;
+    };
+
+    /// read the header and question of a plain query with exactly one question without decoding
+    /// the name; anything else (responses, answers, compressed names) is nullopt
+    std::optional<QueryView>
+    ViewQuery(const byte_t* buf, size_t sz);
+
+    /// wire format replies to hooked queries, keyed by their question, so repeat lookups of the
+    /// same name skip decoding, the query handler and encoding
+    class ReplyCache
+    {
+     public:
+      static constexpr size_t MaxEntries = 4096;
+
+      /// write the cached reply to this query into out, with its id and flags; return the size
+      /// of the reply or nullopt if we have none
+      std::optional<size_t>
+      Answer(const byte_t* buf, size_t sz, byte_t* out, size_t outsz, llarp_time_t now);
+
+      /// true if we have a reply to this query
+      bool
+      Has(const byte_t* buf, size_t sz, llarp_time_t now) const;
+
+      /// remember an encoded reply to a query that had the given header flags for lifetime
+      void
+      Put(const llarp_buffer_t& reply,
+          Fields_t queryFields,
+          llarp_time_t now,
+          llarp_time_t lifetime);
+
+      void
+      Clear();
+
+      size_t
+      Size() const;
+
+     private:
+      struct Entry
+      {
+        /// the whole encoded reply; the key points at the question in here
+        std::vector<byte_t> wire;
+        /// header bits the reply set and cleared relative to its query
+        Fields_t setFields;
+        Fields_t clearFields;
+        llarp_time_t expires;
+      };
+
+      void
+      ExpireOld(llarp_time_t now);
+
+      std::unordered_map<std::string_view, Entry> m_Entries;
+    };
+  }  // namespace dns
+}  // namespace llarp
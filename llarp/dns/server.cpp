@@ -92,10 +92,30 @@ namespace llarp::dns
       llarp::LogError("dns reply failed");
   }
 
+  void
+  PacketHandler::ClearReplyCache()
+  {
+    m_ReplyCache.Clear();
+  }
+
+  void
+  PacketHandler::SendHookedReply(
+      const SockAddr& resolver, const SockAddr& to, Fields_t queryFields, const Message& msg)
+  {
+    auto buf = msg.ToBuffer();
+    if (const auto lifetime = m_QueryHandler->ReplyCacheLifetime(msg); lifetime > 0s)
+      m_ReplyCache.Put(buf, queryFields, m_Loop->time_now(), lifetime);
+    SendServerMessageBufferTo(resolver, to, buf);
+  }
+
   bool
   PacketHandler::ShouldHandlePacket(
       const SockAddr& to, [[maybe_unused]] const SockAddr& from, llarp_buffer_t buf) const
   {
+    // we only cache replies to queries we hooked
+    if (m_ReplyCache.Has(buf.base, buf.sz, m_Loop->time_now()))
+      return true;
+
     MessageHeader hdr;
     if (not hdr.Decode(&buf))
     {
@@ -121,6 +141,15 @@ namespace llarp::dns
   void
   PacketHandler::HandlePacket(const SockAddr& resolver, const SockAddr& from, llarp_buffer_t buf)
   {
+    // repeat lookups of names we hooked are answered straight off the wire
+    std::array<byte_t, 1500> cached;
+    if (const auto sz = m_ReplyCache.Answer(
+            buf.base, buf.sz, cached.data(), cached.size(), m_Loop->time_now()))
+    {
+      SendServerMessageBufferTo(resolver, from, llarp_buffer_t{cached.data(), *sz});
+      return;
+    }
+
     MessageHeader hdr;
     if (not hdr.Decode(&buf))
     {
@@ -155,9 +184,8 @@ namespace llarp::dns
 
     if (m_QueryHandler && m_QueryHandler->ShouldHookDNSMessage(msg))
     {
-      auto reply = [self = shared_from_this(), to = from, resolver](dns::Message msg) {
-        self->SendServerMessageBufferTo(resolver, to, msg.ToBuffer());
-      };
+      auto reply = [self = shared_from_this(), to = from, resolver, fields = hdr.fields](
+                       dns::Message msg) { self->SendHookedReply(resolver, to, fields, msg); };
       if (!m_QueryHandler->HandleHookedDNSMessage(std::move(msg), reply))
       {
         llarp::LogWarn("failed to handle hooked dns");
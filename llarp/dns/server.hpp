@@ -1,6 +1,7 @@
 #pragma once
 
 #include "message.hpp"
+#include "reply_cache.hpp"
 #include <llarp/ev/ev.hpp>
 #include <llarp/net/net.hpp>
 #include "unbound_resolver.hpp"
@@ -24,6 +25,14 @@ namespace llarp
       /// handle a hooked message
       virtual bool
       HandleHookedDNSMessage(Message query, std::function<void(Message)> sendReply) = 0;
+
+      /// how long our reply to a hooked message may be given again from the reply cache without
+      /// asking us, zero to not cache it
+      virtual llarp_time_t
+      ReplyCacheLifetime(const Message&) const
+      {
+        return 0s;
+      }
     };
 
     // Base class for DNS lookups
@@ -49,6 +58,10 @@ namespace llarp
       bool
       ShouldHandlePacket(const SockAddr& to, const SockAddr& from, llarp_buffer_t buf) const;
 
+      /// forget every cached reply, for when what they answered with is no longer true
+      void
+      ClearReplyCache();
+
      protected:
       virtual void
       SendServerMessageBufferTo(const SockAddr& from, const SockAddr& to, llarp_buffer_t buf) = 0;
@@ -60,7 +73,12 @@ namespace llarp
       bool
       SetupUnboundResolver(std::vector<IpAddress> resolvers);
 
+      void
+      SendHookedReply(
+          const SockAddr& resolver, const SockAddr& to, Fields_t queryFields, const Message& msg);
+
       IQueryHandler* const m_QueryHandler;
+      ReplyCache m_ReplyCache;
       std::set<IpAddress> m_Resolvers;
       std::shared_ptr<UnboundResolver> m_UnboundResolver;
       EventLoop_ptr m_Loop;
@@ -1,8 +1,12 @@
 #include "unbound_resolver.hpp"
 
 #include "server.hpp"
+#include <llarp/net/ip_range.hpp>
+#include <llarp/net/net_int.hpp>
 #include <llarp/util/buffer.hpp>
 
+#include <string>
+
 namespace llarp::dns
 {
   struct PendingUnboundLookup
@@ -13,6 +17,22 @@ namespace llarp::dns
     SockAddr askerAddr;
   };
 
+  namespace
+  {
+    /// whether an upstream, given as unbound takes it with an optional @port, is on this host
+    bool
+    IsLoopbackUpstream(std::string_view upstream)
+    {
+      constexpr auto loopback4 = IPRange::FromIPv4(127, 0, 0, 0, 8);
+      const std::string host{upstream.substr(0, upstream.find('@'))};
+      if (huint32_t ip; ip.FromString(host))
+        return loopback4.Contains(ip);
+      if (huint128_t ip; ip.FromString(host))
+        return ip == huint128_t{1} or loopback4.Contains(ip);
+      return false;
+    }
+  }  // namespace
+
   void
   UnboundResolver::Stop()
   {
@@ -23,11 +43,15 @@ namespace llarp::dns
   UnboundResolver::Reset()
   {
     started = false;
+#ifdef _WIN32
     if (runner)
     {
       runner->join();
       runner.reset();
     }
+#else
+    poller.reset();
+#endif
     if (unboundContext)
     {
       ub_ctx_delete(unboundContext);
@@ -38,6 +62,7 @@ namespace llarp::dns
   UnboundResolver::UnboundResolver(EventLoop_ptr loop, ReplyFunction reply, FailFunction fail)
       : unboundContext(nullptr)
       , started(false)
+      , loop(loop)
       , replyFunc(loop->make_caller(std::move(reply)))
       , failFunc(loop->make_caller(std::move(fail)))
   {}
@@ -92,6 +117,8 @@ namespace llarp::dns
     }
 
     ub_ctx_async(unboundContext, 1);
+#ifdef _WIN32
+    // unbound's results pipe is not a socket here, so libuv cannot poll it
     runner = std::make_unique<std::thread>([&]() {
       while (started)
       {
@@ -100,6 +127,20 @@ namespace llarp::dns
         std::this_thread::sleep_for(25ms);
       }
     });
+#else
+    // unbound resolves on its own thread and signals finished lookups on ub_fd; handle them (and
+    // so call our callbacks) on the loop as soon as they arrive
+    poller = loop->make_poller(ub_fd(unboundContext), [self = weak_from_this()]() {
+      if (auto this_ptr = self.lock(); this_ptr and this_ptr->unboundContext)
+        ub_process(this_ptr->unboundContext);
+    });
+    if (not poller)
+    {
+      ub_ctx_delete(unboundContext);
+      unboundContext = nullptr;
+      return false;
+    }
+#endif
     started = true;
     return true;
   }
@@ -107,6 +148,10 @@ namespace llarp::dns
   bool
   UnboundResolver::AddUpstreamResolver(const std::string& upstreamResolverIP)
   {
+    // older unbound releases refuse to forward to loopback addresses, such as a local caching
+    // resolver, unless told otherwise
+    if (IsLoopbackUpstream(upstreamResolverIP))
+      ub_ctx_set_option(unboundContext, "do-not-query-localhost:", "no");
     if (ub_ctx_set_fwd(unboundContext, upstreamResolverIP.c_str()) != 0)
     {
       Reset();
@@ -27,7 +27,13 @@ namespace llarp::dns
     ub_ctx* unboundContext;
 
     std::atomic<bool> started;
+#ifdef _WIN32
     std::unique_ptr<std::thread> runner;
+#else
+    /// runs unbound's callbacks on the loop when its results pipe is readable
+    std::shared_ptr<EventLoopPoller> poller;
+#endif
+    EventLoop_ptr loop;
 
     ReplyFunction replyFunc;
     FailFunction failFunc;
@@ -41,7 +47,7 @@ namespace llarp::dns
     static void
     Callback(void* data, int err, ub_result* result);
 
-    // stop resolver thread
+    // stop resolving
     void
     Stop();
 
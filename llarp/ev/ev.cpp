@@ -1,4 +1,6 @@
 #include "ev.hpp"
+#include "udp_handle.hpp"
+#include <llarp/net/sock_addr.hpp>
 #include <llarp/util/mem.hpp>
 #include <llarp/util/str.hpp>
 
@@ -16,4 +18,13 @@ namespace llarp
   {
     return std::make_shared<llarp::uv::Loop>(queueLength);
   }
+
+  std::shared_ptr<UDPHandle>
+  EventLoop::make_batched_udp(UDPPacketReceiveFunc on_recv)
+  {
+    return make_udp([on_recv = std::move(on_recv)](
+                        UDPHandle& udp, SockAddr src, llarp::OwnedBuffer buf) {
+      on_recv(udp, std::move(src), PacketBuffer::copy_from(buf));
+    });
+  }
 }  // namespace llarp
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/packet_pool.hpp>
 #include <llarp/util/time.hpp>
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/constants/evloop.hpp>
@@ -57,6 +58,16 @@ namespace llarp
     start(llarp_time_t every, std::function<void()> task) = 0;
   };
 
+  /// calls a function on the event loop whenever a file descriptor is readable; stops watching
+  /// it on destruction
+  ///
+  /// Created via EventLoop::make_poller(...).
+  class EventLoopPoller
+  {
+   public:
+    virtual ~EventLoopPoller() = default;
+  };
+
   // this (nearly!) abstract base class
   // is overriden for each platform
   class EventLoop
@@ -172,6 +183,9 @@ namespace llarp
       };
     }
 
+    // Reads packets from a network interface and hands them to packetHandler.  An interface with
+    // more than one queue (see vpn::NetworkInterface::NumQueues) is read by one thread per queue
+    // where the platform supports it, and packetHandler is then called from those threads.
     virtual bool
     add_network_interface(
         std::shared_ptr<vpn::NetworkInterface> netif,
@@ -187,10 +201,32 @@ namespace llarp
 
     using UDPReceiveFunc = std::function<void(UDPHandle&, SockAddr src, llarp::OwnedBuffer buf)>;
 
+    /// like UDPReceiveFunc but the datagram comes in a pooled packet buffer
+    using UDPPacketReceiveFunc =
+        std::function<void(UDPHandle&, SockAddr src, llarp::PacketBuffer pkt)>;
+
     // Constructs a UDP socket that can be used for sending and/or receiving
     virtual std::shared_ptr<UDPHandle>
     make_udp(UDPReceiveFunc on_recv) = 0;
 
+    // Constructs a UDP socket that moves datagrams in batches where the platform supports it
+    // (recvmmsg/sendmmsg on linux).  Sends made with queue_send() on the returned handle are held
+    // until flush() is called.  Received datagrams are handed over in pooled packet buffers; on
+    // linux they are read straight into them.  Falls back to make_udp() elsewhere.
+    virtual std::shared_ptr<UDPHandle>
+    make_batched_udp(UDPPacketReceiveFunc on_recv);
+
+    // Constructs a UDP socket like make_batched_udp() whose datagram i/o is spread over `loops`
+    // event loops: this one and loops - 1 of its own on their own threads, each with a socket
+    // bound to the listen address with SO_REUSEPORT.  Received datagrams are still handed to
+    // on_recv on this loop, in order for any one remote.  Falls back to make_batched_udp() where
+    // SO_REUSEPORT sharding is not supported or loops is 1.
+    virtual std::shared_ptr<UDPHandle>
+    make_sharded_udp([[maybe_unused]] size_t loops, UDPPacketReceiveFunc on_recv)
+    {
+      return make_batched_udp(std::move(on_recv));
+    }
+
     /// set the function that is called once per cycle the flush all the queues
     virtual void
     set_pump_function(std::function<void(void)> pumpll) = 0;
@@ -202,6 +238,12 @@ namespace llarp
     virtual std::shared_ptr<EventLoopWakeup>
     make_waker(std::function<void()> callback) = 0;
 
+    /// Watch a file descriptor someone else reads from, such as the pipe a library signals its
+    /// results on, and call `callback` on the event loop whenever it is readable.  Returns nullptr
+    /// if the descriptor cannot be polled on this platform.
+    virtual std::shared_ptr<EventLoopPoller>
+    make_poller(int fd, std::function<void()> callback) = 0;
+
     // Initializes a new repeated task object. Note that the task is not actually added to the event
     // loop until you call start() on the returned object.  Typically invoked via call_every.
     virtual std::shared_ptr<EventLoopRepeater>
@@ -1,5 +1,6 @@
 #include "ev_libuv.hpp"
 #include "vpn.hpp"
+#include <algorithm>
 #include <memory>
 #include <thread>
 #include <type_traits>
@@ -7,6 +8,9 @@
 
 #include <cstring>
 #include "ev.hpp"
+#ifdef __linux__
+#include "udp_batch.hpp"
+#endif
 
 #include <uvw.hpp>
 
@@ -35,6 +39,26 @@ namespace llarp::uv
     }
   };
 
+#ifndef _WIN32
+  class UVPoller final : public EventLoopPoller
+  {
+    std::shared_ptr<uvw::PollHandle> poll;
+
+   public:
+    UVPoller(std::shared_ptr<uvw::PollHandle> handle, std::function<void()> callback)
+        : poll{std::move(handle)}
+    {
+      poll->on<uvw::PollEvent>([f = std::move(callback)](auto&, auto&) { f(); });
+      poll->start(uvw::PollHandle::Event::READABLE);
+    }
+
+    ~UVPoller() override
+    {
+      poll->close();
+    }
+  };
+#endif
+
   class UVRepeater final : public EventLoopRepeater
   {
     std::shared_ptr<uvw::TimerHandle> timer;
@@ -168,6 +192,32 @@ namespace llarp::uv
         std::make_shared<llarp::uv::UDPHandle>(*m_Impl, std::move(on_recv)));
   }
 
+#ifdef __linux__
+  std::shared_ptr<llarp::UDPHandle>
+  Loop::make_batched_udp(UDPPacketReceiveFunc on_recv)
+  {
+    return std::static_pointer_cast<llarp::UDPHandle>(
+        std::make_shared<llarp::uv::BatchedUDPHandle>(*m_Impl, std::move(on_recv)));
+  }
+
+  std::shared_ptr<llarp::UDPHandle>
+  Loop::make_sharded_udp(size_t loops, UDPPacketReceiveFunc on_recv)
+  {
+    if (loops <= 1)
+      return make_batched_udp(std::move(on_recv));
+    auto udp = std::make_shared<llarp::uv::ShardedUDPHandle>(*m_Impl, loops, std::move(on_recv));
+    // forget handles that have since gone away so rebinding does not grow this forever
+    m_ShardedUDP.erase(
+        std::remove_if(
+            m_ShardedUDP.begin(),
+            m_ShardedUDP.end(),
+            [](const auto& weak) { return weak.expired(); }),
+        m_ShardedUDP.end());
+    m_ShardedUDP.push_back(udp);
+    return udp;
+  }
+#endif
+
   static void
   setup_oneshot_timer(uvw::Loop& loop, llarp_time_t delay, std::function<void()> callback)
   {
@@ -213,6 +263,18 @@ namespace llarp::uv
         return call_soon([this] { stop(); });
 
       llarp::LogInfo("stopping event loop");
+#ifdef __linux__
+      // the readers wake us up, so they have to be gone before the wakeup handle is
+      for (auto& readers : m_NetIfReaders)
+        readers->Stop();
+      // so do the udp shards
+      for (const auto& weak : m_ShardedUDP)
+      {
+        if (auto udp = weak.lock())
+          udp->Stop();
+      }
+      m_ShardedUDP.clear();
+#endif
       m_Impl->walk([](auto&& handle) {
         if constexpr (!std::is_pointer_v<std::remove_reference_t<decltype(handle)>>)
           handle.close();
@@ -238,6 +300,14 @@ namespace llarp::uv
       std::shared_ptr<llarp::vpn::NetworkInterface> netif,
       std::function<void(llarp::net::IPPacket)> handler)
   {
+#ifdef __linux__
+    if (netif->NumQueues() > 1)
+    {
+      m_NetIfReaders.emplace_back(std::make_unique<NetIfQueueReaders>(
+          std::move(netif), std::move(handler), [this] { wakeup(); }));
+      return true;
+    }
+#endif
 #ifndef _WIN32
     using event_t = uvw::PollEvent;
     auto handle = m_Impl->resource<uvw::PollHandle>(netif->PollFD());
@@ -353,6 +423,17 @@ namespace llarp::uv
         std::make_shared<UVWakeup>(*m_Impl, std::move(callback)));
   }
 
+  std::shared_ptr<llarp::EventLoopPoller>
+  Loop::make_poller([[maybe_unused]] int fd, [[maybe_unused]] std::function<void()> callback)
+  {
+#ifndef _WIN32
+    if (auto handle = m_Impl->resource<uvw::PollHandle>(fd))
+      return std::make_shared<UVPoller>(std::move(handle), std::move(callback));
+#endif
+    // libuv only polls sockets on windows
+    return nullptr;
+  }
+
   std::shared_ptr<EventLoopRepeater>
   Loop::make_repeater()
   {
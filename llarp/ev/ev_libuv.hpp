@@ -1,6 +1,8 @@
 #pragma once
 #include "ev.hpp"
 #include "udp_handle.hpp"
+#include "netif_queues.hpp"
+#include "udp_shards.hpp"
 #include <llarp/util/thread/queue.hpp>
 #include <llarp/util/meta/memfn.hpp>
 
@@ -60,12 +62,23 @@ namespace llarp::uv
     std::shared_ptr<llarp::EventLoopWakeup>
     make_waker(std::function<void()> callback) override;
 
+    std::shared_ptr<llarp::EventLoopPoller>
+    make_poller(int fd, std::function<void()> callback) override;
+
     std::shared_ptr<EventLoopRepeater>
     make_repeater() override;
 
     std::shared_ptr<llarp::UDPHandle>
     make_udp(UDPReceiveFunc on_recv) override;
 
+#ifdef __linux__
+    std::shared_ptr<llarp::UDPHandle>
+    make_batched_udp(UDPPacketReceiveFunc on_recv) override;
+
+    std::shared_ptr<llarp::UDPHandle>
+    make_sharded_udp(size_t loops, UDPPacketReceiveFunc on_recv) override;
+#endif
+
     void
     FlushLogic();
 
@@ -92,6 +105,11 @@ namespace llarp::uv
     std::unordered_map<int, std::shared_ptr<uvw::PollHandle>> m_Polls;
 
     std::optional<std::thread::id> m_EventLoopThreadID;
+
+#ifdef __linux__
+    std::vector<std::unique_ptr<NetIfQueueReaders>> m_NetIfReaders;
+    std::vector<std::weak_ptr<ShardedUDPHandle>> m_ShardedUDP;
+#endif
   };
 
 }  // namespace llarp::uv
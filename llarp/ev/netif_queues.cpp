@@ -0,0 +1,97 @@
+#include "netif_queues.hpp"
+
+#include <llarp/util/logging/logger.hpp>
+#include <llarp/util/thread/threading.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+
+namespace llarp::uv
+{
+  /// how long a reader waits on its fd before checking whether it should stop
+  static constexpr int PollTimeoutMS = 100;
+
+  NetIfQueueReaders::NetIfQueueReaders(
+      std::shared_ptr<vpn::NetworkInterface> netif,
+      std::function<void(net::IPPacket)> handler,
+      std::function<void(void)> wakeup)
+      : m_NetIf{std::move(netif)}, m_Handler{std::move(handler)}, m_Wakeup{std::move(wakeup)}
+  {
+    const auto numQueues = m_NetIf->NumQueues();
+    for (size_t queue = 0; queue < numQueues; ++queue)
+    {
+      const int fd = m_NetIf->QueueFD(queue);
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    for (size_t queue = 0; queue < numQueues; ++queue)
+      m_Threads.emplace_back([this, queue] { Run(queue); });
+  }
+
+  NetIfQueueReaders::~NetIfQueueReaders()
+  {
+    Stop();
+  }
+
+  void
+  NetIfQueueReaders::Stop()
+  {
+    m_Run = false;
+    for (auto& thread : m_Threads)
+    {
+      if (thread.joinable())
+        thread.join();
+    }
+    m_Threads.clear();
+  }
+
+  void
+  NetIfQueueReaders::Run(size_t queue)
+  {
+    util::SetThreadName("llarp-tun" + std::to_string(queue));
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(queue % cores, &set);
+    if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0)
+      LogWarn("failed to pin tun queue ", queue, " to core ", queue % cores, ": ", strerror(rc));
+
+    pollfd pfd{m_NetIf->QueueFD(queue), POLLIN, 0};
+    while (m_Run)
+    {
+      if (::poll(&pfd, 1, PollTimeoutMS) <= 0)
+        continue;
+      try
+      {
+        bool more = true;
+        while (more and m_Run)
+        {
+          size_t handled = 0;
+          for (; handled < BatchSize; ++handled)
+          {
+            auto pkt = m_NetIf->ReadNextPacketFrom(queue);
+            if (pkt.sz == 0)
+            {
+              more = false;
+              break;
+            }
+            if (not(pkt.IsV4() or pkt.IsV6()))
+              continue;
+            m_Handler(std::move(pkt));
+          }
+          if (handled)
+            m_Wakeup();
+        }
+      }
+      catch (std::error_code& ec)
+      {
+        LogError("failed to read from ", m_NetIf->IfName(), " queue ", queue, ": ", ec.message());
+        return;
+      }
+    }
+  }
+}  // namespace llarp::uv
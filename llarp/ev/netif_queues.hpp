@@ -0,0 +1,52 @@
+#pragma once
+#ifdef __linux__
+#include "vpn.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace llarp::uv
+{
+  /// reads every queue of a multi-queue network interface on its own thread.
+  ///
+  /// each thread waits on its queue's fd, drains it in batches, drops anything that is not an
+  /// ip packet and feeds the rest to the packet handler right there, so the handler runs on
+  /// several threads at once and must be safe to call that way.  after every batch we call
+  /// wakeup so the event loop gets to route what the handler queued.  on linux each thread is
+  /// pinned to one core.
+  class NetIfQueueReaders
+  {
+   public:
+    /// most packets we read from one queue before calling wakeup
+    static constexpr size_t BatchSize = 64;
+
+    NetIfQueueReaders(
+        std::shared_ptr<vpn::NetworkInterface> netif,
+        std::function<void(net::IPPacket)> handler,
+        std::function<void(void)> wakeup);
+
+    ~NetIfQueueReaders();
+
+    NetIfQueueReaders(const NetIfQueueReaders&) = delete;
+    NetIfQueueReaders&
+    operator=(const NetIfQueueReaders&) = delete;
+
+    /// stop and join all reader threads, idempotent
+    void
+    Stop();
+
+   private:
+    void
+    Run(size_t queue);
+
+    const std::shared_ptr<vpn::NetworkInterface> m_NetIf;
+    const std::function<void(net::IPPacket)> m_Handler;
+    const std::function<void(void)> m_Wakeup;
+    std::atomic<bool> m_Run{true};
+    std::vector<std::thread> m_Threads;
+  };
+}  // namespace llarp::uv
+#endif
@@ -0,0 +1,291 @@
+#include "udp_batch.hpp"
+#include <llarp/util/logging/logger.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+namespace llarp::uv
+{
+  BatchedUDPHandle::BatchedUDPHandle(
+      uvw::Loop& loop, EventLoop::UDPPacketReceiveFunc rf, bool reusePort)
+      : llarp::UDPHandle{[this](UDPHandle& udp, SockAddr from, OwnedBuffer buf) {
+        m_OnPacket(udp, std::move(from), PacketBuffer::copy_from(buf));
+      }}
+      , m_OnPacket{std::move(rf)}
+      , m_Loop{loop}
+      , m_ReusePort{reusePort}
+      , m_SendSlots{std::make_unique<std::array<Slot, BatchSize>>()}
+  {
+    assert(m_OnPacket);
+    for (size_t idx = 0; idx < BatchSize; ++idx)
+    {
+      auto& rhdr = m_RecvHeaders[idx];
+      std::memset(&rhdr, 0, sizeof(rhdr));
+      rhdr.msg_hdr.msg_name = &m_RecvSlots[idx].addr;
+      rhdr.msg_hdr.msg_iov = &m_RecvSlots[idx].iov;
+      rhdr.msg_hdr.msg_iovlen = 1;
+      arm_recv_slot(idx);
+
+      auto& sslot = (*m_SendSlots)[idx];
+      sslot.iov.iov_base = sslot.data.data();
+      auto& shdr = m_SendHeaders[idx];
+      std::memset(&shdr, 0, sizeof(shdr));
+      shdr.msg_hdr.msg_name = &sslot.addr;
+      shdr.msg_hdr.msg_iov = &sslot.iov;
+      shdr.msg_hdr.msg_iovlen = 1;
+    }
+  }
+
+  BatchedUDPHandle::~BatchedUDPHandle()
+  {
+    close();
+  }
+
+  void
+  BatchedUDPHandle::arm_recv_slot(size_t idx)
+  {
+    auto& slot = m_RecvSlots[idx];
+    slot.pkt = PacketBuffer::uninitialized(SlotSize);
+    slot.iov.iov_base = slot.pkt.data();
+    slot.iov.iov_len = slot.pkt.size();
+  }
+
+  bool
+  BatchedUDPHandle::ensure_socket(int af)
+  {
+    if (m_FD >= 0)
+      return true;
+    m_FD = ::socket(af, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_FD < 0)
+    {
+      LogError("failed to create udp socket: ", strerror(errno));
+      return false;
+    }
+    if (m_ReusePort)
+    {
+      const int one = 1;
+      if (::setsockopt(m_FD, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1)
+      {
+        LogError("failed to set SO_REUSEPORT on udp socket: ", strerror(errno));
+        ::close(m_FD);
+        m_FD = -1;
+        return false;
+      }
+    }
+    m_Family = af;
+    m_Poll = m_Loop.resource<uvw::PollHandle>(m_FD);
+    m_Poll->on<uvw::PollEvent>([this](const auto&, auto&) { drain(); });
+    m_Poll->start(uvw::PollHandle::Event::READABLE);
+    return true;
+  }
+
+  bool
+  BatchedUDPHandle::listen(const SockAddr& addr)
+  {
+    if (m_FD >= 0)
+      close();
+    const sockaddr* saddr = addr;
+    if (not ensure_socket(saddr->sa_family))
+      return false;
+    const socklen_t slen =
+        saddr->sa_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    if (::bind(m_FD, saddr, slen) == -1)
+    {
+      LogError("failed to bind and start receiving on ", addr, ": ", strerror(errno));
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  socklen_t
+  BatchedUDPHandle::make_dest(const SockAddr& dest, sockaddr_storage& out) const
+  {
+    const sockaddr* saddr = dest;
+    if (m_Family == AF_INET6 and saddr->sa_family == AF_INET)
+    {
+      // ipv6 socket talking to an ipv4 peer; use the v4 mapped form
+      std::memcpy(&out, static_cast<const sockaddr_in6*>(dest), sizeof(sockaddr_in6));
+      return sizeof(sockaddr_in6);
+    }
+    const socklen_t slen =
+        saddr->sa_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    std::memcpy(&out, saddr, slen);
+    return slen;
+  }
+
+  bool
+  BatchedUDPHandle::send(const SockAddr& dest, const llarp_buffer_t& buf)
+  {
+    if (not ensure_socket(static_cast<const sockaddr*>(dest)->sa_family))
+      return false;
+    sockaddr_storage to{};
+    const auto tolen = make_dest(dest, to);
+    return ::sendto(
+               m_FD, buf.base, buf.sz, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&to), tolen)
+        >= 0;
+  }
+
+  bool
+  BatchedUDPHandle::queue_send(const SockAddr& dest, const llarp_buffer_t& buf)
+  {
+    std::lock_guard lock{m_SendMutex};
+    if (buf.sz > SlotSize)
+    {
+      // too big for a slot, this never happens with iwp so just count it and send it directly
+      Stats::Add(m_Stats.txOversized, 1);
+      return send(dest, buf);
+    }
+    if (not ensure_socket(static_cast<const sockaddr*>(dest)->sa_family))
+      return false;
+    if (m_SendQueued == BatchSize)
+      flush_locked();
+    auto& slot = (*m_SendSlots)[m_SendQueued];
+    auto& hdr = m_SendHeaders[m_SendQueued];
+    std::copy_n(buf.base, buf.sz, slot.data.data());
+    slot.iov.iov_len = buf.sz;
+    hdr.msg_hdr.msg_namelen = make_dest(dest, slot.addr);
+    m_SendQueued++;
+    return true;
+  }
+
+  void
+  BatchedUDPHandle::flush()
+  {
+    std::lock_guard lock{m_SendMutex};
+    flush_locked();
+  }
+
+  void
+  BatchedUDPHandle::flush_locked()
+  {
+    if (m_SendQueued == 0 or m_FD < 0)
+      return;
+    size_t offset = 0;
+    while (offset < m_SendQueued)
+    {
+      const int sent = ::sendmmsg(
+          m_FD, m_SendHeaders.data() + offset, m_SendQueued - offset, MSG_DONTWAIT);
+      if (sent < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN or errno == EWOULDBLOCK)
+        {
+          // socket buffer is full, drop the rest like a failed trySend would
+          Stats::Add(m_Stats.txDropped, m_SendQueued - offset);
+          break;
+        }
+        // the error is for the datagram at the head of the batch, skip it and keep going
+        LogDebug("sendmmsg failed: ", strerror(errno));
+        Stats::Add(m_Stats.txDropped, 1);
+        offset++;
+        continue;
+      }
+      Stats::Add(m_Stats.txBatches, 1);
+      Stats::Add(m_Stats.txPackets, sent);
+      Stats::Max(m_Stats.txMaxBatch, sent);
+      offset += sent;
+    }
+    m_SendQueued = 0;
+  }
+
+  void
+  BatchedUDPHandle::drain()
+  {
+    for (size_t round = 0; round < MaxRecvRounds; ++round)
+    {
+      for (auto& hdr : m_RecvHeaders)
+      {
+        hdr.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        hdr.msg_hdr.msg_flags = 0;
+        hdr.msg_len = 0;
+      }
+      const int got = ::recvmmsg(m_FD, m_RecvHeaders.data(), BatchSize, MSG_DONTWAIT, nullptr);
+      if (got <= 0)
+      {
+        if (got < 0 and errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR)
+          LogDebug("recvmmsg failed: ", strerror(errno));
+        return;
+      }
+      Stats::Add(m_Stats.rxBatches, 1);
+      Stats::Add(m_Stats.rxPackets, got);
+      Stats::Max(m_Stats.rxMaxBatch, got);
+      for (int idx = 0; idx < got; ++idx)
+      {
+        const auto& hdr = m_RecvHeaders[idx];
+        if (hdr.msg_hdr.msg_flags & MSG_TRUNC)
+        {
+          Stats::Add(m_Stats.rxTruncated, 1);
+          continue;
+        }
+        auto& slot = m_RecvSlots[idx];
+        const auto* from = reinterpret_cast<const sockaddr*>(&slot.addr);
+        if (from->sa_family != AF_INET and from->sa_family != AF_INET6)
+          continue;
+        // hand the buffer itself over and put a new one in its place
+        SockAddr src{*from};
+        auto pkt = std::move(slot.pkt);
+        pkt.resize(hdr.msg_len);
+        arm_recv_slot(idx);
+        m_OnPacket(*this, std::move(src), std::move(pkt));
+        // the receive handler is allowed to close us
+        if (m_FD < 0)
+          return;
+      }
+      if (static_cast<size_t>(got) < BatchSize)
+        return;
+    }
+  }
+
+  void
+  BatchedUDPHandle::close()
+  {
+    if (m_Poll)
+    {
+      m_Poll->close();
+      m_Poll.reset();
+    }
+    if (m_FD >= 0)
+    {
+      {
+        std::lock_guard lock{m_SendMutex};
+        flush_locked();
+      }
+      ::close(m_FD);
+      m_FD = -1;
+    }
+    m_Family = AF_UNSPEC;
+  }
+
+  util::StatusObject
+  BatchedUDPHandle::ExtractStatus() const
+  {
+    const auto get = [](const std::atomic<uint64_t>& counter) {
+      return counter.load(std::memory_order_relaxed);
+    };
+    const auto avg = [](uint64_t pkts, uint64_t batches) -> double {
+      return batches ? double(pkts) / double(batches) : 0.0;
+    };
+    const uint64_t rxBatches = get(m_Stats.rxBatches), rxPackets = get(m_Stats.rxPackets);
+    const uint64_t txBatches = get(m_Stats.txBatches), txPackets = get(m_Stats.txPackets);
+    return util::StatusObject{
+        {"batched", true},
+        {"batchSize", BatchSize},
+        {"rxBatches", rxBatches},
+        {"rxPackets", rxPackets},
+        {"rxAvgBatch", avg(rxPackets, rxBatches)},
+        {"rxMaxBatch", get(m_Stats.rxMaxBatch)},
+        {"rxTruncated", get(m_Stats.rxTruncated)},
+        {"txBatches", txBatches},
+        {"txPackets", txPackets},
+        {"txAvgBatch", avg(txPackets, txBatches)},
+        {"txMaxBatch", get(m_Stats.txMaxBatch)},
+        {"txDropped", get(m_Stats.txDropped)},
+        {"txOversized", get(m_Stats.txOversized)}};
+  }
+}  // namespace llarp::uv
@@ -0,0 +1,154 @@
+#pragma once
+#ifdef __linux__
+#include "udp_handle.hpp"
+#include <llarp/net/sock_addr.hpp>
+#include <llarp/util/packet_pool.hpp>
+#include <llarp/util/thread/threading.hpp>
+
+#include <uvw/loop.h>
+#include <uvw/poll.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace llarp::uv
+{
+  /// linux udp handle that moves datagrams in batches using recvmmsg/sendmmsg.
+  ///
+  /// inbound datagrams are drained from the socket straight into pooled packet buffers when the
+  /// socket becomes readable, and the buffer is handed to the receive handler as is. outbound
+  /// datagrams passed to queue_send() are copied into preallocated send slots and go out with a
+  /// single sendmmsg when flush() is called (once per Router::PumpLL via ILinkLayer::Pump) or when
+  /// the send slots fill up.
+  class BatchedUDPHandle final : public llarp::UDPHandle
+  {
+   public:
+    /// number of datagrams we move per syscall
+    static constexpr size_t BatchSize = 64;
+    /// size of each packet slot; iwp packets are at most one fragment plus overhead and padding
+    static constexpr size_t SlotSize = packet_pool::SlotSize;
+    /// max number of full recvmmsg batches we drain per readable event before yielding to the
+    /// rest of the event loop
+    static constexpr size_t MaxRecvRounds = 8;
+
+    /// with reusePort the socket sets SO_REUSEPORT before binding so several handles can listen
+    /// on the same address, the kernel spreading remotes over them
+    BatchedUDPHandle(uvw::Loop& loop, EventLoop::UDPPacketReceiveFunc rf, bool reusePort = false);
+
+    ~BatchedUDPHandle() override;
+
+    bool
+    listen(const SockAddr& addr) override;
+
+    bool
+    send(const SockAddr& dest, const llarp_buffer_t& buf) override;
+
+    bool
+    queue_send(const SockAddr& dest, const llarp_buffer_t& buf) override;
+
+    void
+    flush() override;
+
+    void
+    close() override;
+
+    std::optional<int>
+    file_descriptor() override
+    {
+      if (m_FD >= 0)
+        return m_FD;
+      return std::nullopt;
+    }
+
+    util::StatusObject
+    ExtractStatus() const override;
+
+   private:
+    struct Slot
+    {
+      std::array<byte_t, SlotSize> data;
+      sockaddr_storage addr;
+      iovec iov;
+    };
+
+    /// a receive slot reads into a pooled buffer that is given away when a datagram lands in it
+    struct RecvSlot
+    {
+      PacketBuffer pkt;
+      sockaddr_storage addr;
+      iovec iov;
+    };
+
+    /// the rx counters are only written on the event loop and the tx counters only with
+    /// m_SendMutex held, but ExtractStatus() reads them all from whatever thread asks
+    struct Stats
+    {
+      std::atomic<uint64_t> rxBatches{0};
+      std::atomic<uint64_t> rxPackets{0};
+      std::atomic<uint64_t> rxMaxBatch{0};
+      std::atomic<uint64_t> rxTruncated{0};
+      std::atomic<uint64_t> txBatches{0};
+      std::atomic<uint64_t> txPackets{0};
+      std::atomic<uint64_t> txMaxBatch{0};
+      std::atomic<uint64_t> txDropped{0};
+      std::atomic<uint64_t> txOversized{0};
+
+      /// counters have one writer at a time, so a plain load and store is enough to add to them
+      static void
+      Add(std::atomic<uint64_t>& counter, uint64_t n)
+      {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+      static void
+      Max(std::atomic<uint64_t>& counter, uint64_t n)
+      {
+        if (counter.load(std::memory_order_relaxed) < n)
+          counter.store(n, std::memory_order_relaxed);
+      }
+    };
+
+    /// open the socket for address family af if it is not already open
+    bool
+    ensure_socket(int af);
+
+    /// read datagrams off the socket until it would block or we hit MaxRecvRounds
+    void
+    drain();
+
+    /// put a fresh pooled buffer in receive slot idx
+    void
+    arm_recv_slot(size_t idx);
+
+    /// send everything in the send slots; caller must hold m_SendMutex
+    void
+    flush_locked();
+
+    /// fill in a sockaddr for sending to dest from our socket's address family
+    socklen_t
+    make_dest(const SockAddr& dest, sockaddr_storage& out) const;
+
+    EventLoop::UDPPacketReceiveFunc m_OnPacket;
+    uvw::Loop& m_Loop;
+    const bool m_ReusePort;
+    std::shared_ptr<uvw::PollHandle> m_Poll;
+    int m_FD = -1;
+    int m_Family = AF_UNSPEC;
+
+    std::array<RecvSlot, BatchSize> m_RecvSlots;
+    std::array<mmsghdr, BatchSize> m_RecvHeaders;
+
+    mutable std::mutex m_SendMutex;
+    std::unique_ptr<std::array<Slot, BatchSize>> m_SendSlots GUARDED_BY(m_SendMutex);
+    std::array<mmsghdr, BatchSize> m_SendHeaders GUARDED_BY(m_SendMutex);
+    size_t m_SendQueued GUARDED_BY(m_SendMutex) = 0;
+
+    Stats m_Stats;
+  };
+}  // namespace llarp::uv
+#endif
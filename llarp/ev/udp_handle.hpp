@@ -1,5 +1,8 @@
+#pragma once
+
 #include "ev.hpp"
 #include "../util/buffer.hpp"
+#include "../util/status.hpp"
 
 namespace llarp
 {
@@ -20,6 +23,27 @@ namespace llarp
     virtual bool
     send(const SockAddr& dest, const llarp_buffer_t& buf) = 0;
 
+    // Queues a packet to be sent to the given recipient on the next call to flush().  Unlike send()
+    // this may be called from any thread.  Handles that do not batch sends (the default) send
+    // immediately and return the result of send().
+    virtual bool
+    queue_send(const SockAddr& dest, const llarp_buffer_t& buf)
+    {
+      return send(dest, buf);
+    }
+
+    // Sends everything queued with queue_send().  Does nothing for handles that do not batch.
+    virtual void
+    flush()
+    {}
+
+    // Returns batching counters for this handle, if it keeps any.
+    virtual util::StatusObject
+    ExtractStatus() const
+    {
+      return util::StatusObject{{"batched", false}};
+    }
+
     // Closes the listening UDP socket (if opened); this is typically called (automatically) during
     // destruction.  Does nothing if the UDP socket is already closed.
     virtual void
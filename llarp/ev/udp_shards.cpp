@@ -0,0 +1,229 @@
+#include "udp_shards.hpp"
+#include <llarp/util/logging/logger.hpp>
+#include <llarp/util/thread/threading.hpp>
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+namespace llarp::uv
+{
+  ShardedUDPHandle::ShardedUDPHandle(
+      uvw::Loop& loop, size_t loops, EventLoop::UDPPacketReceiveFunc rf)
+      : llarp::UDPHandle{[this](UDPHandle& udp, SockAddr from, OwnedBuffer buf) {
+        m_OnPacket(udp, std::move(from), PacketBuffer::copy_from(buf));
+      }}
+      , m_Loop{loop}
+      , m_NumLoops{std::max<size_t>(loops, 1)}
+      , m_OnPacket{std::move(rf)}
+      , m_Socket{
+            loop,
+            [this](UDPHandle&, SockAddr from, PacketBuffer pkt) {
+              m_OnPacket(*this, std::move(from), std::move(pkt));
+            },
+            true}
+      , m_Inbox{InboxSize}
+  {
+    assert(m_OnPacket);
+  }
+
+  ShardedUDPHandle::~ShardedUDPHandle()
+  {
+    close();
+  }
+
+  bool
+  ShardedUDPHandle::listen(const SockAddr& addr)
+  {
+    close();
+    if (not m_Socket.listen(addr))
+      return false;
+
+    // bind the shards to where we actually ended up, we may have been given port 0
+    SockAddr bound{addr};
+    sockaddr_storage local{};
+    socklen_t len = sizeof(local);
+    if (::getsockname(*m_Socket.file_descriptor(), reinterpret_cast<sockaddr*>(&local), &len)
+        == 0)
+      bound = SockAddr{*reinterpret_cast<const sockaddr*>(&local)};
+
+    m_InboxWakeup = m_Loop.resource<uvw::AsyncHandle>();
+    m_InboxWakeup->on<uvw::AsyncEvent>([this](const auto&, auto&) { DrainInbox(); });
+
+    for (size_t idx = 1; idx < m_NumLoops; ++idx)
+    {
+      if (not StartShard(idx, bound))
+      {
+        LogWarn("could not start udp loop ", idx, " on ", bound, ", running with ", idx);
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool
+  ShardedUDPHandle::StartShard(size_t idx, const SockAddr& addr)
+  {
+    auto shard = std::make_unique<Shard>();
+    auto* s = shard.get();
+    if (not(s->loop = uvw::Loop::create()))
+      return false;
+    s->socket = std::make_unique<BatchedUDPHandle>(
+        *s->loop,
+        [s](UDPHandle&, SockAddr from, PacketBuffer pkt) {
+          s->received.emplace_back(std::move(from), std::move(pkt));
+        },
+        true);
+    if (not s->socket->listen(addr))
+    {
+      // let the loop finish closing the socket's poll handle before it goes away
+      s->loop->run();
+      return false;
+    }
+    s->received.reserve(BatchedUDPHandle::BatchSize);
+
+    s->wakeup = s->loop->resource<uvw::AsyncHandle>();
+    s->wakeup->on<uvw::AsyncEvent>([s](const auto&, auto& wakeup) {
+      if (s->stopping)
+      {
+        // with no handles left open the loop returns from run()
+        s->socket->close();
+        s->handoff->close();
+        wakeup.close();
+        return;
+      }
+      if (s->dirty.exchange(false))
+        s->socket->flush();
+    });
+    s->handoff = s->loop->resource<uvw::CheckHandle>();
+    s->handoff->on<uvw::CheckEvent>([this, s](const auto&, auto&) { HandOff(*s); });
+    s->handoff->start();
+
+    s->thread = std::thread{[s, idx] {
+      util::SetThreadName("llarp-udp" + std::to_string(idx));
+      s->loop->run();
+      s->loop->close();
+    }};
+    m_Shards.emplace_back(std::move(shard));
+    return true;
+  }
+
+  void
+  ShardedUDPHandle::HandOff(Shard& shard)
+  {
+    if (shard.received.empty())
+      return;
+    const auto count = shard.received.size();
+    if (m_Inbox.tryPushBack(std::move(shard.received)) == thread::QueueReturn::Success)
+      m_InboxWakeup->send();
+    else
+      shard.dropped += count;
+    shard.received.clear();
+    shard.received.reserve(BatchedUDPHandle::BatchSize);
+  }
+
+  void
+  ShardedUDPHandle::DrainInbox()
+  {
+    // only what is there now; batches that land while we work trigger another wakeup
+    for (auto pending = m_Inbox.size(); pending > 0; --pending)
+    {
+      auto batch = m_Inbox.tryPopFront();
+      if (not batch)
+        return;
+      for (auto& [from, pkt] : *batch)
+        m_OnPacket(*this, std::move(from), std::move(pkt));
+    }
+  }
+
+  size_t
+  ShardedUDPHandle::ShardFor(const SockAddr& dest) const
+  {
+    if (m_Shards.empty())
+      return 0;
+    // SockAddr::Hash shifts the port up past the low bits, so mix them back down or every
+    // remote behind one ip would send through the same socket
+    const uint64_t hash = SockAddr::Hash{}(dest) * 0x9E3779B97F4A7C15ULL;
+    return (hash >> 32) % (m_Shards.size() + 1);
+  }
+
+  bool
+  ShardedUDPHandle::send(const SockAddr& dest, const llarp_buffer_t& buf)
+  {
+    return m_Socket.send(dest, buf);
+  }
+
+  bool
+  ShardedUDPHandle::queue_send(const SockAddr& dest, const llarp_buffer_t& buf)
+  {
+    const auto idx = ShardFor(dest);
+    if (idx == 0)
+      return m_Socket.queue_send(dest, buf);
+    auto& shard = *m_Shards[idx - 1];
+    if (not shard.socket->queue_send(dest, buf))
+      return false;
+    shard.dirty = true;
+    return true;
+  }
+
+  void
+  ShardedUDPHandle::flush()
+  {
+    m_Socket.flush();
+    for (const auto& shard : m_Shards)
+    {
+      if (shard->dirty)
+        shard->wakeup->send();
+    }
+  }
+
+  void
+  ShardedUDPHandle::Stop()
+  {
+    for (const auto& shard : m_Shards)
+    {
+      shard->stopping = true;
+      shard->wakeup->send();
+    }
+    for (const auto& shard : m_Shards)
+    {
+      if (shard->thread.joinable())
+        shard->thread.join();
+    }
+    m_Shards.clear();
+  }
+
+  void
+  ShardedUDPHandle::close()
+  {
+    Stop();
+    m_Socket.close();
+    if (m_InboxWakeup)
+    {
+      m_InboxWakeup->close();
+      m_InboxWakeup.reset();
+    }
+    m_Inbox.removeAll();
+  }
+
+  util::StatusObject
+  ShardedUDPHandle::ExtractStatus() const
+  {
+    // m_Shards only changes on the owning loop, which is where we are; what the shards count on
+    // their own threads is atomic and may just lag a little
+    std::vector<util::StatusObject> loops{m_Socket.ExtractStatus()};
+    uint64_t dropped = 0;
+    for (const auto& shard : m_Shards)
+    {
+      loops.emplace_back(shard->socket->ExtractStatus());
+      dropped += shard->dropped;
+    }
+    return util::StatusObject{
+        {"batched", true},
+        {"loops", loops},
+        {"inboxDepth", m_Inbox.size()},
+        {"dropped", dropped}};
+  }
+}  // namespace llarp::uv
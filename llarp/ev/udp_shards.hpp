@@ -0,0 +1,114 @@
+#pragma once
+#ifdef __linux__
+#include "udp_batch.hpp"
+#include <llarp/util/thread/queue.hpp>
+
+#include <uvw/async.h>
+#include <uvw/check.h>
+#include <uvw/loop.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace llarp::uv
+{
+  /// udp handle whose datagram i/o is spread over several event loops.
+  ///
+  /// every loop, the owning one included, has its own batched socket bound to the same address
+  /// with SO_REUSEPORT, so the kernel hashes each remote onto one socket and a remote's datagrams
+  /// always come in on the same loop, in order.  the extra loops run on their own threads and do
+  /// nothing but move datagrams: what they read is handed to the owning loop a batch at a time
+  /// through a lock-free queue, and sends are spread over their sockets by destination so the
+  /// sendmmsg calls happen on their threads too.  the receive handler only ever runs on the
+  /// owning loop.
+  class ShardedUDPHandle final : public llarp::UDPHandle
+  {
+   public:
+    /// most receive batches that may wait for the owning loop before the shards start dropping
+    static constexpr size_t InboxSize = 1024;
+
+    /// `loops` counts the owning loop, so loops - 1 threads are started on listen()
+    ShardedUDPHandle(uvw::Loop& loop, size_t loops, EventLoop::UDPPacketReceiveFunc rf);
+
+    ~ShardedUDPHandle() override;
+
+    bool
+    listen(const SockAddr& addr) override;
+
+    bool
+    send(const SockAddr& dest, const llarp_buffer_t& buf) override;
+
+    /// thread safe; the datagram goes out on the socket its destination hashes to
+    bool
+    queue_send(const SockAddr& dest, const llarp_buffer_t& buf) override;
+
+    void
+    flush() override;
+
+    void
+    close() override;
+
+    std::optional<int>
+    file_descriptor() override
+    {
+      return m_Socket.file_descriptor();
+    }
+
+    /// must be called from the owning loop, as the router's status is
+    util::StatusObject
+    ExtractStatus() const override;
+
+    /// stop and join the shard threads, idempotent; must be called from the owning loop
+    void
+    Stop();
+
+   private:
+    using Received = std::vector<std::pair<SockAddr, PacketBuffer>>;
+
+    struct Shard
+    {
+      std::shared_ptr<uvw::Loop> loop;
+      std::unique_ptr<BatchedUDPHandle> socket;
+      /// flushes the socket, or tears the shard down once stopping is set
+      std::shared_ptr<uvw::AsyncHandle> wakeup;
+      /// hands what the socket read this iteration to the owning loop
+      std::shared_ptr<uvw::CheckHandle> handoff;
+      /// read since the last handoff; only touched on the shard's thread
+      Received received;
+      std::atomic<bool> dirty{false};
+      std::atomic<bool> stopping{false};
+      /// datagrams dropped because the owning loop's inbox was full
+      std::atomic<uint64_t> dropped{0};
+      std::thread thread;
+    };
+
+    /// set up shard idx listening on addr; called on the owning loop before its thread starts
+    bool
+    StartShard(size_t idx, const SockAddr& addr);
+
+    /// push what a shard read this iteration to the inbox; runs on the shard's thread
+    void
+    HandOff(Shard& shard);
+
+    /// feed everything the shards handed over to the receive handler; runs on the owning loop
+    void
+    DrainInbox();
+
+    /// the socket sends to dest go out on, 0 being the owning loop's own
+    size_t
+    ShardFor(const SockAddr& dest) const;
+
+    uvw::Loop& m_Loop;
+    const size_t m_NumLoops;
+    const EventLoop::UDPPacketReceiveFunc m_OnPacket;
+    /// the owning loop's own socket
+    BatchedUDPHandle m_Socket;
+    std::vector<std::unique_ptr<Shard>> m_Shards;
+    thread::Queue<Received> m_Inbox;
+    std::shared_ptr<uvw::AsyncHandle> m_InboxWakeup;
+  };
+}  // namespace llarp::uv
+#endif
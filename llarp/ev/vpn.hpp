@@ -29,6 +29,12 @@ namespace llarp::vpn
     std::string ifname;
     huint32_t dnsaddr;
     std::set<InterfaceAddress> addrs;
+    /// number of packet queues to open, more than one spreads reading the interface over that
+    /// many threads where the platform supports it
+    size_t queues = 1;
+    /// exchange large tcp packets with the kernel and split and merge them ourselves, where the
+    /// platform supports it
+    bool offload = false;
   };
 
   /// a vpn network interface
@@ -53,10 +59,40 @@ namespace llarp::vpn
     virtual net::IPPacket
     ReadNextPacket() = 0;
 
-    /// write a packet to the interface
-    /// returns false if we dropped it
+    /// write a packet to the interface, which may hold on to it until the next Flush
+    /// returns false if we dropped it, or if held back packets written out with it were dropped
     virtual bool
     WritePacket(net::IPPacket pkt) = 0;
+
+    /// write out packets that WritePacket held back to write together, returns false if any of
+    /// them were dropped
+    virtual bool
+    Flush()
+    {
+      return true;
+    }
+
+    /// how many packet queues we read from, each with its own fd. queue 0 is PollFD().
+    virtual size_t
+    NumQueues() const
+    {
+      return 1;
+    }
+
+    /// get pollable fd for reading from one queue
+    virtual int
+    QueueFD(size_t /*queue*/) const
+    {
+      return PollFD();
+    }
+
+    /// read next ip packet from one queue, return an empty packet if there are none ready.
+    /// safe to call for different queues at the same time.
+    virtual net::IPPacket
+    ReadNextPacketFrom(size_t /*queue*/)
+    {
+      return ReadNextPacket();
+    }
   };
 
   /// a vpn platform
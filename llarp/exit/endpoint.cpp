@@ -1,5 +1,7 @@
 #include "endpoint.hpp"
 
+#include <algorithm>
+
 #include <llarp/handlers/exit.hpp>
 #include <llarp/path/path_context.hpp>
 #include <llarp/router/abstractrouter.hpp>
@@ -117,29 +119,27 @@ namespace llarp
       llarp::net::IPPacket pkt;
       if (!pkt.Load(buf.underlying))
         return false;
+      // the addresses are rewritten when the queue is flushed
+      huint128_t dst;
       if (pkt.IsV6() && m_Parent->SupportsV6())
       {
-        huint128_t dst;
         if (m_RewriteSource)
           dst = m_Parent->GetIfAddr();
         else
           dst = pkt.dstv6();
-        pkt.UpdateIPv6Address(m_IP, dst);
       }
       else if (pkt.IsV4() && !m_Parent->SupportsV6())
       {
-        huint32_t dst;
         if (m_RewriteSource)
-          dst = net::TruncateV6(m_Parent->GetIfAddr());
+          dst = m_Parent->GetIfAddr();
         else
-          dst = pkt.dstv4();
-        pkt.UpdateIPv4Address(xhtonl(net::TruncateV6(m_IP)), xhtonl(dst));
+          dst = net::ExpandV4(pkt.dstv4());
       }
       else
       {
         return false;
       }
-      m_UpstreamQueue.emplace(pkt, counter);
+      m_UpstreamQueue.emplace_back(pkt, counter, m_IP, dst);
       m_TxRate += buf.underlying.sz;
       m_LastActive = m_Parent->Now();
       return true;
@@ -187,11 +187,18 @@ namespace llarp
     Endpoint::Flush()
     {
       // flush upstream queue
-      while (m_UpstreamQueue.size())
+      const auto highestFirst = [](const auto& left, const auto& right) {
+        return right < left;
+      };
+      if (not std::is_sorted(m_UpstreamQueue.begin(), m_UpstreamQueue.end(), highestFirst))
+        std::stable_sort(m_UpstreamQueue.begin(), m_UpstreamQueue.end(), highestFirst);
+      net::AddressRewriter rewriter;
+      for (auto& item : m_UpstreamQueue)
       {
-        m_Parent->QueueOutboundTraffic(m_UpstreamQueue.top().pkt);
-        m_UpstreamQueue.pop();
+        rewriter.Rewrite(item.pkt, item.src, item.dst);
+        m_Parent->QueueOutboundTraffic(std::move(item.pkt));
       }
+      m_UpstreamQueue.clear();
       // flush downstream queue
       auto path = GetCurrentPath();
       bool sent = path != nullptr;
@@ -5,7 +5,8 @@
 #include <llarp/path/path.hpp>
 #include <llarp/util/time.hpp>
 
-#include <queue>
+#include <deque>
+#include <vector>
 
 namespace llarp
 {
@@ -122,11 +123,14 @@ namespace llarp
 
       struct UpstreamBuffer
       {
-        UpstreamBuffer(const llarp::net::IPPacket& p, uint64_t c) : pkt(p), counter(c)
+        UpstreamBuffer(const llarp::net::IPPacket& p, uint64_t c, huint128_t s, huint128_t d)
+            : pkt(p), counter(c), src(s), dst(d)
         {}
 
         llarp::net::IPPacket pkt;
         uint64_t counter;
+        /// the addresses pkt is rewritten to when it is flushed
+        huint128_t src, dst;
 
         bool
         operator<(const UpstreamBuffer& other) const
@@ -135,7 +139,8 @@ namespace llarp
         }
       };
 
-      using UpstreamQueue_t = std::priority_queue<UpstreamBuffer>;
+      /// flushed highest counter first
+      using UpstreamQueue_t = std::vector<UpstreamBuffer>;
       UpstreamQueue_t m_UpstreamQueue;
       uint64_t m_Counter;
     };
@@ -1,5 +1,6 @@
 #include "exit.hpp"
 
+#include <llarp/crypto/crypto.hpp>
 #include <llarp/dns/dns.hpp>
 #include <llarp/net/net.hpp>
 #include <llarp/path/path_context.hpp>
@@ -7,7 +8,6 @@
 #include <llarp/util/str.hpp>
 #include <llarp/util/bits.hpp>
 
-#include <cassert>
 
 namespace llarp
 {
@@ -17,6 +17,7 @@ namespace llarp
         : m_Router(r)
         , m_Resolver(std::make_shared<dns::Proxy>(r->loop(), this))
         , m_Name(std::move(name))
+        , m_Addrs{llarp::randint()}
         , m_LocalResolverAddr("127.0.0.1", 53)
         , m_InetToNetwork(name + "_exit_rx", r->loop(), r->loop())
 
@@ -84,10 +85,10 @@ namespace llarp
         }
         else
         {
-          auto itr = m_IPToKey.find(ip);
-          if (itr != m_IPToKey.end() && m_SNodeKeys.find(itr->second) != m_SNodeKeys.end())
+          const auto* entry = m_Addrs.FindByIP(ip);
+          if (entry && entry->snode)
           {
-            RouterID them = itr->second;
+            RouterID them{entry->remote.as_array()};
             msg.AddAReply(them.ToString());
           }
           else
@@ -150,9 +151,10 @@ namespace llarp
           {
             // we do not have it mapped, async obtain it
             ObtainSNodeSession(r, [&](std::shared_ptr<exit::BaseSession> session) {
-              if (session && session->IsReady())
+              const auto* entry = m_Addrs.FindByRemote(pubKey);
+              if (session && session->IsReady() && entry)
               {
-                msg.AddINReply(m_KeyToIP[pubKey], isV6);
+                msg.AddINReply(entry->ip, isV6);
               }
               else
               {
@@ -165,10 +167,9 @@ namespace llarp
           else
           {
             // we have it mapped already as a service node
-            auto itr = m_KeyToIP.find(pubKey);
-            if (itr != m_KeyToIP.end())
+            if (const auto* entry = m_Addrs.FindByRemote(pubKey))
             {
-              ip = itr->second;
+              ip = entry->ip;
               msg.AddINReply(ip, isV6);
             }
             else  // fallback case that should never happen (probably)
@@ -216,18 +217,20 @@ namespace llarp
     {
       m_InetToNetwork.Process([&](Pkt_t& pkt) {
         PubKey pk;
+        bool snode;
         {
-          auto itr = m_IPToKey.find(pkt.dstv6());
-          if (itr == m_IPToKey.end())
+          const auto* entry = m_Addrs.FindByIP(pkt.dstv6());
+          if (entry == nullptr)
           {
             // drop
             LogWarn(Name(), " dropping packet, has no session at ", pkt.dstv6());
             return;
           }
-          pk = itr->second;
+          pk = PubKey{entry->remote};
+          snode = entry->snode;
         }
         // check if this key is a service node
-        if (m_SNodeKeys.find(pk) != m_SNodeKeys.end())
+        if (snode)
         {
           // check if it's a service node session we made and queue it via our
           // snode session that we made otherwise use an inbound session that
@@ -287,6 +290,8 @@ namespace llarp
           ++itr;
         }
       }
+      if (m_NetIf)
+        m_NetIf->Flush();
       m_Router->PumpLL();
     }
 
@@ -296,14 +301,14 @@ namespace llarp
       // map our address
       const PubKey us(m_Router->pubkey());
       const huint128_t ip = GetIfAddr();
-      m_KeyToIP[us] = ip;
-      m_IPToKey[ip] = us;
-      m_IPActivity[ip] = std::numeric_limits<llarp_time_t>::max();
       m_SNodeKeys.insert(us);
+      m_Addrs.Map(ip, us, true).lastActive = llarp_time_t::max();
       if (m_ShouldInitTun)
       {
         vpn::InterfaceInfo info;
         info.ifname = m_ifname;
+        info.queues = m_TunQueues;
+        info.offload = m_TunOffload;
         info.addrs.emplace(m_OurRange);
 
         m_NetIf = GetRouter()->GetVPNPlatform()->ObtainInterface(std::move(info));
@@ -359,66 +364,35 @@ namespace llarp
     bool
     ExitEndpoint::HasLocalMappedAddrFor(const PubKey& pk) const
     {
-      return m_KeyToIP.find(pk) != m_KeyToIP.end();
+      return m_Addrs.FindByRemote(pk) != nullptr;
     }
 
     huint128_t
     ExitEndpoint::GetIPForIdent(const PubKey pk)
     {
-      huint128_t found = {0};
-      if (!HasLocalMappedAddrFor(pk))
+      auto* entry = m_Addrs.FindByRemote(pk);
+      if (entry == nullptr)
       {
         // allocate and map
-        found.h = AllocateNewAddress().h;
-        if (!m_KeyToIP.emplace(pk, found).second)
+        entry = m_Addrs.Allocate(pk, false);
+        if (entry == nullptr)
         {
-          LogError(Name(), "failed to map ", pk, " to ", found);
-          return found;
+          // kick the least active ident off the exit and take its address
+          // TODO: DoS
+          if (const auto* oldest = m_Addrs.LeastActive())
+            KickIdentOffExit(PubKey{oldest->remote});
+          entry = m_Addrs.Allocate(pk, false);
         }
-        if (!m_IPToKey.emplace(found, pk).second)
+        if (entry == nullptr)
         {
-          LogError(Name(), "failed to map ", found, " to ", pk);
-          return found;
+          LogError(Name(), " failed to map ", pk, ", no free addresses");
+          return huint128_t{0};
         }
-        if (HasLocalMappedAddrFor(pk))
-          LogInfo(Name(), " mapping ", pk, " to ", found);
-        else
-          LogError(Name(), "failed to map ", pk, " to ", found);
+        LogInfo(Name(), " mapping ", pk, " to ", entry->ip);
       }
-      else
-        found.h = m_KeyToIP[pk].h;
-
-      MarkIPActive(found);
-      m_KeyToIP.rehash(0);
-      assert(HasLocalMappedAddrFor(pk));
-      return found;
-    }
-
-    huint128_t
-    ExitEndpoint::AllocateNewAddress()
-    {
-      if (m_NextAddr < m_HigestAddr)
-        return ++m_NextAddr;
-
-      // find oldest activity ip address
-      huint128_t found = {0};
-      llarp_time_t min = std::numeric_limits<llarp_time_t>::max();
-      auto itr = m_IPActivity.begin();
-      while (itr != m_IPActivity.end())
-      {
-        if (itr->second < min)
-        {
-          found.h = itr->first.h;
-          min = itr->second;
-        }
-        ++itr;
-      }
-      // kick old ident off exit
-      // TODO: DoS
-      PubKey pk = m_IPToKey[found];
-      KickIdentOffExit(pk);
-
-      return found;
+      entry->snode = m_SNodeKeys.count(pk) != 0;
+      entry->lastActive = GetRouter()->Now();
+      return entry->ip;
     }
 
     bool
@@ -431,21 +405,13 @@ namespace llarp
     ExitEndpoint::KickIdentOffExit(const PubKey& pk)
     {
       LogInfo(Name(), " kicking ", pk, " off exit");
-      huint128_t ip = m_KeyToIP[pk];
-      m_KeyToIP.erase(pk);
-      m_IPToKey.erase(ip);
+      m_Addrs.EraseRemote(pk);
       auto range = m_ActiveExits.equal_range(pk);
       auto exit_itr = range.first;
       while (exit_itr != range.second)
         exit_itr = m_ActiveExits.erase(exit_itr);
     }
 
-    void
-    ExitEndpoint::MarkIPActive(huint128_t ip)
-    {
-      m_IPActivity[ip] = GetRouter()->Now();
-    }
-
     void
     ExitEndpoint::OnInetPacket(net::IPPacket pkt)
     {
@@ -537,11 +503,12 @@ namespace llarp
       const auto host_str = m_OurRange.BaseAddressString();
       // string, or just a plain char array?
       m_IfAddr = m_OurRange.addr;
-      m_NextAddr = m_IfAddr;
-      m_HigestAddr = m_OurRange.HighestAddr();
+      m_Addrs.SetRange(m_IfAddr + huint128_t{1}, m_OurRange.HighestAddr());
       m_UseV6 = not m_OurRange.IsV4();
 
       m_ifname = networkConfig.m_ifname;
+      m_TunQueues = networkConfig.m_tunQueues;
+      m_TunOffload = networkConfig.m_tunOffload;
       if (m_ifname.empty())
       {
         const auto maybe = llarp::FindFreeTun();
@@ -564,8 +531,9 @@ namespace llarp
       if (pubKey == us)
         return m_IfAddr;
 
+      const bool isNew = m_SNodeKeys.emplace(pubKey).second;
       huint128_t ip = GetIPForIdent(pubKey);
-      if (m_SNodeKeys.emplace(pubKey).second)
+      if (isNew)
       {
         auto session = std::make_shared<exit::SNodeSession>(
             other,
@@ -586,13 +554,13 @@ namespace llarp
     {
       if (wantInternet && !m_PermitExit)
         return false;
-      auto ip = GetIPForIdent(pk);
       if (GetRouter()->pathContext().TransitHopPreviousIsRouter(path, pk.as_array()))
       {
         // we think this path belongs to a service node
         // mark it as such so we don't make an outbound session to them
         m_SNodeKeys.emplace(pk.as_array());
       }
+      auto ip = GetIPForIdent(pk);
       m_ActiveExits.emplace(
           pk, std::make_unique<exit::Endpoint>(pk, path, !wantInternet, ip, this));
 
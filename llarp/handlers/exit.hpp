@@ -3,6 +3,7 @@
 #include <llarp/exit/endpoint.hpp>
 #include "tun.hpp"
 #include <llarp/dns/server.hpp>
+#include <llarp/net/address_table.hpp>
 #include <unordered_map>
 
 namespace llarp
@@ -108,9 +109,6 @@ namespace llarp
       huint128_t
       GetIPForIdent(const PubKey pk);
 
-      huint128_t
-      AllocateNewAddress();
-
       /// obtain ip for service node session, creates a new session if one does
       /// not existing already
       huint128_t
@@ -123,9 +121,6 @@ namespace llarp
       bool
       QueueSNodePacket(const llarp_buffer_t& buf, huint128_t from);
 
-      void
-      MarkIPActive(huint128_t ip);
-
       void
       KickIdentOffExit(const PubKey& pk);
 
@@ -140,9 +135,9 @@ namespace llarp
 
       std::unordered_multimap<PubKey, std::unique_ptr<exit::Endpoint>, PubKey::Hash> m_ActiveExits;
 
-      using KeyMap_t = std::unordered_map<PubKey, huint128_t, PubKey::Hash>;
-
-      KeyMap_t m_KeyToIP;
+      /// maps key to ip and ip to key, with whether the key is a service node and when the ip
+      /// was last active
+      net::AddressTable m_Addrs;
 
       using SNodes_t = std::set<PubKey>;
       /// set of pubkeys we treat as snodes
@@ -153,16 +148,11 @@ namespace llarp
       /// snode sessions we are talking to directly
       SNodeSessions_t m_SNodeSessions;
 
-      std::unordered_map<huint128_t, PubKey> m_IPToKey;
-
       huint128_t m_IfAddr;
-      huint128_t m_HigestAddr;
-
-      huint128_t m_NextAddr;
       IPRange m_OurRange;
       std::string m_ifname;
-
-      std::unordered_map<huint128_t, llarp_time_t> m_IPActivity;
+      size_t m_TunQueues = 1;
+      bool m_TunOffload = false;
 
       std::shared_ptr<vpn::NetworkInterface> m_NetIf;
 
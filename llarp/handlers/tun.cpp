@@ -9,6 +9,7 @@
 #include <netdb.h>
 #endif
 
+#include <llarp/crypto/crypto.hpp>
 #include <llarp/dns/dns.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/router/abstractrouter.hpp>
@@ -32,6 +33,9 @@ namespace llarp
   {
     constexpr size_t udp_header_size = 8;
 
+    /// how long the dns server may give out an address we mapped without asking us again
+    constexpr auto dns_reply_cache_lifetime = 10s;
+
     // Intercepts DNS IP packets going to an IP on the tun interface; this is currently used on
     // Android where binding to a DNS port (i.e. via llarp::dns::Proxy) isn't possible because of OS
     // restrictions, but a tun interface *is* available.
@@ -87,6 +91,7 @@ namespace llarp
     TunEndpoint::TunEndpoint(AbstractRouter* r, service::Context* parent)
         : service::Endpoint(r, parent)
         , m_UserToNetworkPktQueue("endpoint_sendq", r->loop(), r->loop())
+        , m_Addrs{llarp::randint()}
     {
       m_PacketRouter.reset(
           new vpn::PacketRouter{[&](net::IPPacket pkt) { HandleGotUserPacket(std::move(pkt)); }});
@@ -125,22 +130,20 @@ namespace llarp
       obj["ustreamResolvers"] = resolvers;
       obj["localResolver"] = m_LocalResolverAddr.toString();
       util::StatusObject ips{};
-      for (const auto& item : m_IPActivity)
-      {
-        util::StatusObject ipObj{{"lastActive", to_json(item.second)}};
+      m_Addrs.ForEach([&ips](const net::AddressEntry& entry) {
+        util::StatusObject ipObj{{"lastActive", to_json(entry.lastActive)}};
         std::string remoteStr;
-        AlignedBuffer<32> addr = m_IPToAddr.at(item.first);
-        if (m_SNodes.at(addr))
-          remoteStr = RouterID(addr.as_array()).ToString();
+        if (entry.snode)
+          remoteStr = RouterID(entry.remote.as_array()).ToString();
         else
-          remoteStr = service::Address(addr.as_array()).ToString();
+          remoteStr = service::Address(entry.remote.as_array()).ToString();
         ipObj["remote"] = remoteStr;
-        std::string ipaddr = item.first.ToString();
+        std::string ipaddr = entry.ip.ToString();
         ips[ipaddr] = ipObj;
-      }
+      });
       obj["addrs"] = ips;
       obj["ourIP"] = m_OurIP.ToString();
-      obj["nextIP"] = m_NextIP.ToString();
+      obj["nextIP"] = m_Addrs.NextIP().ToString();
       obj["maxIP"] = m_MaxIP.ToString();
       return obj;
     }
@@ -240,6 +243,8 @@ namespace llarp
       }
 
       m_IfName = conf.m_ifname;
+      m_TunQueues = conf.m_tunQueues;
+      m_TunOffload = conf.m_tunOffload;
       if (m_IfName.empty())
       {
         const auto maybe = llarp::FindFreeTun();
@@ -267,7 +272,7 @@ namespace llarp
     bool
     TunEndpoint::HasLocalIP(const huint128_t& ip) const
     {
-      return m_IPToAddr.find(ip) != m_IPToAddr.end();
+      return m_Addrs.FindByIP(ip) != nullptr;
     }
 
     void
@@ -276,11 +281,17 @@ namespace llarp
       FlushSend();
       Pump(Now());
       // flush network to user
-      while (not m_NetworkToUserPktQueue.empty())
+      auto& queue = m_NetworkToUserPktQueue;
+      if (not std::is_sorted(queue.begin(), queue.end()))
+        std::stable_sort(queue.begin(), queue.end());
+      net::AddressRewriter rewriter;
+      for (auto& write : queue)
       {
-        m_NetIf->WritePacket(m_NetworkToUserPktQueue.top().pkt);
-        m_NetworkToUserPktQueue.pop();
+        rewriter.Rewrite(write.pkt, write.src, write.dst);
+        m_NetIf->WritePacket(std::move(write.pkt));
       }
+      queue.clear();
+      m_NetIf->Flush();
     }
 
     static bool
@@ -299,10 +310,10 @@ namespace llarp
     bool
     TunEndpoint::FindAddrForIP(service::Address& addr, huint128_t ip)
     {
-      auto itr = m_IPToAddr.find(ip);
-      if (itr != m_IPToAddr.end() and not m_SNodes[itr->second])
+      const auto* entry = m_Addrs.FindByIP(ip);
+      if (entry and not entry->snode)
       {
-        addr = service::Address(itr->second.as_array());
+        addr = service::Address(entry->remote.as_array());
         return true;
       }
       return false;
@@ -312,10 +323,10 @@ namespace llarp
     bool
     TunEndpoint::FindAddrForIP(RouterID& addr, huint128_t ip)
     {
-      auto itr = m_IPToAddr.find(ip);
-      if (itr != m_IPToAddr.end() and m_SNodes[itr->second])
+      const auto* entry = m_Addrs.FindByIP(ip);
+      if (entry and entry->snode)
       {
-        addr = RouterID(itr->second.as_array());
+        addr = RouterID(entry->remote.as_array());
         return true;
       }
       return false;
@@ -692,6 +703,27 @@ namespace llarp
       return true;
     }
 
+    llarp_time_t
+    TunEndpoint::ReplyCacheLifetime(const dns::Message& reply) const
+    {
+      // only a/aaaa replies with an address we mapped, which stays true until the mapping goes
+      // away and we clear the cache; random.snode and localhost.loki can change under us
+      if (reply.questions.size() != 1 or reply.answers.empty())
+        return 0s;
+      const auto& question = reply.questions[0];
+      if (question.qtype != dns::qTypeA and question.qtype != dns::qTypeAAAA)
+        return 0s;
+      if ((reply.hdr_fields & 0xf) != dns::flags_RCODENoError)
+        return 0s;
+      if (not(question.HasTLD(".loki") or question.HasTLD(".snode")))
+        return 0s;
+      if (is_random_snode(reply) or is_localhost_loki(reply))
+        return 0s;
+      if (reply.answers.back().rr_type != question.qtype)
+        return 0s;
+      return dns_reply_cache_lifetime;
+    }
+
     void
     TunEndpoint::ResetInternalState()
     {
@@ -739,19 +771,19 @@ namespace llarp
     bool
     TunEndpoint::MapAddress(const service::Address& addr, huint128_t ip, bool SNode)
     {
-      auto itr = m_IPToAddr.find(ip);
-      if (itr != m_IPToAddr.end())
+      if (const auto* entry = m_Addrs.FindByIP(ip))
       {
         llarp::LogWarn(
-            ip, " already mapped to ", service::Address(itr->second.as_array()).ToString());
+            ip, " already mapped to ", service::Address(entry->remote.as_array()).ToString());
         return false;
       }
       llarp::LogInfo(Name() + " map ", addr.ToString(), " to ", ip);
 
-      m_IPToAddr[ip] = addr;
-      m_AddrToIP[addr] = ip;
-      m_SNodes[addr] = SNode;
+      m_Addrs.Map(ip, addr, SNode);
       MarkIPActiveForever(ip);
+      // the remote may have had another address before
+      if (m_Resolver)
+        m_Resolver->ClearReplyCache();
       return true;
     }
 
@@ -786,8 +818,9 @@ namespace llarp
     bool
     TunEndpoint::SetupTun()
     {
-      m_NextIP = m_OurIP;
       m_MaxIP = m_OurRange.HighestAddr();
+      // we hand out the addresses between ours and the highest one in the range
+      m_Addrs.SetRange(m_OurIP + huint128_t{1}, m_MaxIP - huint128_t{1});
       llarp::LogInfo(Name(), " set ", m_IfName, " to have address ", m_OurIP);
       llarp::LogInfo(Name(), " allocated up to ", m_MaxIP, " on range ", m_OurRange);
 
@@ -806,6 +839,8 @@ namespace llarp
       info.addrs.emplace(v6range, AF_INET6);
 
       info.ifname = m_IfName;
+      info.queues = m_TunQueues;
+      info.offload = m_TunOffload;
       info.dnsaddr.FromString(m_LocalResolverAddr.toHost());
 
       LogInfo(Name(), " setting up network...");
@@ -921,12 +956,12 @@ namespace llarp
         if (dst == ipv6_multicast_all_nodes and m_state->m_ExitEnabled)
         {
           // send ipv6 multicast
-          for (const auto& [ip, addr] : m_IPToAddr)
-          {
-            (void)ip;
+          m_Addrs.ForEach([&](const net::AddressEntry& entry) {
             SendToServiceOrQueue(
-                service::Address{addr.as_array()}, pkt.ConstBuffer(), service::eProtocolExit);
-          }
+                service::Address{entry.remote.as_array()},
+                pkt.ConstBuffer(),
+                service::eProtocolExit);
+          });
           return;
         }
 
@@ -935,11 +970,11 @@ namespace llarp
         {
           dst = net::ExpandV4(net::TruncateV6(dst));
         }
-        auto itr = m_IPToAddr.find(dst);
-        if (itr == m_IPToAddr.end())
+        const auto* entry = m_Addrs.FindByIP(dst);
+        if (entry == nullptr)
         {
-          const auto exits = m_ExitMap.FindAll(dst);
-          if (IsBogon(dst) or exits.empty())
+          const auto exit = m_ExitMap.FindLongest(dst);
+          if (IsBogon(dst) or not exit)
           {
             // send icmp unreachable
             const auto icmp = pkt.MakeICMPUnreachable();
@@ -950,7 +985,7 @@ namespace llarp
           }
           else
           {
-            const auto addr = *exits.begin();
+            const auto addr = *exit;
             pkt.ZeroSourceAddress();
             MarkAddressOutbound(addr);
             EnsurePathToService(
@@ -967,12 +1002,12 @@ namespace llarp
           return;
         }
         bool rewriteAddrs = true;
-        if (m_SNodes.at(itr->second))
+        if (entry->snode)
         {
           sendFunc = std::bind(
               &TunEndpoint::SendToSNodeOrQueue,
               this,
-              itr->second.as_array(),
+              entry->remote.as_array(),
               std::placeholders::_1);
         }
         else if (m_state->m_ExitEnabled and src != m_OurIP)
@@ -981,7 +1016,7 @@ namespace llarp
           sendFunc = std::bind(
               &TunEndpoint::SendToServiceOrQueue,
               this,
-              service::Address(itr->second.as_array()),
+              service::Address(entry->remote.as_array()),
               std::placeholders::_1,
               service::eProtocolExit);
         }
@@ -990,7 +1025,7 @@ namespace llarp
           sendFunc = std::bind(
               &TunEndpoint::SendToServiceOrQueue,
               this,
-              service::Address(itr->second.as_array()),
+              service::Address(entry->remote.as_array()),
               std::placeholders::_1,
               pkt.ServiceProtocol());
         }
@@ -1066,8 +1101,7 @@ namespace llarp
           src = pkt.srcv6();
         }
         // find what exit we think this should be for
-        const auto mapped = m_ExitMap.FindAll(src);
-        if (mapped.count(service::Address{addr}) == 0 or IsBogon(src))
+        if (not m_ExitMap.Matches(src, service::Address{addr}) or IsBogon(src))
         {
           // we got exit traffic from someone who we should not have gotten it from
           return false;
@@ -1090,21 +1124,14 @@ namespace llarp
       ManagedBuffer buf(b);
       WritePacket write;
       write.seqno = seqno;
-      auto& pkt = write.pkt;
-      // load
-      if (!pkt.Load(buf))
+      write.src = src;
+      write.dst = dst;
+      // load, the addresses are rewritten when the queue is flushed
+      if (!write.pkt.Load(buf))
       {
         return false;
       }
-      if (pkt.IsV4())
-      {
-        pkt.UpdateIPv4Address(xhtonl(net::TruncateV6(src)), xhtonl(net::TruncateV6(dst)));
-      }
-      else if (pkt.IsV6())
-      {
-        pkt.UpdateIPv6Address(src, dst);
-      }
-      m_NetworkToUserPktQueue.push(std::move(write));
+      m_NetworkToUserPktQueue.push_back(std::move(write));
       return true;
     }
 
@@ -1117,84 +1144,58 @@ namespace llarp
     huint128_t
     TunEndpoint::ObtainIPForAddr(const AlignedBuffer<32>& ident, bool snode)
     {
-      llarp_time_t now = Now();
-      huint128_t nextIP = {0};
+      const llarp_time_t now = Now();
+      // previously allocated address
+      if (auto* entry = m_Addrs.FindByRemote(ident))
       {
-        // previously allocated address
-        auto itr = m_AddrToIP.find(ident);
-        if (itr != m_AddrToIP.end())
-        {
-          // mark ip active
-          MarkIPActive(itr->second);
-          return itr->second;
-        }
+        entry->lastActive = std::max(entry->lastActive, now);
+        return entry->ip;
       }
       // allocate new address
-      if (m_NextIP < m_MaxIP)
-      {
-        do
-        {
-          nextIP = ++m_NextIP;
-        } while (m_IPToAddr.find(nextIP) != m_IPToAddr.end() && m_NextIP < m_MaxIP);
-        if (nextIP < m_MaxIP)
-        {
-          m_AddrToIP[ident] = nextIP;
-          m_IPToAddr[nextIP] = ident;
-          m_SNodes[ident] = snode;
-          llarp::LogInfo(Name(), " mapped ", ident, " to ", nextIP);
-          MarkIPActive(nextIP);
-          return nextIP;
-        }
-      }
-
-      // we are full
-      // expire least active ip
-      // TODO: prevent DoS
-      std::pair<huint128_t, llarp_time_t> oldest = {huint128_t{0}, 0s};
-
-      // find oldest entry
-      auto itr = m_IPActivity.begin();
-      while (itr != m_IPActivity.end())
+      auto* entry = m_Addrs.Allocate(ident, snode);
+      if (entry == nullptr)
       {
-        if (itr->second <= now)
+        // we are full
+        // expire least active ip
+        // TODO: prevent DoS
+        const auto* oldest = m_Addrs.LeastActive();
+        if (oldest == nullptr)
         {
-          if ((now - itr->second) > oldest.second)
-          {
-            oldest.first = itr->first;
-            oldest.second = itr->second;
-          }
+          llarp::LogError(Name(), " cannot map ", ident, ", every address is taken for good");
+          return huint128_t{0};
         }
-        ++itr;
+        const auto ip = oldest->ip;
+        m_Addrs.EraseIP(ip);
+        entry = &m_Addrs.Map(ip, ident, snode);
+        // cached dns replies may still hand out the old mapping
+        if (m_Resolver)
+          m_Resolver->ClearReplyCache();
       }
-      // remap address
-      m_IPToAddr[oldest.first] = ident;
-      m_AddrToIP[ident] = oldest.first;
-      m_SNodes[ident] = snode;
-      nextIP = oldest.first;
-
+      llarp::LogInfo(Name(), " mapped ", ident, " to ", entry->ip);
       // mark ip active
-      m_IPActivity[nextIP] = std::max(m_IPActivity[nextIP], now);
-
-      return nextIP;
+      entry->lastActive = now;
+      return entry->ip;
     }
 
     bool
     TunEndpoint::HasRemoteForIP(huint128_t ip) const
     {
-      return m_IPToAddr.find(ip) != m_IPToAddr.end();
+      return m_Addrs.FindByIP(ip) != nullptr;
     }
 
     void
     TunEndpoint::MarkIPActive(huint128_t ip)
     {
       llarp::LogDebug(Name(), " address ", ip, " is active");
-      m_IPActivity[ip] = std::max(Now(), m_IPActivity[ip]);
+      if (auto* entry = m_Addrs.FindByIP(ip))
+        entry->lastActive = std::max(Now(), entry->lastActive);
     }
 
     void
     TunEndpoint::MarkIPActiveForever(huint128_t ip)
     {
-      m_IPActivity[ip] = std::numeric_limits<llarp_time_t>::max();
+      if (auto* entry = m_Addrs.FindByIP(ip))
+        entry->lastActive = llarp_time_t::max();
     }
 
     void
@@ -3,6 +3,7 @@
 #include <llarp/dns/server.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/ev/vpn.hpp>
+#include <llarp/net/address_table.hpp>
 #include <llarp/net/ip.hpp>
 #include <llarp/net/ip_packet.hpp>
 #include <llarp/net/net.hpp>
@@ -12,7 +13,7 @@
 #include <llarp/vpn/packet_router.hpp>
 
 #include <future>
-#include <queue>
+#include <vector>
 
 namespace llarp
 {
@@ -62,6 +63,9 @@ namespace llarp
       HandleHookedDNSMessage(
           dns::Message query, std::function<void(dns::Message)> sendreply) override;
 
+      llarp_time_t
+      ReplyCacheLifetime(const dns::Message& reply) const override;
+
       void
       TickTun(llarp_time_t now);
 
@@ -126,10 +130,10 @@ namespace llarp
       ObtainAddrForIP(huint128_t ip, bool isSNode)
       {
         Addr_t addr;
-        auto itr = m_IPToAddr.find(ip);
-        if (itr != m_IPToAddr.end() and m_SNodes[itr->second] == isSNode)
+        const auto* entry = m_Addrs.FindByIP(ip);
+        if (entry and entry->snode == isSNode)
         {
-          addr = Addr_t(itr->second);
+          addr = Addr_t(entry->remote);
         }
         // found
         return addr;
@@ -142,7 +146,7 @@ namespace llarp
       bool
       HasAddress(const AlignedBuffer<32>& addr) const
       {
-        return m_AddrToIP.find(addr) != m_AddrToIP.end();
+        return m_Addrs.FindByRemote(addr) != nullptr;
       }
 
       /// get ip address for key unconditionally
@@ -171,16 +175,19 @@ namespace llarp
       {
         uint64_t seqno;
         net::IPPacket pkt;
+        /// the addresses pkt is rewritten to when it is flushed
+        huint128_t src, dst;
 
         bool
         operator<(const WritePacket& other) const
         {
-          return other.seqno < seqno;
+          return seqno < other.seqno;
         }
       };
 
-      /// queue for sending packets to user from network
-      std::priority_queue<WritePacket> m_NetworkToUserPktQueue;
+      /// queue for sending packets to user from network, written out in seqno order on flush with
+      /// their addresses rewritten then, so that a run of packets of one flow shares the work
+      std::vector<WritePacket> m_NetworkToUserPktQueue;
       /// return true if we have a remote loki address for this ip address
       bool
       HasRemoteForIP(huint128_t ipv4) const;
@@ -197,14 +204,9 @@ namespace llarp
       virtual void
       FlushSend();
 
-      /// maps ip to key (host byte order)
-      std::unordered_map<huint128_t, AlignedBuffer<32>> m_IPToAddr;
-      /// maps key to ip (host byte order)
-      std::unordered_map<AlignedBuffer<32>, huint128_t, AlignedBuffer<32>::Hash> m_AddrToIP;
-
-      /// maps key to true if key is a service node, maps key to false if key is
-      /// a hidden service
-      std::unordered_map<AlignedBuffer<32>, bool, AlignedBuffer<32>::Hash> m_SNodes;
+      /// maps ip to key and key to ip (host byte order), with whether the key is a service node
+      /// or a hidden service and when we last saw traffic for it
+      net::AddressTable m_Addrs;
 
      private:
       template <typename Addr_t, typename Endpoint_t>
@@ -230,15 +232,11 @@ namespace llarp
       /// our dns resolver
       std::shared_ptr<dns::PacketHandler> m_Resolver;
 
-      /// maps ip address to timestamp last active
-      std::unordered_map<huint128_t, llarp_time_t> m_IPActivity;
       /// our ip address (host byte order)
       huint128_t m_OurIP;
       /// our network interface's ipv6 address
       huint128_t m_OurIPv6;
 
-      /// next ip address to allocate (host byte order)
-      huint128_t m_NextIP;
       /// highest ip address to allocate (host byte order)
       huint128_t m_MaxIP;
       /// our ip range we are using
@@ -252,6 +250,10 @@ namespace llarp
       /// use v6?
       bool m_UseV6;
       std::string m_IfName;
+      /// number of tun queues, read on their own threads when more than one
+      size_t m_TunQueues = 1;
+      /// split and merge large tcp packets on the tun ourselves
+      bool m_TunOffload = false;
 
       std::shared_ptr<vpn::NetworkInterface> m_NetIf;
 
@@ -0,0 +1,179 @@
+#include "crypto_lanes.hpp"
+
+#include <llarp/util/logging/logger.hpp>
+#include <llarp/util/thread/threading.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace llarp::iwp
+{
+  /// never make more lanes than this when picking the number of lanes ourselves
+  static constexpr size_t MaxDefaultLanes = 8;
+
+  struct CryptoLanes::Lane
+  {
+    using Clock_t = std::chrono::steady_clock;
+
+    const size_t id;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::pair<Clock_t::time_point, Job_t>> jobs GUARDED_BY(mutex);
+    bool stopping GUARDED_BY(mutex) = false;
+    std::thread thread;
+
+    std::atomic<uint64_t> depth{0};
+    std::atomic<uint64_t> processed{0};
+    /// sum and max of time from queue to job completion, in microseconds
+    std::atomic<uint64_t> totalLatency{0};
+    std::atomic<uint64_t> maxLatency{0};
+
+    explicit Lane(size_t idx) : id{idx}
+    {
+      thread = std::thread{[this] { Run(); }};
+    }
+
+    void
+    Pin()
+    {
+#ifdef __linux__
+      const auto cores = std::max(1u, std::thread::hardware_concurrency());
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(id % cores, &set);
+      if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0)
+        LogWarn("failed to pin crypto lane ", id, " to core ", id % cores, ": ", strerror(rc));
+#endif
+    }
+
+    void
+    Run()
+    {
+      util::SetThreadName("llarp-crypto" + std::to_string(id));
+      Pin();
+      std::unique_lock lock{mutex};
+      while (true)
+      {
+        cv.wait(lock, [this] { return stopping or not jobs.empty(); });
+        if (jobs.empty())
+          return;
+        auto [queuedAt, job] = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        job();
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 Clock_t::now() - queuedAt)
+                                 .count();
+        depth--;
+        processed++;
+        totalLatency += latency;
+        uint64_t prev = maxLatency.load();
+        while (prev < uint64_t(latency) and not maxLatency.compare_exchange_weak(prev, latency))
+        {}
+        lock.lock();
+      }
+    }
+
+    void
+    Queue(Job_t job)
+    {
+      {
+        std::lock_guard lock{mutex};
+        if (stopping)
+          return;
+        jobs.emplace_back(Clock_t::now(), std::move(job));
+        depth++;
+      }
+      cv.notify_one();
+    }
+
+    void
+    Stop()
+    {
+      {
+        std::lock_guard lock{mutex};
+        stopping = true;
+      }
+      cv.notify_one();
+      if (thread.joinable())
+        thread.join();
+    }
+
+    util::StatusObject
+    ExtractStatus() const
+    {
+      const uint64_t done = processed.load();
+      return util::StatusObject{
+          {"lane", id},
+          {"queueDepth", depth.load()},
+          {"processed", done},
+          {"avgLatencyUS", done ? totalLatency.load() / done : 0},
+          {"maxLatencyUS", maxLatency.load()}};
+    }
+  };
+
+  CryptoLanes::CryptoLanes(size_t numLanes)
+  {
+    if (numLanes == 0)
+      numLanes = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, MaxDefaultLanes);
+    for (size_t idx = 0; idx < numLanes; ++idx)
+      m_Lanes.emplace_back(std::make_unique<Lane>(idx));
+    LogDebug("started ", numLanes, " iwp crypto lanes");
+  }
+
+  CryptoLanes::~CryptoLanes()
+  {
+    Stop();
+  }
+
+  size_t
+  CryptoLanes::NumLanes() const
+  {
+    return m_Lanes.size();
+  }
+
+  size_t
+  CryptoLanes::LaneFor(const SockAddr& remote) const
+  {
+    return SockAddr::Hash{}(remote) % m_Lanes.size();
+  }
+
+  void
+  CryptoLanes::Queue(size_t lane, Job_t job)
+  {
+    m_Lanes[lane % m_Lanes.size()]->Queue(std::move(job));
+  }
+
+  void
+  CryptoLanes::Stop()
+  {
+    for (auto& lane : m_Lanes)
+      lane->Stop();
+  }
+
+  util::StatusObject
+  CryptoLanes::ExtractLaneStatus(size_t lane) const
+  {
+    return m_Lanes[lane % m_Lanes.size()]->ExtractStatus();
+  }
+
+  util::StatusObject
+  CryptoLanes::ExtractStatus() const
+  {
+    std::vector<util::StatusObject> lanes;
+    for (const auto& lane : m_Lanes)
+      lanes.emplace_back(lane->ExtractStatus());
+    return util::StatusObject{{"lanes", lanes}};
+  }
+}  // namespace llarp::iwp
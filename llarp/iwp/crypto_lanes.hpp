@@ -0,0 +1,57 @@
+#pragma once
+
+#include <llarp/net/sock_addr.hpp>
+#include <llarp/util/status.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace llarp::iwp
+{
+  /// a fixed set of worker threads ("lanes") that do iwp packet crypto.
+  ///
+  /// every session hashes onto exactly one lane by its remote address, and a lane runs its jobs
+  /// one at a time in the order they were queued, so encrypt and decrypt batches of a session are
+  /// never reordered with respect to each other.  on linux each lane is pinned to one core.
+  class CryptoLanes
+  {
+   public:
+    using Job_t = std::function<void(void)>;
+
+    /// start numLanes lanes; 0 means pick a number based on the cores we have
+    explicit CryptoLanes(size_t numLanes = 0);
+
+    ~CryptoLanes();
+
+    CryptoLanes(const CryptoLanes&) = delete;
+    CryptoLanes&
+    operator=(const CryptoLanes&) = delete;
+
+    size_t
+    NumLanes() const;
+
+    /// the lane a session with this remote address uses for all of its crypto
+    size_t
+    LaneFor(const SockAddr& remote) const;
+
+    /// queue a job on a lane, jobs on the same lane run in order
+    void
+    Queue(size_t lane, Job_t job);
+
+    /// finish all queued jobs and stop the lane threads, idempotent
+    void
+    Stop();
+
+    /// queue depth and latency stats for one lane
+    util::StatusObject
+    ExtractLaneStatus(size_t lane) const;
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct Lane;
+    std::vector<std::unique_ptr<Lane>> m_Lanes;
+  };
+}  // namespace llarp::iwp
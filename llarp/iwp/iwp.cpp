@@ -20,7 +20,8 @@ namespace llarp
         TimeoutHandler timeout,
         SessionClosedHandler closed,
         PumpDoneHandler pumpDone,
-        WorkerFunc_t work)
+        WorkerFunc_t work,
+        std::shared_ptr<CryptoLanes> lanes)
     {
       return std::make_shared<LinkLayer>(
           keyManager,
@@ -35,7 +36,8 @@ namespace llarp
           closed,
           pumpDone,
           work,
-          true);
+          true,
+          std::move(lanes));
     }
 
     LinkLayer_ptr
@@ -51,7 +53,8 @@ namespace llarp
         TimeoutHandler timeout,
         SessionClosedHandler closed,
         PumpDoneHandler pumpDone,
-        WorkerFunc_t work)
+        WorkerFunc_t work,
+        std::shared_ptr<CryptoLanes> lanes)
     {
       return std::make_shared<LinkLayer>(
           keyManager,
@@ -66,7 +69,8 @@ namespace llarp
           closed,
           pumpDone,
           work,
-          false);
+          false,
+          std::move(lanes));
     }
   }  // namespace iwp
 }  // namespace llarp
@@ -20,7 +20,8 @@ namespace llarp::iwp
       TimeoutHandler timeout,
       SessionClosedHandler closed,
       PumpDoneHandler pumpDone,
-      WorkerFunc_t work);
+      WorkerFunc_t work,
+      std::shared_ptr<CryptoLanes> lanes = nullptr);
 
   LinkLayer_ptr
   NewOutboundLink(
@@ -35,6 +36,7 @@ namespace llarp::iwp
       TimeoutHandler timeout,
       SessionClosedHandler closed,
       PumpDoneHandler pumpDone,
-      WorkerFunc_t work);
+      WorkerFunc_t work,
+      std::shared_ptr<CryptoLanes> lanes = nullptr);
 
 }  // namespace llarp::iwp
@@ -19,13 +19,14 @@ namespace llarp::iwp
       SessionClosedHandler closed,
       PumpDoneHandler pumpDone,
       WorkerFunc_t worker,
-      bool allowInbound)
+      bool allowInbound,
+      std::shared_ptr<CryptoLanes> lanes)
       : ILinkLayer(
           keyManager, getrc, h, sign, before, est, reneg, timeout, closed, pumpDone, worker)
       , m_Wakeup{ev->make_waker([this]() { HandleWakeupPlaintext(); })}
       , m_PlaintextRecv{1024}
       , permitInbound{allowInbound}
-
+      , m_CryptoLanes{lanes ? std::move(lanes) : std::make_shared<CryptoLanes>()}
   {}
 
   const char*
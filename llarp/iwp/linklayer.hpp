@@ -6,6 +6,7 @@
 #include <llarp/crypto/types.hpp>
 #include <llarp/link/server.hpp>
 #include <llarp/config/key_manager.hpp>
+#include "crypto_lanes.hpp"
 
 #include <memory>
 
@@ -30,7 +31,8 @@ namespace llarp::iwp
         SessionClosedHandler closed,
         PumpDoneHandler pumpDone,
         WorkerFunc_t dowork,
-        bool permitInbound);
+        bool permitInbound,
+        std::shared_ptr<CryptoLanes> lanes);
 
     std::shared_ptr<ILinkSession>
     NewOutboundSession(const RouterContact& rc, const AddressInfo& ai) override;
@@ -56,6 +58,26 @@ namespace llarp::iwp
     void
     AddWakeup(std::weak_ptr<Session> peer);
 
+    /// the crypto lane a session to this remote address does its packet crypto on
+    size_t
+    CryptoLaneFor(const SockAddr& remote) const
+    {
+      return m_CryptoLanes->LaneFor(remote);
+    }
+
+    /// queue packet crypto work on a crypto lane; work on the same lane runs in order
+    void
+    QueueCrypto(size_t lane, CryptoLanes::Job_t job)
+    {
+      m_CryptoLanes->Queue(lane, std::move(job));
+    }
+
+    util::StatusObject
+    ExtractCryptoLaneStatus(size_t lane) const
+    {
+      return m_CryptoLanes->ExtractLaneStatus(lane);
+    }
+
    private:
     void
     HandleWakeupPlaintext();
@@ -64,6 +86,7 @@ namespace llarp::iwp
     std::unordered_map<SockAddr, std::weak_ptr<Session>, SockAddr::Hash> m_PlaintextRecv;
     std::unordered_map<SockAddr, RouterID, SockAddr::Hash> m_AuthedAddrs;
     const bool permitInbound;
+    const std::shared_ptr<CryptoLanes> m_CryptoLanes;
   };
 
   using LinkLayer_ptr = std::shared_ptr<LinkLayer>;
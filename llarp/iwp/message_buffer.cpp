@@ -13,7 +13,7 @@ namespace llarp
         ILinkSession::CompletionHandler handler)
         : m_Data{std::move(msg)}
         , m_MsgID{msgid}
-        , m_Completed{handler}
+        , m_Completed{std::move(handler)}
         , m_LastFlush{now}
         , m_StartedAt{now}
     {
@@ -59,7 +59,7 @@ namespace llarp
 
     void
     OutboundMessage::FlushUnAcked(
-        std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now)
+        const std::function<void(ILinkSession::Packet_t)>& sendpkt, llarp_time_t now)
     {
       /// overhead for a data packet in plaintext
       static constexpr size_t Overhead = 10;
@@ -172,7 +172,8 @@ namespace llarp
     }
 
     void
-    InboundMessage::SendACKS(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now)
+    InboundMessage::SendACKS(
+        const std::function<void(ILinkSession::Packet_t)>& sendpkt, llarp_time_t now)
     {
       sendpkt(ACKS());
       m_LastACKSent = now;
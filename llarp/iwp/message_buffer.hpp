@@ -57,7 +57,7 @@ namespace llarp
       Ack(byte_t bitmask);
 
       void
-      FlushUnAcked(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
+      FlushUnAcked(const std::function<void(ILinkSession::Packet_t)>& sendpkt, llarp_time_t now);
 
       bool
       ShouldFlush(llarp_time_t now) const;
@@ -106,7 +106,7 @@ namespace llarp
       ShouldSendACKS(llarp_time_t now) const;
 
       void
-      SendACKS(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
+      SendACKS(const std::function<void(ILinkSession::Packet_t)>& sendpkt, llarp_time_t now);
 
       ILinkSession::Packet_t
       ACKS() const;
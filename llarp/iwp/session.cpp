@@ -4,6 +4,8 @@
 #include <llarp/messages/discard.hpp>
 #include <llarp/util/meta/memfn.hpp>
 
+#include <iterator>
+
 namespace llarp
 {
   namespace iwp
@@ -37,6 +39,7 @@ namespace llarp
         , m_ChosenAI(ai)
         , m_RemoteRC(rc)
         , m_PlaintextRecv{PlaintextQueueSize}
+        , m_CryptoLane{p->CryptoLaneFor(m_RemoteAddr)}
     {
       token.Zero();
       GotLIM = util::memFn(&Session::GotOutboundLIM, this);
@@ -50,6 +53,7 @@ namespace llarp
         , m_CreatedAt{p->Now()}
         , m_RemoteAddr{from}
         , m_PlaintextRecv{PlaintextQueueSize}
+        , m_CryptoLane{p->CryptoLaneFor(m_RemoteAddr)}
     {
       token.Randomize();
       GotLIM = util::memFn(&Session::GotInboundLIM, this);
@@ -124,7 +128,7 @@ namespace llarp
       {
         LogError("failed to encode LIM for ", m_RemoteAddr);
       }
-      if (!SendMessageBuffer(std::move(data), h))
+      if (!SendMessageBuffer(std::move(data), std::move(h)))
       {
         LogError("failed to send LIM to ", m_RemoteAddr);
       }
@@ -137,28 +141,63 @@ namespace llarp
       m_EncryptNext.emplace_back(std::move(data));
       if (!IsEstablished())
       {
-        EncryptWorker(std::move(m_EncryptNext));
+        // handshake packets are encrypted and sent right away on the event loop
+        auto msgs = std::move(m_EncryptNext);
         m_EncryptNext = CryptoQueue_t{};
+        EncryptInPlace(msgs);
+        for (const auto& pkt : msgs)
+          Send_LL(pkt.data(), pkt.size());
       }
     }
 
+    void
+    Session::EncryptInPlace(CryptoQueue_t& msgs)
+    {
+      std::vector<XChaCha20Job> ciphers;
+      std::vector<HMACJob> hashes;
+      ciphers.reserve(msgs.size());
+      hashes.reserve(msgs.size());
+      for (auto& pkt : msgs)
+      {
+        ciphers.push_back(XChaCha20Job{
+            pkt.data() + PacketOverhead,
+            pkt.size() - PacketOverhead,
+            &m_SessionKey,
+            pkt.data() + HMACSIZE});
+        hashes.push_back(
+            HMACJob{pkt.data(), pkt.data() + HMACSIZE, pkt.size() - HMACSIZE, &m_SessionKey});
+      }
+      CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
+      CryptoManager::instance()->hmac_many(hashes.data(), hashes.size());
+    }
+
     void
     Session::EncryptWorker(CryptoQueue_t msgs)
     {
       LogDebug("encrypt worker ", msgs.size(), " messages");
-      for (auto& pkt : msgs)
+      EncryptInPlace(msgs);
       {
-        llarp_buffer_t pktbuf{pkt};
-        const TunnelNonce nonce_ptr{pkt.data() + HMACSIZE};
-        pktbuf.base += PacketOverhead;
-        pktbuf.cur = pktbuf.base;
-        pktbuf.sz -= PacketOverhead;
-        CryptoManager::instance()->xchacha20(pktbuf, m_SessionKey, nonce_ptr);
-        pktbuf.base = pkt.data() + HMACSIZE;
-        pktbuf.sz = pkt.size() - HMACSIZE;
-        CryptoManager::instance()->hmac(pkt.data(), pktbuf, m_SessionKey);
-        Send_LL(pkt.data(), pkt.size());
+        std::lock_guard lock{m_CiphertextMutex};
+        if (m_CiphertextSend.empty())
+          m_CiphertextSend = std::move(msgs);
+        else
+          std::move(msgs.begin(), msgs.end(), std::back_inserter(m_CiphertextSend));
       }
+      m_Parent->WakeupPlaintext();
+    }
+
+    void
+    Session::SendCiphertext()
+    {
+      CryptoQueue_t msgs;
+      {
+        std::lock_guard lock{m_CiphertextMutex};
+        msgs = std::move(m_CiphertextSend);
+        m_CiphertextSend = CryptoQueue_t{};
+      }
+      // these are only queued here, the link flushes them all at once at the end of the pump
+      for (const auto& pkt : msgs)
+        Send_LL(pkt.data(), pkt.size());
     }
 
     void
@@ -183,12 +222,14 @@ namespace llarp
       const auto now = m_Parent->Now();
       const auto msgid = m_TXID++;
       const auto bufsz = buf.size();
-      auto& msg = m_TXMsgs.emplace(msgid, OutboundMessage{msgid, std::move(buf), now, completed})
-                      .first->second;
+      auto& msg =
+          m_TXMsgs
+              .emplace(msgid, OutboundMessage{msgid, std::move(buf), now, std::move(completed)})
+              .first->second;
       EncryptAndSend(msg.XMIT());
       if (bufsz > FragmentSize)
       {
-        msg.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
+        msg.FlushUnAcked(m_EncryptAndSend, now);
       }
       m_Stats.totalInFlightTX++;
       LogDebug("send message ", msgid);
@@ -223,6 +264,8 @@ namespace llarp
     void
     Session::Pump()
     {
+      // anything our crypto lane finished since the last pump goes out with this pump's flush
+      SendCiphertext();
       const auto now = m_Parent->Now();
       if (m_State == State::Ready || m_State == State::LinkIntro)
       {
@@ -232,14 +275,14 @@ namespace llarp
         {
           if (item.second.ShouldSendACKS(now))
           {
-            item.second.SendACKS(util::memFn(&Session::EncryptAndSend, this), now);
+            item.second.SendACKS(m_EncryptAndSend, now);
           }
         }
         for (auto& item : m_TXMsgs)
         {
           if (item.second.ShouldFlush(now))
           {
-            item.second.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
+            item.second.FlushUnAcked(m_EncryptAndSend, now);
           }
         }
       }
@@ -247,15 +290,21 @@ namespace llarp
       assert(self.use_count() > 1);
       if (not m_EncryptNext.empty())
       {
-        m_Parent->QueueWork([self, data = m_EncryptNext] { self->EncryptWorker(data); });
-        m_EncryptNext.clear();
+        m_Parent->QueueCrypto(
+            m_CryptoLane, [self, data = std::move(m_EncryptNext)]() mutable {
+              self->EncryptWorker(std::move(data));
+            });
+        m_EncryptNext = CryptoQueue_t{};
       }
 
       if (not m_DecryptNext.empty())
       {
         m_Parent->AddWakeup(weak_from_this());
-        m_Parent->QueueWork([self, data = m_DecryptNext] { self->DecryptWorker(data); });
-        m_DecryptNext.clear();
+        m_Parent->QueueCrypto(
+            m_CryptoLane, [self, data = std::move(m_DecryptNext)]() mutable {
+              self->DecryptWorker(std::move(data));
+            });
+        m_DecryptNext = CryptoQueue_t{};
       }
     }
 
@@ -315,6 +364,7 @@ namespace llarp
           {"txMsgQueueSize", m_TXMsgs.size()},
           {"rxMsgQueueSize", m_RXMsgs.size()},
           {"remoteAddr", m_RemoteAddr.toString()},
+          {"cryptoLane", m_Parent->ExtractCryptoLaneStatus(m_CryptoLane)},
           {"remoteRC", m_RemoteRC.ExtractStatus()},
           {"created", to_json(m_CreatedAt)},
           {"uptime", to_json(now - m_CreatedAt)}};
@@ -606,16 +656,78 @@ namespace llarp
     void
     Session::DecryptWorker(CryptoQueue_t msgs)
     {
+      // same checks as DecryptMessageInPlace but with the keyed hashes and then the ciphers of
+      // the whole batch done in one go
       auto itr = msgs.begin();
       while (itr != msgs.end())
       {
-        auto& pkt = *itr;
-        if (not DecryptMessageInPlace(pkt))
+        if (itr->size() <= PacketOverhead)
         {
+          LogError("packet too small from ", m_RemoteAddr);
           itr = msgs.erase(itr);
+          continue;
+        }
+        ++itr;
+      }
+      std::vector<ShortHash> digests(msgs.size());
+      std::vector<HMACJob> hashes;
+      hashes.reserve(msgs.size());
+      for (size_t idx = 0; idx < msgs.size(); ++idx)
+      {
+        auto& pkt = msgs[idx];
+        hashes.push_back(HMACJob{
+            digests[idx].data(),
+            pkt.data() + ShortHash::SIZE,
+            pkt.size() - ShortHash::SIZE,
+            &m_SessionKey});
+      }
+      if (not CryptoManager::instance()->hmac_many(hashes.data(), hashes.size()))
+      {
+        LogError("failed to caclulate keyed hashes for ", m_RemoteAddr);
+        return;
+      }
+      size_t kept = 0;
+      for (size_t idx = 0; idx < msgs.size(); ++idx)
+      {
+        auto& pkt = msgs[idx];
+        const ShortHash expected{pkt.data()};
+        if (digests[idx] != expected)
+        {
+          LogError(
+              "keyed hash mismatch ",
+              digests[idx],
+              " != ",
+              expected,
+              " from ",
+              m_RemoteAddr,
+              " state=",
+              int(m_State),
+              " size=",
+              pkt.size());
           LogError("failed to decrypt session data from ", m_RemoteAddr);
           continue;
         }
+        if (kept != idx)
+          msgs[kept] = std::move(pkt);
+        ++kept;
+      }
+      msgs.resize(kept);
+      std::vector<XChaCha20Job> ciphers;
+      ciphers.reserve(msgs.size());
+      for (auto& pkt : msgs)
+      {
+        ciphers.push_back(XChaCha20Job{
+            pkt.data() + PacketOverhead,
+            pkt.size() - PacketOverhead,
+            &m_SessionKey,
+            pkt.data() + ShortHash::SIZE});
+      }
+      CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
+
+      itr = msgs.begin();
+      while (itr != msgs.end())
+      {
+        auto& pkt = *itr;
         if (pkt[PacketOverhead] != LLARP_PROTO_VERSION)
         {
           LogError(
@@ -833,12 +945,13 @@ namespace llarp
     }
 
     void
-    Session::HandleRecvMsgCompleted(const InboundMessage& msg)
+    Session::HandleRecvMsgCompleted(InboundMessage& msg)
     {
       const auto rxid = msg.m_MsgID;
       if (m_ReplayFilter.emplace(rxid, m_Parent->Now()).second)
       {
-        m_Parent->HandleMessage(this, msg.m_Data);
+        // the message is dropped right after this so hand its buffer over
+        m_Parent->HandleMessage(this, std::move(msg.m_Data));
         EncryptAndSend(msg.ACKS());
       }
       m_RXMsgs.erase(rxid);
@@ -871,7 +984,7 @@ namespace llarp
       }
       else
       {
-        itr->second.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
+        itr->second.FlushUnAcked(m_EncryptAndSend, now);
       }
     }
 
@@ -9,6 +9,7 @@
 #include <unordered_set>
 #include <deque>
 #include <queue>
+#include <mutex>
 
 #include <llarp/util/thread/queue.hpp>
 
@@ -188,6 +189,11 @@ namespace llarp
       std::map<uint64_t, InboundMessage> m_RXMsgs;
       std::map<uint64_t, OutboundMessage> m_TXMsgs;
 
+      /// EncryptAndSend for the message buffers to send fragments and acks with, made once; it
+      /// only captures this so unlike a memFn it does not allocate
+      const std::function<void(Packet_t)> m_EncryptAndSend{
+          [this](Packet_t pkt) { EncryptAndSend(std::move(pkt)); }};
+
       /// maps rxid to time recieved
       std::unordered_map<uint64_t, llarp_time_t> m_ReplayFilter;
       /// rx messages to send in next round of multiacks
@@ -200,6 +206,21 @@ namespace llarp
 
       llarp::thread::Queue<CryptoQueue_t> m_PlaintextRecv;
 
+      /// the crypto lane all of our packet crypto runs on
+      const size_t m_CryptoLane;
+
+      /// ciphertext encrypted on our crypto lane waiting for the event loop to send it
+      std::mutex m_CiphertextMutex;
+      CryptoQueue_t m_CiphertextSend GUARDED_BY(m_CiphertextMutex);
+
+      /// encrypt packets in place
+      void
+      EncryptInPlace(CryptoQueue_t& msgs);
+
+      /// send ciphertext our crypto lane finished encrypting; called from the event loop
+      void
+      SendCiphertext();
+
       void
       EncryptWorker(CryptoQueue_t msgs);
 
@@ -228,7 +249,7 @@ namespace llarp
       SendMACK();
 
       void
-      HandleRecvMsgCompleted(const InboundMessage& msg);
+      HandleRecvMsgCompleted(InboundMessage& msg);
 
       void
       GenerateAndSendIntro();
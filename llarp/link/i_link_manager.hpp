@@ -26,10 +26,11 @@ namespace llarp
     virtual IOutboundSessionMaker*
     GetSessionMaker() const = 0;
 
+    /// hand an encoded link message to the session we have with remote
     virtual bool
     SendTo(
         const RouterID& remote,
-        const llarp_buffer_t& buf,
+        ILinkSession::Message_t msg,
         ILinkSession::CompletionHandler completed) = 0;
 
     virtual bool
@@ -36,7 +36,9 @@ namespace llarp
 
   bool
   LinkManager::SendTo(
-      const RouterID& remote, const llarp_buffer_t& buf, ILinkSession::CompletionHandler completed)
+      const RouterID& remote,
+      ILinkSession::Message_t msg,
+      ILinkSession::CompletionHandler completed)
   {
     if (stopping)
       return false;
@@ -51,7 +53,7 @@ namespace llarp
       return false;
     }
 
-    return link->SendTo(remote, buf, completed);
+    return link->SendTo(remote, std::move(msg), std::move(completed));
   }
 
   bool
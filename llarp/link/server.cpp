@@ -126,14 +126,13 @@ namespace llarp
   }
 
   bool
-  ILinkLayer::Configure(EventLoop_ptr loop, const std::string& ifname, int af, uint16_t port)
+  ILinkLayer::Configure(
+      EventLoop_ptr loop, const std::string& ifname, int af, uint16_t port, size_t eventLoops)
   {
     m_Loop = std::move(loop);
-    m_udp = m_Loop->make_udp(
-        [this]([[maybe_unused]] UDPHandle& udp, const SockAddr& from, llarp_buffer_t buf) {
-          ILinkSession::Packet_t pkt;
-          pkt.resize(buf.sz);
-          std::copy_n(buf.base, buf.sz, pkt.data());
+    m_udp = m_Loop->make_sharded_udp(
+        eventLoops,
+        [this]([[maybe_unused]] UDPHandle& udp, const SockAddr& from, PacketBuffer pkt) {
           RecvFrom(from, std::move(pkt));
         });
 
@@ -214,6 +213,8 @@ namespace llarp
         }
       }
     }
+    // send everything the sessions queued up this cycle in as few syscalls as we can
+    m_udp->flush();
     {
       Lock_t l(m_AuthedLinksMutex);
       for (const auto& r : closedSessions)
@@ -295,6 +296,7 @@ namespace llarp
         {"name", Name()},
         {"rank", uint64_t(Rank())},
         {"addr", m_ourAddr.toString()},
+        {"udp", m_udp->ExtractStatus()},
         {"sessions", util::StatusObject{{"pending", pending}, {"established", established}}}};
   }
 
@@ -429,12 +431,17 @@ namespace llarp
   void
   ILinkLayer::SendTo_LL(const SockAddr& to, const llarp_buffer_t& pkt)
   {
-    m_udp->send(to, pkt);
+    m_udp->queue_send(to, pkt);
+    // packets queued from worker threads go out on the next pump so make sure there is one
+    if (not m_Loop->inEventLoop())
+      m_Loop->wakeup();
   }
 
   bool
   ILinkLayer::SendTo(
-      const RouterID& remote, const llarp_buffer_t& buf, ILinkSession::CompletionHandler completed)
+      const RouterID& remote,
+      ILinkSession::Message_t msg,
+      ILinkSession::CompletionHandler completed)
   {
     std::shared_ptr<ILinkSession> s;
     {
@@ -451,9 +458,7 @@ namespace llarp
         }
       }
     }
-    ILinkSession::Message_t pkt(buf.sz);
-    std::copy_n(buf.base, buf.sz, pkt.begin());
-    return s && s->SendMessageBuffer(std::move(pkt), completed);
+    return s && s->SendMessageBuffer(std::move(msg), std::move(completed));
   }
 
   bool
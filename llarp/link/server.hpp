@@ -18,7 +18,7 @@ namespace llarp
   /// handle a link layer message. this allows for the message to be handled by "upper layers"
   ///
   /// currently called from iwp::Session when messages are sent or received.
-  using LinkMessageHandler = std::function<bool(ILinkSession*, const llarp_buffer_t&)>;
+  using LinkMessageHandler = std::function<bool(ILinkSession*, ILinkSession::Message_t)>;
 
   /// sign a buffer with identity key. this function should take the given `llarp_buffer_t` and
   /// sign it, prividing the signature in the out variable `Signature&`.
@@ -107,8 +107,15 @@ namespace llarp
     void
     SendTo_LL(const SockAddr& to, const llarp_buffer_t& pkt);
 
+    /// bind to port on ifname; with more than one event loop the socket's i/o is spread over that
+    /// many loops, see EventLoop::make_sharded_udp
     virtual bool
-    Configure(EventLoop_ptr loop, const std::string& ifname, int af, uint16_t port);
+    Configure(
+        EventLoop_ptr loop,
+        const std::string& ifname,
+        int af,
+        uint16_t port,
+        size_t eventLoops = 1);
 
     virtual std::shared_ptr<ILinkSession>
     NewOutboundSession(const RouterContact& rc, const AddressInfo& ai) = 0;
@@ -150,7 +157,7 @@ namespace llarp
     virtual bool
     SendTo(
         const RouterID& remote,
-        const llarp_buffer_t& buf,
+        ILinkSession::Message_t msg,
         ILinkSession::CompletionHandler completed);
 
     virtual bool
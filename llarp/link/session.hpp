@@ -4,6 +4,7 @@
 #include <llarp/net/net.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/router_contact.hpp>
+#include <llarp/util/packet_pool.hpp>
 #include <llarp/util/types.hpp>
 
 #include <functional>
@@ -52,7 +53,8 @@ namespace llarp
     /// message delivery result hook function
     using CompletionHandler = std::function<void(DeliveryStatus)>;
 
-    using Packet_t = std::vector<byte_t>;
+    /// a single datagram on the wire, in a pooled buffer
+    using Packet_t = PacketBuffer;
     using Message_t = std::vector<byte_t>;
 
     /// send a message buffer to the remote endpoint
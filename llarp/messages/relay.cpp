@@ -4,6 +4,9 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/util/bencode.hpp>
 
+#include <cstring>
+#include <string_view>
+
 namespace llarp
 {
   void
@@ -114,4 +117,79 @@ namespace llarp
     llarp::LogWarn("unhandled downstream message id=", pathid);
     return false;
   }
+
+  bool
+  RelayFrame::Parse()
+  {
+    using namespace std::literals;
+    std::string_view rest{reinterpret_cast<const char*>(buf.data()), buf.size()};
+    const auto offset = [&]() { return buf.size() - rest.size(); };
+    const auto skip = [&rest](std::string_view prefix) {
+      if (rest.substr(0, prefix.size()) != prefix)
+        return false;
+      rest.remove_prefix(prefix.size());
+      return true;
+    };
+    // a decimal without leading zeros followed by end
+    const auto number = [&rest](char end, uint64_t& n) {
+      size_t len = 0;
+      n = 0;
+      while (len < rest.size() and len < 8 and rest[len] >= '0' and rest[len] <= '9')
+        n = n * 10 + (rest[len++] - '0');
+      if (len == 0 or len == rest.size() or rest[len] != end or (len > 1 and rest[0] == '0'))
+        return false;
+      rest.remove_prefix(len + 1);
+      return true;
+    };
+
+    if (skip("d1:a1:u1:p16:"sv))
+      upstream = true;
+    else if (skip("d1:a1:d1:p16:"sv))
+      upstream = false;
+    else
+      return false;
+    pathidOffset = offset();
+    if (rest.size() < PathID_t::SIZE)
+      return false;
+    rest.remove_prefix(PathID_t::SIZE);
+
+    uint64_t version;
+    if (not skip("1:vi"sv) or not number('e', version) or version != LLARP_PROTO_VERSION)
+      return false;
+    if (not skip("1:x"sv) or not number(':', payloadSize))
+      return false;
+    // same limit as decoding into RelayUpstreamMessage::X
+    if (payloadSize > MAX_LINK_MSG_SIZE - 128 or rest.size() < payloadSize)
+      return false;
+    payloadOffset = offset();
+    rest.remove_prefix(payloadSize);
+
+    if (not skip("1:y32:"sv) or rest.size() < TunnelNonce::SIZE)
+      return false;
+    nonceOffset = offset();
+    rest.remove_prefix(TunnelNonce::SIZE);
+    return rest == "e"sv;
+  }
+
+  PathID_t
+  RelayFrame::PathID() const
+  {
+    PathID_t id;
+    std::memcpy(id.data(), buf.data() + pathidOffset, id.size());
+    return id;
+  }
+
+  void
+  RelayFrame::SetPathID(const PathID_t& id)
+  {
+    std::memcpy(buf.data() + pathidOffset, id.data(), id.size());
+  }
+
+  void
+  RelayFrame::XorNonce(const TunnelNonce& x)
+  {
+    auto* nonce = Nonce();
+    for (size_t idx = 0; idx < TunnelNonce::SIZE; ++idx)
+      nonce[idx] ^= x[idx];
+  }
 }  // namespace llarp
@@ -67,4 +67,46 @@ namespace llarp
       return 0;
     }
   };
+
+  /// a RelayUpstreamMessage or RelayDownstreamMessage kept in the encoded form it arrived in.
+  ///
+  /// a relay forwarding one of these does not need to decode it: the payload is decrypted where it
+  /// sits, the path id and nonce are overwritten in place and the same bytes go on to the next hop.
+  /// only the canonical encoding our BEncode() produces is recognised, anything else is left to
+  /// the regular link message parser.
+  struct RelayFrame
+  {
+    std::vector<byte_t> buf;
+    bool upstream = false;
+    size_t pathidOffset = 0;
+    size_t payloadOffset = 0;
+    size_t payloadSize = 0;
+    size_t nonceOffset = 0;
+
+    /// find where everything is in buf, false if it is not a relay message in canonical form
+    bool
+    Parse();
+
+    PathID_t
+    PathID() const;
+
+    void
+    SetPathID(const PathID_t& id);
+
+    byte_t*
+    Payload()
+    {
+      return buf.data() + payloadOffset;
+    }
+
+    byte_t*
+    Nonce()
+    {
+      return buf.data() + nonceOffset;
+    }
+
+    /// xor the nonce with x in place
+    void
+    XorNonce(const TunnelNonce& x);
+  };
 }  // namespace llarp
@@ -14,7 +14,9 @@
 #include <llarp/util/meta/memfn.hpp>
 #include <llarp/tooling/path_event.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <memory>
 #include <optional>
 
 namespace llarp
@@ -174,27 +176,23 @@ namespace llarp
   {
     using Context = llarp::path::PathContext;
     using Hop = llarp::path::TransitHop;
-    using Decrypter = AsyncFrameDecrypter<LRCMFrameDecrypt>;
-    using Decrypter_ptr = std::unique_ptr<Decrypter>;
-    Decrypter_ptr decrypter;
     std::array<EncryptedFrame, 8> frames;
     Context* context;
     // decrypted record
     LR_CommitRecord record;
     // the actual hop
     std::shared_ptr<Hop> hop;
+    /// when it was queued for decryption
+    const llarp_time_t queuedAt;
+    /// where it came from
+    const IpAddress fromAddr;
 
-    const std::optional<IpAddress> fromAddr;
-
-    LRCMFrameDecrypt(Context* ctx, Decrypter_ptr dec, const LR_CommitMessage* commit)
-        : decrypter(std::move(dec))
-        , frames(commit->frames)
+    LRCMFrameDecrypt(Context* ctx, const LR_CommitMessage* commit)
+        : frames(commit->frames)
         , context(ctx)
         , hop(std::make_shared<Hop>())
-        , fromAddr(
-              commit->session->GetRemoteRC().IsPublicRouter()
-                  ? std::optional<IpAddress>{}
-                  : commit->session->GetRemoteEndpoint())
+        , queuedAt(ctx->Router()->Now())
+        , fromAddr(commit->session->GetRemoteEndpoint())
     {
       hop->info.downstream = commit->session->GetPubKey();
     }
@@ -259,26 +257,6 @@ namespace llarp
         return;
       }
 
-      if (self->fromAddr)
-      {
-        // only do ip limiting from non service nodes
-#ifndef LOKINET_HIVE
-        if (self->context->CheckPathLimitHitByIP(*self->fromAddr))
-        {
-          // we hit a limit so tell it to slow tf down
-          llarp::LogError("client path build hit limit ", *self->fromAddr);
-          OnForwardLRCMResult(
-              self->context->Router(),
-              self->hop->info.rxID,
-              self->hop->info.downstream,
-              self->hop->pathKey,
-              SendStatus::Congestion);
-          self->hop = nullptr;
-          return;
-        }
-#endif
-      }
-
       if (!self->context->Router()->ConnectionToRouterAllowed(self->hop->info.upstream))
       {
         // we are not allowed to forward it ... now what?
@@ -351,121 +329,136 @@ namespace llarp
     // TODO: If decryption has succeeded here but we otherwise don't
     //       want to or can't accept the path build request, send
     //       a status message saying as much.
-    static void
-    HandleDecrypted(llarp_buffer_t* buf, std::shared_ptr<LRCMFrameDecrypt> self)
+    /// read the record out of our decrypted frame and set up the hop from it; this is done in a
+    /// worker thread
+    bool
+    HandleDecrypted(llarp_time_t now)
     {
-      auto now = self->context->Router()->Now();
-      auto& info = self->hop->info;
-      if (!buf)
-      {
-        llarp::LogError("LRCM decrypt failed from ", info.downstream);
-        self->decrypter = nullptr;
-        return;
-      }
+      auto& info = hop->info;
+      auto buf = frames[0].Buffer();
       buf->cur = buf->base + EncryptedFrameOverheadSize;
       llarp::LogDebug("decrypted LRCM from ", info.downstream);
       // successful decrypt
-      if (!self->record.BDecode(buf))
+      if (!record.BDecode(buf))
       {
         llarp::LogError("malformed frame inside LRCM from ", info.downstream);
-        self->decrypter = nullptr;
-        return;
+        return false;
       }
 
-      info.txID = self->record.txid;
-      info.rxID = self->record.rxid;
+      info.txID = record.txid;
+      info.rxID = record.rxid;
 
       if (info.txID.IsZero() || info.rxID.IsZero())
       {
         llarp::LogError("LRCM refusing zero pathid");
-        self->decrypter = nullptr;
-        return;
+        return false;
       }
 
-      info.upstream = self->record.nextHop;
+      info.upstream = record.nextHop;
 
       // generate path key as we are in a worker thread
       auto crypto = CryptoManager::instance();
       if (!crypto->dh_server(
-              self->hop->pathKey,
-              self->record.commkey,
-              self->context->EncryptionSecretKey(),
-              self->record.tunnelNonce))
+              hop->pathKey, record.commkey, context->EncryptionSecretKey(), record.tunnelNonce))
       {
         llarp::LogError("LRCM DH Failed ", info);
-        self->decrypter = nullptr;
-        return;
+        return false;
       }
       // generate hash of hop key for nonce mutation
-      crypto->shorthash(self->hop->nonceXOR, llarp_buffer_t(self->hop->pathKey));
-      if (self->record.work && self->record.work->IsValid(now))
+      crypto->shorthash(hop->nonceXOR, llarp_buffer_t(hop->pathKey));
+      if (record.work && record.work->IsValid(now))
       {
         llarp::LogDebug(
-            "LRCM extended lifetime by ", self->record.work->extendedLifetime, " for ", info);
-        self->hop->lifetime += self->record.work->extendedLifetime;
+            "LRCM extended lifetime by ", record.work->extendedLifetime, " for ", info);
+        hop->lifetime += record.work->extendedLifetime;
       }
-      else if (self->record.lifetime < path::default_lifetime && self->record.lifetime > 10s)
+      else if (record.lifetime < path::default_lifetime && record.lifetime > 10s)
       {
-        self->hop->lifetime = self->record.lifetime;
-        llarp::LogDebug("LRCM short lifespan set to ", self->hop->lifetime, " for ", info);
+        hop->lifetime = record.lifetime;
+        llarp::LogDebug("LRCM short lifespan set to ", hop->lifetime, " for ", info);
       }
 
       // TODO: check if we really want to accept it
-      self->hop->started = now;
+      hop->started = now;
 
-      self->context->Router()->NotifyRouterEvent<tooling::PathRequestReceivedEvent>(
-          self->context->Router()->pubkey(), self->hop);
+      context->Router()->NotifyRouterEvent<tooling::PathRequestReceivedEvent>(
+          context->Router()->pubkey(), hop);
 
-      size_t sz = self->frames[0].size();
+      size_t sz = frames[0].size();
       // shift
-      std::array<EncryptedFrame, 8> frames;
-      frames[0] = self->frames[1];
-      frames[1] = self->frames[2];
-      frames[2] = self->frames[3];
-      frames[3] = self->frames[4];
-      frames[4] = self->frames[5];
-      frames[5] = self->frames[6];
-      frames[6] = self->frames[7];
+      std::rotate(frames.begin(), frames.begin() + 1, frames.end());
       // put our response on the end
       frames[7] = EncryptedFrame(sz - EncryptedFrameOverheadSize);
       // random junk for now
       frames[7].Randomize();
-      self->frames = std::move(frames);
-      if (self->context->HopIsUs(info.upstream))
-      {
-        // we are the farthest hop
-        llarp::LogDebug("We are the farthest hop for ", info);
-        // send a LRSM down the path
-        self->context->loop()->call([self] {
-          SendPathConfirm(self);
-          self->decrypter = nullptr;
-        });
-      }
-      else
-      {
-        // forward upstream
-        // we are still in the worker thread so post job to logic
-        self->context->loop()->call([self] {
-          SendLRCM(self);
-          self->decrypter = nullptr;
-        });
-      }
+      return true;
     }
   };
 
+  void
+  DecryptCommits(path::PathContext* context, std::vector<std::shared_ptr<LRCMFrameDecrypt>> commits)
+  {
+    const size_t num = commits.size();
+    std::vector<EncryptedFrame*> frames;
+    frames.reserve(num);
+    for (const auto& commit : commits)
+      frames.push_back(&commit->frames[0]);
+    auto ok = std::make_unique<bool[]>(num);
+    EncryptedFrame::DecryptManyInPlace(
+        frames.data(), num, context->EncryptionSecretKey(), ok.get());
+
+    const auto now = context->Router()->Now();
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      auto& commit = commits[idx];
+      if (not ok[idx])
+        llarp::LogError("LRCM decrypt failed from ", commit->hop->info.downstream);
+      // a build that does not check out goes no further
+      if (not ok[idx] or not commit->HandleDecrypted(now))
+        commit->hop = nullptr;
+    }
+
+    // we are still in the worker thread so post job to logic
+    context->loop()->call([context, commits = std::move(commits)] {
+      for (const auto& commit : commits)
+      {
+        context->CommitFinished(commit->queuedAt, commit->fromAddr, commit->hop != nullptr);
+        if (not commit->hop)
+          continue;
+        if (context->HopIsUs(commit->hop->info.upstream))
+        {
+          // we are the farthest hop
+          llarp::LogDebug("We are the farthest hop for ", commit->hop->info);
+          // send a LRSM down the path
+          LRCMFrameDecrypt::SendPathConfirm(commit);
+        }
+        else
+        {
+          // forward upstream
+          LRCMFrameDecrypt::SendLRCM(commit);
+        }
+      }
+    });
+  }
+
   bool
   LR_CommitMessage::AsyncDecrypt(llarp::path::PathContext* context) const
   {
-    auto decrypter = std::make_unique<LRCMFrameDecrypt::Decrypter>(
-        context->EncryptionSecretKey(), &LRCMFrameDecrypt::HandleDecrypted);
-    // copy frames so we own them
-    auto frameDecrypt = std::make_shared<LRCMFrameDecrypt>(context, std::move(decrypter), this);
-
-    // decrypt frames async
-    frameDecrypt->decrypter->AsyncDecrypt(
-        frameDecrypt->frames[0], frameDecrypt, [r = context->Router()](auto func) {
-          r->QueueWork(std::move(func));
-        });
+    const IpAddress fromAddr{session->GetRemoteEndpoint()};
+    // only do ip limiting from non service nodes, and before we spend a dh on the build; we
+    // cannot tell it to slow down without decrypting it so it is dropped
+#ifndef LOKINET_HIVE
+    if (not session->GetRemoteRC().IsPublicRouter() and context->CheckPathLimitHitByIP(fromAddr))
+    {
+      llarp::LogError("client path build hit limit ", fromAddr);
+      context->CommitLimited();
+      return true;
+    }
+#endif
+    // copy frames so we own them, they are decrypted with the next batch
+    if (not context->QueueCommit(std::make_shared<LRCMFrameDecrypt>(context, this), fromAddr))
+      llarp::LogWarn(
+          "too many path builds waiting to be decrypted, dropped one from ", session->GetPubKey());
     return true;
   }
 }  // namespace llarp
@@ -9,6 +9,7 @@
 #include <array>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace llarp
 {
@@ -69,6 +70,8 @@ namespace llarp
     bool
     HandleMessage(AbstractRouter* router) const override;
 
+    /// queue the frame meant for us to be decrypted, unless the client it came from is over its
+    /// path build limit
     bool
     AsyncDecrypt(llarp::path::PathContext* context) const;
 
@@ -84,4 +87,12 @@ namespace llarp
       return 5;
     }
   };
+
+  struct LRCMFrameDecrypt;
+
+  /// decrypt a batch of queued path builds on a worker, then forward or confirm the ones that
+  /// check out from the event loop
+  void
+  DecryptCommits(
+      path::PathContext* context, std::vector<std::shared_ptr<LRCMFrameDecrypt>> commits);
 }  // namespace llarp
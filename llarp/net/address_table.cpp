@@ -0,0 +1,167 @@
+#include "address_table.hpp"
+
+#include <algorithm>
+
+namespace llarp::net
+{
+  void
+  AddressTable::Index::Insert(uint64_t hash, uint32_t entry)
+  {
+    for (size_t group = hash >> 7, probe = 0;; group += ++probe)
+    {
+      group &= m_GroupMask;
+      if (const auto bits = MatchFree(Group(group)))
+      {
+        const size_t slot = group * GroupSize + (__builtin_ctzll(bits) >> 3);
+        if (m_Ctrl[slot] == Empty)
+          m_Used++;
+        m_Ctrl[slot] = Tag(hash);
+        m_Slots[slot] = entry;
+        return;
+      }
+    }
+  }
+
+  void
+  AddressTable::Index::Reset(size_t size)
+  {
+    // keep at most half full after a rebuild so we do not rebuild again straight away
+    size_t groups = 2;
+    while (groups * GroupSize < size * 2)
+      groups *= 2;
+    m_Ctrl.assign(groups * GroupSize, Empty);
+    m_Slots.assign(groups * GroupSize, 0);
+    m_GroupMask = groups - 1;
+    m_Used = 0;
+  }
+
+  AddressTable::AddressTable(uint64_t seed) : m_Seed{seed}
+  {
+    Rehash(0);
+  }
+
+  void
+  AddressTable::SetRange(huint128_t first, huint128_t last)
+  {
+    m_First = first;
+    m_Last = last;
+    m_Next = first;
+    m_Exhausted = last < first;
+    m_Free.clear();
+  }
+
+  AddressEntry&
+  AddressTable::Map(const huint128_t& ip, const AlignedBuffer<32>& remote, bool snode)
+  {
+    EraseIP(ip);
+    EraseRemote(remote);
+    return Insert(ip, remote, snode);
+  }
+
+  AddressEntry*
+  AddressTable::Allocate(const AlignedBuffer<32>& remote, bool snode)
+  {
+    // skip over ips someone mapped by hand
+    while (not m_Free.empty())
+    {
+      const auto ip = m_Free.back();
+      m_Free.pop_back();
+      if (not FindByIP(ip))
+        return &Insert(ip, remote, snode);
+    }
+    while (not m_Exhausted)
+    {
+      const auto ip = m_Next;
+      if (m_Next == m_Last)
+        m_Exhausted = true;
+      else
+        ++m_Next;
+      if (not FindByIP(ip))
+        return &Insert(ip, remote, snode);
+    }
+    return nullptr;
+  }
+
+  const AddressEntry*
+  AddressTable::LeastActive() const
+  {
+    const AddressEntry* oldest = nullptr;
+    for (const auto& entry : m_Entries)
+    {
+      if (entry.lastActive == llarp_time_t::max())
+        continue;
+      if (oldest == nullptr or entry.lastActive < oldest->lastActive)
+        oldest = &entry;
+    }
+    return oldest;
+  }
+
+  bool
+  AddressTable::EraseIP(const huint128_t& ip)
+  {
+    const auto* entry = FindByIP(ip);
+    if (entry == nullptr)
+      return false;
+    Erase(entry - m_Entries.data());
+    return true;
+  }
+
+  bool
+  AddressTable::EraseRemote(const AlignedBuffer<32>& remote)
+  {
+    const auto* entry = FindByRemote(remote);
+    if (entry == nullptr)
+      return false;
+    Erase(entry - m_Entries.data());
+    return true;
+  }
+
+  AddressEntry&
+  AddressTable::Insert(const huint128_t& ip, const AlignedBuffer<32>& remote, bool snode)
+  {
+    if (m_ByIP.Full() or m_ByRemote.Full())
+      Rehash(m_Entries.size() + 1);
+    const uint32_t idx = m_Entries.size();
+    auto& entry = m_Entries.emplace_back();
+    entry.ip = ip;
+    entry.remote = remote;
+    entry.snode = snode;
+    m_ByIP.Insert(HashIP(ip), idx);
+    m_ByRemote.Insert(HashRemote(remote), idx);
+    return entry;
+  }
+
+  void
+  AddressTable::Erase(uint32_t idx)
+  {
+    const auto is = [](uint32_t want) { return [want](uint32_t idx) { return idx == want; }; };
+    const auto& entry = m_Entries[idx];
+    m_ByIP.Erase(m_ByIP.Find(HashIP(entry.ip), is(idx)));
+    m_ByRemote.Erase(m_ByRemote.Find(HashRemote(entry.remote), is(idx)));
+    if (InRange(entry.ip) and (m_Exhausted or entry.ip < m_Next))
+      m_Free.push_back(entry.ip);
+
+    // fill the hole with the last entry
+    const uint32_t last = m_Entries.size() - 1;
+    if (idx != last)
+    {
+      const auto& moved = m_Entries[last];
+      m_ByIP.Set(m_ByIP.Find(HashIP(moved.ip), is(last)), idx);
+      m_ByRemote.Set(m_ByRemote.Find(HashRemote(moved.remote), is(last)), idx);
+      m_Entries[idx] = moved;
+    }
+    m_Entries.pop_back();
+  }
+
+  void
+  AddressTable::Rehash(size_t size)
+  {
+    m_ByIP.Reset(size);
+    m_ByRemote.Reset(size);
+    for (uint32_t idx = 0; idx < m_Entries.size(); ++idx)
+    {
+      m_ByIP.Insert(HashIP(m_Entries[idx].ip), idx);
+      m_ByRemote.Insert(HashRemote(m_Entries[idx].remote), idx);
+    }
+  }
+}  // namespace llarp::net
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "net_int.hpp"
+#include <llarp/util/aligned.hpp>
+#include <llarp/util/endian.hpp>
+#include <llarp/util/types.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace llarp::net
+{
+  /// a remote we gave a local ip address to
+  struct AddressEntry
+  {
+    /// the ip we gave them (host byte order)
+    huint128_t ip;
+    /// their address or router id
+    AlignedBuffer<32> remote;
+    /// when traffic last went to or from them, llarp_time_t::max() to never expire
+    llarp_time_t lastActive = 0s;
+    /// true if remote is a service node
+    bool snode = false;
+  };
+
+  /// maps local ip addresses to remotes and back for the tun and exit endpoints, and hands out
+  /// the ip addresses.
+  ///
+  /// the entries sit together in one flat array, looked up by two open addressing hash indexes
+  /// (one by ip, one by remote) that hold entry numbers.  the indexes work like abseil's swiss
+  /// tables: a control byte per slot with 7 bits of the hash, probed 8 at a time by comparing
+  /// whole words, so a lookup touches a word of control bytes and the one entry it is after.
+  ///
+  /// free ips come from a list of released ones and then from a counter running through the
+  /// range, so handing one out does not search for a free ip.
+  ///
+  /// pointers to entries stay valid until the next change to the table.
+  class AddressTable
+  {
+   public:
+    /// seed is mixed into the hashes so remotes cannot pick keys that collide in our indexes
+    explicit AddressTable(uint64_t seed);
+
+    /// hand out ips from first to last, inclusive, and forget what we handed out before
+    void
+    SetRange(huint128_t first, huint128_t last);
+
+    const AddressEntry*
+    FindByIP(const huint128_t& ip) const
+    {
+      const auto slot = m_ByIP.Find(
+          HashIP(ip), [this, &ip](uint32_t idx) { return m_Entries[idx].ip == ip; });
+      return slot == Index::NPos ? nullptr : &m_Entries[m_ByIP.At(slot)];
+    }
+
+    AddressEntry*
+    FindByIP(const huint128_t& ip)
+    {
+      return const_cast<AddressEntry*>(std::as_const(*this).FindByIP(ip));
+    }
+
+    const AddressEntry*
+    FindByRemote(const AlignedBuffer<32>& remote) const
+    {
+      const auto slot = m_ByRemote.Find(HashRemote(remote), [this, &remote](uint32_t idx) {
+        return m_Entries[idx].remote == remote;
+      });
+      return slot == Index::NPos ? nullptr : &m_Entries[m_ByRemote.At(slot)];
+    }
+
+    AddressEntry*
+    FindByRemote(const AlignedBuffer<32>& remote)
+    {
+      return const_cast<AddressEntry*>(std::as_const(*this).FindByRemote(remote));
+    }
+
+    /// map ip to remote, replacing whatever either of them was mapped to before
+    AddressEntry&
+    Map(const huint128_t& ip, const AlignedBuffer<32>& remote, bool snode);
+
+    /// map remote to a free ip from our range, nullptr if there are none left
+    AddressEntry*
+    Allocate(const AlignedBuffer<32>& remote, bool snode);
+
+    /// the entry that has been inactive for longest, leaving out the ones that never expire.
+    /// nullptr if there is none.
+    const AddressEntry*
+    LeastActive() const;
+
+    /// remove the entry for ip, returning false if there is none. its ip goes back to the free
+    /// ips if it is one we hand out.
+    bool
+    EraseIP(const huint128_t& ip);
+
+    bool
+    EraseRemote(const AlignedBuffer<32>& remote);
+
+    template <typename Visit_t>
+    void
+    ForEach(Visit_t visit) const
+    {
+      for (const auto& entry : m_Entries)
+        visit(entry);
+    }
+
+    size_t
+    Size() const
+    {
+      return m_Entries.size();
+    }
+
+    bool
+    Empty() const
+    {
+      return m_Entries.empty();
+    }
+
+    /// the next ip we hand out once there are no released ones
+    huint128_t
+    NextIP() const
+    {
+      return m_Next;
+    }
+
+   private:
+    /// an open addressing hash set of entry numbers. it does not know the keys: lookups take a
+    /// predicate on the entry number, and the table rebuilds the index when it needs to grow.
+    class Index
+    {
+     public:
+      static constexpr size_t NPos = std::numeric_limits<size_t>::max();
+
+      /// the slot holding an entry matching hash for which match(entry) is true, or NPos
+      template <typename Match_t>
+      size_t
+      Find(uint64_t hash, Match_t match) const
+      {
+        if (m_Ctrl.empty())
+          return NPos;
+        const auto tag = Tag(hash);
+        for (size_t group = hash >> 7, probe = 0;; group += ++probe)
+        {
+          group &= m_GroupMask;
+          const auto word = Group(group);
+          for (auto bits = MatchTag(word, tag); bits; bits &= bits - 1)
+          {
+            const size_t slot = group * GroupSize + (__builtin_ctzll(bits) >> 3);
+            if (match(m_Slots[slot]))
+              return slot;
+          }
+          if (MatchEmpty(word))
+            return NPos;
+        }
+      }
+
+      uint32_t
+      At(size_t slot) const
+      {
+        return m_Slots[slot];
+      }
+
+      void
+      Set(size_t slot, uint32_t entry)
+      {
+        m_Slots[slot] = entry;
+      }
+
+      /// add entry under hash, the caller makes sure it is not there already
+      void
+      Insert(uint64_t hash, uint32_t entry);
+
+      void
+      Erase(size_t slot)
+      {
+        m_Ctrl[slot] = Deleted;
+      }
+
+      /// whether one more insert would take us over our load factor, counting deleted slots
+      bool
+      Full() const
+      {
+        return (m_Used + 1) * 8 > m_Slots.size() * 7;
+      }
+
+      /// empty the index and make room for at least size entries
+      void
+      Reset(size_t size);
+
+     private:
+      static constexpr size_t GroupSize = 8;
+      static constexpr uint8_t Empty = 0x80;
+      static constexpr uint8_t Deleted = 0xfe;
+      static constexpr uint64_t LSBs = 0x0101'0101'0101'0101UL;
+      static constexpr uint64_t MSBs = 0x8080'8080'8080'8080UL;
+
+      static uint8_t
+      Tag(uint64_t hash)
+      {
+        return hash & 0x7f;
+      }
+
+      uint64_t
+      Group(size_t group) const
+      {
+        uint64_t word;
+        std::memcpy(&word, m_Ctrl.data() + group * GroupSize, sizeof(word));
+        return le64toh(word);
+      }
+
+      /// high bit set in the bytes of word equal to tag. may give false positives on bytes
+      /// next to a real match, which the caller weeds out by comparing keys.
+      static uint64_t
+      MatchTag(uint64_t word, uint8_t tag)
+      {
+        const uint64_t x = word ^ (LSBs * tag);
+        return (x - LSBs) & ~x & MSBs;
+      }
+
+      static uint64_t
+      MatchEmpty(uint64_t word)
+      {
+        return word & (~word << 6) & MSBs;
+      }
+
+      static uint64_t
+      MatchFree(uint64_t word)
+      {
+        return word & MSBs;
+      }
+
+      std::vector<uint8_t> m_Ctrl;
+      std::vector<uint32_t> m_Slots;
+      size_t m_GroupMask = 0;
+      /// full and deleted slots
+      size_t m_Used = 0;
+    };
+
+    uint64_t
+    HashIP(const huint128_t& ip) const
+    {
+      return Mix(ip.h.lower ^ Mix(ip.h.upper ^ m_Seed));
+    }
+
+    uint64_t
+    HashRemote(const AlignedBuffer<32>& remote) const
+    {
+      uint64_t words[2];
+      std::memcpy(words, remote.data(), sizeof(words));
+      return Mix(words[1] ^ Mix(words[0] ^ m_Seed));
+    }
+
+    static uint64_t
+    Mix(uint64_t x)
+    {
+      x ^= x >> 33;
+      x *= 0xff51'afd7'ed55'8ccdUL;
+      x ^= x >> 33;
+      x *= 0xc4ce'b9fe'1a85'ec53UL;
+      return x ^ (x >> 33);
+    }
+
+    bool
+    InRange(const huint128_t& ip) const
+    {
+      return not(ip < m_First) and not(m_Last < ip);
+    }
+
+    AddressEntry&
+    Insert(const huint128_t& ip, const AlignedBuffer<32>& remote, bool snode);
+
+    void
+    Erase(uint32_t idx);
+
+    /// rebuild both indexes with room for size entries
+    void
+    Rehash(size_t size);
+
+    const uint64_t m_Seed;
+    std::vector<AddressEntry> m_Entries;
+    Index m_ByIP;
+    Index m_ByRemote;
+
+    huint128_t m_First{0};
+    huint128_t m_Last{0};
+    huint128_t m_Next{0};
+    /// true once m_Next went past m_Last
+    bool m_Exhausted = true;
+    /// ips we handed out and got back
+    std::vector<huint128_t> m_Free;
+  };
+}  // namespace llarp::net
@@ -0,0 +1,126 @@
+#include "checksum.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace llarp::net
+{
+  namespace
+  {
+    /// the bytes after the last whole 32 bit word, padded with zeros in memory order
+    uint64_t
+    SumTail(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      uint32_t word = 0;
+      std::memcpy(&word, buf, sz);
+      return ChecksumAdd(sum, word);
+    }
+
+    uint64_t
+    PartialScalar(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      // 32 bit words into two 64 bit accumulators cannot overflow before 2^32 words
+      uint64_t acc[2] = {0, 0};
+      for (; sz >= 8; sz -= 8, buf += 8)
+      {
+        uint32_t words[2];
+        std::memcpy(words, buf, sizeof(words));
+        acc[0] += words[0];
+        acc[1] += words[1];
+      }
+      if (sz >= 4)
+      {
+        uint32_t word;
+        std::memcpy(&word, buf, sizeof(word));
+        acc[0] += word;
+        sz -= 4;
+        buf += 4;
+      }
+      sum = ChecksumAdd(sum, ChecksumAdd(acc[0], acc[1]));
+      return SumTail(buf, sz, sum);
+    }
+
+#if defined(__SSE2__)
+    uint64_t
+    PartialSSE2(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      // widen each 32 bit word to 64 bits and add those
+      const __m128i zero = _mm_setzero_si128();
+      __m128i acc[2] = {zero, zero};
+      for (; sz >= 16; sz -= 16, buf += 16)
+      {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+        acc[0] = _mm_add_epi64(acc[0], _mm_unpacklo_epi32(v, zero));
+        acc[1] = _mm_add_epi64(acc[1], _mm_unpackhi_epi32(v, zero));
+      }
+      uint64_t lanes[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc[0]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 2), acc[1]);
+      for (const auto lane : lanes)
+        sum = ChecksumAdd(sum, lane);
+      return PartialScalar(buf, sz, sum);
+    }
+#elif defined(__ARM_NEON)
+    uint64_t
+    PartialNEON(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      // pairwise add the 32 bit words into 64 bit lanes
+      uint64x2_t acc[2] = {vdupq_n_u64(0), vdupq_n_u64(0)};
+      for (; sz >= 32; sz -= 32, buf += 32)
+      {
+        acc[0] = vpadalq_u32(acc[0], vreinterpretq_u32_u8(vld1q_u8(buf)));
+        acc[1] = vpadalq_u32(acc[1], vreinterpretq_u32_u8(vld1q_u8(buf + 16)));
+      }
+      if (sz >= 16)
+      {
+        acc[0] = vpadalq_u32(acc[0], vreinterpretq_u32_u8(vld1q_u8(buf)));
+        sz -= 16;
+        buf += 16;
+      }
+      sum = ChecksumAdd(sum, vgetq_lane_u64(acc[0], 0));
+      sum = ChecksumAdd(sum, vgetq_lane_u64(acc[0], 1));
+      sum = ChecksumAdd(sum, vgetq_lane_u64(acc[1], 0));
+      sum = ChecksumAdd(sum, vgetq_lane_u64(acc[1], 1));
+      return PartialScalar(buf, sz, sum);
+    }
+#endif
+
+    std::vector<ChecksumKernel>
+    FindKernels()
+    {
+      std::vector<ChecksumKernel> kernels;
+      kernels.push_back({"scalar", &PartialScalar});
+#if defined(__SSE2__)
+      kernels.push_back({"sse2", &PartialSSE2});
+#elif defined(__ARM_NEON)
+      kernels.push_back({"neon", &PartialNEON});
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#ifdef LOKINET_CHECKSUM_AVX2
+      if (__builtin_cpu_supports("avx2"))
+        kernels.push_back(checksum_avx2_kernel);
+#endif
+#endif
+      return kernels;
+    }
+  }  // namespace
+
+  const std::vector<ChecksumKernel>&
+  ChecksumKernels()
+  {
+    static const auto kernels = FindKernels();
+    return kernels;
+  }
+
+  uint64_t
+  ChecksumPartial(const byte_t* buf, size_t sz, uint64_t sum)
+  {
+    static const auto partial = ChecksumKernels().back().partial;
+    return partial(buf, sz, sum);
+  }
+}  // namespace llarp::net
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <llarp/util/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * checksum.hpp
+ *
+ * the internet checksum (rfc 1071) over whole buffers.  the ones complement sum does not care
+ * about word size or byte order until it is folded, so the kernels add the buffer up as 32 bit
+ * words in wide lanes and fold once at the end.  the scalar and sse2 / neon kernels are built
+ * in; the avx2 one lives in its own translation unit compiled with -mavx2 and is picked at
+ * runtime by cpu support, see LOKINET_CHECKSUM_AVX2.
+ */
+
+namespace llarp::net
+{
+  /// add the buffer up as 16 bit words in memory order onto sum, unfolded.  an odd last byte
+  /// counts as a word with a zero byte after it.
+  uint64_t
+  ChecksumPartial(const byte_t* buf, size_t sz, uint64_t sum = 0);
+
+  /// fold a partial sum to 16 bits, in the same order the words were read in
+  constexpr uint16_t
+  ChecksumFold(uint64_t sum)
+  {
+    sum = (sum & 0xffff'ffff) + (sum >> 32);
+    sum = (sum & 0xffff'ffff) + (sum >> 32);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return sum;
+  }
+
+  /// add two partial sums without losing the carry
+  constexpr uint64_t
+  ChecksumAdd(uint64_t a, uint64_t b)
+  {
+    a += b;
+    return a + (a < b);
+  }
+
+  struct ChecksumKernel
+  {
+    std::string_view name;
+    uint64_t (*partial)(const byte_t* buf, size_t sz, uint64_t sum);
+  };
+
+  /// only defined when the compiler can build it, see LOKINET_CHECKSUM_AVX2
+  extern const ChecksumKernel checksum_avx2_kernel;
+
+  /// every kernel this cpu can run, slowest first; ChecksumPartial uses the last one
+  const std::vector<ChecksumKernel>&
+  ChecksumKernels();
+}  // namespace llarp::net
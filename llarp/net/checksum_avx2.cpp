@@ -0,0 +1,42 @@
+// compiled with -mavx2, only called when the cpu has it
+#include "checksum.hpp"
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace llarp::net
+{
+  namespace
+  {
+    uint64_t
+    PartialAVX2(const byte_t* buf, size_t sz, uint64_t sum)
+    {
+      // widen each 32 bit word to 64 bits and add those
+      const __m256i zero = _mm256_setzero_si256();
+      __m256i acc[2] = {zero, zero};
+      for (; sz >= 32; sz -= 32, buf += 32)
+      {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf));
+        acc[0] = _mm256_add_epi64(acc[0], _mm256_unpacklo_epi32(v, zero));
+        acc[1] = _mm256_add_epi64(acc[1], _mm256_unpackhi_epi32(v, zero));
+      }
+      uint64_t lanes[8];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc[0]);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 4), acc[1]);
+      for (const auto lane : lanes)
+        sum = ChecksumAdd(sum, lane);
+      // the rest is less than a vector
+      for (; sz >= 4; sz -= 4, buf += 4)
+      {
+        uint32_t word;
+        std::memcpy(&word, buf, sizeof(word));
+        sum = ChecksumAdd(sum, word);
+      }
+      uint32_t word = 0;
+      std::memcpy(&word, buf, sz);
+      return ChecksumAdd(sum, word);
+    }
+  }  // namespace
+
+  const ChecksumKernel checksum_avx2_kernel{"avx2", &PartialAVX2};
+}  // namespace llarp::net
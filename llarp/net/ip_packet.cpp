@@ -1,4 +1,5 @@
 #include "ip_packet.hpp"
+#include "checksum.hpp"
 #include "ip.hpp"
 
 #include <llarp/util/buffer.hpp>
@@ -10,6 +11,7 @@
 #endif
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 
 constexpr uint32_t ipv6_flowlabel_mask = 0b0000'0000'0000'1111'1111'1111'1111'1111;
@@ -127,53 +129,24 @@ namespace llarp
     uint16_t
     ipchksum(const byte_t* buf, size_t sz, uint32_t sum)
     {
-      while (sz > 1)
-      {
-        sum += *(const uint16_t*)buf;
-        sz -= sizeof(uint16_t);
-        buf += sizeof(uint16_t);
-      }
-      if (sz != 0)
-      {
-        uint16_t x = 0;
-
-        *(byte_t*)&x = *(const byte_t*)buf;
-        sum += x;
-      }
-
-      // only need to do it 2 times to be sure
-      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
-      sum = (sum & 0xFFff) + (sum >> 16);
-      sum += sum >> 16;
-
-      return uint16_t((~sum) & 0xFFff);
+      return ~ChecksumFold(ChecksumPartial(buf, sz, sum));
     }
 
 #define ADD32CS(x) ((uint32_t)(x & 0xFFff) + (uint32_t)(x >> 16))
 #define SUB32CS(x) ((uint32_t)((~x) & 0xFFff) + (uint32_t)((~x) >> 16))
 
-    static nuint16_t
-    deltaIPv4Checksum(
-        nuint16_t old_sum,
-        nuint32_t old_src_ip,
-        nuint32_t old_dst_ip,
-        nuint32_t new_src_ip,
-        nuint32_t new_dst_ip)
+    /// what replacing the old addresses with the new ones adds to every checksum covering them,
+    /// unfolded.  it does not depend on anything else in the packet.
+    static uint32_t
+    deltaIPv4Addresses(
+        nuint32_t old_src_ip, nuint32_t old_dst_ip, nuint32_t new_src_ip, nuint32_t new_dst_ip)
     {
-      uint32_t sum = uint32_t(old_sum.n) + ADD32CS(old_src_ip.n) + ADD32CS(old_dst_ip.n)
-          + SUB32CS(new_src_ip.n) + SUB32CS(new_dst_ip.n);
-
-      // only need to do it 2 times to be sure
-      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
-      sum = (sum & 0xFFff) + (sum >> 16);
-      sum += sum >> 16;
-
-      return nuint16_t{uint16_t(sum & 0xFFff)};
+      return ADD32CS(old_src_ip.n) + ADD32CS(old_dst_ip.n) + SUB32CS(new_src_ip.n)
+          + SUB32CS(new_dst_ip.n);
     }
 
-    static nuint16_t
-    deltaIPv6Checksum(
-        nuint16_t old_sum,
+    static uint32_t
+    deltaIPv6Addresses(
         const uint32_t old_src_ip[4],
         const uint32_t old_dst_ip[4],
         const uint32_t new_src_ip[4],
@@ -189,64 +162,37 @@ namespace llarp
        * that'd suck for 32bit cpus */
 #define ADDN128CS(x) (ADD32CS(x[0]) + ADD32CS(x[1]) + ADD32CS(x[2]) + ADD32CS(x[3]))
 #define SUBN128CS(x) (SUB32CS(x[0]) + SUB32CS(x[1]) + SUB32CS(x[2]) + SUB32CS(x[3]))
-      uint32_t sum = uint32_t(old_sum.n) + ADDN128CS(old_src_ip) + ADDN128CS(old_dst_ip)
-          + SUBN128CS(new_src_ip) + SUBN128CS(new_dst_ip);
+      return ADDN128CS(old_src_ip) + ADDN128CS(old_dst_ip) + SUBN128CS(new_src_ip)
+          + SUBN128CS(new_dst_ip);
 #undef ADDN128CS
 #undef SUBN128CS
-
-      // only need to do it 2 times to be sure
-      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
-      sum = (sum & 0xFFff) + (sum >> 16);
-      sum += sum >> 16;
-
-      return nuint16_t{uint16_t(sum & 0xFFff)};
     }
 
 #undef ADD32CS
 #undef SUB32CS
 
-    static void
-    deltaChecksumIPv4TCP(
-        byte_t* pld,
-        size_t psz,
-        size_t fragoff,
-        size_t chksumoff,
-        nuint32_t oSrcIP,
-        nuint32_t oDstIP,
-        nuint32_t nSrcIP,
-        nuint32_t nDstIP)
+    static nuint16_t
+    deltaChecksum(nuint16_t old_sum, uint32_t delta)
     {
-      if (fragoff > chksumoff || psz < chksumoff - fragoff + 2)
-        return;
+      uint32_t sum = uint32_t(old_sum.n) + delta;
 
-      auto check = (nuint16_t*)(pld + chksumoff - fragoff);
+      // only need to do it 2 times to be sure
+      // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
+      sum = (sum & 0xFFff) + (sum >> 16);
+      sum += sum >> 16;
 
-      *check = deltaIPv4Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
-      // usually, TCP checksum field cannot be 0xFFff,
-      // because one's complement addition cannot result in 0x0000,
-      // and there's inversion in the end;
-      // emulate that.
-      if (check->n == 0xFFff)
-        check->n = 0x0000;
+      return nuint16_t{uint16_t(sum & 0xFFff)};
     }
 
     static void
-    deltaChecksumIPv6TCP(
-        byte_t* pld,
-        size_t psz,
-        size_t fragoff,
-        size_t chksumoff,
-        const uint32_t oSrcIP[4],
-        const uint32_t oDstIP[4],
-        const uint32_t nSrcIP[4],
-        const uint32_t nDstIP[4])
+    deltaChecksumTCP(byte_t* pld, size_t psz, size_t fragoff, size_t chksumoff, uint32_t delta)
     {
       if (fragoff > chksumoff || psz < chksumoff - fragoff + 2)
         return;
 
       auto check = (nuint16_t*)(pld + chksumoff - fragoff);
 
-      *check = deltaIPv6Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *check = deltaChecksum(*check, delta);
       // usually, TCP checksum field cannot be 0xFFff,
       // because one's complement addition cannot result in 0x0000,
       // and there's inversion in the end;
@@ -256,42 +202,7 @@ namespace llarp
     }
 
     static void
-    deltaChecksumIPv4UDP(
-        byte_t* pld,
-        size_t psz,
-        size_t fragoff,
-        nuint32_t oSrcIP,
-        nuint32_t oDstIP,
-        nuint32_t nSrcIP,
-        nuint32_t nDstIP)
-    {
-      if (fragoff > 6 || psz < 6 + 2)
-        return;
-
-      auto check = (nuint16_t*)(pld + 6);
-      if (check->n == 0x0000)
-        return;  // 0 is used to indicate "no checksum", don't change
-
-      *check = deltaIPv4Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
-      // 0 is used to indicate "no checksum"
-      // 0xFFff and 0 are equivalent in one's complement math
-      // 0xFFff + 1 = 0x10000 -> 0x0001 (same as 0 + 1)
-      // infact it's impossible to get 0 with such addition,
-      // when starting from non-0 value.
-      // inside deltachksum we don't invert so it's safe to skip check there
-      // if(check->n == 0x0000)
-      //   check->n = 0xFFff;
-    }
-
-    static void
-    deltaChecksumIPv6UDP(
-        byte_t* pld,
-        size_t psz,
-        size_t fragoff,
-        const uint32_t oSrcIP[4],
-        const uint32_t oDstIP[4],
-        const uint32_t nSrcIP[4],
-        const uint32_t nDstIP[4])
+    deltaChecksumUDP(byte_t* pld, size_t psz, size_t fragoff, uint32_t delta)
     {
       if (fragoff > 6 || psz < 6 + 2)
         return;
@@ -307,7 +218,7 @@ namespace llarp
       if (check->n == 0x0000)
         return;
 
-      *check = deltaIPv6Checksum(*check, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *check = deltaChecksum(*check, delta);
       // 0 is used to indicate "no checksum"
       // 0xFFff and 0 are equivalent in one's complement math
       // 0xFFff + 1 = 0x10000 -> 0x0001 (same as 0 + 1)
@@ -318,79 +229,61 @@ namespace llarp
       //   check->n = 0xFFff;
     }
 
-    void
-    IPPacket::UpdateIPv4Address(nuint32_t nSrcIP, nuint32_t nDstIP)
+    /// write the new addresses of an ipv4 packet and add delta, their checksum change, to its
+    /// checksums
+    static void
+    rewriteIPv4(IPPacket& pkt, nuint32_t nSrcIP, nuint32_t nDstIP, uint32_t delta)
     {
-      llarp::LogDebug("set src=", nSrcIP, " dst=", nDstIP);
-
-      auto hdr = Header();
-
-      auto oSrcIP = nuint32_t{hdr->saddr};
-      auto oDstIP = nuint32_t{hdr->daddr};
+      auto hdr = pkt.Header();
 
       // L4 checksum
       auto ihs = size_t(hdr->ihl * 4);
-      if (ihs <= sz)
+      if (ihs <= pkt.sz)
       {
-        auto pld = buf + ihs;
-        auto psz = sz - ihs;
+        auto pld = pkt.buf + ihs;
+        auto psz = pkt.sz - ihs;
 
         auto fragoff = size_t((ntohs(hdr->frag_off) & 0x1Fff) * 8);
 
         switch (hdr->protocol)
         {
           case 6:  // TCP
-            deltaChecksumIPv4TCP(pld, psz, fragoff, 16, oSrcIP, oDstIP, nSrcIP, nDstIP);
+            deltaChecksumTCP(pld, psz, fragoff, 16, delta);
             break;
           case 17:   // UDP
           case 136:  // UDP-Lite - same checksum place, same 0->0xFFff condition
-            deltaChecksumIPv4UDP(pld, psz, fragoff, oSrcIP, oDstIP, nSrcIP, nDstIP);
+            deltaChecksumUDP(pld, psz, fragoff, delta);
             break;
           case 33:  // DCCP
-            deltaChecksumIPv4TCP(pld, psz, fragoff, 6, oSrcIP, oDstIP, nSrcIP, nDstIP);
+            deltaChecksumTCP(pld, psz, fragoff, 6, delta);
             break;
         }
       }
 
       // IPv4 checksum
       auto v4chk = (nuint16_t*)&(hdr->check);
-      *v4chk = deltaIPv4Checksum(*v4chk, oSrcIP, oDstIP, nSrcIP, nDstIP);
+      *v4chk = deltaChecksum(*v4chk, delta);
 
       // write new IP addresses
       hdr->saddr = nSrcIP.n;
       hdr->daddr = nDstIP.n;
     }
 
-    void
-    IPPacket::UpdateIPv6Address(huint128_t src, huint128_t dst, std::optional<nuint32_t> flowlabel)
-    {
-      const size_t ihs = 4 + 4 + 16 + 16;
-
-      // XXX should've been checked at upper level?
-      if (sz <= ihs)
-        return;
-
-      auto hdr = HeaderV6();
-      if (flowlabel.has_value())
-      {
-        // set flow label if desired
-        hdr->FlowLabel(*flowlabel);
-      }
+    static constexpr size_t ipv6HeaderSize = 4 + 4 + 16 + 16;
 
-      const auto oldSrcIP = hdr->srcaddr;
-      const auto oldDstIP = hdr->dstaddr;
-      const uint32_t* oSrcIP = in6_uint32_ptr(oldSrcIP);
-      const uint32_t* oDstIP = in6_uint32_ptr(oldDstIP);
+    /// like rewriteIPv4 for an ipv6 packet longer than its fixed header
+    static void
+    rewriteIPv6(IPPacket& pkt, const in6_addr& nSrcIP, const in6_addr& nDstIP, uint32_t delta)
+    {
+      auto hdr = pkt.HeaderV6();
 
       // IPv6 address
-      hdr->srcaddr = HUIntToIn6(src);
-      hdr->dstaddr = HUIntToIn6(dst);
-      const uint32_t* nSrcIP = in6_uint32_ptr(hdr->srcaddr);
-      const uint32_t* nDstIP = in6_uint32_ptr(hdr->dstaddr);
+      hdr->srcaddr = nSrcIP;
+      hdr->dstaddr = nDstIP;
 
       // TODO IPv6 header options
-      auto pld = buf + ihs;
-      auto psz = sz - ihs;
+      auto pld = pkt.buf + ipv6HeaderSize;
+      auto psz = pkt.sz - ipv6HeaderSize;
 
       size_t fragoff = 0;
       auto nextproto = hdr->proto;
@@ -440,18 +333,101 @@ namespace llarp
       switch (nextproto)
       {
         case 6:  // TCP
-          deltaChecksumIPv6TCP(pld, psz, fragoff, 16, oSrcIP, oDstIP, nSrcIP, nDstIP);
+          deltaChecksumTCP(pld, psz, fragoff, 16, delta);
           break;
         case 17:   // UDP
         case 136:  // UDP-Lite - same checksum place, same 0->0xFFff condition
-          deltaChecksumIPv6UDP(pld, psz, fragoff, oSrcIP, oDstIP, nSrcIP, nDstIP);
+          deltaChecksumUDP(pld, psz, fragoff, delta);
           break;
         case 33:  // DCCP
-          deltaChecksumIPv6TCP(pld, psz, fragoff, 6, oSrcIP, oDstIP, nSrcIP, nDstIP);
+          deltaChecksumTCP(pld, psz, fragoff, 6, delta);
           break;
       }
     }
 
+    void
+    IPPacket::UpdateIPv4Address(nuint32_t nSrcIP, nuint32_t nDstIP)
+    {
+      llarp::LogDebug("set src=", nSrcIP, " dst=", nDstIP);
+
+      auto hdr = Header();
+      const auto delta =
+          deltaIPv4Addresses(nuint32_t{hdr->saddr}, nuint32_t{hdr->daddr}, nSrcIP, nDstIP);
+      rewriteIPv4(*this, nSrcIP, nDstIP, delta);
+    }
+
+    void
+    IPPacket::UpdateIPv6Address(huint128_t src, huint128_t dst, std::optional<nuint32_t> flowlabel)
+    {
+      // XXX should've been checked at upper level?
+      if (sz <= ipv6HeaderSize)
+        return;
+
+      auto hdr = HeaderV6();
+      if (flowlabel.has_value())
+      {
+        // set flow label if desired
+        hdr->FlowLabel(*flowlabel);
+      }
+
+      const auto nSrcIP = HUIntToIn6(src);
+      const auto nDstIP = HUIntToIn6(dst);
+      const auto delta = deltaIPv6Addresses(
+          in6_uint32_ptr(hdr->srcaddr),
+          in6_uint32_ptr(hdr->dstaddr),
+          in6_uint32_ptr(nSrcIP),
+          in6_uint32_ptr(nDstIP));
+      rewriteIPv6(*this, nSrcIP, nDstIP, delta);
+    }
+
+    void
+    AddressRewriter::Rewrite(IPPacket& pkt, huint128_t src, huint128_t dst)
+    {
+      if (pkt.IsV4())
+      {
+        const auto hdr = pkt.Header();
+        if (not m_LastV4 or hdr->saddr != m_LastV4->oSrcIP or hdr->daddr != m_LastV4->oDstIP
+            or src != m_LastV4->src or dst != m_LastV4->dst)
+        {
+          const auto nSrcIP = xhtonl(TruncateV6(src));
+          const auto nDstIP = xhtonl(TruncateV6(dst));
+          m_LastV4 = V4{
+              hdr->saddr,
+              hdr->daddr,
+              src,
+              dst,
+              nSrcIP,
+              nDstIP,
+              deltaIPv4Addresses(nuint32_t{hdr->saddr}, nuint32_t{hdr->daddr}, nSrcIP, nDstIP)};
+        }
+        rewriteIPv4(pkt, m_LastV4->nSrcIP, m_LastV4->nDstIP, m_LastV4->delta);
+      }
+      else if (pkt.IsV6() and pkt.sz > ipv6HeaderSize)
+      {
+        const auto hdr = pkt.HeaderV6();
+        if (not m_LastV6 or std::memcmp(&hdr->srcaddr, &m_LastV6->oSrcIP, 16) != 0
+            or std::memcmp(&hdr->dstaddr, &m_LastV6->oDstIP, 16) != 0 or src != m_LastV6->src
+            or dst != m_LastV6->dst)
+        {
+          const auto nSrcIP = HUIntToIn6(src);
+          const auto nDstIP = HUIntToIn6(dst);
+          m_LastV6 = V6{
+              hdr->srcaddr,
+              hdr->dstaddr,
+              src,
+              dst,
+              nSrcIP,
+              nDstIP,
+              deltaIPv6Addresses(
+                  in6_uint32_ptr(hdr->srcaddr),
+                  in6_uint32_ptr(hdr->dstaddr),
+                  in6_uint32_ptr(nSrcIP),
+                  in6_uint32_ptr(nDstIP))};
+        }
+        rewriteIPv6(pkt, m_LastV6->nSrcIP, m_LastV6->nDstIP, m_LastV6->delta);
+      }
+    }
+
     void
     IPPacket::ZeroAddresses(std::optional<nuint32_t> flowlabel)
     {
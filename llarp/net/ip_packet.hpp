@@ -277,6 +277,37 @@ namespace llarp
       MakeICMPUnreachable() const;
     };
 
+    /// rewrites the addresses of a run of packets, such as a flush queue, as UpdateIPv4Address
+    /// and UpdateIPv6Address would one at a time; an ipv4 packet takes the ipv4 part of them.
+    /// how much a rewrite changes the checksums only depends on the old and new addresses, so it
+    /// is kept from one packet to the next and only worked out again when they change.
+    class AddressRewriter
+    {
+     public:
+      void
+      Rewrite(IPPacket& pkt, huint128_t src, huint128_t dst);
+
+     private:
+      struct V4
+      {
+        uint32_t oSrcIP, oDstIP;
+        huint128_t src, dst;
+        nuint32_t nSrcIP, nDstIP;
+        uint32_t delta;
+      };
+
+      struct V6
+      {
+        in6_addr oSrcIP, oDstIP;
+        huint128_t src, dst;
+        in6_addr nSrcIP, nDstIP;
+        uint32_t delta;
+      };
+
+      std::optional<V4> m_LastV4;
+      std::optional<V6> m_LastV6;
+    };
+
     /// generate ip checksum
     uint16_t
     ipchksum(const byte_t* buf, size_t sz, uint32_t sum = 0);
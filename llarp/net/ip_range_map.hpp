@@ -1,17 +1,24 @@
 #pragma once
 
 #include "ip_range.hpp"
+#include "ip_range_table.hpp"
 #include <llarp/util/status.hpp>
+#include <algorithm>
+#include <functional>
 #include <list>
+#include <memory>
+#include <optional>
+#include <set>
 
 namespace llarp
 {
   namespace net
   {
     /// a container that maps an ip range to a value that allows you to lookup
-    /// key by range hit
-    /// TODO: do some kind of magic shit to ensure near constant time for
-    /// lookups
+    /// key by range hit.
+    /// lookups by ip go through an IPRangeTable compiled from the entries, which is rebuilt on the
+    /// first lookup after they change and swapped in atomically so a snapshot from Table() can be
+    /// used off the thread that modifies the map.
     template <typename Value_t>
     struct IPRangeMap
     {
@@ -94,14 +101,37 @@ namespace llarp
       FindAll(const IP_t& addr) const
       {
         std::set<Value_t> found;
-        for (const auto& entry : m_Entries)
-        {
-          if (entry.first.Contains(addr))
-            found.insert(entry.second);
-        }
+        Current().ForEachMatch(addr, [&found](const auto& val) { found.insert(val); });
         return found;
       }
 
+      /// return the value of the most specific range containing this IP, of equally specific ones
+      /// the smallest value
+      std::optional<Value_t>
+      FindLongest(const IP_t& addr) const
+      {
+        if (const auto* val = Current().FindLongest(addr))
+          return *val;
+        return std::nullopt;
+      }
+
+      /// return true if any range containing this IP maps to val
+      bool
+      Matches(const IP_t& addr, const Value_t& val) const
+      {
+        return Current().Matches(addr, val);
+      }
+
+      /// get the lookup table for the current entries, building it if they changed since the last
+      /// call. must be called from the thread that modifies the map; the returned table stays
+      /// valid after that.
+      std::shared_ptr<const IPRangeTable<Value_t>>
+      Table() const
+      {
+        Current();
+        return std::atomic_load(&m_Table);
+      }
+
       struct CompareEntry
       {
         bool
@@ -114,8 +144,15 @@ namespace llarp
       void
       Insert(const Range_t& addr, const Value_t& val)
       {
-        m_Entries.emplace_front(addr, val);
-        m_Entries.sort(CompareEntry{});
+        const Entry_t entry{addr, val};
+        // new entries go in front of equal ones
+        m_Entries.insert(
+            std::find_if(
+                m_Entries.begin(),
+                m_Entries.end(),
+                [&entry](const auto& other) { return not CompareEntry{}(other, entry); }),
+            entry);
+        m_Dirty = true;
       }
 
       template <typename Visit_t>
@@ -126,7 +163,10 @@ namespace llarp
         while (itr != m_Entries.end())
         {
           if (visit(*itr))
+          {
             itr = m_Entries.erase(itr);
+            m_Dirty = true;
+          }
           else
             ++itr;
         }
@@ -144,7 +184,26 @@ namespace llarp
       }
 
      private:
+      /// the table for the current entries. only we replace m_Table so we do not need an atomic
+      /// load to read it here, only the store needs to be atomic for other threads' Table().
+      const IPRangeTable<Value_t>&
+      Current() const
+      {
+        if (m_Dirty)
+        {
+          std::atomic_store(
+              &m_Table,
+              std::shared_ptr<const IPRangeTable<Value_t>>{std::make_shared<IPRangeTable<Value_t>>(
+                  std::vector<Entry_t>{m_Entries.begin(), m_Entries.end()})});
+          m_Dirty = false;
+        }
+        return *m_Table;
+      }
+
       Container_t m_Entries;
+      mutable std::shared_ptr<const IPRangeTable<Value_t>> m_Table =
+          std::make_shared<IPRangeTable<Value_t>>();
+      mutable bool m_Dirty = false;
     };
   }  // namespace net
 }  // namespace llarp
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "ip_range.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace net
+  {
+    /// an immutable longest prefix match table over ip ranges, built once from a list of ranges.
+    ///
+    /// ipv4 mapped ranges live in a trie of their own over the 32 bit address so they do not pay
+    /// for 12 levels of ::ffff:0:0/96, everything else in one over the full 128 bits.  both are
+    /// poptries: every node splits on the next 8 bits of the address, and instead of 256
+    /// pointers it keeps two 256 bit bitmaps, one for the slots that have a child node and one
+    /// for the slots where the leaf value changes, and finds a slot's child or leaf by counting
+    /// the bits below it.  the children and leaves of a node are contiguous, so a lookup is one
+    /// node and a popcount per byte of the address and ends on a leaf after at most 4 (ipv4) or
+    /// 16 (ipv6) nodes.
+    template <typename Value_t>
+    class IPRangeTable
+    {
+     public:
+      using Entry_t = std::pair<IPRange, Value_t>;
+
+      IPRangeTable() = default;
+
+      explicit IPRangeTable(std::vector<Entry_t> entries) : m_Entries{std::move(entries)}
+      {
+        // shorter ranges go in first so longer ones overwrite them; of two equal ranges the
+        // smaller value goes in last so it is the one we find
+        std::vector<uint32_t> order(m_Entries.size());
+        for (uint32_t idx = 0; idx < order.size(); ++idx)
+          order[idx] = idx;
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+          const auto lenA = PrefixLen(m_Entries[a].first);
+          const auto lenB = PrefixLen(m_Entries[b].first);
+          if (lenA != lenB)
+            return lenA < lenB;
+          return m_Entries[b].second < m_Entries[a].second;
+        });
+
+        m_Parent.resize(m_Entries.size(), None);
+        Builder v4, v6;
+        for (const auto idx : order)
+        {
+          const auto& range = m_Entries[idx].first;
+          const auto len = PrefixLen(range);
+          if (len >= 96 and range.IsV4())
+          {
+            m_Parent[idx] = v4.Insert(V4Key(range.addr), len - 96, idx);
+            continue;
+          }
+          m_Parent[idx] = v6.Insert(V6Key(range.addr), len, idx);
+          // a short range that holds all of ipv4 covers the whole of the ipv4 trie
+          if (range.Contains(V4Mapped))
+            v4.Insert(V4Key(V4Mapped), 0, idx);
+        }
+        m_V4 = v4.Compile();
+        m_V6 = v6.Compile();
+      }
+
+      bool
+      Empty() const
+      {
+        return m_Entries.empty();
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Entries.size();
+      }
+
+      /// the value of the most specific range containing ip or nullptr if none does
+      const Value_t*
+      FindLongest(const huint128_t& ip) const
+      {
+        const auto idx = Lookup(ip);
+        if (idx == None)
+          return nullptr;
+        return &m_Entries[idx].second;
+      }
+
+      /// call visit with the value of every range containing ip, most specific first
+      template <typename Visit_t>
+      void
+      ForEachMatch(const huint128_t& ip, Visit_t visit) const
+      {
+        for (auto idx = Lookup(ip); idx != None; idx = m_Parent[idx])
+          visit(m_Entries[idx].second);
+      }
+
+      /// return true if a range containing ip maps to val
+      bool
+      Matches(const huint128_t& ip, const Value_t& val) const
+      {
+        for (auto idx = Lookup(ip); idx != None; idx = m_Parent[idx])
+        {
+          if (m_Entries[idx].second == val)
+            return true;
+        }
+        return false;
+      }
+
+     private:
+      static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+      static constexpr huint128_t V4Mapped{0x0000'ffff'0000'0000UL};
+
+      struct Node
+      {
+        std::array<uint64_t, 4> children{};
+        std::array<uint64_t, 4> leaves{};
+        uint32_t childBase = 0;
+        uint32_t leafBase = 0;
+      };
+
+      /// a compiled trie: m_Nodes[0] is the root unless there are no nodes at all
+      struct Trie
+      {
+        std::vector<Node> nodes;
+        std::vector<uint32_t> leaves;
+      };
+
+      /// set bits of bits at or below slot
+      static uint32_t
+      RankOf(const std::array<uint64_t, 4>& bits, uint8_t slot)
+      {
+        const auto word = slot >> 6;
+        const auto bit = slot & 63;
+        uint32_t rank = __builtin_popcountll(bits[word] & (~uint64_t{0} >> (63 - bit)));
+        for (int idx = 0; idx < word; ++idx)
+          rank += __builtin_popcountll(bits[idx]);
+        return rank;
+      }
+
+      static bool
+      HasBit(const std::array<uint64_t, 4>& bits, uint8_t slot)
+      {
+        return (bits[slot >> 6] >> (slot & 63)) & 1;
+      }
+
+      static int
+      PrefixLen(const IPRange& range)
+      {
+        return bits::count_bits(range.netmask_bits);
+      }
+
+      /// an address as the bits we walk a trie by, most significant first: the whole address for
+      /// the ipv6 trie, the ipv4 address in the top 32 bits for the ipv4 one
+      struct Key
+      {
+        uint64_t upper;
+        uint64_t lower;
+
+        uint8_t
+        operator[](int idx) const
+        {
+          return idx < 8 ? upper >> (56 - idx * 8) : lower >> (120 - idx * 8);
+        }
+      };
+
+      static Key
+      V6Key(const huint128_t& ip)
+      {
+        return Key{ip.h.upper, ip.h.lower};
+      }
+
+      static Key
+      V4Key(const huint128_t& ip)
+      {
+        return Key{ip.h.lower << 32, 0};
+      }
+
+      uint32_t
+      Lookup(const huint128_t& ip) const
+      {
+        if (ip.h.upper == 0 and (ip.h.lower >> 32) == 0xffff)
+          return Lookup(m_V4, V4Key(ip));
+        return Lookup(m_V6, V6Key(ip));
+      }
+
+      static uint32_t
+      Lookup(const Trie& trie, const Key& key)
+      {
+        if (trie.nodes.empty())
+          return None;
+        const Node* node = trie.nodes.data();
+        for (int idx = 0;; ++idx)
+        {
+          const auto slot = key[idx];
+          if (not HasBit(node->children, slot))
+            return trie.leaves[node->leafBase + RankOf(node->leaves, slot) - 1];
+          node = &trie.nodes[node->childBase + RankOf(node->children, slot) - 1];
+        }
+      }
+
+      /// a trie that we insert into and then compile. most nodes only have a child or two and a
+      /// handful of prefixes ending in them, so they keep a sorted list of their children and
+      /// of the runs of slots with the same value rather than 256 of each.
+      class Builder
+      {
+        struct BuildNode
+        {
+          std::vector<std::pair<uint8_t, uint32_t>> children;
+          /// (first slot, value) for each run of slots, sorted, the first one at slot 0
+          std::vector<std::pair<uint16_t, uint32_t>> runs;
+
+          uint32_t
+          ValueAt(uint16_t slot) const
+          {
+            auto itr = std::upper_bound(
+                runs.begin(), runs.end(), slot, [](auto slot, const auto& run) {
+                  return slot < run.first;
+                });
+            return std::prev(itr)->second;
+          }
+
+          uint32_t
+          ChildAt(uint8_t slot) const
+          {
+            auto itr = std::lower_bound(
+                children.begin(), children.end(), slot, [](const auto& child, auto slot) {
+                  return child.first < slot;
+                });
+            if (itr == children.end() or itr->first != slot)
+              return None;
+            return itr->second;
+          }
+
+          void
+          SetRange(uint16_t first, uint16_t end, uint32_t value)
+          {
+            const auto after = end < 256 ? ValueAt(end) : None;
+            auto begin = std::lower_bound(
+                runs.begin(), runs.end(), first, [](const auto& run, auto slot) {
+                  return run.first < slot;
+                });
+            auto itr = std::lower_bound(begin, runs.end(), end, [](const auto& run, auto slot) {
+              return run.first < slot;
+            });
+            const bool split = end < 256 and (itr == runs.end() or itr->first != end);
+            itr = runs.erase(begin, itr);
+            itr = runs.emplace(itr, first, value);
+            if (split)
+              runs.emplace(std::next(itr), end, after);
+          }
+        };
+        std::vector<BuildNode> m_Nodes;
+
+        uint32_t
+        NewNode(uint32_t value)
+        {
+          m_Nodes.emplace_back().runs.emplace_back(0, value);
+          return m_Nodes.size() - 1;
+        }
+
+        void
+        Compile(uint32_t from, size_t to, Trie& trie) const
+        {
+          const auto& build = m_Nodes[from];
+          Node node;
+          node.leafBase = trie.leaves.size();
+          auto child = build.children.begin();
+          auto run = build.runs.begin();
+          bool first = true;
+          uint32_t prev = None;
+          for (uint16_t slot = 0; slot < 256; ++slot)
+          {
+            if (std::next(run) != build.runs.end() and std::next(run)->first == slot)
+              ++run;
+            if (child != build.children.end() and child->first == slot)
+            {
+              node.children[slot >> 6] |= uint64_t{1} << (slot & 63);
+              ++child;
+            }
+            else if (first or run->second != prev)
+            {
+              node.leaves[slot >> 6] |= uint64_t{1} << (slot & 63);
+              trie.leaves.push_back(run->second);
+              prev = run->second;
+              first = false;
+            }
+          }
+          node.childBase = trie.nodes.size();
+          trie.nodes.resize(trie.nodes.size() + build.children.size());
+          trie.nodes[to] = node;
+          for (size_t idx = 0; idx < build.children.size(); ++idx)
+            Compile(build.children[idx].second, node.childBase + idx, trie);
+        }
+
+       public:
+        /// add a prefix of len bits of key mapping to value, which must not be shorter than any
+        /// prefix added before it.
+        /// returns the value of the most specific prefix added before that contains this one.
+        uint32_t
+        Insert(const Key& key, int len, uint32_t value)
+        {
+          if (m_Nodes.empty())
+            NewNode(None);
+          uint32_t node = 0;
+          // a prefix is set on up to 256 slots of the node at the depth of its last byte, with
+          // a node made for every byte before that. the new nodes start out with the value of
+          // the slot they hang off.
+          const int depth = len ? (len - 1) / 8 : 0;
+          for (int idx = 0; idx < depth; ++idx)
+          {
+            const auto slot = key[idx];
+            auto child = m_Nodes[node].ChildAt(slot);
+            if (child == None)
+            {
+              child = NewNode(m_Nodes[node].ValueAt(slot));
+              auto& children = m_Nodes[node].children;
+              children.emplace(
+                  std::lower_bound(
+                      children.begin(),
+                      children.end(),
+                      slot,
+                      [](const auto& child, auto slot) { return child.first < slot; }),
+                  slot,
+                  child);
+            }
+            node = child;
+          }
+          const int rest = len - depth * 8;
+          const uint16_t first = rest ? key[depth] & (0xff << (8 - rest)) & 0xff : 0;
+          const auto parent = m_Nodes[node].ValueAt(first);
+          m_Nodes[node].SetRange(first, first + (1 << (8 - rest)), value);
+          return parent;
+        }
+
+        Trie
+        Compile() const
+        {
+          Trie trie;
+          if (m_Nodes.empty())
+            return trie;
+          trie.nodes.resize(1);
+          Compile(0, 0, trie);
+          return trie;
+        }
+      };
+
+      std::vector<Entry_t> m_Entries;
+      /// the entry of the next most specific range containing each one, None if there is none
+      std::vector<uint32_t> m_Parent;
+      Trie m_V4;
+      Trie m_V6;
+    };
+  }  // namespace net
+}  // namespace llarp
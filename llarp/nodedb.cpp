@@ -9,6 +9,7 @@
 #include "util/mem.hpp"
 #include "util/str.hpp"
 #include "dht/kademlia.hpp"
+#include "router/rc_verifier.hpp"
 
 #include <algorithm>
 #include <fstream>
@@ -17,6 +18,7 @@
 
 static const char skiplist_subdirs[] = "0123456789abcdef";
 static const std::string RC_FILE_EXT = ".signed";
+static const std::string LOG_FILE_NAME = "nodedb.log";
 
 namespace llarp
 {
@@ -54,14 +56,76 @@ namespace llarp
     }
   }
 
+  /// remove the per rc files once they are in the single file, returns how many there were
+  static size_t
+  RemoveSkiplistFiles(const fs::path& nodedbDir)
+  {
+    std::vector<fs::path> files;
+    for (const char& ch : skiplist_subdirs)
+    {
+      if (!ch)
+        continue;
+      llarp::util::IterDir(nodedbDir / std::string(&ch, 1), [&files](const fs::path& f) -> bool {
+        if (fs::is_regular_file(f) and f.extension() == RC_FILE_EXT)
+          files.push_back(f);
+        return true;
+      });
+    }
+    size_t removed = 0;
+    for (const auto& f : files)
+    {
+      std::error_code ec;
+      if (fs::remove(f, ec))
+        ++removed;
+      else
+        LogWarn("failed to remove ", f, ": ", ec.message());
+    }
+    return removed;
+  }
+
   constexpr auto FlushInterval = 5min;
 
-  NodeDB::NodeDB(fs::path root, std::function<void(std::function<void()>)> diskCaller)
+  NodeDB::NodeDB(
+      fs::path root, std::function<void(std::function<void()>)> diskCaller, bool singleFile)
       : m_Root{std::move(root)}
       , disk(std::move(diskCaller))
       , m_NextFlushAt{time_now_ms() + FlushInterval}
   {
     EnsureSkiplist(m_Root);
+    if (singleFile)
+      m_Log = std::make_unique<NodeDBLog>(m_Root / LOG_FILE_NAME);
+  }
+
+  void
+  NodeDB::SetEntry(RouterContact rc)
+  {
+    const RouterID id{rc.pubkey};
+    m_Entries.erase(id);
+    const auto itr = m_Entries.emplace(id, std::move(rc)).first;
+    m_Closest.Insert(dht::Key_t{id});
+    m_Hops.Insert(itr->second.rc);
+  }
+
+  NodeDB::NodeMap::iterator
+  NodeDB::EraseEntry(NodeMap::iterator itr)
+  {
+    m_Closest.Remove(dht::Key_t{itr->first});
+    m_Hops.Remove(itr->first);
+    return m_Entries.erase(itr);
+  }
+
+  std::vector<RouterContact>
+  NodeDB::TakeDirty()
+  {
+    std::vector<RouterContact> dirty;
+    dirty.reserve(m_Dirty.size());
+    for (const auto& id : m_Dirty)
+    {
+      if (auto itr = m_Entries.find(id); itr != m_Entries.end())
+        dirty.push_back(itr->second.rc);
+    }
+    m_Dirty.clear();
+    return dirty;
   }
 
   void
@@ -70,13 +134,19 @@ namespace llarp
     if (now > m_NextFlushAt)
     {
       m_NextFlushAt += FlushInterval;
-      // make copy of all rcs
-      std::vector<RouterContact> copy;
-      for (const auto& item : m_Entries)
-        copy.push_back(item.second.rc);
-      // flush them to disk in one big job
-      // TODO: split this up? idk maybe some day...
-      disk([this, data = std::move(copy)]() {
+      util::NullLock lock{m_Access};
+      if (m_Dirty.empty() and m_Removed.empty())
+        return;
+      // only what changed since the last flush goes out
+      if (m_Log)
+      {
+        disk([log = m_Log.get(), data = TakeDirty(), removed = std::move(m_Removed)]() {
+          log->Append(data, removed);
+        });
+        m_Removed.clear();
+        return;
+      }
+      disk([this, data = TakeDirty()]() {
         for (const auto& rc : data)
         {
           rc.Write(GetPathForPubkey(rc.pubkey));
@@ -102,6 +172,84 @@ namespace llarp
   void
   NodeDB::LoadFromDisk()
   {
+    if (m_Log)
+      LoadFromLog();
+    else
+      LoadFromFiles();
+  }
+
+  void
+  NodeDB::LoadFromLog()
+  {
+    if (not fs::exists(m_Log->File()))
+    {
+      // first start with a single file, everything we had goes into it right away so the per rc
+      // files are not left behind for good
+      LoadFromFiles();
+      std::vector<RouterContact> rcs;
+      rcs.reserve(m_Entries.size());
+      for (const auto& item : m_Entries)
+        rcs.push_back(item.second.rc);
+      if (not m_Log->Append(rcs, {}))
+      {
+        // keep the files and try again on the next flush
+        for (const auto& item : m_Entries)
+          m_Dirty.insert(item.first);
+        return;
+      }
+      LogInfo(
+          "moved ",
+          rcs.size(),
+          " rcs into ",
+          m_Log->File(),
+          ", removed ",
+          RemoveSkiplistFiles(m_Root),
+          " per rc files");
+      return;
+    }
+    const auto now = time_now_ms();
+    size_t checked = 0;
+    const bool loaded = m_Log->Load([&](const auto& rcs, const auto& signatureChecked) {
+      // checking signatures is what makes loading slow, so rcs with a signature we already
+      // checked on an earlier run only get the cheap checks and the rest are checked in parallel
+      std::vector<RouterContact> unchecked;
+      for (size_t idx = 0; idx < rcs.size(); ++idx)
+      {
+        if (not signatureChecked[idx])
+          unchecked.push_back(rcs[idx]);
+      }
+      const auto valid = VerifyRCs(unchecked, now);
+      std::vector<bool> keep(rcs.size());
+      for (size_t idx = 0, next = 0; idx < rcs.size(); ++idx)
+      {
+        if (signatureChecked[idx])
+        {
+          keep[idx] = rcs[idx].VerifyExceptSignature(now);
+          checked += keep[idx];
+        }
+        else
+          keep[idx] = valid[next++];
+        if (keep[idx])
+          SetEntry(rcs[idx]);
+      }
+      return keep;
+    });
+    if (not loaded)
+      throw std::runtime_error{stringify("cannot load nodedb from ", m_Log->File())};
+    LogDebug(
+        "loaded ",
+        m_Entries.size(),
+        " rcs from ",
+        m_Log->File(),
+        ", ",
+        checked,
+        " already checked");
+  }
+
+  void
+  NodeDB::LoadFromFiles()
+  {
+    std::vector<RouterContact> rcs;
     for (const char& ch : skiplist_subdirs)
     {
       if (!ch)
@@ -114,17 +262,30 @@ namespace llarp
         if (fs::is_regular_file(f) and f.extension() == RC_FILE_EXT)
         {
           RouterContact rc{};
-          if (rc.Read(f) and rc.Verify(time_now_ms()))
-            m_Entries.emplace(rc.pubkey, rc);
+          if (rc.Read(f))
+            rcs.emplace_back(std::move(rc));
         }
         return true;
       });
     }
+    const auto valid = VerifyRCs(rcs, time_now_ms());
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+    {
+      if (valid[idx])
+        SetEntry(std::move(rcs[idx]));
+    }
   }
 
   void
-  NodeDB::SaveToDisk() const
+  NodeDB::SaveToDisk()
   {
+    if (m_Log)
+    {
+      m_Log->Append(TakeDirty(), m_Removed);
+      m_Removed.clear();
+      return;
+    }
+    m_Dirty.clear();
     for (const auto& item : m_Entries)
     {
       item.second.rc.Write(GetPathForPubkey(item.first));
@@ -152,7 +313,8 @@ namespace llarp
   NodeDB::Remove(RouterID pk)
   {
     util::NullLock lock{m_Access};
-    m_Entries.erase(pk);
+    if (auto itr = m_Entries.find(pk); itr != m_Entries.end())
+      EraseEntry(itr);
     AsyncRemoveManyFromDisk({pk});
   }
 
@@ -167,7 +329,7 @@ namespace llarp
       if (itr->second.insertedAt < cutoff and keep.count(itr->second.rc.pubkey) == 0)
       {
         removed.insert(itr->second.rc.pubkey);
-        itr = m_Entries.erase(itr);
+        itr = EraseEntry(itr);
       }
       else
         ++itr;
@@ -180,8 +342,9 @@ namespace llarp
   NodeDB::Put(RouterContact rc)
   {
     util::NullLock lock{m_Access};
-    m_Entries.erase(rc.pubkey);
-    m_Entries.emplace(rc.pubkey, rc);
+    m_Dirty.insert(rc.pubkey);
+    m_Removed.erase(rc.pubkey);
+    SetEntry(std::move(rc));
   }
 
   size_t
@@ -198,17 +361,22 @@ namespace llarp
     auto itr = m_Entries.find(rc.pubkey);
     if (itr == m_Entries.end() or itr->second.rc.OtherIsNewer(rc))
     {
-      // delete if existing
-      if (itr != m_Entries.end())
-        m_Entries.erase(itr);
-      // add new entry
-      m_Entries.emplace(rc.pubkey, rc);
+      m_Dirty.insert(rc.pubkey);
+      m_Removed.erase(rc.pubkey);
+      SetEntry(std::move(rc));
     }
   }
 
   void
-  NodeDB::AsyncRemoveManyFromDisk(std::unordered_set<RouterID> remove) const
+  NodeDB::AsyncRemoveManyFromDisk(std::unordered_set<RouterID> remove)
   {
+    for (const auto& id : remove)
+      m_Dirty.erase(id);
+    if (m_Log)
+    {
+      m_Removed.merge(remove);
+      return;
+    }
     // build file list
     std::set<fs::path> files;
     for (auto id : remove)
@@ -226,47 +394,25 @@ namespace llarp
   NodeDB::FindClosestTo(llarp::dht::Key_t location) const
   {
     util::NullLock lock{m_Access};
-    llarp::RouterContact rc;
-    const llarp::dht::XorMetric compare(location);
-    VisitAll([&rc, compare](const auto& otherRC) {
-      if (rc.pubkey.IsZero())
-      {
-        rc = otherRC;
-        return;
-      }
-      if (compare(
-              llarp::dht::Key_t{otherRC.pubkey.as_array()},
-              llarp::dht::Key_t{rc.pubkey.as_array()}))
-        rc = otherRC;
-    });
-    return rc;
+    std::vector<dht::Key_t> closest;
+    m_Closest.FindClosest(location, 1, closest);
+    if (closest.empty())
+      return {};
+    return m_Entries.at(RouterID{closest.front().as_array()}).rc;
   }
 
   std::vector<RouterContact>
   NodeDB::FindManyClosestTo(llarp::dht::Key_t location, uint32_t numRouters) const
   {
     util::NullLock lock{m_Access};
-    std::vector<const RouterContact*> all;
-
-    const auto& entries = m_Entries;
-
-    all.reserve(entries.size());
-    for (auto& entry : entries)
-    {
-      all.push_back(&entry.second.rc);
-    }
-
-    auto it_mid = numRouters < all.size() ? all.begin() + numRouters : all.end();
-    std::partial_sort(
-        all.begin(), it_mid, all.end(), [compare = dht::XorMetric{location}](auto* a, auto* b) {
-          return compare(*a, *b);
-        });
+    std::vector<dht::Key_t> keys;
+    keys.reserve(std::min<size_t>(numRouters, m_Entries.size()));
+    m_Closest.FindClosest(location, numRouters, keys);
 
     std::vector<RouterContact> closest;
-    closest.reserve(numRouters);
-    for (auto it = all.begin(); it != it_mid; ++it)
-      closest.push_back(**it);
-
+    closest.reserve(keys.size());
+    for (const auto& key : keys)
+      closest.push_back(m_Entries.at(RouterID{key.as_array()}).rc);
     return closest;
   }
 }  // namespace llarp
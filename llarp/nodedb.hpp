@@ -7,7 +7,10 @@
 #include "util/thread/threading.hpp"
 #include "util/thread/annotations.hpp"
 #include "dht/key.hpp"
+#include "dht/xor_index.hpp"
+#include "path/hop_index.hpp"
 #include "crypto/crypto.hpp"
+#include "nodedb_log.hpp"
 
 #include <set>
 #include <optional>
@@ -16,6 +19,7 @@
 #include <utility>
 #include <atomic>
 #include <algorithm>
+#include <memory>
 
 namespace llarp
 {
@@ -31,6 +35,12 @@ namespace llarp
 
     NodeMap m_Entries;
 
+    /// the keys of m_Entries for finding the routers closest to a dht location
+    dht::XorIndex m_Closest;
+
+    /// the rcs in m_Entries as candidates for path hops
+    path::HopIndex m_Hops;
+
     const fs::path m_Root;
 
     const std::function<void(std::function<void()>)> disk;
@@ -39,24 +49,58 @@ namespace llarp
 
     mutable util::NullMutex m_Access;
 
-    /// asynchronously remove the files for a set of rcs on disk given their public ident key
+    /// set when we keep everything in one file instead of one file per rc
+    std::unique_ptr<NodeDBLog> m_Log;
+
+    /// routers whose rc changed since the last flush
+    std::unordered_set<RouterID> m_Dirty;
+
+    /// routers dropped since the last flush, only used with m_Log
+    std::unordered_set<RouterID> m_Removed;
+
+    /// remove a set of rcs on disk given their public ident key: the files are removed
+    /// asynchronously, with m_Log the removal is written out on the next flush
     void
-    AsyncRemoveManyFromDisk(std::unordered_set<RouterID> idents) const;
+    AsyncRemoveManyFromDisk(std::unordered_set<RouterID> idents);
+
+    /// add rc, replacing any entry for the same router
+    void
+    SetEntry(RouterContact rc);
+
+    NodeMap::iterator
+    EraseEntry(NodeMap::iterator itr);
+
+    /// the rcs of routers in m_Dirty, clears m_Dirty
+    std::vector<RouterContact>
+    TakeDirty();
+
+    /// load from the skiplist of per rc files
+    void
+    LoadFromFiles();
+
+    /// load from m_Log, carrying over any per rc files the first time and then removing them
+    void
+    LoadFromLog();
 
     /// get filename of an RC file given its public ident key
     fs::path
     GetPathForPubkey(RouterID pk) const;
 
    public:
-    explicit NodeDB(fs::path rootdir, std::function<void(std::function<void()>)> diskCaller);
+    /// singleFile keeps the rcs in one append only file in rootdir rather than a file each
+    explicit NodeDB(
+        fs::path rootdir,
+        std::function<void(std::function<void()>)> diskCaller,
+        bool singleFile = false);
 
     /// load all entries from disk syncrhonously
     void
     LoadFromDisk();
 
-    /// explicit save all RCs to disk synchronously
+    /// explicit save all RCs to disk synchronously, with a single file only what changed is
+    /// written
     void
-    SaveToDisk() const;
+    SaveToDisk();
 
     /// the number of RCs that are loaded from disk
     size_t
@@ -82,6 +126,14 @@ namespace llarp
     std::optional<RouterContact>
     Get(RouterID pk) const;
 
+    /// every router we know of as a candidate path hop, for picking hops without going over the
+    /// whole nodedb
+    path::HopIndex&
+    HopCandidates()
+    {
+      return m_Hops;
+    }
+
     template <typename Filter>
     std::optional<RouterContact>
     GetRandom(Filter visit) const
@@ -145,7 +197,7 @@ namespace llarp
         if (visit(itr->second.rc))
         {
           removed.insert(itr->second.rc.pubkey);
-          itr = m_Entries.erase(itr);
+          itr = EraseEntry(itr);
         }
         else
           ++itr;
@@ -158,11 +210,12 @@ namespace llarp
     void
     RemoveStaleRCs(std::unordered_set<RouterID> keep, llarp_time_t cutoff);
 
-    /// put this rc into the cache if it is not there or newer than the one there already
+    /// put this rc into the cache if it is not there or newer than the one there already. the
+    /// rc's signature must have been checked, a single file nodedb remembers that it was.
     void
     PutIfNewer(RouterContact rc);
 
-    /// unconditional put of rc into cache
+    /// unconditional put of rc into cache, the same goes for its signature as for PutIfNewer
     void
     Put(RouterContact rc);
   };
@@ -0,0 +1,458 @@
+#include "nodedb_log.hpp"
+
+#include "crypto/crypto.hpp"
+#include "util/buffer.hpp"
+#include "util/endian.hpp"
+#include "util/logging/logger.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llarp
+{
+  namespace
+  {
+    constexpr std::array<byte_t, 8> Magic{'l', 'l', 'n', 'd', 'b', 'v', '1', '\n'};
+
+    // a record is:
+    //   u32 le  size of the payload
+    //   u32 le  checksum of everything after it
+    //   u8      type
+    //   32      router id for rc and tombstone records, rc hash for checked records
+    //   size    payload, the encoded rc for rc records and nothing for the others
+    constexpr size_t RecordHeaderSize = 4 + 4 + 1 + 32;
+    static_assert(RouterID::SIZE == 32 and ShortHash::SIZE == 32);
+
+    enum class RecordType : byte_t
+    {
+      RC = 1,
+      Tombstone = 2,
+      Checked = 3
+    };
+
+    /// don't bother compacting files smaller than this
+    constexpr uint64_t CompactMinSize = 256 * 1024;
+
+    /// fnv-1a, enough to spot a torn or scribbled record; the rc signatures do the real work
+    uint32_t
+    Checksum(const byte_t* data, size_t sz)
+    {
+      uint32_t h = 2166136261u;
+      for (size_t idx = 0; idx < sz; ++idx)
+      {
+        h ^= data[idx];
+        h *= 16777619u;
+      }
+      return h;
+    }
+
+    void
+    PutRecord(
+        std::vector<byte_t>& out,
+        RecordType type,
+        const byte_t* key,
+        const byte_t* payload,
+        size_t sz)
+    {
+      const auto start = out.size();
+      out.resize(start + RecordHeaderSize + sz);
+      auto* rec = out.data() + start;
+      htole32buf(rec, sz);
+      rec[8] = static_cast<byte_t>(type);
+      std::memcpy(rec + 9, key, 32);
+      if (sz)
+        std::memcpy(rec + RecordHeaderSize, payload, sz);
+      htole32buf(rec + 4, Checksum(rec + 8, RecordHeaderSize - 8 + sz));
+    }
+
+    ShortHash
+    HashOf(const byte_t* data, size_t sz)
+    {
+      ShortHash h;
+      CryptoManager::instance()->shorthash(h, llarp_buffer_t{data, sz});
+      return h;
+    }
+
+    bool
+    WriteOut(const fs::path& file, const std::vector<byte_t>& data, std::ios::openmode mode)
+    {
+      std::ofstream f{file.string(), std::ios::binary | mode};
+      if (not f.is_open())
+        return false;
+      f.write(reinterpret_cast<const char*>(data.data()), data.size());
+      f.flush();
+      return f.good();
+    }
+
+    /// replace file with data all at once, so a failed write leaves it as it was
+    bool
+    ReplaceFile(const fs::path& file, const std::vector<byte_t>& data)
+    {
+      const fs::path tmpFile{file.string() + ".tmp"};
+      std::error_code ec;
+      if (not WriteOut(tmpFile, data, std::ios::trunc))
+      {
+        LogError("failed to write ", tmpFile);
+        fs::remove(tmpFile, ec);
+        return false;
+      }
+      fs::rename(tmpFile, file, ec);
+      if (ec)
+      {
+        LogError("failed to replace ", file, ": ", ec.message());
+        fs::remove(tmpFile, ec);
+        return false;
+      }
+      return true;
+    }
+
+    /// the payload size of the record at offset into data if a whole, intact one starts there
+    std::optional<size_t>
+    RecordAt(const byte_t* data, size_t size, uint64_t offset)
+    {
+      if (offset + RecordHeaderSize > size)
+        return std::nullopt;
+      const auto* rec = data + offset;
+      const size_t sz = le32toh(buf32toh(rec));
+      if (sz > MAX_RC_SIZE or offset + RecordHeaderSize + sz > size)
+        return std::nullopt;
+      if (rec[8] < static_cast<byte_t>(RecordType::RC)
+          or rec[8] > static_cast<byte_t>(RecordType::Checked))
+        return std::nullopt;
+      if (Checksum(rec + 8, RecordHeaderSize - 8 + sz) != le32toh(buf32toh(rec + 4)))
+        return std::nullopt;
+      return sz;
+    }
+
+    /// a read only view of a whole file, mapped where we can
+    class FileView
+    {
+     public:
+      explicit FileView(const fs::path& file)
+      {
+#ifdef _WIN32
+        std::ifstream f{file.string(), std::ios::binary};
+        if (f.is_open())
+          m_Copy.assign(std::istreambuf_iterator<char>{f}, std::istreambuf_iterator<char>{});
+        m_Data = reinterpret_cast<const byte_t*>(m_Copy.data());
+        m_Size = m_Copy.size();
+#else
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+          return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 and st.st_size > 0)
+        {
+          void* ptr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (ptr != MAP_FAILED)
+          {
+            ::madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+            m_Data = static_cast<const byte_t*>(ptr);
+            m_Size = st.st_size;
+          }
+        }
+        ::close(fd);
+#endif
+      }
+
+      FileView(const FileView&) = delete;
+      FileView&
+      operator=(const FileView&) = delete;
+
+      ~FileView()
+      {
+#ifndef _WIN32
+        if (m_Data)
+          ::munmap(const_cast<byte_t*>(m_Data), m_Size);
+#endif
+      }
+
+      const byte_t*
+      data() const
+      {
+        return m_Data;
+      }
+
+      size_t
+      size() const
+      {
+        return m_Size;
+      }
+
+     private:
+      const byte_t* m_Data = nullptr;
+      size_t m_Size = 0;
+#ifdef _WIN32
+      std::string m_Copy;
+#endif
+    };
+  }  // namespace
+
+  NodeDBLog::NodeDBLog(fs::path file) : m_File{std::move(file)}
+  {}
+
+  bool
+  NodeDBLog::Load(LoadVisitor visit)
+  {
+    std::unique_lock lock{m_Access};
+    m_Index.clear();
+    m_Checked.clear();
+    m_PendingChecked.clear();
+    m_FileSize = 0;
+    m_LiveBytes = 0;
+    if (not fs::exists(m_File))
+      return true;
+
+    size_t torn = 0;
+    {
+      FileView view{m_File};
+      if (view.size() < Magic.size()
+          or std::memcmp(view.data(), Magic.data(), Magic.size()) != 0)
+      {
+        LogError(m_File, " is not a nodedb log");
+        return false;
+      }
+
+      // index the newest record for every router without decoding anything
+      uint64_t offset = Magic.size();
+      size_t damaged = 0;
+      while (offset < view.size())
+      {
+        const auto sz = RecordAt(view.data(), view.size(), offset);
+        if (not sz)
+        {
+          // a bad record that runs to the end of the file is what a crash in the middle of an
+          // append leaves behind, one with good records after it was scribbled on and is skipped
+          auto next = offset + 1;
+          while (next < view.size() and not RecordAt(view.data(), view.size(), next))
+            ++next;
+          if (next >= view.size())
+            break;
+          damaged += next - offset;
+          offset = next;
+          continue;
+        }
+        const auto* rec = view.data() + offset;
+        const auto type = static_cast<RecordType>(rec[8]);
+        const auto* key = rec + 9;
+        if (type == RecordType::RC or type == RecordType::Tombstone)
+        {
+          const RouterID id{key};
+          if (auto itr = m_Index.find(id); itr != m_Index.end())
+          {
+            m_LiveBytes -= itr->second.size;
+            m_Index.erase(itr);
+          }
+          if (type == RecordType::RC)
+          {
+            const uint32_t recordSize = RecordHeaderSize + *sz;
+            m_Index.emplace(id, Span{offset, recordSize, HashOf(rec + RecordHeaderSize, *sz)});
+            m_LiveBytes += recordSize;
+          }
+        }
+        else
+          m_Checked.emplace(key);
+        offset += RecordHeaderSize + *sz;
+      }
+      if (damaged)
+        LogWarn("skipped ", damaged, " bytes of damaged records in ", m_File);
+      m_FileSize = offset;
+      torn = view.size() - offset;
+
+      std::vector<RouterID> ids, dropped;
+      std::vector<RouterContact> rcs;
+      std::vector<bool> checked;
+      for (const auto& [id, span] : m_Index)
+      {
+        RouterContact rc;
+        llarp_buffer_t buf{
+            view.data() + span.offset + RecordHeaderSize, span.size - RecordHeaderSize};
+        if (not rc.BDecode(&buf) or not(rc.pubkey == id))
+        {
+          dropped.emplace_back(id);
+          continue;
+        }
+        ids.emplace_back(id);
+        rcs.emplace_back(std::move(rc));
+        checked.push_back(m_Checked.count(span.hash) != 0);
+      }
+      const auto keep = visit(rcs, checked);
+      for (size_t idx = 0; idx < ids.size(); ++idx)
+      {
+        if (idx >= keep.size() or not keep[idx])
+        {
+          dropped.emplace_back(ids[idx]);
+          continue;
+        }
+        if (not checked[idx])
+        {
+          const auto& hash = m_Index[ids[idx]].hash;
+          m_Checked.emplace(hash);
+          m_PendingChecked.emplace_back(hash);
+        }
+      }
+      for (const auto& id : dropped)
+      {
+        m_LiveBytes -= m_Index[id].size;
+        m_Index.erase(id);
+      }
+    }
+
+    if (torn)
+    {
+      LogWarn("dropping ", torn, " bytes of incomplete records at the end of ", m_File);
+      std::error_code ec;
+      fs::resize_file(m_File, m_FileSize, ec);
+      if (ec)
+        LogError("failed to truncate ", m_File, ": ", ec.message());
+    }
+    return true;
+  }
+
+  bool
+  NodeDBLog::Append(
+      const std::vector<RouterContact>& rcs, const std::unordered_set<RouterID>& removed)
+  {
+    std::unique_lock lock{m_Access};
+    std::vector<byte_t> out;
+    if (m_FileSize == 0)
+      out.assign(Magic.begin(), Magic.end());
+
+    std::vector<std::pair<RouterID, Span>> added;
+    std::array<byte_t, MAX_RC_SIZE> tmp;
+    for (const auto& rc : rcs)
+    {
+      llarp_buffer_t buf{tmp};
+      if (not rc.BEncode(&buf))
+      {
+        LogWarn("failed to encode rc for ", RouterID(rc.pubkey));
+        continue;
+      }
+      const size_t sz = buf.cur - buf.base;
+      const auto hash = HashOf(tmp.data(), sz);
+      added.emplace_back(
+          rc.pubkey,
+          Span{m_FileSize + out.size(), static_cast<uint32_t>(RecordHeaderSize + sz), hash});
+      PutRecord(out, RecordType::RC, rc.pubkey.data(), tmp.data(), sz);
+      // its signature was checked before it got into the nodedb
+      PutRecord(out, RecordType::Checked, hash.data(), nullptr, 0);
+    }
+    for (const auto& id : removed)
+      PutRecord(out, RecordType::Tombstone, id.data(), nullptr, 0);
+    for (const auto& hash : m_PendingChecked)
+      PutRecord(out, RecordType::Checked, hash.data(), nullptr, 0);
+
+    if (out.empty())
+      return true;
+    if (m_FileSize == 0)
+    {
+      // a new file is written whole, half a header would make it look like it is not a log
+      if (not ReplaceFile(m_File, out))
+        return false;
+    }
+    else if (not WriteOut(m_File, out, std::ios::app))
+    {
+      LogError("failed to append to ", m_File);
+      // don't leave half a record where the next append would go
+      std::error_code ec;
+      fs::resize_file(m_File, m_FileSize, ec);
+      return false;
+    }
+    m_FileSize += out.size();
+    m_PendingChecked.clear();
+
+    for (const auto& id : removed)
+    {
+      if (auto itr = m_Index.find(id); itr != m_Index.end())
+      {
+        m_LiveBytes -= itr->second.size;
+        m_Index.erase(itr);
+      }
+    }
+    for (auto& [id, span] : added)
+    {
+      m_Checked.emplace(span.hash);
+      auto& entry = m_Index[id];
+      m_LiveBytes -= entry.size;
+      entry = span;
+      m_LiveBytes += span.size;
+    }
+
+    if (ShouldCompact())
+      return CompactLocked();
+    return true;
+  }
+
+  bool
+  NodeDBLog::ShouldCompact() const
+  {
+    return m_FileSize > CompactMinSize and m_FileSize > 2 * m_LiveBytes;
+  }
+
+  bool
+  NodeDBLog::Compact()
+  {
+    std::unique_lock lock{m_Access};
+    return CompactLocked();
+  }
+
+  bool
+  NodeDBLog::CompactLocked()
+  {
+    std::vector<byte_t> out{Magic.begin(), Magic.end()};
+    out.reserve(m_LiveBytes + m_Index.size() * RecordHeaderSize + Magic.size());
+    std::unordered_map<RouterID, Span> index;
+    decltype(m_Checked) checked;
+    {
+      FileView view{m_File};
+      if (view.size() < m_FileSize)
+      {
+        LogError(m_File, " is shorter than expected, not compacting it");
+        return false;
+      }
+      for (const auto& [id, span] : m_Index)
+      {
+        index.emplace(id, Span{out.size(), span.size, span.hash});
+        const auto* rec = view.data() + span.offset;
+        out.insert(out.end(), rec, rec + span.size);
+        if (m_Checked.count(span.hash))
+        {
+          checked.emplace(span.hash);
+          PutRecord(out, RecordType::Checked, span.hash.data(), nullptr, 0);
+        }
+      }
+    }
+
+    if (not ReplaceFile(m_File, out))
+      return false;
+    LogDebug("compacted ", m_File, " from ", m_FileSize, " to ", out.size(), " bytes");
+    m_Index = std::move(index);
+    m_Checked = std::move(checked);
+    m_PendingChecked.clear();
+    m_FileSize = out.size();
+    return true;
+  }
+
+  size_t
+  NodeDBLog::LiveBytes() const
+  {
+    std::unique_lock lock{m_Access};
+    return m_LiveBytes;
+  }
+
+  size_t
+  NodeDBLog::FileSize() const
+  {
+    std::unique_lock lock{m_Access};
+    return m_FileSize;
+  }
+}  // namespace llarp
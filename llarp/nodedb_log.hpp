@@ -0,0 +1,93 @@
+#pragma once
+
+#include "crypto/types.hpp"
+#include "router_contact.hpp"
+#include "router_id.hpp"
+#include "util/fs.hpp"
+#include "util/thread/annotations.hpp"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace llarp
+{
+  /// the nodedb kept in one append only file instead of one file per router.
+  ///
+  /// the file is a short header followed by records, each one being a router's encoded rc, a
+  /// tombstone for a router we dropped, or the hash of an encoded rc whose signature we already
+  /// checked. the newest record for a router wins. loading maps the file and walks the record
+  /// headers once to index where each router's live rc is; flushing only appends what changed
+  /// since the last flush, and once the file is mostly dead records it is rewritten with just the
+  /// live ones.
+  class NodeDBLog
+  {
+   public:
+    explicit NodeDBLog(fs::path file);
+
+    /// the file we live in
+    const fs::path&
+    File() const
+    {
+      return m_File;
+    }
+
+    /// given the newest rc of every router and whether the signature of each was checked on an
+    /// earlier run, returns which of them to keep
+    using LoadVisitor = std::function<std::vector<bool>(
+        const std::vector<RouterContact>& rcs, const std::vector<bool>& checked)>;
+
+    /// map the file and hand every router's newest rc to visit all at once, so they can be
+    /// checked together. kept rcs count as checked from then on and dropped ones are left out
+    /// of the next compaction. a torn record at the end of the file, as left behind by a crash,
+    /// is cut off and damaged records with good ones after them are skipped. returns false if
+    /// the file is there but is not a nodedb log.
+    bool
+    Load(LoadVisitor visit) EXCLUDES(m_Access);
+
+    /// append the rcs that changed, tombstones for the routers that are gone and any new checked
+    /// marks, then compact if it is time to. the rcs must have had their signatures checked, as
+    /// everything put in the nodedb has, and are marked as checked along with them.
+    bool
+    Append(const std::vector<RouterContact>& rcs, const std::unordered_set<RouterID>& removed)
+        EXCLUDES(m_Access);
+
+    /// rewrite the file with only live records
+    bool
+    Compact() EXCLUDES(m_Access);
+
+    /// bytes of the file that are records for live routers
+    size_t
+    LiveBytes() const EXCLUDES(m_Access);
+
+    /// bytes of the whole file
+    size_t
+    FileSize() const EXCLUDES(m_Access);
+
+   private:
+    struct Span
+    {
+      uint64_t offset;
+      uint32_t size;
+      /// hash of the encoded rc
+      ShortHash hash;
+    };
+
+    bool
+    CompactLocked() REQUIRES(m_Access);
+
+    bool
+    ShouldCompact() const REQUIRES(m_Access);
+
+    const fs::path m_File;
+    mutable std::mutex m_Access;
+    std::unordered_map<RouterID, Span> m_Index GUARDED_BY(m_Access);
+    std::unordered_set<ShortHash, ShortHash::Hash> m_Checked GUARDED_BY(m_Access);
+    /// checked marks that are not in the file yet
+    std::vector<ShortHash> m_PendingChecked GUARDED_BY(m_Access);
+    uint64_t m_FileSize GUARDED_BY(m_Access) = 0;
+    uint64_t m_LiveBytes GUARDED_BY(m_Access) = 0;
+  };
+}  // namespace llarp
@@ -0,0 +1,190 @@
+#include "hop_index.hpp"
+
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/net/ip.hpp>
+#include <llarp/net/net_bits.hpp>
+
+#include <algorithm>
+#include <random>
+
+namespace llarp
+{
+  namespace path
+  {
+    void
+    HopIndex::Insert(const RouterContact& rc)
+    {
+      const RouterID router{rc.pubkey};
+      if (auto itr = m_Lookup.find(router); itr != m_Lookup.end())
+      {
+        // a newer rc for a router we have, it keeps its place and whether it is bad
+        auto& candidate = m_Candidates[itr->second];
+        candidate.rc = &rc;
+        Classify(candidate);
+        return;
+      }
+      const auto idx = static_cast<uint32_t>(m_Candidates.size());
+      auto& candidate = m_Candidates.emplace_back();
+      candidate.rc = &rc;
+      Classify(candidate);
+      m_Position.push_back(m_Order.size());
+      m_Order.push_back(idx);
+      m_Lookup.emplace(router, idx);
+    }
+
+    void
+    HopIndex::Remove(const RouterID& router)
+    {
+      const auto itr = m_Lookup.find(router);
+      if (itr == m_Lookup.end())
+        return;
+      const auto idx = itr->second;
+      m_Lookup.erase(itr);
+
+      // take it out of the order, then move the last candidate into its slot
+      SwapOrder(m_Position[idx], m_Order.size() - 1);
+      m_Order.pop_back();
+      const auto last = static_cast<uint32_t>(m_Candidates.size() - 1);
+      if (idx != last)
+      {
+        m_Candidates[idx] = m_Candidates[last];
+        m_Position[idx] = m_Position[last];
+        m_Order[m_Position[idx]] = idx;
+        m_Lookup[RouterID{m_Candidates[idx].rc->pubkey}] = idx;
+      }
+      m_Candidates.pop_back();
+      m_Position.pop_back();
+    }
+
+    void
+    HopIndex::Clear()
+    {
+      m_Candidates.clear();
+      m_Order.clear();
+      m_Position.clear();
+      m_Lookup.clear();
+    }
+
+    void
+    HopIndex::SetUniqueNetmask(int bits)
+    {
+      m_NetmaskBits = bits;
+      m_Netmask = bits > 0 ? netmask_ipv6_bits(96 + bits) : huint128_t{};
+      for (auto& candidate : m_Candidates)
+        Classify(candidate);
+    }
+
+    size_t
+    HopIndex::NumBad() const
+    {
+      return std::count_if(m_Candidates.begin(), m_Candidates.end(), [](const auto& candidate) {
+        return candidate.bad;
+      });
+    }
+
+    huint128_t
+    HopIndex::Network(const AddressInfo& addr) const
+    {
+      return net::In6ToHUInt(addr.ip) & m_Netmask;
+    }
+
+    void
+    HopIndex::Classify(Candidate& candidate) const
+    {
+      candidate.numNetworks = 0;
+      candidate.distinct = true;
+      if (m_NetmaskBits <= 0)
+        return;
+      const auto& addrs = candidate.rc->addrs;
+      if (addrs.size() > MaxNetworks)
+      {
+        candidate.distinct = false;
+        return;
+      }
+      for (const auto& addr : addrs)
+      {
+        const auto network = Network(addr);
+        const auto begin = candidate.networks.begin();
+        const auto end = begin + candidate.numNetworks;
+        if (std::find(begin, end, network) != end)
+          candidate.distinct = false;
+        candidate.networks[candidate.numNetworks++] = network;
+      }
+    }
+
+    void
+    HopIndex::SwapOrder(size_t a, size_t b)
+    {
+      std::swap(m_Order[a], m_Order[b]);
+      m_Position[m_Order[a]] = a;
+      m_Position[m_Order[b]] = b;
+    }
+
+    size_t
+    HopIndex::RandomBelow(size_t n)
+    {
+      CSRNG rng;
+      return std::uniform_int_distribution<size_t>{0, n - 1}(rng);
+    }
+
+    bool
+    HopIndex::Taken::Has(const RouterID& router) const
+    {
+      const auto end = m_Routers.begin() + m_NumRouters;
+      return std::find(m_Routers.begin(), end, router) != end;
+    }
+
+    bool
+    HopIndex::Taken::AddNetwork(huint128_t network)
+    {
+      const auto end = m_Networks.begin() + m_NumNetworks;
+      if (m_NumNetworks == m_Networks.size() or std::find(m_Networks.begin(), end, network) != end)
+        return false;
+      m_Networks[m_NumNetworks++] = network;
+      return true;
+    }
+
+    bool
+    HopIndex::Taken::Add(const RouterContact& rc)
+    {
+      const RouterID router{rc.pubkey};
+      if (Has(router))
+        return true;
+      if (m_NumRouters == m_Routers.size())
+        return false;
+      m_Routers[m_NumRouters++] = router;
+      if (m_Index.m_NetmaskBits <= 0)
+        return true;
+      bool ok = true;
+      for (const auto& addr : rc.addrs)
+        ok = AddNetwork(m_Index.Network(addr)) and ok;
+      return ok;
+    }
+
+    bool
+    HopIndex::Taken::CanAdd(const Candidate& candidate) const
+    {
+      if (m_NumRouters == m_Routers.size() or Has(RouterID{candidate.rc->pubkey}))
+        return false;
+      if (m_Index.m_NetmaskBits <= 0)
+        return true;
+      if (not candidate.distinct or m_NumNetworks + candidate.numNetworks > m_Networks.size())
+        return false;
+      const auto end = m_Networks.begin() + m_NumNetworks;
+      for (size_t idx = 0; idx < candidate.numNetworks; ++idx)
+      {
+        if (std::find(m_Networks.begin(), end, candidate.networks[idx]) != end)
+          return false;
+      }
+      return true;
+    }
+
+    void
+    HopIndex::Taken::Add(const Candidate& candidate)
+    {
+      m_Routers[m_NumRouters++] = RouterID{candidate.rc->pubkey};
+      for (size_t idx = 0; idx < candidate.numNetworks; ++idx)
+        m_Networks[m_NumNetworks++] = candidate.networks[idx];
+    }
+  }  // namespace path
+}  // namespace llarp
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <llarp/constants/path.hpp>
+#include <llarp/net/net_int.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/router_id.hpp>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp
+{
+  namespace path
+  {
+    /// the routers we may build paths over, kept in step with the nodedb so picking the hops of a
+    /// build does not copy, shuffle and filter every rc we know of once per hop.
+    ///
+    /// each candidate carries what deciding on a hop needs: whether profiling thinks it is bad for
+    /// paths, refreshed from the router tick, and the networks its addresses fall in at the
+    /// [paths] unique-range-size netmask.  a pick is a lazy fisher-yates shuffle over an array of
+    /// candidate indices, so picking the hops of a path costs a few swaps and checks per hop and
+    /// never allocates.
+    class HopIndex
+    {
+      struct Candidate;
+
+     public:
+      /// most addresses of one router we keep networks for; while the unique range netmask is on
+      /// routers with more than this are never picked
+      static constexpr size_t MaxNetworks = 4;
+
+      /// the hops a path has so far; a new hop may not repeat one or share a network with one
+      class Taken
+      {
+       public:
+        explicit Taken(const HopIndex& index) : m_Index{index}
+        {}
+
+        /// add a hop we did not pick, such as the first hop or the endpoint; false if it shares a
+        /// network with a hop already taken.  adding the same router twice is allowed.
+        bool
+        Add(const RouterContact& rc);
+
+        bool
+        Has(const RouterID& router) const;
+
+        size_t
+        Size() const
+        {
+          return m_NumRouters;
+        }
+
+       private:
+        friend class HopIndex;
+
+        bool
+        CanAdd(const Candidate& candidate) const;
+
+        void
+        Add(const Candidate& candidate);
+
+        bool
+        AddNetwork(huint128_t network);
+
+        const HopIndex& m_Index;
+        std::array<RouterID, max_len> m_Routers;
+        size_t m_NumRouters = 0;
+        std::array<huint128_t, max_len * MaxNetworks> m_Networks;
+        size_t m_NumNetworks = 0;
+      };
+
+      /// add or replace the candidate for rc's router.  only the address is kept, rc must stay
+      /// where it is until it is removed or inserted again.
+      void
+      Insert(const RouterContact& rc);
+
+      /// drop a router, does nothing if it is not a candidate
+      void
+      Remove(const RouterID& router);
+
+      void
+      Clear();
+
+      /// hops must be from distinct /bits networks, 0 turns the check off
+      void
+      SetUniqueNetmask(int bits);
+
+      /// mark the candidates isBad(router id) holds for as not to be used
+      template <typename IsBad>
+      void
+      RefreshBad(IsBad&& isBad)
+      {
+        for (auto& candidate : m_Candidates)
+          candidate.bad = isBad(candidate.rc->pubkey);
+      }
+
+      /// pick a random router that is not bad, does not clash with the hops taken and that
+      /// filter accepts; it is added to taken.  nullptr if there is none.
+      template <typename Filter>
+      const RouterContact*
+      Pick(Taken& taken, Filter&& filter)
+      {
+        const size_t num = m_Order.size();
+        for (size_t idx = 0; idx < num; ++idx)
+        {
+          SwapOrder(idx, idx + RandomBelow(num - idx));
+          const auto& candidate = m_Candidates[m_Order[idx]];
+          if (candidate.bad or not taken.CanAdd(candidate) or not filter(*candidate.rc))
+            continue;
+          taken.Add(candidate);
+          return candidate.rc;
+        }
+        return nullptr;
+      }
+
+      const RouterContact*
+      Pick(Taken& taken)
+      {
+        return Pick(taken, [](const RouterContact&) { return true; });
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Candidates.size();
+      }
+
+      /// number of candidates currently marked bad
+      size_t
+      NumBad() const;
+
+     private:
+      struct Candidate
+      {
+        const RouterContact* rc;
+        bool bad = false;
+        /// false if it can never be a hop while the netmask is on: it has more addresses than we
+        /// keep networks for or two of them share a network
+        bool distinct = true;
+        uint8_t numNetworks = 0;
+        std::array<huint128_t, MaxNetworks> networks;
+      };
+
+      /// fill in the networks of a candidate at the current netmask
+      void
+      Classify(Candidate& candidate) const;
+
+      huint128_t
+      Network(const AddressInfo& addr) const;
+
+      void
+      SwapOrder(size_t a, size_t b);
+
+      static size_t
+      RandomBelow(size_t n);
+
+      std::vector<Candidate> m_Candidates;
+      /// candidate indices in the order the last picks shuffled them into
+      std::vector<uint32_t> m_Order;
+      /// where each candidate is in m_Order
+      std::vector<uint32_t> m_Position;
+      std::unordered_map<RouterID, uint32_t> m_Lookup;
+
+      int m_NetmaskBits = 0;
+      huint128_t m_Netmask{};
+    };
+  }  // namespace path
+}  // namespace llarp
@@ -13,11 +13,7 @@ namespace llarp
         return false;
       if (m_UpstreamQueue == nullptr)
         m_UpstreamQueue = std::make_shared<TrafficQueue_t>();
-      m_UpstreamQueue->emplace_back();
-      auto& pkt = m_UpstreamQueue->back();
-      pkt.first.resize(X.sz);
-      std::copy_n(X.base, X.sz, pkt.first.begin());
-      pkt.second = Y;
+      m_UpstreamQueue->emplace_back(PacketBuffer::copy_from(X), Y);
       r->loop()->wakeup();
       return true;
     }
@@ -30,15 +26,25 @@ namespace llarp
         return false;
       if (m_DownstreamQueue == nullptr)
         m_DownstreamQueue = std::make_shared<TrafficQueue_t>();
-      m_DownstreamQueue->emplace_back();
-      auto& pkt = m_DownstreamQueue->back();
-      pkt.first.resize(X.sz);
-      std::copy_n(X.base, X.sz, pkt.first.begin());
-      pkt.second = Y;
+      m_DownstreamQueue->emplace_back(PacketBuffer::copy_from(X), Y);
       r->loop()->wakeup();
       return true;
     }
 
+    bool
+    IHopHandler::HandleUpstreamFrame(RelayFrame frame, AbstractRouter* r)
+    {
+      return HandleUpstream(
+          llarp_buffer_t{frame.Payload(), frame.payloadSize}, TunnelNonce{frame.Nonce()}, r);
+    }
+
+    bool
+    IHopHandler::HandleDownstreamFrame(RelayFrame frame, AbstractRouter* r)
+    {
+      return HandleDownstream(
+          llarp_buffer_t{frame.Payload(), frame.payloadSize}, TunnelNonce{frame.Nonce()}, r);
+    }
+
     void
     IHopHandler::DecayFilters(llarp_time_t now)
     {
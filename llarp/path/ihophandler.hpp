@@ -4,6 +4,7 @@
 #include <llarp/util/types.hpp>
 #include <llarp/crypto/encrypted_frame.hpp>
 #include <llarp/util/decaying_hashset.hpp>
+#include <llarp/util/packet_pool.hpp>
 #include <llarp/messages/relay.hpp>
 #include <vector>
 
@@ -24,7 +25,7 @@ namespace llarp
   {
     struct IHopHandler
     {
-      using TrafficEvent_t = std::pair<std::vector<byte_t>, TunnelNonce>;
+      using TrafficEvent_t = std::pair<PacketBuffer, TunnelNonce>;
       using TrafficQueue_t = std::list<TrafficEvent_t>;
       using TrafficQueue_ptr = std::shared_ptr<TrafficQueue_t>;
 
@@ -50,6 +51,16 @@ namespace llarp
       virtual bool
       HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*);
 
+      /// handle an upstream relay message that is still encoded, by default the payload is taken
+      /// out and handled by HandleUpstream
+      virtual bool
+      HandleUpstreamFrame(RelayFrame frame, AbstractRouter* r);
+
+      /// handle a downstream relay message that is still encoded, by default the payload is taken
+      /// out and handled by HandleDownstream
+      virtual bool
+      HandleDownstreamFrame(RelayFrame frame, AbstractRouter* r);
+
       /// return timestamp last remote activity happened at
       virtual llarp_time_t
       LastRemoteActivityAt() const = 0;
@@ -422,17 +422,30 @@ namespace llarp
     void
     Path::UpstreamWork(TrafficQueue_ptr msgs, AbstractRouter* r)
     {
+      // one layer at a time over the whole queue
+      std::vector<TunnelNonce> nonces;
+      nonces.reserve(msgs->size());
+      for (const auto& ev : *msgs)
+        nonces.push_back(ev.second);
+      std::vector<XChaCha20Job> ciphers(msgs->size());
+      for (const auto& hop : hops)
+      {
+        size_t idx = 0;
+        for (auto& ev : *msgs)
+        {
+          ciphers[idx] =
+              XChaCha20Job{ev.first.data(), ev.first.size(), &hop.shared, nonces[idx].data()};
+          ++idx;
+        }
+        CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
+        for (auto& n : nonces)
+          n ^= hop.nonceXOR;
+      }
       std::vector<RelayUpstreamMessage> sendmsgs(msgs->size());
       size_t idx = 0;
       for (auto& ev : *msgs)
       {
         const llarp_buffer_t buf(ev.first);
-        TunnelNonce n = ev.second;
-        for (const auto& hop : hops)
-        {
-          CryptoManager::instance()->xchacha20(buf, hop.shared, n);
-          n ^= hop.nonceXOR;
-        }
         auto& msg = sendmsgs[idx];
         msg.X = buf;
         msg.Y = ev.second;
@@ -498,15 +511,25 @@ namespace llarp
       std::vector<RelayDownstreamMessage> sendMsgs(msgs->size());
       size_t idx = 0;
       for (auto& ev : *msgs)
+        sendMsgs[idx++].Y = ev.second;
+      // one layer at a time over the whole queue
+      std::vector<XChaCha20Job> ciphers(msgs->size());
+      for (const auto& hop : hops)
       {
-        const llarp_buffer_t buf(ev.first);
-        sendMsgs[idx].Y = ev.second;
-        for (const auto& hop : hops)
+        idx = 0;
+        for (auto& ev : *msgs)
         {
           sendMsgs[idx].Y ^= hop.nonceXOR;
-          CryptoManager::instance()->xchacha20(buf, hop.shared, sendMsgs[idx].Y);
+          ciphers[idx] = XChaCha20Job{
+              ev.first.data(), ev.first.size(), &hop.shared, sendMsgs[idx].Y.data()};
+          ++idx;
         }
-        sendMsgs[idx].X = buf;
+        CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
+      }
+      idx = 0;
+      for (auto& ev : *msgs)
+      {
+        sendMsgs[idx].X = llarp_buffer_t{ev.first};
         ++idx;
       }
       r->loop()->call([self = shared_from_this(), msgs = std::move(sendMsgs), r]() mutable {
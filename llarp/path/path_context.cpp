@@ -1,16 +1,28 @@
 #include "path_context.hpp"
 
+#include <llarp/messages/relay.hpp>
 #include <llarp/messages/relay_commit.hpp>
 #include "path.hpp"
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/router/i_outbound_message_handler.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace llarp
 {
   namespace path
   {
     static constexpr auto DefaultPathBuildLimit = 500ms;
 
+    /// path builds are counted per ip, whatever port they came from
+    static IpAddress
+    WithoutPort(IpAddress ip)
+    {
+      ip.setPort(0);
+      return ip;
+    }
+
     PathContext::PathContext(AbstractRouter* router)
         : m_Router(router), m_AllowTransit(false), m_PathLimits(DefaultPathBuildLimit)
     {}
@@ -33,12 +45,9 @@ namespace llarp
 #ifdef TESTNET
       return false;
 #else
-      IpAddress remote = ip;
-      // null out the port -- we don't care about it for path limiting purposes
-      remote.setPort(0);
       // try inserting remote address by ip into decaying hash set
       // if it cannot insert it has hit a limit
-      return not m_PathLimits.Insert(remote);
+      return not m_PathLimits.Insert(WithoutPort(ip));
 #endif
     }
 
@@ -109,20 +118,6 @@ namespace llarp
       return nullptr;
     }
 
-    template <typename Lock_t, typename Map_t, typename Key_t, typename CheckValue_t>
-    bool
-    MapHas(Map_t& map, const Key_t& k, CheckValue_t check)
-    {
-      Lock_t lock(map.first);
-      auto range = map.second.equal_range(k);
-      for (auto i = range.first; i != range.second; ++i)
-      {
-        if (check(i->second))
-          return true;
-      }
-      return false;
-    }
-
     template <typename Lock_t, typename Map_t, typename Key_t, typename Value_t>
     void
     MapPut(Map_t& map, const Key_t& k, const Value_t& v)
@@ -166,10 +161,7 @@ namespace llarp
     bool
     PathContext::HasTransitHop(const TransitHopInfo& info)
     {
-      return MapHas<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths, info.txID, [info](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return info == hop->info;
-          });
+      return m_TransitPaths.Has(info);
     }
 
     HopHandler_ptr
@@ -186,35 +178,35 @@ namespace llarp
       if (own)
         return own;
 
-      return MapGet<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths,
-          id,
-          [remote](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return hop->info.upstream == remote;
-          },
-          [](const std::shared_ptr<TransitHop>& h) -> HopHandler_ptr { return h; });
+      return m_TransitPaths.GetByUpstream(remote, id);
     }
 
     bool
     PathContext::TransitHopPreviousIsRouter(const PathID_t& path, const RouterID& otherRouter)
     {
-      SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-      auto itr = m_TransitPaths.second.find(path);
-      if (itr == m_TransitPaths.second.end())
-        return false;
-      return itr->second->info.downstream == otherRouter;
+      return m_TransitPaths.GetByDownstream(otherRouter, path) != nullptr;
     }
 
     HopHandler_ptr
     PathContext::GetByDownstream(const RouterID& remote, const PathID_t& id)
     {
-      return MapGet<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths,
-          id,
-          [remote](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return hop->info.downstream == remote;
-          },
-          [](const std::shared_ptr<TransitHop>& h) -> HopHandler_ptr { return h; });
+      return m_TransitPaths.GetByDownstream(remote, id);
+    }
+
+    bool
+    PathContext::HandleRelayFrame(const RouterID& from, RelayFrame frame)
+    {
+      const auto id = frame.PathID();
+      if (frame.upstream)
+      {
+        if (auto hop = GetByDownstream(from, id))
+          return hop->HandleUpstreamFrame(std::move(frame), m_Router);
+        return false;
+      }
+      if (auto hop = GetByUpstream(from, id))
+        return hop->HandleDownstreamFrame(std::move(frame), m_Router);
+      LogWarn("unhandled downstream message id=", id);
+      return false;
     }
 
     PathSet_ptr
@@ -246,17 +238,7 @@ namespace llarp
     PathContext::GetPathForTransfer(const PathID_t& id)
     {
       const RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        SyncTransitMap_t::Lock_t lock(map.first);
-        auto range = map.second.equal_range(id);
-        for (auto i = range.first; i != range.second; ++i)
-        {
-          if (i->second->info.upstream == us)
-            return i->second;
-        }
-      }
-      return nullptr;
+      return m_TransitPaths.GetByUpstream(us, id);
     }
 
     void
@@ -276,16 +258,107 @@ namespace llarp
     uint64_t
     PathContext::CurrentTransitPaths()
     {
-      SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-      auto& map = m_TransitPaths.second;
-      return map.size() / 2;
+      return m_TransitPaths.Size();
     }
 
     void
     PathContext::PutTransitHop(std::shared_ptr<TransitHop> hop)
     {
-      MapPut<SyncTransitMap_t::Lock_t>(m_TransitPaths, hop->info.txID, hop);
-      MapPut<SyncTransitMap_t::Lock_t>(m_TransitPaths, hop->info.rxID, hop);
+      if (not m_TransitPaths.Put(hop))
+        LogWarn("not adding transit hop ", hop->info, ", its path ids clash with another hop");
+    }
+
+    bool
+    PathContext::QueueCommit(std::shared_ptr<LRCMFrameDecrypt> commit, const IpAddress& from)
+    {
+      const auto ip = WithoutPort(from);
+      const auto itr = m_CommitsByIP.find(ip);
+      const size_t fromIP = itr == m_CommitsByIP.end() ? 0 : itr->second;
+      const size_t share = std::max<size_t>(1, m_MaxPendingCommits / PendingCommitShare);
+      if (m_PendingCommits.size() + m_CommitsInFlight >= m_MaxPendingCommits or fromIP >= share)
+      {
+        m_CommitStats.dropped++;
+        return false;
+      }
+      m_CommitsByIP[ip]++;
+      m_PendingCommits.emplace_back(std::move(commit));
+      m_CommitStats.queued++;
+      return true;
+    }
+
+    void
+    PathContext::SetMaxPendingCommits(size_t max)
+    {
+      m_MaxPendingCommits = max;
+    }
+
+    void
+    PathContext::PumpCommits()
+    {
+      if (m_PendingCommits.empty())
+        return;
+      // split a storm of builds over several workers rather than make one of them do them all
+      for (auto itr = m_PendingCommits.begin(); itr != m_PendingCommits.end();)
+      {
+        const auto end =
+            itr + std::min<size_t>(MaxCommitBatch, std::distance(itr, m_PendingCommits.end()));
+        std::vector<std::shared_ptr<LRCMFrameDecrypt>> batch{
+            std::make_move_iterator(itr), std::make_move_iterator(end)};
+        m_Router->QueueWork(
+            [this, batch = std::move(batch)]() mutable { DecryptCommits(this, std::move(batch)); });
+        m_CommitStats.batches++;
+        itr = end;
+      }
+      m_CommitsInFlight += m_PendingCommits.size();
+      m_PendingCommits.clear();
+    }
+
+    void
+    PathContext::CommitLimited()
+    {
+      m_CommitStats.limited++;
+    }
+
+    void
+    PathContext::CommitFinished(llarp_time_t queuedAt, const IpAddress& from, bool ok)
+    {
+      const auto latency = m_Router->Now() - queuedAt;
+      m_CommitsInFlight--;
+      if (auto itr = m_CommitsByIP.find(WithoutPort(from)); itr != m_CommitsByIP.end())
+      {
+        if (--itr->second == 0)
+          m_CommitsByIP.erase(itr);
+      }
+      m_CommitStats.finished++;
+      if (not ok)
+        m_CommitStats.failed++;
+      m_CommitStats.latencyTotal += latency;
+      m_CommitStats.latencyMax = std::max(m_CommitStats.latencyMax, latency);
+    }
+
+    util::StatusObject
+    PathContext::ExtractStatus() const
+    {
+      return util::StatusObject{
+          {"transitPaths", m_TransitPaths.Size()},
+          {"pendingCommits", m_PendingCommits.size()},
+          {"commitsInFlight", m_CommitsInFlight},
+          {"commits", m_CommitStats.ExtractStatus()}};
+    }
+
+    util::StatusObject
+    CommitStats::ExtractStatus() const
+    {
+      const auto latencyAvg = finished ? latencyTotal / finished : 0s;
+      return util::StatusObject{
+          {"queued", queued},
+          {"dropped", dropped},
+          {"limited", limited},
+          {"failed", failed},
+          {"finished", finished},
+          {"batches", batches},
+          {"latencyAvg", to_json(latencyAvg)},
+          {"latencyMax", to_json(latencyMax)}};
     }
 
     void
@@ -295,21 +368,18 @@ namespace llarp
       m_PathLimits.Decay(now);
 
       {
-        SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-        auto& map = m_TransitPaths.second;
-        auto itr = map.begin();
-        while (itr != map.end())
-        {
-          if (itr->second->Expired(now))
-          {
-            m_Router->outboundMessageHandler().QueueRemoveEmptyPath(itr->first);
-            itr = map.erase(itr);
-          }
+        std::vector<TransitHop_ptr> expired;
+        m_TransitPaths.ForEach([&](const TransitHop_ptr& hop) {
+          if (hop->Expired(now))
+            expired.push_back(hop);
           else
-          {
-            itr->second->DecayFilters(now);
-            ++itr;
-          }
+            hop->DecayFilters(now);
+        });
+        for (const auto& hop : expired)
+        {
+          m_Router->outboundMessageHandler().QueueRemoveEmptyPath(hop->info.txID);
+          m_Router->outboundMessageHandler().QueueRemoveEmptyPath(hop->info.rxID);
+          m_TransitPaths.Remove(hop);
         }
       }
       {
@@ -343,17 +413,7 @@ namespace llarp
       if (h)
         return h;
       const RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        SyncTransitMap_t::Lock_t lock(map.first);
-        auto range = map.second.equal_range(id);
-        for (auto i = range.first; i != range.second; ++i)
-        {
-          if (i->second->info.upstream == us)
-            return i->second;
-        }
-      }
-      return nullptr;
+      return m_TransitPaths.GetByUpstream(us, id);
     }
 
     void PathContext::RemovePathSet(PathSet_ptr)
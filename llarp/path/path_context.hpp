@@ -6,32 +6,60 @@
 #include "path_types.hpp"
 #include "pathset.hpp"
 #include "transit_hop.hpp"
+#include "transit_hop_table.hpp"
 #include <llarp/routing/handler.hpp>
 #include <llarp/router/i_outbound_message_handler.hpp>
 #include <llarp/util/compare_ptr.hpp>
 #include <llarp/util/decaying_hashset.hpp>
+#include <llarp/util/status.hpp>
 #include <llarp/util/types.hpp>
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
   struct AbstractRouter;
   struct LR_CommitMessage;
+  struct LRCMFrameDecrypt;
   struct RelayDownstreamMessage;
   struct RelayUpstreamMessage;
+  struct RelayFrame;
   struct RouterID;
 
   namespace path
   {
-    struct TransitHop;
-    struct TransitHopInfo;
-
-    using TransitHop_ptr = std::shared_ptr<TransitHop>;
+    /// what became of the path builds through us, from being queued for decryption until they
+    /// are back on the event loop
+    struct CommitStats
+    {
+      uint64_t queued = 0;
+      /// dropped before decrypting, too many others were already waiting to be decrypted, or too
+      /// many of them were from the same ip
+      uint64_t dropped = 0;
+      /// dropped before decrypting, the ip they came from hit its path build limit
+      uint64_t limited = 0;
+      uint64_t failed = 0;
+      uint64_t finished = 0;
+      uint64_t batches = 0;
+      llarp_time_t latencyTotal = 0s;
+      llarp_time_t latencyMax = 0s;
+
+      util::StatusObject
+      ExtractStatus() const;
+    };
 
     struct PathContext
     {
+      /// most path builds decrypted by one worker job
+      static constexpr size_t MaxCommitBatch = 32;
+      /// most path builds queued or being decrypted at once, each holds a copy of its frames
+      static constexpr size_t DefaultMaxPendingCommits = 1024;
+      /// one ip can have at most 1/PendingCommitShare of the pending path builds, so a single
+      /// busy peer cannot crowd out everyone else
+      static constexpr size_t PendingCommitShare = 8;
+
       explicit PathContext(AbstractRouter* router);
 
       /// called from router tick function
@@ -62,6 +90,31 @@ namespace llarp
       bool
       HandleRelayCommit(const LR_CommitMessage& msg);
 
+      /// queue a path build that came from an ip to be decrypted with the next batch, from the
+      /// event loop; returns false and drops it if there are already as many waiting as we allow,
+      /// either in all or from that ip
+      bool
+      QueueCommit(std::shared_ptr<LRCMFrameDecrypt> commit, const IpAddress& from);
+
+      /// set how many path builds can be queued or being decrypted at once
+      void
+      SetMaxPendingCommits(size_t max);
+
+      /// hand the path builds queued since the last pump to the workers
+      void
+      PumpCommits();
+
+      /// a path build was dropped before decrypting because of its ip's path build limit
+      void
+      CommitLimited();
+
+      /// a path build from an ip queued at queuedAt is back on the event loop
+      void
+      CommitFinished(llarp_time_t queuedAt, const IpAddress& from, bool ok);
+
+      util::StatusObject
+      ExtractStatus() const;
+
       void
       PutTransitHop(std::shared_ptr<TransitHop> hop);
 
@@ -97,11 +150,10 @@ namespace llarp
       bool
       HopIsUs(const RouterID& k) const;
 
+      /// hand a relay message that is still encoded to the hop it is for, `from` is the router
+      /// that sent it to us
       bool
-      HandleLRUM(const RelayUpstreamMessage& msg);
-
-      bool
-      HandleLRDM(const RelayDownstreamMessage& msg);
+      HandleRelayFrame(const RouterID& from, RelayFrame frame);
 
       void
       AddOwnPath(PathSet_ptr set, Path_ptr p);
@@ -109,25 +161,6 @@ namespace llarp
       void
       RemovePathSet(PathSet_ptr set);
 
-      using TransitHopsMap_t = std::unordered_multimap<PathID_t, TransitHop_ptr, PathID_t::Hash>;
-
-      struct SyncTransitMap_t
-      {
-        using Mutex_t = util::NullMutex;
-        using Lock_t = util::NullLock;
-
-        Mutex_t first;  // protects second
-        TransitHopsMap_t second GUARDED_BY(first);
-
-        void
-        ForEach(std::function<void(const TransitHop_ptr&)> visit) EXCLUDES(first)
-        {
-          Lock_t lock(first);
-          for (const auto& item : second)
-            visit(item.second);
-        }
-      };
-
       // maps path id -> pathset owner of path
       using OwnedPathsMap_t = std::unordered_map<PathID_t, Path_ptr, PathID_t::Hash>;
 
@@ -163,10 +196,17 @@ namespace llarp
 
      private:
       AbstractRouter* m_Router;
-      SyncTransitMap_t m_TransitPaths;
+      TransitHopTable m_TransitPaths;
       SyncOwnedPathsMap_t m_OurPaths;
       bool m_AllowTransit;
       util::DecayingHashSet<IpAddress> m_PathLimits;
+      std::vector<std::shared_ptr<LRCMFrameDecrypt>> m_PendingCommits;
+      /// path builds handed to the workers that are not back on the event loop yet
+      size_t m_CommitsInFlight = 0;
+      size_t m_MaxPendingCommits = DefaultMaxPendingCommits;
+      /// path builds queued or in flight per ip they came from
+      std::unordered_map<IpAddress, size_t, IpAddress::Hash> m_CommitsByIP;
+      CommitStats m_CommitStats;
     };
   }  // namespace path
 }  // namespace llarp
@@ -1,6 +1,7 @@
 #include "pathbuilder.hpp"
 
 #include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/key_pool.hpp>
 #include <llarp/messages/relay_commit.hpp>
 #include <llarp/nodedb.hpp>
 #include "path_context.hpp"
@@ -9,6 +10,7 @@
 #include <llarp/util/buffer.hpp>
 #include <llarp/tooling/path_event.hpp>
 
+#include <atomic>
 #include <functional>
 
 namespace llarp
@@ -24,35 +26,36 @@ namespace llarp
     using Handler = std::function<void(std::shared_ptr<AsyncPathKeyExchangeContext>)>;
 
     Handler result;
-    size_t idx = 0;
     AbstractRouter* router = nullptr;
-    WorkerFunc_t work;
+    std::shared_ptr<EphemeralKeyPool> keys;
     EventLoop_ptr loop;
     LR_CommitMessage LRCM;
+    /// hops whose frame is not done yet
+    std::atomic<size_t> pending{0};
+    std::atomic<bool> failed{false};
 
-    void
-    GenerateNextKey()
+    /// make the keys and the commit frame of one hop.  a hop only reads the rc of the hop after
+    /// it, so every hop can do this at the same time on its own worker.
+    bool
+    GenerateKey(size_t idx)
     {
-      // current hop
       auto& hop = path->hops[idx];
       auto& frame = LRCM.frames[idx];
 
       auto crypto = CryptoManager::instance();
 
-      // generate key
-      crypto->encryption_keygen(hop.commkey);
+      hop.commkey = keys->Take();
       hop.nonce.Randomize();
       // do key exchange
       if (!crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey, hop.nonce))
       {
         LogError(pathset->Name(), " Failed to generate shared key for path build");
-        return;
+        return false;
       }
       // generate nonceXOR valueself->hop->pathKey
       crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
-      ++idx;
 
-      bool isFarthestHop = idx == path->hops.size();
+      const bool isFarthestHop = idx + 1 == path->hops.size();
 
       LR_CommitRecord record;
       if (isFarthestHop)
@@ -61,8 +64,8 @@ namespace llarp
       }
       else
       {
-        hop.upstream = path->hops[idx].rc.pubkey;
-        record.nextRC = std::make_unique<RouterContact>(path->hops[idx].rc);
+        hop.upstream = path->hops[idx + 1].rc.pubkey;
+        record.nextRC = std::make_unique<RouterContact>(path->hops[idx + 1].rc);
       }
       // build record
       record.lifetime = path::default_lifetime;
@@ -81,44 +84,46 @@ namespace llarp
         // failed to encode?
         LogError(pathset->Name(), " Failed to generate Commit Record");
         DumpBuffer(buf);
-        return;
+        return false;
       }
       // use ephemeral keypair for frame
-      SecretKey framekey;
-      crypto->encryption_keygen(framekey);
+      const SecretKey framekey = keys->Take();
       if (!frame.EncryptInPlace(framekey, hop.rc.enckey))
       {
         LogError(pathset->Name(), " Failed to encrypt LRCR");
-        return;
+        return false;
       }
+      return true;
+    }
 
-      if (isFarthestHop)
-      {
-        // farthest hop
-        // TODO: encrypt junk frames because our public keys are not eligator
-        loop->call([self = shared_from_this()] { self->result(self); });
-      }
-      else
-      {
-        // next hop
-        work([self = shared_from_this()] { self->GenerateNextKey(); });
-      }
+    /// called once per hop; the last hop to finish hands the commit to the event loop
+    void
+    HopDone(bool ok)
+    {
+      if (not ok)
+        failed = true;
+      if (--pending > 0 or failed)
+        return;
+      // TODO: encrypt junk frames because our public keys are not eligator
+      loop->call([self = shared_from_this()] { self->result(self); });
     }
 
     /// Generate all keys asynchronously and call handler when done
     void
-    AsyncGenerateKeys(Path_t p, EventLoop_ptr l, WorkerFunc_t worker, Handler func)
+    AsyncGenerateKeys(Path_t p, EventLoop_ptr l, WorkerFunc_t work, Handler func)
     {
       path = p;
       loop = std::move(l);
       result = func;
-      work = worker;
 
       for (size_t i = 0; i < path::max_len; ++i)
       {
         LRCM.frames[i].Randomize();
       }
-      work([self = shared_from_this()] { self->GenerateNextKey(); });
+      const size_t numHops = path->hops.size();
+      pending = numHops;
+      for (size_t idx = 0; idx < numHops; ++idx)
+        work([self = shared_from_this(), idx] { self->HopDone(self->GenerateKey(idx)); });
     }
   };
 
@@ -231,12 +236,11 @@ namespace llarp
     std::optional<std::vector<RouterContact>>
     Builder::GetHopsForBuild()
     {
-      auto filter = [r = m_router](const auto& rc) -> bool {
-        return not r->routerProfiling().IsBadForPath(rc.pubkey);
-      };
-      if (const auto maybe = m_router->nodedb()->GetRandom(filter))
+      auto& candidates = m_router->nodedb()->HopCandidates();
+      HopIndex::Taken taken{candidates};
+      if (const auto* endpoint = candidates.Pick(taken))
       {
-        return GetHopsAlignedToForBuild(maybe->pubkey);
+        return GetHopsAlignedToForBuild(endpoint->pubkey);
       }
       return std::nullopt;
     }
@@ -297,9 +301,8 @@ namespace llarp
     std::optional<std::vector<RouterContact>>
     Builder::GetHopsAlignedToForBuild(RouterID endpoint, const std::set<RouterID>& exclude)
     {
-      const auto pathConfig = m_router->GetConfig()->paths;
-
       std::vector<RouterContact> hops;
+      hops.reserve(numHops);
       {
         const auto maybe = SelectFirstHop(exclude);
         if (not maybe.has_value())
@@ -307,52 +310,27 @@ namespace llarp
         hops.emplace_back(*maybe);
       };
 
-      RouterContact endpointRC;
-      if (const auto maybe = m_router->nodedb()->Get(endpoint))
-      {
-        endpointRC = *maybe;
-      }
-      else
+      const auto endpointRC = m_router->nodedb()->Get(endpoint);
+      if (not endpointRC)
         return std::nullopt;
 
-      for (size_t idx = hops.size(); idx < numHops; ++idx)
-      {
-        if (idx + 1 == numHops)
-        {
-          hops.emplace_back(endpointRC);
-        }
-        else
-        {
-          auto filter =
-              [&hops, r = m_router, endpointRC, pathConfig, exclude](const auto& rc) -> bool {
-            if (exclude.count(rc.pubkey))
-              return false;
-
-            std::set<RouterContact> hopsSet;
-            hopsSet.insert(endpointRC);
-            hopsSet.insert(hops.begin(), hops.end());
-
-            if (r->routerProfiling().IsBadForPath(rc.pubkey))
-              return false;
-            for (const auto& hop : hopsSet)
-            {
-              if (hop.pubkey == rc.pubkey)
-                return false;
-            }
-
-            hopsSet.insert(rc);
-            if (not pathConfig.Acceptable(hopsSet))
-              return false;
-
-            return rc.pubkey != endpointRC.pubkey;
-          };
+      auto& candidates = m_router->nodedb()->HopCandidates();
+      HopIndex::Taken taken{candidates};
+      // hops in between have to get along with both ends, so the ends have to get along too
+      const bool endsAgree = taken.Add(hops.front()) and taken.Add(*endpointRC);
+      if (not endsAgree and hops.size() + 1 < numHops)
+        return std::nullopt;
 
-          if (const auto maybe = m_router->nodedb()->GetRandom(filter))
-            hops.emplace_back(*maybe);
-          else
-            return std::nullopt;
-        }
+      while (hops.size() + 1 < numHops)
+      {
+        const auto* rc = candidates.Pick(
+            taken, [&exclude](const RouterContact& rc) { return exclude.count(rc.pubkey) == 0; });
+        if (not rc)
+          return std::nullopt;
+        hops.emplace_back(*rc);
       }
+      if (hops.size() < numHops)
+        hops.emplace_back(*endpointRC);
       return hops;
     }
 
@@ -383,6 +361,7 @@ namespace llarp
       // async generate keys
       auto ctx = std::make_shared<AsyncPathKeyExchangeContext>();
       ctx->router = m_router;
+      ctx->keys = m_router->ephemeralKeys();
       auto self = GetSelf();
       ctx->pathset = self;
       std::string path_shortName = "[path " + m_router->ShortName() + "-";
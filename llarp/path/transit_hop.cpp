@@ -123,31 +123,35 @@ namespace llarp
         std::vector<RelayDownstreamMessage> msgs;
         while (auto maybe = self->m_DownstreamGather.tryPopFront())
         {
-          msgs.push_back(*maybe);
+          auto& msg = msgs.emplace_back();
+          msg.pathid = self->info.rxID;
+          msg.Y = maybe->second;
+          msg.X = llarp_buffer_t{maybe->first};
         }
         self->HandleAllDownstream(std::move(msgs), r);
       };
+      std::vector<XChaCha20Job> ciphers;
+      ciphers.reserve(msgs->size());
+      for (auto& ev : *msgs)
+        ciphers.push_back(
+            XChaCha20Job{ev.first.data(), ev.first.size(), &pathKey, ev.second.data()});
+      CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
       for (auto& ev : *msgs)
       {
-        RelayDownstreamMessage msg;
-        const llarp_buffer_t buf(ev.first);
-        msg.pathid = info.rxID;
-        msg.Y = ev.second ^ nonceXOR;
-        CryptoManager::instance()->xchacha20(buf, pathKey, ev.second);
-        msg.X = buf;
         llarp::LogDebug(
             "relay ",
-            msg.X.size(),
+            ev.first.size(),
             " bytes downstream from ",
             info.upstream,
             " to ",
             info.downstream);
+        ev.second ^= nonceXOR;
         if (m_DownstreamGather.full())
         {
           r->loop()->call(flushIt);
         }
         if (m_DownstreamGather.enabled())
-          m_DownstreamGather.pushBack(msg);
+          m_DownstreamGather.pushBack(std::move(ev));
       }
       r->loop()->call(flushIt);
     }
@@ -159,24 +163,28 @@ namespace llarp
         std::vector<RelayUpstreamMessage> msgs;
         while (auto maybe = self->m_UpstreamGather.tryPopFront())
         {
-          msgs.push_back(*maybe);
+          auto& msg = msgs.emplace_back();
+          msg.pathid = self->info.txID;
+          msg.Y = maybe->second;
+          msg.X = llarp_buffer_t{maybe->first};
         }
         self->HandleAllUpstream(std::move(msgs), r);
       };
+      std::vector<XChaCha20Job> ciphers;
+      ciphers.reserve(msgs->size());
+      for (auto& ev : *msgs)
+        ciphers.push_back(
+            XChaCha20Job{ev.first.data(), ev.first.size(), &pathKey, ev.second.data()});
+      CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
       for (auto& ev : *msgs)
       {
-        const llarp_buffer_t buf(ev.first);
-        RelayUpstreamMessage msg;
-        CryptoManager::instance()->xchacha20(buf, pathKey, ev.second);
-        msg.pathid = info.txID;
-        msg.Y = ev.second ^ nonceXOR;
-        msg.X = buf;
+        ev.second ^= nonceXOR;
         if (m_UpstreamGather.full())
         {
           r->loop()->call(flushIt);
         }
         if (m_UpstreamGather.enabled())
-          m_UpstreamGather.pushBack(msg);
+          m_UpstreamGather.pushBack(std::move(ev));
       }
       r->loop()->call(flushIt);
     }
@@ -237,6 +245,67 @@ namespace llarp
       r->linkManager().PumpLinks();
     }
 
+    bool
+    TransitHop::HandleUpstreamFrame(RelayFrame frame, AbstractRouter* r)
+    {
+      // at the end of the path the payload is parsed as routing messages, so take it out
+      if (IsEndpoint(r->pubkey()))
+        return IHopHandler::HandleUpstreamFrame(std::move(frame), r);
+      if (not m_UpstreamReplayFilter.Insert(TunnelNonce{frame.Nonce()}))
+        return false;
+      if (m_UpstreamFrames == nullptr)
+        m_UpstreamFrames = std::make_shared<std::vector<RelayFrame>>();
+      m_UpstreamFrames->emplace_back(std::move(frame));
+      r->loop()->wakeup();
+      return true;
+    }
+
+    bool
+    TransitHop::HandleDownstreamFrame(RelayFrame frame, AbstractRouter* r)
+    {
+      if (not m_DownstreamReplayFilter.Insert(TunnelNonce{frame.Nonce()}))
+        return false;
+      if (m_DownstreamFrames == nullptr)
+        m_DownstreamFrames = std::make_shared<std::vector<RelayFrame>>();
+      m_DownstreamFrames->emplace_back(std::move(frame));
+      r->loop()->wakeup();
+      return true;
+    }
+
+    void
+    TransitHop::ForwardFrames(FrameQueue_ptr frames, bool upstream, AbstractRouter* r)
+    {
+      std::vector<XChaCha20Job> ciphers;
+      ciphers.reserve(frames->size());
+      for (auto& frame : *frames)
+        ciphers.push_back(
+            XChaCha20Job{frame.Payload(), frame.payloadSize, &pathKey, frame.Nonce()});
+      CryptoManager::instance()->xchacha20_many(ciphers.data(), ciphers.size());
+
+      const auto& nextID = upstream ? info.txID : info.rxID;
+      const TunnelNonce nonceX{nonceXOR.data()};
+      for (auto& frame : *frames)
+      {
+        frame.XorNonce(nonceX);
+        frame.SetPathID(nextID);
+      }
+      r->loop()->call([self = shared_from_this(), frames, upstream, r]() {
+        const auto& next = upstream ? self->info.upstream : self->info.downstream;
+        const auto& nextID = upstream ? self->info.txID : self->info.rxID;
+        for (auto& frame : *frames)
+        {
+          llarp::LogDebug(
+              "relay ",
+              frame.payloadSize,
+              upstream ? " bytes upstream to " : " bytes downstream to ",
+              next);
+          r->outboundMessageHandler().QueueEncodedMessage(
+              next, std::move(frame.buf), nextID, 0, nullptr);
+        }
+        r->linkManager().PumpLinks();
+      });
+    }
+
     void
     TransitHop::FlushUpstream(AbstractRouter* r)
     {
@@ -247,6 +316,13 @@ namespace llarp
         });
       }
       m_UpstreamQueue = nullptr;
+      if (m_UpstreamFrames && not m_UpstreamFrames->empty())
+      {
+        r->QueueWork([self = shared_from_this(), frames = std::move(m_UpstreamFrames), r]() {
+          self->ForwardFrames(frames, true, r);
+        });
+      }
+      m_UpstreamFrames = nullptr;
     }
 
     void
@@ -259,6 +335,13 @@ namespace llarp
         });
       }
       m_DownstreamQueue = nullptr;
+      if (m_DownstreamFrames && not m_DownstreamFrames->empty())
+      {
+        r->QueueWork([self = shared_from_this(), frames = std::move(m_DownstreamFrames), r]() {
+          self->ForwardFrames(frames, false, r);
+        });
+      }
+      m_DownstreamFrames = nullptr;
     }
 
     /// this is where a DHT message is handled at the end of a path, that is,
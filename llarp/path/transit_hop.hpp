@@ -195,6 +195,14 @@ namespace llarp
       bool
       HandleDHTMessage(const dht::IMessage& msg, AbstractRouter* r) override;
 
+      /// queue a frame to be peeled and forwarded as is, unless we are the end of the path
+      bool
+      HandleUpstreamFrame(RelayFrame frame, AbstractRouter* r) override;
+
+      /// queue a frame to be peeled and forwarded as is
+      bool
+      HandleDownstreamFrame(RelayFrame frame, AbstractRouter* r) override;
+
       void
       FlushUpstream(AbstractRouter* r) override;
 
@@ -215,6 +223,13 @@ namespace llarp
       HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r) override;
 
      private:
+      using FrameQueue_ptr = std::shared_ptr<std::vector<RelayFrame>>;
+
+      /// decrypt our layer of every frame and rewrite its path id and nonce for the next hop, all
+      /// in place; then send them on from the logic thread
+      void
+      ForwardFrames(FrameQueue_ptr frames, bool upstream, AbstractRouter* r);
+
       void
       SetSelfDestruct();
 
@@ -222,8 +237,12 @@ namespace llarp
       QueueDestroySelf(AbstractRouter* r);
 
       std::set<std::shared_ptr<TransitHop>, ComparePtr<std::shared_ptr<TransitHop>>> m_FlushOthers;
-      thread::Queue<RelayUpstreamMessage> m_UpstreamGather;
-      thread::Queue<RelayDownstreamMessage> m_DownstreamGather;
+      /// crypto workers hand peeled payloads with their next hop nonce back to the logic thread
+      /// through these; the relay messages are only built when they are flushed
+      thread::Queue<TrafficEvent_t> m_UpstreamGather;
+      thread::Queue<TrafficEvent_t> m_DownstreamGather;
+      FrameQueue_ptr m_UpstreamFrames;
+      FrameQueue_ptr m_DownstreamFrames;
       std::atomic<uint32_t> m_UpstreamWorkCounter;
       std::atomic<uint32_t> m_DownstreamWorkCounter;
     };
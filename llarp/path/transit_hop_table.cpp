@@ -0,0 +1,219 @@
+#include "transit_hop_table.hpp"
+#include "transit_hop.hpp"
+
+#include <cstring>
+
+namespace llarp
+{
+  namespace path
+  {
+    namespace
+    {
+      constexpr uint64_t Fibonacci = 0x9E3779B97F4A7C15ULL;
+      constexpr size_t MinSlots = 16;
+    }  // namespace
+
+    uint64_t
+    TransitHopTable::Key::Hash() const
+    {
+      // path ids are random so a word of one is already a good hash, the router and direction
+      // are only mixed in to keep a hop's four keys apart
+      uint64_t h, r;
+      std::memcpy(&h, id.data(), sizeof(h));
+      std::memcpy(&r, remote.data(), sizeof(r));
+      h ^= (r + upstream) * Fibonacci;
+      return h ? h : 1;
+    }
+
+    bool
+    TransitHopTable::Key::Matches(const TransitHop& hop) const
+    {
+      const auto& info = hop.info;
+      return (id == info.txID or id == info.rxID)
+          and remote == (upstream ? info.upstream : info.downstream);
+    }
+
+    const TransitHopTable::Slot*
+    TransitHopTable::Shard::Find(const Key& k, uint64_t hash) const
+    {
+      if (slots.empty())
+        return nullptr;
+      const size_t mask = slots.size() - 1;
+      for (size_t idx = hash & mask;; idx = (idx + 1) & mask)
+      {
+        const auto& slot = slots[idx];
+        if (slot.hash == 0)
+          return nullptr;
+        if (slot.hash == hash and k.Matches(*slot.hop))
+          return &slot;
+      }
+    }
+
+    void
+    TransitHopTable::Shard::Grow()
+    {
+      std::vector<Slot> old(std::max(MinSlots, slots.size() * 2));
+      std::swap(old, slots);
+      const size_t mask = slots.size() - 1;
+      for (auto& slot : old)
+      {
+        if (slot.hash == 0)
+          continue;
+        size_t idx = slot.hash & mask;
+        while (slots[idx].hash)
+          idx = (idx + 1) & mask;
+        slots[idx] = std::move(slot);
+      }
+    }
+
+    void
+    TransitHopTable::Shard::Insert(const Key& k, uint64_t hash, TransitHop_ptr hop)
+    {
+      if (Find(k, hash))
+        return;
+      // keep it at most half full so probes stay short
+      if ((used + 1) * 2 > slots.size())
+        Grow();
+      const size_t mask = slots.size() - 1;
+      size_t idx = hash & mask;
+      while (slots[idx].hash)
+        idx = (idx + 1) & mask;
+      slots[idx] = Slot{hash, std::move(hop)};
+      used++;
+    }
+
+    bool
+    TransitHopTable::Shard::Erase(const Key& k, uint64_t hash, const TransitHop_ptr& hop)
+    {
+      const auto* found = Find(k, hash);
+      if (found == nullptr or found->hop != hop)
+        return false;
+      const size_t mask = slots.size() - 1;
+      size_t hole = found - slots.data();
+      slots[hole] = Slot{};
+      used--;
+      // shift anything after the hole that probed past it back into it, so lookups never stop
+      // early at an empty slot that used to be in their way
+      for (size_t idx = (hole + 1) & mask; slots[idx].hash; idx = (idx + 1) & mask)
+      {
+        const size_t home = slots[idx].hash & mask;
+        if (((idx - home) & mask) >= ((idx - hole) & mask))
+        {
+          slots[hole] = std::move(slots[idx]);
+          slots[idx] = Slot{};
+          hole = idx;
+        }
+      }
+      return true;
+    }
+
+    std::array<TransitHopTable::Key, 4>
+    TransitHopTable::KeysFor(const TransitHopInfo& info)
+    {
+      // the first key is the one ForEach visits the hop under
+      return {
+          Key{info.txID, info.upstream, true},
+          Key{info.rxID, info.upstream, true},
+          Key{info.txID, info.downstream, false},
+          Key{info.rxID, info.downstream, false}};
+    }
+
+    TransitHopTable::Shard&
+    TransitHopTable::ShardFor(uint64_t hash)
+    {
+      // top bits of a fibonacci hash so the shard does not correlate with the slot
+      return m_Shards[(hash * Fibonacci) >> (64 - ShardBits)];
+    }
+
+    const TransitHopTable::Shard&
+    TransitHopTable::ShardFor(uint64_t hash) const
+    {
+      return m_Shards[(hash * Fibonacci) >> (64 - ShardBits)];
+    }
+
+    TransitHop_ptr
+    TransitHopTable::Get(const Key& k) const
+    {
+      const auto hash = k.Hash();
+      const auto& shard = ShardFor(hash);
+      std::shared_lock lock{shard.mutex};
+      if (const auto* slot = shard.Find(k, hash))
+        return slot->hop;
+      return nullptr;
+    }
+
+    bool
+    TransitHopTable::Put(TransitHop_ptr hop)
+    {
+      std::lock_guard writeLock{m_WriteMutex};
+      const auto keys = KeysFor(hop->info);
+      for (const auto& k : keys)
+      {
+        if (Get(k))
+          return false;
+      }
+      for (const auto& k : keys)
+      {
+        const auto hash = k.Hash();
+        auto& shard = ShardFor(hash);
+        std::unique_lock lock{shard.mutex};
+        shard.Insert(k, hash, hop);
+      }
+      m_Size++;
+      return true;
+    }
+
+    void
+    TransitHopTable::Remove(const TransitHop_ptr& hop)
+    {
+      std::lock_guard writeLock{m_WriteMutex};
+      bool removed = false;
+      for (const auto& k : KeysFor(hop->info))
+      {
+        const auto hash = k.Hash();
+        auto& shard = ShardFor(hash);
+        std::unique_lock lock{shard.mutex};
+        removed |= shard.Erase(k, hash, hop);
+      }
+      if (removed)
+        m_Size--;
+    }
+
+    TransitHop_ptr
+    TransitHopTable::GetByUpstream(const RouterID& remote, const PathID_t& id) const
+    {
+      return Get(Key{id, remote, true});
+    }
+
+    TransitHop_ptr
+    TransitHopTable::GetByDownstream(const RouterID& remote, const PathID_t& id) const
+    {
+      return Get(Key{id, remote, false});
+    }
+
+    bool
+    TransitHopTable::Has(const TransitHopInfo& info) const
+    {
+      for (const auto& k : KeysFor(info))
+      {
+        if (Get(k))
+          return true;
+      }
+      return false;
+    }
+
+    void
+    TransitHopTable::ForEach(std::function<void(const TransitHop_ptr&)> visit) const
+    {
+      for (const auto& shard : m_Shards)
+      {
+        std::shared_lock lock{shard.mutex};
+        for (const auto& slot : shard.slots)
+        {
+          if (slot.hash and slot.hash == KeysFor(slot.hop->info)[0].Hash())
+            visit(slot.hop);
+        }
+      }
+    }
+  }  // namespace path
+}  // namespace llarp
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "path_types.hpp"
+#include <llarp/router_id.hpp>
+#include <llarp/util/thread/annotations.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace llarp
+{
+  namespace path
+  {
+    struct TransitHop;
+    struct TransitHopInfo;
+
+    using TransitHop_ptr = std::shared_ptr<TransitHop>;
+
+    /// all the transit hops we relay for, indexed by (path id, remote router, direction).
+    ///
+    /// every hop is filed under both of its path ids, once for the router upstream of us and once
+    /// for the router downstream, so finding the hop for a relayed message is a single hash probe.
+    /// the index is split into shards each with its own reader/writer lock; lookups only ever take
+    /// a shared lock on the one shard their key lands in and so can be done from any thread
+    /// without getting in each other's way.
+    class TransitHopTable
+    {
+     public:
+      static constexpr size_t ShardBits = 6;
+      static constexpr size_t NumShards = size_t{1} << ShardBits;
+
+      /// add a hop, false if any of its path ids is already in use by another hop with the same
+      /// upstream or downstream router, in which case nothing is added
+      bool
+      Put(TransitHop_ptr hop) EXCLUDES(m_WriteMutex);
+
+      /// drop a hop from the table, does nothing if it is not in it
+      void
+      Remove(const TransitHop_ptr& hop) EXCLUDES(m_WriteMutex);
+
+      /// the hop with path id `id` whose upstream router is `remote`
+      TransitHop_ptr
+      GetByUpstream(const RouterID& remote, const PathID_t& id) const;
+
+      /// the hop with path id `id` whose downstream router is `remote`
+      TransitHop_ptr
+      GetByDownstream(const RouterID& remote, const PathID_t& id) const;
+
+      /// true if we have this exact hop or if putting it would clash with one we have
+      bool
+      Has(const TransitHopInfo& info) const;
+
+      /// visit every hop once.  visit is called with a shard locked and must not add or remove
+      /// hops.
+      void
+      ForEach(std::function<void(const TransitHop_ptr&)> visit) const;
+
+      /// number of hops
+      size_t
+      Size() const
+      {
+        return m_Size.load(std::memory_order_relaxed);
+      }
+
+     private:
+      struct Key
+      {
+        PathID_t id;
+        RouterID remote;
+        bool upstream;
+
+        /// never 0, which marks an empty slot
+        uint64_t
+        Hash() const;
+
+        /// true if this is one of hop's keys
+        bool
+        Matches(const TransitHop& hop) const;
+      };
+
+      struct Slot
+      {
+        uint64_t hash = 0;
+        TransitHop_ptr hop;
+      };
+
+      /// an open addressed, linear probed table.  a slot keeps the key's hash next to the hop so a
+      /// probe only has to look at the hop itself once the hash matches.
+      struct alignas(64) Shard
+      {
+        mutable std::shared_mutex mutex;
+        std::vector<Slot> slots GUARDED_BY(mutex);
+        size_t used GUARDED_BY(mutex) = 0;
+
+        const Slot*
+        Find(const Key& k, uint64_t hash) const REQUIRES_SHARED(mutex);
+
+        /// add hop under k unless k is already taken
+        void
+        Insert(const Key& k, uint64_t hash, TransitHop_ptr hop) REQUIRES(mutex);
+
+        /// remove k if it is filed under hop
+        bool
+        Erase(const Key& k, uint64_t hash, const TransitHop_ptr& hop) REQUIRES(mutex);
+
+        void
+        Grow() REQUIRES(mutex);
+      };
+
+      static std::array<Key, 4>
+      KeysFor(const TransitHopInfo& info);
+
+      Shard&
+      ShardFor(uint64_t hash);
+
+      const Shard&
+      ShardFor(uint64_t hash) const;
+
+      TransitHop_ptr
+      Get(const Key& k) const;
+
+      /// serialises writers so a hop's keys go in and out together
+      std::mutex m_WriteMutex;
+      std::array<Shard, NumShards> m_Shards;
+      std::atomic<size_t> m_Size{0};
+    };
+  }  // namespace path
+}  // namespace llarp
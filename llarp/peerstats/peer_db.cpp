@@ -4,11 +4,21 @@
 #include <llarp/util/status.hpp>
 #include <llarp/util/str.hpp>
 
+#include <algorithm>
+
 namespace llarp
 {
+  namespace
+  {
+    /// rows written per statement, which keeps the bound parameters under sqlite's default limit
+    /// of 999
+    constexpr size_t FlushBatchSize = 64;
+  }  // namespace
+
   PeerDb::PeerDb()
   {
     m_lastFlush.store({});
+    m_lastFlushDuration.store({});
   }
 
   void
@@ -20,6 +30,7 @@ namespace llarp
       throw std::runtime_error("Reloading database not supported");  // TODO
 
     m_peerStats.clear();
+    m_recentlyUsed.clear();
 
     // sqlite_orm treats empty-string as an indicator to load a memory-backed database, which we'll
     // use if file is an empty-optional
@@ -35,18 +46,25 @@ namespace llarp
     }
 
     m_storage = std::make_unique<PeerDbStorage>(initStorage(fileString));
+    if (file.has_value())
+    {
+      // keep the connection (and with it the journal) open instead of reopening the file for
+      // every statement
+      m_storage->open_forever();
+      m_storage->pragma.journal_mode(sqlite_orm::journal_mode::WAL);
+      // NORMAL: a crash can lose the last flush but never corrupts the database
+      m_storage->pragma.synchronous(1);
+    }
     m_storage->sync_schema(true);  // true for "preserve" as in "don't nuke" (how cute!)
 
-    auto allStats = m_storage->get_all<PeerStats>();
-    LogInfo("Loading ", allStats.size(), " PeerStats from table peerstats...");
-    for (PeerStats& stats : allStats)
+    if (file.has_value())
     {
-      // we cleared m_peerStats, and the database should enforce that routerId is unique...
-      assert(m_peerStats.find(stats.routerId) == m_peerStats.end());
-
-      stats.stale = false;
-      m_peerStats[stats.routerId] = stats;
+      m_reader = std::make_unique<PeerDbStorage>(initStorage(fileString));
+      m_reader->open_forever();
     }
+
+    m_numStored = m_storage->count<PeerStats>();
+    LogInfo("Found ", m_numStored, " PeerStats in table peerstats");
   }
 
   void
@@ -54,15 +72,16 @@ namespace llarp
   {
     LogDebug("flushing PeerDb...");
 
-    auto start = time_now_ms();
-    if (not shouldFlush(start))
+    if (not m_storage)
+      throw std::runtime_error("Cannot flush database before it has been loaded");
+
+    if (m_flushing.exchange(true))
     {
       LogWarn("Call to flushDatabase() while already in progress, ignoring");
       return;
     }
 
-    if (not m_storage)
-      throw std::runtime_error("Cannot flush database before it has been loaded");
+    auto start = time_now_ms();
 
     std::vector<PeerStats> staleStats;
 
@@ -72,33 +91,60 @@ namespace llarp
       // copy all stale entries
       for (auto& entry : m_peerStats)
       {
-        if (entry.second.stale)
+        if (entry.second.stats.stale)
         {
-          staleStats.push_back(entry.second);
-          entry.second.stale = false;
+          staleStats.push_back(entry.second.stats);
+          entry.second.stats.stale = false;
         }
       }
     }
 
     LogDebug("Updating ", staleStats.size(), " stats");
 
+    size_t numStored = 0;
+    try
     {
-      auto guard = m_storage->transaction_guard();
+      std::lock_guard guard(m_storageLock);
+      auto transaction = m_storage->transaction_guard();
 
+      for (auto itr = staleStats.begin(); itr != staleStats.end();)
+      {
+        const auto batch = std::min<size_t>(FlushBatchSize, staleStats.end() - itr);
+        m_storage->replace_range(itr, itr + batch);
+        itr += batch;
+      }
+
+      transaction.commit();
+      numStored = m_storage->count<PeerStats>();
+    }
+    catch (...)
+    {
+      // nothing was written, so they still have to be, and must not be dropped before they are
+      std::lock_guard guard(m_statsLock);
       for (const auto& stats : staleStats)
       {
-        m_storage->replace(stats);
+        if (auto itr = m_peerStats.find(stats.routerId); itr != m_peerStats.end())
+          itr->second.stats.stale = true;
       }
+      m_flushing = false;
+      throw;
+    }
 
-      guard.commit();
+    {
+      // only now that they are written can the peers we copied be dropped
+      std::lock_guard guard(m_statsLock);
+      m_numStored = numStored;
+      evictColdPeers();
     }
 
     auto end = time_now_ms();
 
     auto elapsed = end - start;
-    LogDebug("PeerDb flush took about ", elapsed, " seconds");
+    LogDebug("PeerDb flush took about ", elapsed, " ms");
 
+    m_lastFlushDuration.store(elapsed);
     m_lastFlush.store(end);
+    m_flushing = false;
   }
 
   void
@@ -108,23 +154,22 @@ namespace llarp
       throw std::invalid_argument(
           stringify("routerId ", routerId, " doesn't match ", delta.routerId));
 
-    std::lock_guard guard(m_statsLock);
-    auto itr = m_peerStats.find(routerId);
-    if (itr == m_peerStats.end())
-      itr = m_peerStats.insert({routerId, delta}).first;
+    std::unique_lock lock(m_statsLock);
+    PeerStats* stats = findPeerStats(routerId, lock);
+    if (stats)
+      *stats += delta;
     else
-      itr->second += delta;
+      stats = &insertPeerStats(delta);
 
-    itr->second.stale = true;
+    stats->stale = true;
   }
 
   void
   PeerDb::modifyPeerStats(const RouterID& routerId, std::function<void(PeerStats&)> callback)
   {
-    std::lock_guard guard(m_statsLock);
+    std::unique_lock lock(m_statsLock);
 
-    PeerStats& stats = m_peerStats[routerId];
-    stats.routerId = routerId;
+    PeerStats& stats = findOrCreatePeerStats(routerId, lock);
     stats.stale = true;
     callback(stats);
   }
@@ -132,25 +177,54 @@ namespace llarp
   std::optional<PeerStats>
   PeerDb::getCurrentPeerStats(const RouterID& routerId) const
   {
-    std::lock_guard guard(m_statsLock);
-    auto itr = m_peerStats.find(routerId);
-    if (itr == m_peerStats.end())
+    std::unique_lock lock(m_statsLock);
+    const PeerStats* stats = findPeerStats(routerId, lock);
+    if (not stats)
       return std::nullopt;
     else
-      return itr->second;
+      return *stats;
   }
 
   std::vector<PeerStats>
   PeerDb::listAllPeerStats() const
   {
-    std::lock_guard guard(m_statsLock);
-
     std::vector<PeerStats> statsList;
-    statsList.reserve(m_peerStats.size());
+    std::unordered_set<RouterID, RouterID::Hash> inMemory;
 
-    for (const auto& [routerId, stats] : m_peerStats)
     {
-      statsList.push_back(stats);
+      std::lock_guard guard(m_statsLock);
+
+      statsList.reserve(m_peerStats.size());
+      inMemory.reserve(m_peerStats.size());
+
+      for (const auto& [routerId, cached] : m_peerStats)
+      {
+        statsList.push_back(cached.stats);
+        inMemory.insert(routerId);
+      }
+    }
+
+    std::vector<PeerStats> stored;
+    if (m_reader)
+    {
+      std::lock_guard guard(m_readerLock);
+      stored = m_reader->get_all<PeerStats>();
+    }
+    else if (m_storage)
+    {
+      std::lock_guard guard(m_storageLock);
+      stored = m_storage->get_all<PeerStats>();
+    }
+
+    // what we had in memory is newer than what was last flushed, and anything that was not in
+    // memory when we looked was flushed before it was dropped
+    for (PeerStats& stats : stored)
+    {
+      if (inMemory.count(stats.routerId) == 0)
+      {
+        stats.stale = false;
+        statsList.push_back(std::move(stats));
+      }
     }
 
     return statsList;
@@ -159,16 +233,15 @@ namespace llarp
   std::vector<PeerStats>
   PeerDb::listPeerStats(const std::vector<RouterID>& ids) const
   {
-    std::lock_guard guard(m_statsLock);
+    std::unique_lock lock(m_statsLock);
 
     std::vector<PeerStats> statsList;
     statsList.reserve(ids.size());
 
     for (const auto& id : ids)
     {
-      const auto itr = m_peerStats.find(id);
-      if (itr != m_peerStats.end())
-        statsList.push_back(itr->second);
+      if (const PeerStats* stats = findPeerStats(id, lock))
+        statsList.push_back(*stats);
     }
 
     return statsList;
@@ -224,11 +297,10 @@ namespace llarp
   void
   PeerDb::handleGossipedRC(const RouterContact& rc, llarp_time_t now)
   {
-    std::lock_guard guard(m_statsLock);
+    std::unique_lock lock(m_statsLock);
 
     RouterID id(rc.pubkey);
-    auto& stats = m_peerStats[id];
-    stats.routerId = id;
+    auto& stats = findOrCreatePeerStats(id, lock);
 
     const bool isNewRC = (stats.lastRCUpdated < rc.last_updated);
 
@@ -261,9 +333,20 @@ namespace llarp
   {
     fs::path dbPath = routerConfig.m_dataDir / "peerstats.sqlite";
 
+    setCacheSize(routerConfig.m_peerDbCacheSize);
     loadDatabase(dbPath);
   }
 
+  void
+  PeerDb::setCacheSize(size_t numPeers)
+  {
+    if (numPeers == 0)
+      throw std::invalid_argument("PeerDb cache size must be at least 1");
+
+    std::lock_guard guard(m_statsLock);
+    m_cacheSize = numPeers;
+  }
+
   bool
   PeerDb::shouldFlush(llarp_time_t now)
   {
@@ -274,6 +357,16 @@ namespace llarp
   util::StatusObject
   PeerDb::ExtractStatus() const
   {
+    // read before taking the lock, as it may go to the database
+    const auto allStats = listAllPeerStats();
+
+    std::vector<util::StatusObject> statsObjs;
+    statsObjs.reserve(allStats.size());
+    for (const auto& stats : allStats)
+    {
+      statsObjs.push_back(stats.toJson());
+    }
+
     std::lock_guard guard(m_statsLock);
 
     bool loaded = (m_storage.get() != nullptr);
@@ -281,20 +374,114 @@ namespace llarp
     if (loaded)
       dbFile = m_storage->filename();
 
-    std::vector<util::StatusObject> statsObjs;
-    statsObjs.reserve(m_peerStats.size());
-    for (const auto& pair : m_peerStats)
-    {
-      statsObjs.push_back(pair.second.toJson());
-    }
-
     util::StatusObject obj{
         {"dbLoaded", loaded},
         {"dbFile", dbFile},
         {"lastFlushMs", m_lastFlush.load().count()},
+        {"lastFlushDurationMs", m_lastFlushDuration.load().count()},
+        {"cacheSize", m_cacheSize},
+        {"numCached", m_peerStats.size()},
+        {"numStored", m_numStored},
+        {"numReloaded", m_numReloaded},
+        {"numEvicted", m_numEvicted},
         {"stats", statsObjs},
     };
     return obj;
   }
 
+  PeerStats*
+  PeerDb::findCachedPeerStats(const RouterID& routerId) const
+  {
+    auto itr = m_peerStats.find(routerId);
+    if (itr == m_peerStats.end())
+      return nullptr;
+
+    m_recentlyUsed.splice(m_recentlyUsed.begin(), m_recentlyUsed, itr->second.used);
+    return &itr->second.stats;
+  }
+
+  PeerStats*
+  PeerDb::findPeerStats(const RouterID& routerId, std::unique_lock<std::mutex>& lock) const
+  {
+    while (true)
+    {
+      if (PeerStats* stats = findCachedPeerStats(routerId))
+        return stats;
+
+      // a memory-backed database never drops a peer, so there is nothing to read back
+      if (not m_reader)
+        return nullptr;
+
+      const auto numEvicted = m_numEvicted;
+      lock.unlock();
+      auto stored = readPeerStats(routerId);
+      lock.lock();
+
+      // someone else read it back while we were
+      if (PeerStats* stats = findCachedPeerStats(routerId))
+        return stats;
+
+      // if peers were dropped in the meantime this one may have been read back, changed, flushed
+      // and dropped again after we read it, so what we have could be old
+      if (m_numEvicted != numEvicted)
+        continue;
+
+      if (not stored)
+        return nullptr;
+
+      m_numReloaded++;
+      stored->stale = false;
+      return &insertPeerStats(*stored);
+    }
+  }
+
+  PeerStats&
+  PeerDb::findOrCreatePeerStats(const RouterID& routerId, std::unique_lock<std::mutex>& lock)
+  {
+    if (PeerStats* stats = findPeerStats(routerId, lock))
+      return *stats;
+    return insertPeerStats(PeerStats{routerId});
+  }
+
+  PeerStats&
+  PeerDb::insertPeerStats(const PeerStats& stats) const
+  {
+    m_recentlyUsed.push_front(stats.routerId);
+    auto& cached = m_peerStats[stats.routerId];
+    cached.stats = stats;
+    cached.used = m_recentlyUsed.begin();
+    return cached.stats;
+  }
+
+  std::optional<PeerStats>
+  PeerDb::readPeerStats(const RouterID& routerId) const
+  {
+    std::lock_guard guard(m_readerLock);
+    auto stats = m_reader->get_pointer<PeerStats>(routerId);
+    if (not stats)
+      return std::nullopt;
+    return *stats;
+  }
+
+  void
+  PeerDb::evictColdPeers()
+  {
+    if (not m_reader)
+      return;
+
+    auto itr = m_recentlyUsed.end();
+    while (m_peerStats.size() > m_cacheSize and itr != m_recentlyUsed.begin())
+    {
+      --itr;
+      auto found = m_peerStats.find(*itr);
+      // changed since we copied it for the flush, keep it until the next one
+      if (found->second.stats.stale)
+        continue;
+
+      m_peerStats.erase(found);
+      itr = m_recentlyUsed.erase(itr);
+      m_numEvicted++;
+    }
+  }
+
 };  // namespace llarp
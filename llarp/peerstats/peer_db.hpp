@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
 #include <functional>
+#include <list>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <sqlite_orm/sqlite_orm.h>
 
@@ -19,8 +23,16 @@ namespace llarp
   /// This uses a sqlite3 database behind the scenes as persistance, but this database is
   /// periodically flushed to, meaning that it will become stale as PeerDb accumulates stats without
   /// a flush.
+  ///
+  /// Only a bounded number of peers are kept in memory. Once a file-backed database is loaded,
+  /// peers that have been flushed and not used for a while are dropped from memory and read back
+  /// from the database the next time they are used, so memory use does not grow with the number
+  /// of peers ever seen.
   struct PeerDb
   {
+    /// How many peers are kept in memory unless configured otherwise
+    static constexpr size_t DefaultCacheSize = 10000;
+
     /// Constructor
     PeerDb();
 
@@ -28,6 +40,10 @@ namespace llarp
     /// `std::nullopt`, the database will be loaded into memory (useful for testing).
     ///
     /// This must be called prior to calling flushDatabase(), and will truncate any existing data.
+    /// Nothing is read up front, the stats of each peer are read as it is first used.
+    ///
+    /// A file-backed database is put in WAL mode so that peers can be read back while a flush is
+    /// writing.
     ///
     /// This is a blocking call, both in the sense that it blocks on disk/database I/O and that it
     /// will sit on a mutex while the database is loaded.
@@ -42,6 +58,10 @@ namespace llarp
     /// and should be called in an appropriate threading context. However, it will make a temporary
     /// copy of the peer stats so as to avoid sitting on a mutex lock during disk I/O.
     ///
+    /// Only peers whose stats changed since the last flush are written, several rows to a
+    /// statement. Afterwards the coldest peers are dropped from memory until no more than the
+    /// cache size are left; peers with changes still to be written are never dropped.
+    ///
     /// @throws if the database could not be written to (esp. if loadDatabase() has not been called)
     void
     flushDatabase();
@@ -75,7 +95,8 @@ namespace llarp
     modifyPeerStats(const RouterID& routerId, std::function<void(PeerStats&)> callback);
 
     /// Provides a snapshot of the most recent PeerStats we have for the given peer. If we don't
-    /// have any stats for the peer, std::nullopt
+    /// have any stats for the peer, std::nullopt. Stats that were dropped from memory are read
+    /// back from the database.
     ///
     /// @param routerId is the RouterID of the requested peer
     /// @return a copy of the most recent peer stats or an empty one if no such peer is known
@@ -84,7 +105,8 @@ namespace llarp
 
     /// Lists all peer stats. This essentially dumps the database into a list of PeerStats objects.
     ///
-    /// Note that this avoids disk I/O by copying from our cached map of peers.
+    /// Note that this reads the whole database, though without holding up the other calls while
+    /// it does.
     ///
     /// @return a list of all PeerStats we have maintained
     std::vector<PeerStats>
@@ -113,6 +135,13 @@ namespace llarp
     void
     configure(const RouterConfig& routerConfig);
 
+    /// Sets how many peers are kept in memory. Takes effect at the next flush. A memory-backed
+    /// database keeps every peer, as dropping them would save nothing.
+    ///
+    /// @param numPeers is the most peers to keep in memory, must be at least 1
+    void
+    setCacheSize(size_t numPeers);
+
     /// Returns whether or not we should flush, as determined by the last time we flushed and the
     /// configured flush interval.
     ///
@@ -120,19 +149,72 @@ namespace llarp
     bool
     shouldFlush(llarp_time_t now);
 
-    /// Get JSON status for API
+    /// Get JSON status for API. Like listAllPeerStats(), "stats" lists every peer, including
+    /// those that were dropped from memory.
     ///
     /// @return JSON object representing our current status
     util::StatusObject
     ExtractStatus() const;
 
    private:
-    std::unordered_map<RouterID, PeerStats, RouterID::Hash> m_peerStats;
+    struct CachedStats
+    {
+      PeerStats stats;
+      /// where this peer is in m_recentlyUsed
+      std::list<RouterID>::iterator used;
+    };
+
+    /// Finds the stats for a peer in memory and marks the peer as just used. m_statsLock must be
+    /// held.
+    PeerStats*
+    findCachedPeerStats(const RouterID& routerId) const;
+
+    /// Like findCachedPeerStats() but reads the stats back from the database if they were dropped
+    /// from memory. `lock` must hold m_statsLock; it is released while the database is read.
+    ///
+    /// @return the stats or nullptr if we know nothing about the peer
+    PeerStats*
+    findPeerStats(const RouterID& routerId, std::unique_lock<std::mutex>& lock) const;
+
+    /// Like findPeerStats() but starts empty stats for a peer we know nothing about
+    PeerStats&
+    findOrCreatePeerStats(const RouterID& routerId, std::unique_lock<std::mutex>& lock);
+
+    /// Adds stats for a peer that is not in memory as the most recently used. m_statsLock must be
+    /// held.
+    PeerStats&
+    insertPeerStats(const PeerStats& stats) const;
+
+    /// Reads one peer's stats from a file-backed database
+    std::optional<PeerStats>
+    readPeerStats(const RouterID& routerId) const;
+
+    /// Drops the least recently used peers that have nothing left to flush until no more than
+    /// m_cacheSize are left. Does nothing for a memory-backed database. m_statsLock must be held.
+    void
+    evictColdPeers();
+
+    mutable std::unordered_map<RouterID, CachedStats, RouterID::Hash> m_peerStats;
+    /// most recently used at the front
+    mutable std::list<RouterID> m_recentlyUsed;
     mutable std::mutex m_statsLock;
+    size_t m_cacheSize = DefaultCacheSize;
+    /// how many peers had a row in the database after the last load or flush
+    size_t m_numStored = 0;
+    mutable uint64_t m_numReloaded = 0;
+    uint64_t m_numEvicted = 0;
 
+    /// what flushDatabase() writes to
     std::unique_ptr<PeerDbStorage> m_storage;
+    mutable std::mutex m_storageLock;
+    /// a second connection to a file-backed database that reads peers back without waiting on
+    /// m_storageLock
+    std::unique_ptr<PeerDbStorage> m_reader;
+    mutable std::mutex m_readerLock;
 
+    std::atomic<bool> m_flushing{false};
     std::atomic<llarp_time_t> m_lastFlush;
+    std::atomic<llarp_time_t> m_lastFlushDuration;
   };
 
 }  // namespace llarp
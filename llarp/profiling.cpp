@@ -1,6 +1,10 @@
 #include "profiling.hpp"
 
+#include <algorithm>
+#include <deque>
 #include <fstream>
+#include <iterator>
+#include <mutex>
 #include "util/fs.hpp"
 
 namespace llarp
@@ -100,6 +104,239 @@ namespace llarp
         and checkIsGood(pathTimeoutCount, pathSuccessCount, chances);
   }
 
+  namespace
+  {
+    /// halve a counter that may be bumped at the same time
+    void
+    Halve(std::atomic<uint64_t>& counter)
+    {
+      auto val = counter.load(std::memory_order_relaxed);
+      while (not counter.compare_exchange_weak(val, val / 2, std::memory_order_relaxed))
+        ;
+    }
+
+    constexpr size_t ShardBits = 4;
+    constexpr size_t InitialShardCapacity = 64;
+
+    bool
+    BEncodeProfiles(
+        const std::vector<std::pair<RouterID, RouterProfile>>& profiles, llarp_buffer_t* buf)
+    {
+      if (!bencode_start_dict(buf))
+        return false;
+      for (const auto& [router, profile] : profiles)
+      {
+        if (!router.BEncode(buf))
+          return false;
+        if (!profile.BEncode(buf))
+          return false;
+      }
+      return bencode_end(buf);
+    }
+
+    /// profiles are tiny, this always fits
+    std::vector<byte_t>
+    EncodeProfiles(const std::vector<std::pair<RouterID, RouterProfile>>& profiles)
+    {
+      std::vector<byte_t> tmp((profiles.size() * (RouterProfile::MaxSize + 32 + 8)) + 8);
+      llarp_buffer_t buf(tmp);
+      if (not BEncodeProfiles(profiles, &buf))
+        return {};
+      tmp.resize(buf.cur - buf.base);
+      return tmp;
+    }
+
+    // lookups never lock, so a table or entry that was unlinked can only be freed once every
+    // lookup that might have found it is done.  each thread announces the reclaim epoch it
+    // started its current lookup in and whatever was retired at an epoch no later than the
+    // oldest one announced is free to go.
+
+    struct alignas(64) ReaderSlot
+    {
+      /// 0 while the thread is not looking anything up
+      std::atomic<uint64_t> epoch{0};
+      bool taken = false;
+    };
+
+    struct Readers
+    {
+      std::mutex mutex;
+      std::deque<ReaderSlot> slots;
+      std::atomic<uint64_t> epoch{1};
+
+      ReaderSlot*
+      Take()
+      {
+        std::lock_guard lock{mutex};
+        for (auto& slot : slots)
+        {
+          if (not slot.taken)
+          {
+            slot.taken = true;
+            return &slot;
+          }
+        }
+        auto& slot = slots.emplace_back();
+        slot.taken = true;
+        return &slot;
+      }
+
+      void
+      Give(ReaderSlot* slot)
+      {
+        std::lock_guard lock{mutex};
+        slot->epoch.store(0, std::memory_order_release);
+        slot->taken = false;
+      }
+
+      /// the epoch of the oldest running lookup, or the current epoch if there is none
+      uint64_t
+      Oldest()
+      {
+        uint64_t oldest = epoch.load(std::memory_order_seq_cst);
+        std::lock_guard lock{mutex};
+        for (const auto& slot : slots)
+        {
+          if (const auto started = slot.epoch.load(std::memory_order_seq_cst))
+            oldest = std::min(oldest, started);
+        }
+        return oldest;
+      }
+    };
+
+    /// shared by every Profiling, slots outlive the threads that give them back on exit
+    Readers&
+    readers()
+    {
+      static auto* r = new Readers{};
+      return *r;
+    }
+
+    struct ThreadReader
+    {
+      ReaderSlot* slot = nullptr;
+      size_t depth = 0;
+
+      ~ThreadReader()
+      {
+        if (slot)
+          readers().Give(slot);
+      }
+    };
+
+    thread_local ThreadReader t_reader;
+
+    /// announces a lookup on this thread for as long as it lives; nests
+    class ReadGuard
+    {
+     public:
+      ReadGuard()
+      {
+        if (t_reader.depth++)
+          return;
+        auto& r = readers();
+        if (t_reader.slot == nullptr)
+          t_reader.slot = r.Take();
+        // seq_cst so either Reclaim sees us or we see what it unlinked
+        t_reader.slot->epoch.store(
+            r.epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+      }
+
+      ReadGuard(const ReadGuard&) = delete;
+      ReadGuard&
+      operator=(const ReadGuard&) = delete;
+
+      ~ReadGuard()
+      {
+        if (--t_reader.depth == 0)
+          t_reader.slot->epoch.store(0, std::memory_order_release);
+      }
+    };
+
+    size_t
+    CapacityFor(size_t num)
+    {
+      size_t capacity = InitialShardCapacity;
+      while (capacity < (num + 1) * 2)
+        capacity *= 2;
+      return capacity;
+    }
+  }  // namespace
+
+  static_assert(Profiling::NumShards == (size_t{1} << ShardBits));
+
+  RouterProfile
+  Profiling::Entry::Snapshot() const
+  {
+    RouterProfile profile;
+    profile.connectTimeoutCount = connectTimeoutCount.load(std::memory_order_relaxed);
+    profile.connectGoodCount = connectGoodCount.load(std::memory_order_relaxed);
+    profile.pathSuccessCount = pathSuccessCount.load(std::memory_order_relaxed);
+    profile.pathFailCount = pathFailCount.load(std::memory_order_relaxed);
+    profile.pathTimeoutCount = pathTimeoutCount.load(std::memory_order_relaxed);
+    profile.lastUpdated = lastUpdated.load(std::memory_order_relaxed);
+    profile.lastDecay = lastDecay.load(std::memory_order_relaxed);
+    profile.version = version.load(std::memory_order_relaxed);
+    return profile;
+  }
+
+  void
+  Profiling::Entry::Set(const RouterProfile& profile)
+  {
+    connectTimeoutCount = profile.connectTimeoutCount;
+    connectGoodCount = profile.connectGoodCount;
+    pathSuccessCount = profile.pathSuccessCount;
+    pathFailCount = profile.pathFailCount;
+    pathTimeoutCount = profile.pathTimeoutCount;
+    lastUpdated = profile.lastUpdated;
+    lastDecay = profile.lastDecay;
+    version = profile.version;
+  }
+
+  void
+  Profiling::Entry::Decay(llarp_time_t now)
+  {
+    Halve(connectGoodCount);
+    Halve(connectTimeoutCount);
+    Halve(pathSuccessCount);
+    Halve(pathFailCount);
+    Halve(pathTimeoutCount);
+    lastDecay = now;
+    dirty = true;
+  }
+
+  void
+  Profiling::Entry::Touch(llarp_time_t now)
+  {
+    lastUpdated.store(now, std::memory_order_relaxed);
+    if (not present.load(std::memory_order_relaxed))
+      present.store(true, std::memory_order_release);
+    if (not dirty.load(std::memory_order_relaxed))
+      dirty.store(true, std::memory_order_relaxed);
+  }
+
+  Profiling::Table::Table(size_t capacity)
+      : mask{capacity - 1}, slots{std::make_unique<std::atomic<Entry*>[]>(capacity)}
+  {
+    for (size_t idx = 0; idx < capacity; ++idx)
+      slots[idx].store(nullptr, std::memory_order_relaxed);
+  }
+
+  void
+  Profiling::Table::Place(Entry* entry, size_t hash)
+  {
+    size_t idx = (hash >> ShardBits) & mask;
+    while (slots[idx].load(std::memory_order_relaxed))
+      idx = (idx + 1) & mask;
+    slots[idx].store(entry, std::memory_order_release);
+    ++used;
+  }
+
+  Profiling::Shard::Shard() : current{std::make_unique<Table>(InitialShardCapacity)}
+  {
+    table.store(current.get(), std::memory_order_release);
+  }
+
   Profiling::Profiling() : m_DisableProfiling(false)
   {}
 
@@ -115,92 +352,261 @@ namespace llarp
     m_DisableProfiling.store(false);
   }
 
+  Profiling::Entry*
+  Profiling::Find(const RouterID& r) const
+  {
+    const auto hash = RouterID::Hash{}(r);
+    const Table* table = m_Shards[hash % NumShards].table.load(std::memory_order_seq_cst);
+    // tables are never more than half full so this always runs into an empty slot
+    for (size_t idx = (hash >> ShardBits) & table->mask;; idx = (idx + 1) & table->mask)
+    {
+      auto* entry = table->slots[idx].load(std::memory_order_acquire);
+      if (entry == nullptr or entry->router == r)
+        return entry;
+    }
+  }
+
+  Profiling::Entry&
+  Profiling::FindOrAdd(const RouterID& r)
+  {
+    if (auto* entry = Find(r))
+      return *entry;
+    const auto hash = RouterID::Hash{}(r);
+    auto& shard = m_Shards[hash % NumShards];
+    util::Lock lock{shard.mutex};
+    // someone may have added it while we waited for the lock
+    if (auto* entry = Find(r))
+      return *entry;
+    return Add(shard, std::make_unique<Entry>(r));
+  }
+
+  Profiling::Entry&
+  Profiling::Add(Shard& shard, std::unique_ptr<Entry> entry)
+  {
+    if ((shard.current->used + 1) * 2 > shard.current->mask + 1)
+    {
+      // readers still on the old table just miss routers added from now on
+      auto grown = std::make_unique<Table>((shard.current->mask + 1) * 2);
+      for (const auto& added : shard.entries)
+        grown->Place(added.get(), RouterID::Hash{}(added->router));
+      Replace(shard, std::move(grown), {});
+    }
+    auto& added = *shard.entries.emplace_back(std::move(entry));
+    shard.current->Place(&added, RouterID::Hash{}(added.router));
+    return added;
+  }
+
+  void
+  Profiling::Replace(
+      Shard& shard, std::unique_ptr<Table> table, std::vector<std::unique_ptr<Entry>> entries)
+  {
+    shard.table.store(table.get(), std::memory_order_seq_cst);
+    // a lookup that announces this epoch or a later one started after the store above
+    const auto epoch = readers().epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    shard.retired.push_back(
+        Retired{epoch, std::exchange(shard.current, std::move(table)), std::move(entries)});
+  }
+
+  void
+  Profiling::Reclaim()
+  {
+    for (auto& shard : m_Shards)
+    {
+      util::Lock lock{shard.mutex};
+      // anything marked from now on is present again and is put back below
+      auto keep = std::partition(shard.entries.begin(), shard.entries.end(), [](const auto& e) {
+        return e->present.load(std::memory_order_acquire) or e->dirty.load();
+      });
+      if (keep == shard.entries.end())
+        continue;
+      std::vector<std::unique_ptr<Entry>> cleared{
+          std::make_move_iterator(keep), std::make_move_iterator(shard.entries.end())};
+      shard.entries.erase(keep, shard.entries.end());
+      auto table = std::make_unique<Table>(CapacityFor(shard.entries.size()));
+      for (const auto& entry : shard.entries)
+        table->Place(entry.get(), RouterID::Hash{}(entry->router));
+      Replace(shard, std::move(table), std::move(cleared));
+    }
+
+    const auto oldest = readers().Oldest();
+    for (auto& shard : m_Shards)
+    {
+      util::Lock lock{shard.mutex};
+      auto itr = std::partition(shard.retired.begin(), shard.retired.end(), [oldest](auto& r) {
+        return r.epoch > oldest;
+      });
+      // putting an entry back can retire another table
+      std::vector<Retired> done{
+          std::make_move_iterator(itr), std::make_move_iterator(shard.retired.end())};
+      shard.retired.erase(itr, shard.retired.end());
+      for (auto& retired : done)
+      {
+        for (auto& entry : retired.entries)
+        {
+          // marked by someone who found it before it was unlinked
+          if (not entry->present.load(std::memory_order_acquire))
+            continue;
+          auto* other = Find(entry->router);
+          if (other == nullptr)
+          {
+            Add(shard, std::move(entry));
+            continue;
+          }
+          // and then added again by someone who didn't find it
+          other->connectTimeoutCount.fetch_add(entry->connectTimeoutCount.load());
+          other->connectGoodCount.fetch_add(entry->connectGoodCount.load());
+          other->pathSuccessCount.fetch_add(entry->pathSuccessCount.load());
+          other->pathFailCount.fetch_add(entry->pathFailCount.load());
+          other->pathTimeoutCount.fetch_add(entry->pathTimeoutCount.load());
+          other->Touch(entry->lastUpdated.load());
+        }
+      }
+    }
+  }
+
+  Profiling::Footprint
+  Profiling::Held() const
+  {
+    Footprint held;
+    for (const auto& shard : m_Shards)
+    {
+      util::Lock lock{shard.mutex};
+      held.entries += shard.entries.size();
+      held.tables += 1;
+      for (const auto& retired : shard.retired)
+      {
+        held.entries += retired.entries.size();
+        held.tables += retired.table != nullptr;
+      }
+    }
+    return held;
+  }
+
+  const Profiling::Entry*
+  Profiling::FindPresent(const RouterID& r) const
+  {
+    const auto* entry = Find(r);
+    if (entry == nullptr or not entry->present.load(std::memory_order_acquire))
+      return nullptr;
+    return entry;
+  }
+
   bool
-  Profiling::IsBadForConnect(const RouterID& r, uint64_t chances)
+  Profiling::IsBadForConnect(const RouterID& r, uint64_t chances) const
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGoodForConnect(chances);
+    ReadGuard guard;
+    const auto* entry = FindPresent(r);
+    return entry and not entry->Snapshot().IsGoodForConnect(chances);
   }
 
   bool
-  Profiling::IsBadForPath(const RouterID& r, uint64_t chances)
+  Profiling::IsBadForPath(const RouterID& r, uint64_t chances) const
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGoodForPath(chances);
+    ReadGuard guard;
+    const auto* entry = FindPresent(r);
+    return entry and not entry->Snapshot().IsGoodForPath(chances);
   }
 
   bool
-  Profiling::IsBad(const RouterID& r, uint64_t chances)
+  Profiling::IsBad(const RouterID& r, uint64_t chances) const
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGood(chances);
+    ReadGuard guard;
+    const auto* entry = FindPresent(r);
+    return entry and not entry->Snapshot().IsGood(chances);
+  }
+
+  std::optional<RouterProfile>
+  Profiling::GetProfile(const RouterID& r) const
+  {
+    ReadGuard guard;
+    if (const auto* entry = FindPresent(r))
+      return entry->Snapshot();
+    return std::nullopt;
+  }
+
+  size_t
+  Profiling::Size() const
+  {
+    ReadGuard guard;
+    size_t num = 0;
+    ForEachEntry([&num](const Entry& entry) { num += entry.present.load(); });
+    return num;
   }
 
   void
   Profiling::Tick()
   {
-    util::Lock lock(m_ProfilesMutex);
-    std::for_each(m_Profiles.begin(), m_Profiles.end(), [](auto& item) { item.second.Tick(); });
+    ReadGuard guard;
+    static constexpr auto updateInterval = 30min;
+    const auto now = llarp::time_now_ms();
+    ForEachEntry([now](Entry& entry) {
+      if (not entry.present.load(std::memory_order_acquire))
+        return;
+      const auto lastDecay = entry.lastDecay.load(std::memory_order_relaxed);
+      if (lastDecay < now && now - lastDecay > updateInterval)
+        entry.Decay(now);
+    });
   }
 
   void
   Profiling::MarkConnectTimeout(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles[r].connectTimeoutCount += 1;
-    m_Profiles[r].lastUpdated = llarp::time_now_ms();
+    ReadGuard guard;
+    auto& entry = FindOrAdd(r);
+    entry.connectTimeoutCount.fetch_add(1, std::memory_order_relaxed);
+    entry.Touch(llarp::time_now_ms());
   }
 
   void
   Profiling::MarkConnectSuccess(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles[r].connectGoodCount += 1;
-    m_Profiles[r].lastUpdated = llarp::time_now_ms();
+    ReadGuard guard;
+    auto& entry = FindOrAdd(r);
+    entry.connectGoodCount.fetch_add(1, std::memory_order_relaxed);
+    entry.Touch(llarp::time_now_ms());
   }
 
   void
   Profiling::ClearProfile(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles.erase(r);
+    ReadGuard guard;
+    if (auto* entry = Find(r))
+    {
+      entry->present.store(false, std::memory_order_release);
+      entry->Set(RouterProfile{});
+      entry->dirty = true;
+    }
   }
 
   void
   Profiling::MarkHopFail(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles[r].pathFailCount += 1;
-    m_Profiles[r].lastUpdated = llarp::time_now_ms();
+    ReadGuard guard;
+    auto& entry = FindOrAdd(r);
+    entry.pathFailCount.fetch_add(1, std::memory_order_relaxed);
+    entry.Touch(llarp::time_now_ms());
   }
 
   void
   Profiling::MarkPathFail(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
+    ReadGuard guard;
+    const auto now = llarp::time_now_ms();
     size_t idx = 0;
     for (const auto& hop : p->hops)
     {
       // don't mark first hop as failure because we are connected to it directly
       if (idx)
       {
-        m_Profiles[hop.rc.pubkey].pathFailCount += 1;
-        m_Profiles[hop.rc.pubkey].lastUpdated = llarp::time_now_ms();
+        auto& entry = FindOrAdd(hop.rc.pubkey);
+        entry.pathFailCount.fetch_add(1, std::memory_order_relaxed);
+        entry.Touch(now);
       }
       ++idx;
     }
@@ -209,14 +615,16 @@ namespace llarp
   void
   Profiling::MarkPathTimeout(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
+    ReadGuard guard;
+    const auto now = llarp::time_now_ms();
     size_t idx = 0;
     for (const auto& hop : p->hops)
     {
       if (idx)
       {
-        m_Profiles[hop.rc.pubkey].pathTimeoutCount += 1;
-        m_Profiles[hop.rc.pubkey].lastUpdated = llarp::time_now_ms();
+        auto& entry = FindOrAdd(hop.rc.pubkey);
+        entry.pathTimeoutCount.fetch_add(1, std::memory_order_relaxed);
+        entry.Touch(now);
       }
       ++idx;
     }
@@ -225,64 +633,120 @@ namespace llarp
   void
   Profiling::MarkPathSuccess(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
+    ReadGuard guard;
+    const auto now = llarp::time_now_ms();
     const auto sz = p->hops.size();
     for (const auto& hop : p->hops)
     {
+      auto& entry = FindOrAdd(hop.rc.pubkey);
       // redeem previous fails by halfing the fail count and setting timeout to zero
-      m_Profiles[hop.rc.pubkey].pathFailCount /= 2;
-      m_Profiles[hop.rc.pubkey].pathTimeoutCount = 0;
+      Halve(entry.pathFailCount);
+      entry.pathTimeoutCount.store(0, std::memory_order_relaxed);
       // mark success at hop
-      m_Profiles[hop.rc.pubkey].pathSuccessCount += sz;
-      m_Profiles[hop.rc.pubkey].lastUpdated = llarp::time_now_ms();
+      entry.pathSuccessCount.fetch_add(sz, std::memory_order_relaxed);
+      entry.Touch(now);
     }
   }
 
   bool
   Profiling::Save(const fs::path fpath)
   {
-    const size_t sz = (m_Profiles.size() * (RouterProfile::MaxSize + 32 + 8)) + 8;
-
-    std::vector<byte_t> tmp(sz, 0);
-    llarp_buffer_t buf(tmp);
+    // puts back what was marked after it was unlinked, so it is saved
+    Reclaim();
+    bool rewrite = m_SaveFailed or fpath != m_SaveFile;
+    // take the changed marks as we go so a change made while we write is not lost
+    std::vector<std::pair<RouterID, RouterProfile>> changed;
+    {
+      ReadGuard guard;
+      ForEachEntry([&changed, &rewrite](Entry& entry) {
+        if (not entry.dirty.exchange(false, std::memory_order_relaxed))
+          return;
+        if (entry.present.load(std::memory_order_acquire))
+          changed.emplace_back(entry.router, entry.Snapshot());
+        else
+          rewrite = true;
+      });
+    }
+    if (changed.empty() and not rewrite)
+    {
+      m_LastSave = llarp::time_now_ms();
+      return true;
+    }
+    m_SaveFailed = true;
 
+    std::vector<byte_t> data;
+    if (not rewrite)
+    {
+      std::sort(changed.begin(), changed.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      });
+      data = EncodeProfiles(changed);
+      if (data.empty())
+        return false;
+      rewrite = m_FileSize + data.size() > 2 * m_RewriteSize;
+    }
+    if (rewrite)
     {
-      util::Lock lock{m_ProfilesMutex};
-      if (not BEncode(&buf))
+      data = EncodeProfiles(SnapshotProfiles());
+      if (data.empty())
         return false;
     }
 
-    buf.sz = buf.cur - buf.base;
-    auto optional_f = util::OpenFileStream<std::ofstream>(fpath, std::ios::binary);
-    if (!optional_f)
-      return false;
-    auto& f = *optional_f;
-    if (not f.is_open())
-      return false;
+    auto mode = std::ios::binary;
+    if (not rewrite)
+      mode |= std::ios::app;
+    {
+      auto optional_f = util::OpenFileStream<std::ofstream>(fpath, mode);
+      if (!optional_f)
+        return false;
+      auto& f = *optional_f;
+      if (not f.is_open())
+        return false;
 
-    f.write(reinterpret_cast<const char*>(buf.base), buf.sz);
-    if (not f.good())
-      return false;
+      f.write(reinterpret_cast<const char*>(data.data()), data.size());
+      f.flush();
+      if (not f.good())
+      {
+        if (not rewrite)
+        {
+          // don't leave half a dict where the next load would trip over it
+          std::error_code ec;
+          fs::resize_file(fpath, m_FileSize, ec);
+        }
+        return false;
+      }
+    }
+    m_SaveFile = fpath;
+    m_FileSize = rewrite ? data.size() : m_FileSize + data.size();
+    if (rewrite)
+      m_RewriteSize = data.size();
     m_LastSave = llarp::time_now_ms();
+    m_SaveFailed = false;
+    // unlinks what this save wrote out as cleared
+    Reclaim();
     return true;
   }
 
+  std::vector<std::pair<RouterID, RouterProfile>>
+  Profiling::SnapshotProfiles() const
+  {
+    ReadGuard guard;
+    std::vector<std::pair<RouterID, RouterProfile>> profiles;
+    ForEachEntry([&profiles](const Entry& entry) {
+      if (entry.present.load(std::memory_order_acquire))
+        profiles.emplace_back(entry.router, entry.Snapshot());
+    });
+    // bencoded dicts are sorted by key
+    std::sort(profiles.begin(), profiles.end(), [](const auto& a, const auto& b) {
+      return a.first < b.first;
+    });
+    return profiles;
+  }
+
   bool
   Profiling::BEncode(llarp_buffer_t* buf) const
   {
-    if (!bencode_start_dict(buf))
-      return false;
-
-    auto itr = m_Profiles.begin();
-    while (itr != m_Profiles.end())
-    {
-      if (!itr->first.BEncode(buf))
-        return false;
-      if (!itr->second.BEncode(buf))
-        return false;
-      ++itr;
-    }
-    return bencode_end(buf);
+    return BEncodeProfiles(SnapshotProfiles(), buf);
   }
 
   bool
@@ -294,7 +758,12 @@ namespace llarp
     if (!bencode_decode_dict(profile, buf))
       return false;
     RouterID pk = k.base;
-    return m_Profiles.emplace(pk, profile).second;
+    ReadGuard guard;
+    // a profile appended by a later save replaces the one before it
+    auto& entry = FindOrAdd(pk);
+    entry.Set(profile);
+    entry.present.store(true, std::memory_order_release);
+    return true;
   }
 
   bool
@@ -306,14 +775,45 @@ namespace llarp
   bool
   Profiling::Load(const fs::path fname)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles.clear();
-    if (!BDecodeReadFile(fname, *this))
+    {
+      ReadGuard guard;
+      ForEachEntry([](Entry& entry) {
+        entry.present.store(false, std::memory_order_release);
+        entry.Set(RouterProfile{});
+        entry.dirty = false;
+      });
+    }
+    std::vector<byte_t> data;
+    {
+      std::ifstream f{fname.string(), std::ios::binary};
+      if (f.is_open())
+        data.assign(std::istreambuf_iterator<char>{f}, std::istreambuf_iterator<char>{});
+    }
+    llarp_buffer_t buf{data};
+    if (not BDecode(&buf))
     {
       llarp::LogWarn("failed to load router profiles from ", fname);
+      Reclaim();
       return false;
     }
+    m_RewriteSize = buf.cur - buf.base;
+    // then whatever later saves appended, a crash in the middle of one leaves it torn at the end
+    m_FileSize = m_RewriteSize;
+    while (m_FileSize < data.size())
+    {
+      llarp_buffer_t changes{data.data() + m_FileSize, data.size() - m_FileSize};
+      if (not BDecode(&changes))
+      {
+        llarp::LogWarn(
+            "dropping ", data.size() - m_FileSize, " bytes of damaged profiles from ", fname);
+        m_SaveFailed = true;
+        break;
+      }
+      m_FileSize += changes.cur - changes.base;
+    }
+    m_SaveFile = fname;
     m_LastSave = llarp::time_now_ms();
+    Reclaim();
     return true;
   }
 
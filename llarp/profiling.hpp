@@ -6,7 +6,12 @@
 #include "util/thread/threading.hpp"
 
 #include "util/thread/annotations.hpp"
-#include <map>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace llarp
 {
@@ -46,46 +51,66 @@ namespace llarp
     Tick();
   };
 
+  /// what we know about how routers behave, kept per router and consulted when picking hops and
+  /// deciding who to connect to.
+  ///
+  /// routers are spread over shards by id.  each shard has an open addressed table of entries
+  /// whose counters are atomics, so checking a router and marking one we have seen before never
+  /// takes a lock; only the first mark of a router takes its shard's lock to add it.  outgrown
+  /// tables and the entries of cleared profiles are unlinked on save and load, and freed once no
+  /// lookup that started before they were unlinked is still running.
   struct Profiling
   {
+    static constexpr size_t NumShards = 16;
+
     Profiling();
 
     /// generic variant
     bool
-    IsBad(const RouterID& r, uint64_t chances = 8) EXCLUDES(m_ProfilesMutex);
+    IsBad(const RouterID& r, uint64_t chances = 8) const;
 
     /// check if this router should have paths built over it
     bool
-    IsBadForPath(const RouterID& r, uint64_t chances = 8) EXCLUDES(m_ProfilesMutex);
+    IsBadForPath(const RouterID& r, uint64_t chances = 8) const;
 
     /// check if this router should be connected directly to
     bool
-    IsBadForConnect(const RouterID& r, uint64_t chances = 8) EXCLUDES(m_ProfilesMutex);
+    IsBadForConnect(const RouterID& r, uint64_t chances = 8) const;
 
     void
-    MarkConnectTimeout(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkConnectTimeout(const RouterID& r);
 
     void
-    MarkConnectSuccess(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkConnectSuccess(const RouterID& r);
 
     void
-    MarkPathTimeout(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkPathTimeout(path::Path* p);
 
     void
-    MarkPathFail(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkPathFail(path::Path* p);
 
     void
-    MarkPathSuccess(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkPathSuccess(path::Path* p);
 
     void
-    MarkHopFail(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkHopFail(const RouterID& r);
 
     void
-    ClearProfile(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    ClearProfile(const RouterID& r);
 
     void
-    Tick() EXCLUDES(m_ProfilesMutex);
+    Tick();
+
+    /// the profile of a router, if we have one
+    std::optional<RouterProfile>
+    GetProfile(const RouterID& r) const;
 
+    /// number of routers we have a profile for
+    size_t
+    Size() const;
+
+    /// bencode a snapshot of every profile; readers and markers are not held up while it is
+    /// taken
     bool
     BEncode(llarp_buffer_t* buf) const;
 
@@ -93,14 +118,18 @@ namespace llarp
     BDecode(llarp_buffer_t* buf);
 
     bool
-    DecodeKey(const llarp_buffer_t& k, llarp_buffer_t* buf) NO_THREAD_SAFETY_ANALYSIS;
-    // disabled because we do load -> bencode::BDecodeReadFromFile -> DecodeKey
+    DecodeKey(const llarp_buffer_t& k, llarp_buffer_t* buf);
 
     bool
-    Load(const fs::path fname) EXCLUDES(m_ProfilesMutex);
+    Load(const fs::path fname);
 
+    /// write our profiles to fname.  only the profiles that changed since the last save are
+    /// appended to the file we last saved to or loaded from; the whole file is rewritten when it
+    /// is a different one, a profile was cleared, the last save failed or the appended changes
+    /// have grown it to twice the size of its last rewrite.  frees what lookups can no longer
+    /// be using afterwards.
     bool
-    Save(const fs::path fname) EXCLUDES(m_ProfilesMutex);
+    Save(const fs::path fname);
 
     bool
     ShouldSave(llarp_time_t now) const;
@@ -111,10 +140,138 @@ namespace llarp
     void
     Enable();
 
+    /// what we hold memory for, including what was unlinked and is not freed yet
+    struct Footprint
+    {
+      size_t entries = 0;
+      size_t tables = 0;
+    };
+
+    Footprint
+    Held() const;
+
    private:
-    mutable util::Mutex m_ProfilesMutex;  // protects m_Profiles
-    std::map<RouterID, RouterProfile> m_Profiles GUARDED_BY(m_ProfilesMutex);
+    /// the profile of one router
+    struct Entry
+    {
+      explicit Entry(const RouterID& r) : router{r}
+      {}
+
+      const RouterID router;
+      /// false until marked and after ClearProfile; the entry stays until it is saved as cleared
+      std::atomic<bool> present{false};
+      /// changed since the last save
+      std::atomic<bool> dirty{false};
+      std::atomic<uint64_t> connectTimeoutCount{0};
+      std::atomic<uint64_t> connectGoodCount{0};
+      std::atomic<uint64_t> pathSuccessCount{0};
+      std::atomic<uint64_t> pathFailCount{0};
+      std::atomic<uint64_t> pathTimeoutCount{0};
+      std::atomic<llarp_time_t> lastUpdated{0s};
+      std::atomic<llarp_time_t> lastDecay{0s};
+      std::atomic<uint64_t> version{LLARP_PROTO_VERSION};
+
+      RouterProfile
+      Snapshot() const;
+
+      /// copy in the counters of profile, leaves present alone
+      void
+      Set(const RouterProfile& profile);
+
+      void
+      Decay(llarp_time_t now);
+
+      /// mark it present and changed at now
+      void
+      Touch(llarp_time_t now);
+    };
+
+    /// slots for the entries of one shard, at most half full
+    struct Table
+    {
+      explicit Table(size_t capacity);
+
+      const size_t mask;
+      std::unique_ptr<std::atomic<Entry*>[]> slots;
+      size_t used = 0;
+
+      void
+      Place(Entry* entry, size_t hash);
+    };
+
+    /// a table and entries that were unlinked at a reclaim epoch
+    struct Retired
+    {
+      uint64_t epoch;
+      std::unique_ptr<Table> table;
+      std::vector<std::unique_ptr<Entry>> entries;
+    };
+
+    struct Shard
+    {
+      Shard();
+
+      mutable util::Mutex mutex;  // protects adding entries, growing the table and reclaiming
+      std::atomic<Table*> table;
+      std::unique_ptr<Table> current GUARDED_BY(mutex);
+      std::vector<std::unique_ptr<Entry>> entries GUARDED_BY(mutex);
+      /// freed once no lookup that could have found them is running
+      std::vector<Retired> retired GUARDED_BY(mutex);
+    };
+
+    /// every profile we hold, sorted by router
+    std::vector<std::pair<RouterID, RouterProfile>>
+    SnapshotProfiles() const;
+
+    /// callers hold a ReadGuard for as long as they use the entry, see profiling.cpp
+    Entry*
+    Find(const RouterID& r) const;
+
+    Entry&
+    FindOrAdd(const RouterID& r);
+
+    /// put entry in shard's table, growing it if it has to
+    Entry&
+    Add(Shard& shard, std::unique_ptr<Entry> entry) REQUIRES(shard.mutex);
+
+    /// publish table as shard's table and retire the one it replaces along with entries
+    void
+    Replace(Shard& shard, std::unique_ptr<Table> table, std::vector<std::unique_ptr<Entry>> entries)
+        REQUIRES(shard.mutex);
+
+    /// unlink the entries of profiles that are cleared and saved as such, then free what was
+    /// retired before every running lookup started
+    void
+    Reclaim();
+
+    /// the entry of r if it holds a profile
+    const Entry*
+    FindPresent(const RouterID& r) const;
+
+    template <typename Visit>
+    void
+    ForEachEntry(Visit&& visit) const
+    {
+      for (const auto& shard : m_Shards)
+      {
+        const Table* table = shard.table.load(std::memory_order_seq_cst);
+        for (size_t idx = 0; idx <= table->mask; ++idx)
+        {
+          if (auto* entry = table->slots[idx].load(std::memory_order_acquire))
+            visit(*entry);
+        }
+      }
+    }
+
+    std::array<Shard, NumShards> m_Shards;
     llarp_time_t m_LastSave = 0s;
+    /// the last save failed so the next one rewrites the file whether or not anything changed
+    bool m_SaveFailed = false;
+    /// the file the last save or load used; changes are only appended to it
+    fs::path m_SaveFile;
+    /// how long m_SaveFile is and how long its last rewrite left it
+    size_t m_FileSize = 0;
+    size_t m_RewriteSize = 0;
     std::atomic<bool> m_DisableProfiling;
   };
 
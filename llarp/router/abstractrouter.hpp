@@ -41,6 +41,7 @@ namespace llarp
   struct ILinkManager;
   struct I_RCLookupHandler;
   struct RoutePoker;
+  class EphemeralKeyPool;
 
   namespace exit
   {
@@ -87,8 +88,10 @@ namespace llarp
 
     virtual ~AbstractRouter() = default;
 
+    /// handle a whole link message from a session, takes ownership of the message so relayed
+    /// traffic can be sent on in the same buffer
     virtual bool
-    HandleRecvLinkMessageBuffer(ILinkSession* from, const llarp_buffer_t& msg) = 0;
+    HandleRecvLinkMessageBuffer(ILinkSession* from, std::vector<byte_t> msg) = 0;
 
     virtual const LMQ_ptr&
     lmq() const = 0;
@@ -126,6 +129,10 @@ namespace llarp
     virtual const SecretKey&
     encryption() const = 0;
 
+    /// pre-made ephemeral keys for path builds
+    virtual const std::shared_ptr<EphemeralKeyPool>&
+    ephemeralKeys() const = 0;
+
     virtual Profiling&
     routerProfiling() = 0;
 
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace llarp
 {
@@ -26,6 +27,7 @@ namespace llarp
   static const size_t MAX_PATH_QUEUE_SIZE = 100;
   static const size_t MAX_OUTBOUND_QUEUE_SIZE = 1000;
   static const size_t MAX_OUTBOUND_MESSAGES_PER_TICK = 500;
+  static const size_t MAX_OUTBOUND_BYTES_PER_TICK = 512 * 1024;
 
   struct IOutboundMessageHandler
   {
@@ -34,6 +36,15 @@ namespace llarp
     virtual bool
     QueueMessage(const RouterID& remote, const ILinkMessage* msg, SendStatusHandler callback) = 0;
 
+    /// queue a link message that is already encoded, as QueueMessage does once it has encoded msg
+    virtual bool
+    QueueEncodedMessage(
+        const RouterID& remote,
+        std::vector<uint8_t> encoded,
+        const PathID_t& pathid,
+        uint16_t priority,
+        SendStatusHandler callback) = 0;
+
     virtual void
     Tick() = 0;
 
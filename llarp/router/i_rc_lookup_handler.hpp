@@ -3,6 +3,7 @@
 #include <llarp/util/types.hpp>
 #include <llarp/router_id.hpp>
 
+#include <functional>
 #include <memory>
 #include <set>
 #include <vector>
@@ -44,6 +45,13 @@ namespace llarp
     virtual bool
     CheckRC(const RouterContact& rc) const = 0;
 
+    /// CheckRC for many rcs at once with the signatures checked in parallel on the worker
+    /// threads. handler, if set, is called on the event loop with the rcs that passed.
+    virtual void
+    CheckRCs(
+        std::vector<RouterContact> rcs,
+        std::function<void(std::vector<RouterContact>)> handler = nullptr) const = 0;
+
     virtual bool
     GetRandomWhitelistRouter(RouterID& router) const = 0;
 
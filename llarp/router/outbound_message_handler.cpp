@@ -13,23 +13,14 @@
 
 namespace llarp
 {
-  const PathID_t OutboundMessageHandler::zeroID;
-
   OutboundMessageHandler::OutboundMessageHandler(size_t maxQueueSize)
-      : outboundQueue(maxQueueSize), removedPaths(20), removedSomePaths(false)
+      : outboundQueue(maxQueueSize), removedPaths(20)
   {}
 
   bool
   OutboundMessageHandler::QueueMessage(
       const RouterID& remote, const ILinkMessage* msg, SendStatusHandler callback)
   {
-    if (not _linkManager->SessionIsClient(remote) and not _lookupHandler->RemoteIsAllowed(remote))
-    {
-      DoCallback(callback, SendStatus::InvalidRouter);
-      return true;
-    }
-
-    const uint16_t priority = msg->Priority();
     std::array<byte_t, MAX_LINK_MSG_SIZE> linkmsg_buffer;
     llarp_buffer_t buf(linkmsg_buffer);
 
@@ -38,15 +29,33 @@ namespace llarp
       return false;
     }
 
-    Message message;
-    message.first.resize(buf.sz);
-    message.second = callback;
+    return QueueEncodedMessage(
+        remote,
+        std::vector<byte_t>(buf.base, buf.base + buf.sz),
+        msg->pathid,
+        msg->Priority(),
+        std::move(callback));
+  }
+
+  bool
+  OutboundMessageHandler::QueueEncodedMessage(
+      const RouterID& remote,
+      std::vector<byte_t> encoded,
+      const PathID_t& pathid,
+      uint16_t priority,
+      SendStatusHandler callback)
+  {
+    if (not _linkManager->SessionIsClient(remote) and not _lookupHandler->RemoteIsAllowed(remote))
+    {
+      DoCallback(callback, SendStatus::InvalidRouter);
+      return true;
+    }
 
-    std::copy_n(buf.base, buf.sz, message.first.data());
+    Message message{std::move(encoded), std::move(callback)};
 
     if (_linkManager->HasSessionTo(remote))
     {
-      QueueOutboundMessage(remote, std::move(message), msg->pathid, priority);
+      QueueOutboundMessage(remote, std::move(message), pathid, priority);
       return true;
     }
 
@@ -59,8 +68,9 @@ namespace llarp
 
       MessageQueueEntry entry;
       entry.priority = priority;
-      entry.message = message;
+      entry.message = std::move(message);
       entry.router = remote;
+      entry.queued = _loop->time_now();
       itr_pair.first->second.push(std::move(entry));
 
       shouldCreateSession = itr_pair.second;
@@ -80,7 +90,7 @@ namespace llarp
     m_Killer.TryAccess([self = this]() {
       self->ProcessOutboundQueue();
       self->RemoveEmptyPathQueues();
-      self->SendRoundRobin();
+      self->SendScheduled();
     });
   }
 
@@ -96,18 +106,18 @@ namespace llarp
     });
   }
 
-  // TODO: this
   util::StatusObject
   OutboundMessageHandler::ExtractStatus() const
   {
     util::StatusObject status{
-        "queueStats",
-        {{"queued", m_queueStats.queued},
-         {"dropped", m_queueStats.dropped},
-         {"sent", m_queueStats.sent},
-         {"queueWatermark", m_queueStats.queueWatermark},
-         {"perTickMax", m_queueStats.perTickMax},
-         {"numTicks", m_queueStats.numTicks}}};
+        {"queueStats",
+         {{"queued", m_queueStats.queued},
+          {"dropped", m_queueStats.dropped},
+          {"sent", m_queueStats.sent},
+          {"queueWatermark", m_queueStats.queueWatermark},
+          {"perTickMax", m_queueStats.perTickMax},
+          {"numTicks", m_queueStats.numTicks}}},
+        {"classes", scheduler.ExtractStatus()}};
 
     return status;
   }
@@ -119,8 +129,6 @@ namespace llarp
     _linkManager = linkManager;
     _lookupHandler = lookupHandler;
     _loop = std::move(loop);
-
-    outboundMessageQueues.emplace(zeroID, MessageQueue());
   }
 
   void
@@ -210,29 +218,24 @@ namespace llarp
   }
 
   bool
-  OutboundMessageHandler::Send(const RouterID& remote, const Message& msg)
+  OutboundMessageHandler::Send(const RouterID& remote, Message msg)
   {
-    const llarp_buffer_t buf(msg.first);
-    auto callback = msg.second;
     m_queueStats.sent++;
-    return _linkManager->SendTo(remote, buf, [=](ILinkSession::DeliveryStatus status) {
-      if (status == ILinkSession::DeliveryStatus::eDeliverySuccess)
-        DoCallback(callback, SendStatus::Success);
-      else
-      {
-        DoCallback(callback, SendStatus::Congestion);
-      }
-    });
-  }
-
-  bool
-  OutboundMessageHandler::SendIfSession(const RouterID& remote, const Message& msg)
-  {
-    if (_linkManager->HasSessionTo(remote))
+    // most messages are relayed traffic with nobody waiting on them; those go down to the
+    // session with no completion handler at all instead of one wrapping an empty callback
+    ILinkSession::CompletionHandler completed;
+    if (msg.second)
     {
-      return Send(remote, msg);
+      completed = [this, callback = std::move(msg.second)](ILinkSession::DeliveryStatus status) {
+        if (status == ILinkSession::DeliveryStatus::eDeliverySuccess)
+          DoCallback(callback, SendStatus::Success);
+        else
+        {
+          DoCallback(callback, SendStatus::Congestion);
+        }
+      };
     }
-    return false;
+    return _linkManager->SendTo(remote, std::move(msg.first), std::move(completed));
   }
 
   bool
@@ -245,6 +248,7 @@ namespace llarp
     entry.router = remote;
     entry.pathid = pathid;
     entry.priority = priority;
+    entry.queued = _loop->time_now();
     if (outboundQueue.tryPushBack(std::move(entry)) != llarp::thread::QueueReturn::Success)
     {
       m_queueStats.dropped++;
@@ -273,20 +277,8 @@ namespace llarp
       // TODO: can we add util::thread::Queue::front() for move semantics here?
       MessageQueueEntry entry = outboundQueue.popFront();
 
-      auto itr_pair = outboundMessageQueues.emplace(entry.pathid, MessageQueue());
-
-      if (itr_pair.second && !entry.pathid.IsZero())
-      {
-        roundRobinOrder.push(entry.pathid);
-      }
-
-      MessageQueue& path_queue = itr_pair.first->second;
-
-      if (path_queue.size() < MAX_PATH_QUEUE_SIZE || entry.pathid.IsZero())
-      {
-        path_queue.push(std::move(entry));
-      }
-      else
+      // a refused entry is not moved from
+      if (not scheduler.Push(std::move(entry)))
       {
         LogWarn(
             "ProcessOutboundQueue outbound message handler dropped message on "
@@ -301,88 +293,26 @@ namespace llarp
   void
   OutboundMessageHandler::RemoveEmptyPathQueues()
   {
-    removedSomePaths = false;
-    if (removedPaths.empty())
-      return;
-
     while (not removedPaths.empty())
-    {
-      auto itr = outboundMessageQueues.find(removedPaths.popFront());
-      if (itr != outboundMessageQueues.end())
-      {
-        outboundMessageQueues.erase(itr);
-      }
-    }
-    removedSomePaths = true;
+      scheduler.RemovePath(removedPaths.popFront());
   }
 
   void
-  OutboundMessageHandler::SendRoundRobin()
+  OutboundMessageHandler::SendScheduled()
   {
     m_queueStats.numTicks++;
 
-    // send non-routing messages first priority
-    auto& non_routing_mq = outboundMessageQueues[zeroID];
-    while (not non_routing_mq.empty())
-    {
-      const MessageQueueEntry& entry = non_routing_mq.top();
-      Send(entry.router, entry.message);
-      non_routing_mq.pop();
-    }
-
-    size_t empty_count = 0;
-    size_t num_queues = roundRobinOrder.size();
-
-    if (removedSomePaths)
-    {
-      for (size_t i = 0; i < num_queues; i++)
-      {
-        PathID_t pathid = std::move(roundRobinOrder.front());
-        roundRobinOrder.pop();
-
-        if (outboundMessageQueues.find(pathid) != outboundMessageQueues.end())
-        {
-          roundRobinOrder.push(std::move(pathid));
-        }
-      }
-    }
-
-    num_queues = roundRobinOrder.size();
-    size_t sent_count = 0;
-    if (num_queues == 0)  // if no queues, return
-    {
-      return;
-    }
-
-    while (sent_count < MAX_OUTBOUND_MESSAGES_PER_TICK)  // TODO: better stop condition
-    {
-      PathID_t pathid = std::move(roundRobinOrder.front());
-      roundRobinOrder.pop();
-
-      auto& message_queue = outboundMessageQueues[pathid];
-      if (message_queue.size() > 0)
-      {
-        const MessageQueueEntry& entry = message_queue.top();
-
-        Send(entry.router, entry.message);
-        message_queue.pop();
-
-        empty_count = 0;
-        sent_count++;
-      }
-      else
-      {
-        empty_count++;
-      }
-
-      roundRobinOrder.push(std::move(pathid));
-
-      // if num_queues empty queues in a row, all queues empty.
-      if (empty_count == num_queues)
-      {
-        break;
-      }
-    }
+    const auto sent_count = scheduler.Schedule(
+        _loop->time_now(),
+        MAX_OUTBOUND_MESSAGES_PER_TICK,
+        MAX_OUTBOUND_BYTES_PER_TICK,
+        [this](MessageQueueEntry entry) { Send(entry.router, std::move(entry.message)); },
+        [this](MessageQueueEntry entry) {
+          // sat in a standing queue for too long, the sender should back off
+          LogDebug("outbound message on pathid=", entry.pathid, " waited too long, dropping");
+          DoCallback(std::move(entry.message.second), SendStatus::Congestion);
+          m_queueStats.dropped++;
+        });
 
     m_queueStats.perTickMax = std::max((uint32_t)sent_count, m_queueStats.perTickMax);
   }
@@ -407,17 +337,16 @@ namespace llarp
 
     while (!movedMessages.empty())
     {
-      const MessageQueueEntry& entry = movedMessages.top();
+      auto entry = PopTop(movedMessages);
 
       if (status == SendStatus::Success)
       {
-        Send(entry.router, entry.message);
+        Send(entry.router, std::move(entry.message));
       }
       else
       {
         DoCallback(entry.message.second, status);
       }
-      movedMessages.pop();
     }
   }
 
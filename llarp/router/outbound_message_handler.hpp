@@ -1,16 +1,14 @@
 #pragma once
 
 #include "i_outbound_message_handler.hpp"
+#include "outbound_scheduler.hpp"
 
 #include <llarp/ev/ev.hpp>
 #include <llarp/util/thread/queue.hpp>
 #include <llarp/path/path_types.hpp>
 #include <llarp/router_id.hpp>
 
-#include <list>
 #include <unordered_map>
-#include <utility>
-#include <queue>
 
 struct llarp_buffer_t;
 
@@ -31,6 +29,14 @@ namespace llarp
     QueueMessage(const RouterID& remote, const ILinkMessage* msg, SendStatusHandler callback)
         override EXCLUDES(_mutex);
 
+    bool
+    QueueEncodedMessage(
+        const RouterID& remote,
+        std::vector<uint8_t> encoded,
+        const PathID_t& pathid,
+        uint16_t priority,
+        SendStatusHandler callback) override EXCLUDES(_mutex);
+
     void
     Tick() override;
 
@@ -44,21 +50,8 @@ namespace llarp
     Init(ILinkManager* linkManager, I_RCLookupHandler* lookupHandler, EventLoop_ptr loop);
 
    private:
-    using Message = std::pair<std::vector<byte_t>, SendStatusHandler>;
-
-    struct MessageQueueEntry
-    {
-      uint16_t priority;
-      Message message;
-      PathID_t pathid;
-      RouterID router;
-
-      bool
-      operator<(const MessageQueueEntry& other) const
-      {
-        return other.priority < priority;
-      }
-    };
+    using Message = OutboundMessage;
+    using MessageQueueEntry = OutboundQueueEntry;
 
     struct MessageQueueStats
     {
@@ -71,7 +64,7 @@ namespace llarp
       uint32_t numTicks = 0;
     };
 
-    using MessageQueue = std::priority_queue<MessageQueueEntry>;
+    using MessageQueue = OutboundMessageQueue;
 
     void
     OnSessionEstablished(const RouterID& router);
@@ -101,10 +94,7 @@ namespace llarp
     EncodeBuffer(const ILinkMessage* msg, llarp_buffer_t& buf);
 
     bool
-    Send(const RouterID& remote, const Message& msg);
-
-    bool
-    SendIfSession(const RouterID& remote, const Message& msg);
+    Send(const RouterID& remote, Message msg);
 
     bool
     QueueOutboundMessage(
@@ -117,23 +107,20 @@ namespace llarp
     RemoveEmptyPathQueues();
 
     void
-    SendRoundRobin();
+    SendScheduled();
 
     void
     FinalizeSessionRequest(const RouterID& router, SendStatus status) EXCLUDES(_mutex);
 
     llarp::thread::Queue<MessageQueueEntry> outboundQueue;
     llarp::thread::Queue<PathID_t> removedPaths;
-    bool removedSomePaths;
 
     mutable util::Mutex _mutex;  // protects pendingSessionMessageQueues
 
     std::unordered_map<RouterID, MessageQueue, RouterID::Hash> pendingSessionMessageQueues
         GUARDED_BY(_mutex);
 
-    std::unordered_map<PathID_t, MessageQueue, PathID_t::Hash> outboundMessageQueues;
-
-    std::queue<PathID_t> roundRobinOrder;
+    OutboundScheduler scheduler;
 
     ILinkManager* _linkManager;
     I_RCLookupHandler* _lookupHandler;
@@ -141,10 +128,6 @@ namespace llarp
 
     util::ContentionKiller m_Killer;
 
-    // paths cannot have pathid "0", so it can be used as the "pathid"
-    // for non-traffic (control) messages, so they can be prioritized.
-    static const PathID_t zeroID;
-
     MessageQueueStats m_queueStats;
   };
 
@@ -0,0 +1,320 @@
+#include "outbound_scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace llarp
+{
+  namespace
+  {
+    /// when to drop next once count messages have been dropped in a row: sooner the longer the
+    /// queue stays standing
+    llarp_time_t
+    ControlLaw(llarp_time_t t, uint32_t count)
+    {
+      return t
+          + std::chrono::duration_cast<llarp_time_t>(
+                 OutboundScheduler::CoDelInterval / std::sqrt(static_cast<double>(count)));
+    }
+  }  // namespace
+
+  OutboundQueueEntry
+  PopTop(OutboundMessageQueue& queue)
+  {
+    // priority_queue only gives out a const top, but it is popped right away and popping only
+    // looks at the priority which a move leaves alone
+    auto entry = std::move(const_cast<OutboundQueueEntry&>(queue.top()));
+    queue.pop();
+    return entry;
+  }
+
+  OutboundScheduler::Class
+  OutboundScheduler::ClassOf(const OutboundQueueEntry& entry)
+  {
+    // only relayed path traffic goes out at priority 0 on a path
+    if (entry.priority == 0 and not entry.pathid.IsZero())
+      return Class::Data;
+    return Class::Control;
+  }
+
+  bool
+  OutboundScheduler::Push(OutboundQueueEntry&& entry)
+  {
+    if (ClassOf(entry) == Class::Control)
+    {
+      m_ControlStats.Added(entry);
+      m_Control.push(std::move(entry));
+      return true;
+    }
+
+    auto [itr, inserted] = m_Flows.try_emplace(entry.pathid);
+    auto& flow = itr->second;
+    if (inserted)
+    {
+      flow.router = entry.router;
+      auto [ritr, newRouter] = m_Routers.try_emplace(entry.router);
+      if (newRouter)
+        m_ActiveRouters.push_back(entry.router);
+      ritr->second.active.push_back(entry.pathid);
+    }
+    else if (flow.messages.size() >= MAX_PATH_QUEUE_SIZE)
+    {
+      m_DataStats.overflowed++;
+      return false;
+    }
+    m_DataStats.Added(entry);
+    flow.bytes += entry.message.first.size();
+    flow.messages.push_back(std::move(entry));
+    return true;
+  }
+
+  size_t
+  OutboundScheduler::Schedule(
+      llarp_time_t now,
+      size_t maxMessages,
+      size_t maxBytes,
+      const Visitor& send,
+      const Visitor& drop)
+  {
+    size_t sent = 0;
+    size_t sentBytes = 0;
+    while (not m_Control.empty())
+    {
+      auto entry = PopTop(m_Control);
+      m_ControlStats.Removed(entry);
+      m_ControlStats.Sent(entry, now);
+      sent++;
+      sentBytes += entry.message.first.size();
+      send(std::move(entry));
+    }
+
+    Budget budget{
+        maxMessages > sent ? maxMessages - sent : 0,
+        maxBytes > sentBytes ? maxBytes - sentBytes : 0};
+    while (not budget.Exhausted() and not m_ActiveRouters.empty())
+    {
+      const auto routerID = m_ActiveRouters.front();
+      auto& router = m_Routers[routerID];
+      if (not router.inTurn)
+      {
+        router.deficit += Quantum;
+        router.inTurn = true;
+      }
+      const auto left = budget.messages;
+      if (ServeRouter(router, budget, now, send, drop) == TurnEnd::OutOfBudget)
+      {
+        // carry on where we left off next tick
+        sent += left - budget.messages;
+        break;
+      }
+      sent += left - budget.messages;
+      router.inTurn = false;
+      m_ActiveRouters.pop_front();
+      if (router.active.empty())
+        m_Routers.erase(routerID);
+      else
+        m_ActiveRouters.push_back(routerID);
+    }
+    return sent;
+  }
+
+  OutboundScheduler::TurnEnd
+  OutboundScheduler::ServeRouter(
+      RouterFlows& router,
+      Budget& budget,
+      llarp_time_t now,
+      const Visitor& send,
+      const Visitor& drop)
+  {
+    while (not router.active.empty())
+    {
+      const auto pathid = router.active.front();
+      auto& flow = m_Flows[pathid];
+      if (not flow.inTurn)
+      {
+        flow.deficit += Quantum;
+        flow.inTurn = true;
+      }
+
+      while (not flow.messages.empty())
+      {
+        if (ShouldDrop(flow, now))
+        {
+          auto entry = PopFront(flow);
+          m_DataStats.expired++;
+          drop(std::move(entry));
+          continue;
+        }
+        const auto size = flow.messages.front().message.first.size();
+        if (size > flow.deficit)
+          break;
+        if (size > router.deficit)
+          return TurnEnd::Done;
+        if (budget.Exhausted())
+          return TurnEnd::OutOfBudget;
+
+        auto entry = PopFront(flow);
+        flow.deficit -= size;
+        router.deficit -= size;
+        budget.messages--;
+        budget.bytes -= std::min(budget.bytes, size);
+        m_DataStats.Sent(entry, now);
+        send(std::move(entry));
+      }
+
+      router.active.pop_front();
+      if (flow.messages.empty())
+      {
+        // an idle flow keeps no credit
+        m_Flows.erase(pathid);
+      }
+      else
+      {
+        flow.inTurn = false;
+        router.active.push_back(pathid);
+      }
+    }
+    router.deficit = 0;
+    return TurnEnd::Done;
+  }
+
+  bool
+  OutboundScheduler::ShouldDrop(Flow& flow, llarp_time_t now)
+  {
+    const auto sojourn = now - flow.messages.front().queued;
+    bool okToDrop = false;
+    if (sojourn < CoDelTarget or flow.bytes <= MAX_LINK_MSG_SIZE)
+    {
+      // below target, or too little queued to be a standing queue
+      flow.firstAboveTime = 0s;
+    }
+    else if (flow.firstAboveTime == 0s)
+    {
+      flow.firstAboveTime = now + CoDelInterval;
+    }
+    else if (now >= flow.firstAboveTime)
+    {
+      okToDrop = true;
+    }
+
+    if (flow.dropping)
+    {
+      if (not okToDrop)
+      {
+        flow.dropping = false;
+        return false;
+      }
+      if (now < flow.dropNext)
+        return false;
+      flow.dropCount++;
+      flow.dropNext = ControlLaw(flow.dropNext, flow.dropCount);
+      return true;
+    }
+    if (not okToDrop)
+      return false;
+
+    flow.dropping = true;
+    // if we were dropping not long ago pick up near the rate that worked then
+    if (flow.dropCount > 2 and now - flow.dropNext < 16 * CoDelInterval)
+      flow.dropCount -= 2;
+    else
+      flow.dropCount = 1;
+    flow.dropNext = ControlLaw(now, flow.dropCount);
+    return true;
+  }
+
+  OutboundQueueEntry
+  OutboundScheduler::PopFront(Flow& flow)
+  {
+    auto entry = std::move(flow.messages.front());
+    flow.messages.pop_front();
+    flow.bytes -= entry.message.first.size();
+    m_DataStats.Removed(entry);
+    return entry;
+  }
+
+  void
+  OutboundScheduler::RemovePath(const PathID_t& pathid)
+  {
+    auto itr = m_Flows.find(pathid);
+    if (itr == m_Flows.end())
+      return;
+    for (const auto& entry : itr->second.messages)
+      m_DataStats.Removed(entry);
+
+    const auto routerID = itr->second.router;
+    m_Flows.erase(itr);
+    auto ritr = m_Routers.find(routerID);
+    if (ritr == m_Routers.end())
+      return;
+    auto& active = ritr->second.active;
+    active.erase(std::remove(active.begin(), active.end(), pathid), active.end());
+    if (active.empty())
+    {
+      m_Routers.erase(ritr);
+      m_ActiveRouters.erase(
+          std::remove(m_ActiveRouters.begin(), m_ActiveRouters.end(), routerID),
+          m_ActiveRouters.end());
+    }
+  }
+
+  size_t
+  OutboundScheduler::Depth(Class cls) const
+  {
+    return Stats(cls).depth;
+  }
+
+  const OutboundScheduler::ClassStats&
+  OutboundScheduler::Stats(Class cls) const
+  {
+    return cls == Class::Control ? m_ControlStats : m_DataStats;
+  }
+
+  util::StatusObject
+  OutboundScheduler::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"control", m_ControlStats.ExtractStatus()},
+        {"data", m_DataStats.ExtractStatus()},
+        {"routers", m_Routers.size()},
+        {"paths", m_Flows.size()}};
+  }
+
+  void
+  OutboundScheduler::ClassStats::Added(const OutboundQueueEntry& entry)
+  {
+    depth++;
+    bytes += entry.message.first.size();
+    queued++;
+  }
+
+  void
+  OutboundScheduler::ClassStats::Removed(const OutboundQueueEntry& entry)
+  {
+    depth--;
+    bytes -= entry.message.first.size();
+  }
+
+  void
+  OutboundScheduler::ClassStats::Sent(const OutboundQueueEntry& entry, llarp_time_t now)
+  {
+    sent++;
+    const auto sojourn = std::max(now - entry.queued, 0ms);
+    sojournAvg += (sojourn.count() - sojournAvg) / 16;
+    sojournMax = std::max(sojourn, sojournMax);
+  }
+
+  util::StatusObject
+  OutboundScheduler::ClassStats::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"depth", depth},
+        {"bytes", bytes},
+        {"queued", queued},
+        {"sent", sent},
+        {"overflowed", overflowed},
+        {"expired", expired},
+        {"sojournAvg", sojournAvg},
+        {"sojournMax", sojournMax.count()}};
+  }
+}  // namespace llarp
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "i_outbound_message_handler.hpp"
+
+#include <llarp/constants/link_layer.hpp>
+#include <llarp/path/path_types.hpp>
+#include <llarp/router_id.hpp>
+#include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
+
+#include <deque>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  using OutboundMessage = std::pair<std::vector<byte_t>, SendStatusHandler>;
+
+  struct OutboundQueueEntry
+  {
+    uint16_t priority = 0;
+    OutboundMessage message;
+    PathID_t pathid;
+    RouterID router;
+    /// when it was handed to the outbound message handler
+    llarp_time_t queued = 0s;
+
+    bool
+    operator<(const OutboundQueueEntry& other) const
+    {
+      return other.priority < priority;
+    }
+  };
+
+  using OutboundMessageQueue = std::priority_queue<OutboundQueueEntry>;
+
+  /// take the top entry off a queue, moving its message out instead of copying it
+  OutboundQueueEntry
+  PopTop(OutboundMessageQueue& queue);
+
+  /// the outbound messages waiting for a link session, split into control and data.
+  ///
+  /// control is everything not carrying path traffic (link intros, path builds, relay status,
+  /// direct dht) and is all sent before any data, in priority order.
+  ///
+  /// data is relayed path traffic, served by deficit round robin with byte quanta, first between
+  /// the routers it goes to and then between the paths to each router, so one busy path or one
+  /// busy neighbour gets no more than its share of a tick. each path queue drops messages that
+  /// have waited past their target for a while, CoDel style, so a standing queue on a path does
+  /// not turn into latency for everything behind it.
+  class OutboundScheduler
+  {
+   public:
+    enum class Class
+    {
+      Control,
+      Data
+    };
+
+    /// bytes a router and a path may send per round; at least one message of the largest size
+    static constexpr size_t Quantum = MAX_LINK_MSG_SIZE;
+    /// how long data may sit in a path queue before it counts as a standing queue
+    static constexpr auto CoDelTarget = 5ms;
+    /// how long a standing queue is tolerated before we start dropping from it
+    static constexpr auto CoDelInterval = 100ms;
+
+    using Visitor = std::function<void(OutboundQueueEntry)>;
+
+    static Class
+    ClassOf(const OutboundQueueEntry& entry);
+
+    /// queue a message to be sent; false and the entry left alone if its path queue is full
+    bool
+    Push(OutboundQueueEntry&& entry);
+
+    /// hand all queued control messages to send, then data messages until maxMessages or maxBytes
+    /// have been sent in total; data that waited too long is handed to drop instead. returns the
+    /// number of messages sent.
+    size_t
+    Schedule(
+        llarp_time_t now,
+        size_t maxMessages,
+        size_t maxBytes,
+        const Visitor& send,
+        const Visitor& drop);
+
+    /// forget everything queued on a path that is gone
+    void
+    RemovePath(const PathID_t& pathid);
+
+    /// number of queued messages in a class
+    size_t
+    Depth(Class cls) const;
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct ClassStats
+    {
+      size_t depth = 0;
+      size_t bytes = 0;
+      uint64_t queued = 0;
+      uint64_t sent = 0;
+      /// refused because their path queue was full
+      uint64_t overflowed = 0;
+      /// dropped for waiting too long
+      uint64_t expired = 0;
+      /// moving average and largest time between queueing and sending
+      double sojournAvg = 0;
+      llarp_time_t sojournMax = 0s;
+
+      void
+      Added(const OutboundQueueEntry& entry);
+
+      void
+      Removed(const OutboundQueueEntry& entry);
+
+      void
+      Sent(const OutboundQueueEntry& entry, llarp_time_t now);
+
+      util::StatusObject
+      ExtractStatus() const;
+    };
+
+    /// the data queued on one path, and its share of its router's rounds
+    struct Flow
+    {
+      RouterID router;
+      std::deque<OutboundQueueEntry> messages;
+      size_t bytes = 0;
+      size_t deficit = 0;
+      /// true while it is its turn and it has been given its quantum for the turn
+      bool inTurn = false;
+
+      // codel state
+      llarp_time_t firstAboveTime = 0s;
+      llarp_time_t dropNext = 0s;
+      uint32_t dropCount = 0;
+      bool dropping = false;
+    };
+
+    /// the paths with data queued to one router, served in turn
+    struct RouterFlows
+    {
+      std::deque<PathID_t> active;
+      size_t deficit = 0;
+      bool inTurn = false;
+    };
+
+    enum class TurnEnd
+    {
+      /// the router has sent all its deficit allows or has nothing left
+      Done,
+      /// the tick ran out of budget part way through its turn
+      OutOfBudget
+    };
+
+    struct Budget
+    {
+      size_t messages;
+      size_t bytes;
+
+      bool
+      Exhausted() const
+      {
+        return messages == 0 or bytes == 0;
+      }
+    };
+
+    TurnEnd
+    ServeRouter(
+        RouterFlows& router,
+        Budget& budget,
+        llarp_time_t now,
+        const Visitor& send,
+        const Visitor& drop);
+
+    /// true if the message at the head of the flow has been waiting long enough to drop
+    bool
+    ShouldDrop(Flow& flow, llarp_time_t now);
+
+    OutboundQueueEntry
+    PopFront(Flow& flow);
+
+    const ClassStats&
+    Stats(Class cls) const;
+
+    OutboundMessageQueue m_Control;
+    std::unordered_map<PathID_t, Flow, PathID_t::Hash> m_Flows;
+    std::unordered_map<RouterID, RouterFlows, RouterID::Hash> m_Routers;
+    std::deque<RouterID> m_ActiveRouters;
+
+    ClassStats m_ControlStats;
+    ClassStats m_DataStats;
+  };
+}  // namespace llarp
@@ -11,7 +11,9 @@
 #include <llarp/nodedb.hpp>
 #include <llarp/dht/context.hpp>
 #include "abstractrouter.hpp"
+#include "rc_verifier.hpp"
 
+#include <algorithm>
 #include <iterator>
 #include <functional>
 #include <random>
@@ -163,6 +165,53 @@ namespace llarp
     return true;
   }
 
+  void
+  RCLookupHandler::CheckRCs(
+      std::vector<RouterContact> rcs,
+      std::function<void(std::vector<RouterContact>)> handler) const
+  {
+    // the cheap checks first so we only spend time on signatures we would keep
+    rcs.erase(
+        std::remove_if(
+            rcs.begin(),
+            rcs.end(),
+            [this](const auto& rc) {
+              if (RemoteIsAllowed(rc.pubkey))
+                return false;
+              _dht->impl->DelRCNodeAsync(dht::Key_t{rc.pubkey});
+              return true;
+            }),
+        rcs.end());
+
+    VerifyRCsAsync(
+        std::move(rcs),
+        _dht->impl->Now(),
+        _work,
+        _loop,
+        [dht = _dht, n = _nodedb, handler = std::move(handler)](
+            std::vector<RouterContact> rcs, std::vector<bool> valid) {
+          std::vector<RouterContact> passed;
+          passed.reserve(rcs.size());
+          for (size_t idx = 0; idx < rcs.size(); ++idx)
+          {
+            auto& rc = rcs[idx];
+            if (not valid[idx])
+            {
+              LogWarn("RC for ", RouterID(rc.pubkey), " is invalid");
+              continue;
+            }
+            if (rc.IsPublicRouter())
+            {
+              n->PutIfNewer(rc);
+              dht->impl->PutRCNodeAsync(rc);
+            }
+            passed.emplace_back(std::move(rc));
+          }
+          if (handler)
+            handler(std::move(passed));
+        });
+  }
+
   size_t
   RCLookupHandler::NumberOfStrictConnectRouters() const
   {
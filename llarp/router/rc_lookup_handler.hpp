@@ -56,6 +56,11 @@ namespace llarp
     bool
     CheckRC(const RouterContact& rc) const override;
 
+    void
+    CheckRCs(
+        std::vector<RouterContact> rcs,
+        std::function<void(std::vector<RouterContact>)> handler = nullptr) const override;
+
     bool
     GetRandomWhitelistRouter(RouterID& router) const override EXCLUDES(_mutex);
 
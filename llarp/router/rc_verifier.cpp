@@ -0,0 +1,100 @@
+#include "rc_verifier.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace llarp
+{
+  namespace
+  {
+    /// rcs checked by one job; a few hundred microseconds of work
+    constexpr size_t ChunkSize = 8;
+
+    /// std::vector<bool> packs bits so threads cannot each write their own element of one
+    using Results_t = std::vector<char>;
+
+    void
+    VerifyChunk(
+        const std::vector<RouterContact>& rcs, Results_t& valid, size_t chunk, llarp_time_t now)
+    {
+      const auto end = std::min(rcs.size(), (chunk + 1) * ChunkSize);
+      for (size_t idx = chunk * ChunkSize; idx < end; ++idx)
+        valid[idx] = rcs[idx].Verify(now);
+    }
+
+    size_t
+    NumChunks(size_t numRCs)
+    {
+      return (numRCs + ChunkSize - 1) / ChunkSize;
+    }
+  }  // namespace
+
+  std::vector<bool>
+  VerifyRCs(const std::vector<RouterContact>& rcs, llarp_time_t now, size_t threads)
+  {
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto numChunks = NumChunks(rcs.size());
+    threads = std::min(threads, numChunks);
+
+    Results_t valid(rcs.size());
+    std::atomic<size_t> nextChunk{0};
+    const auto run = [&]() {
+      for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+        VerifyChunk(rcs, valid, chunk, now);
+    };
+    std::vector<std::thread> helpers;
+    for (size_t idx = 1; idx < threads; ++idx)
+      helpers.emplace_back(run);
+    run();
+    for (auto& helper : helpers)
+      helper.join();
+    return {valid.begin(), valid.end()};
+  }
+
+  void
+  VerifyRCsAsync(
+      std::vector<RouterContact> rcs,
+      llarp_time_t now,
+      const std::function<void(std::function<void(void)>)>& work,
+      EventLoop_ptr loop,
+      VerifiedRCsHandler done)
+  {
+    struct State
+    {
+      std::vector<RouterContact> rcs;
+      Results_t valid;
+      std::atomic<size_t> remaining;
+      EventLoop_ptr loop;
+      VerifiedRCsHandler done;
+    };
+    const auto numChunks = NumChunks(rcs.size());
+    if (numChunks == 0)
+    {
+      loop->call([done = std::move(done)]() { done({}, {}); });
+      return;
+    }
+    auto state = std::make_shared<State>();
+    state->valid.resize(rcs.size());
+    state->rcs = std::move(rcs);
+    state->remaining = numChunks;
+    state->loop = std::move(loop);
+    state->done = std::move(done);
+
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+      work([state, chunk, now]() {
+        VerifyChunk(state->rcs, state->valid, chunk, now);
+        if (--state->remaining > 0)
+          return;
+        // the last chunk in hands everything back
+        state->loop->call([state]() {
+          state->done(
+              std::move(state->rcs), std::vector<bool>{state->valid.begin(), state->valid.end()});
+        });
+      });
+    }
+  }
+}  // namespace llarp
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <llarp/ev/ev.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/util/time.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace llarp
+{
+  /// checking an rc is mostly its ed25519 signature, which is slow enough that a few thousand of
+  /// them at bootstrap or after a netsplit hold everything else up when done one at a time.
+  /// these spread the checks over several threads.
+
+  /// check every rc in rcs using the calling thread and up to threads - 1 more, 0 meaning one
+  /// thread per core. blocks until done and returns whether each rc passed, in the same order.
+  std::vector<bool>
+  VerifyRCs(const std::vector<RouterContact>& rcs, llarp_time_t now, size_t threads = 0);
+
+  using VerifiedRCsHandler =
+      std::function<void(std::vector<RouterContact> rcs, std::vector<bool> valid)>;
+
+  /// check rcs in chunks queued with work; once the last chunk is done, done is called on loop
+  /// with the rcs and whether each passed, in the order they were given
+  void
+  VerifyRCsAsync(
+      std::vector<RouterContact> rcs,
+      llarp_time_t now,
+      const std::function<void(std::function<void(void)>)>& work,
+      EventLoop_ptr loop,
+      VerifiedRCsHandler done);
+}  // namespace llarp
@@ -11,6 +11,7 @@
 #include <llarp/iwp/iwp.hpp>
 #include <llarp/link/server.hpp>
 #include <llarp/messages/link_message.hpp>
+#include <llarp/messages/relay.hpp>
 #include <llarp/net/net.hpp>
 #include <llarp/net/route.hpp>
 #include <stdexcept>
@@ -20,6 +21,7 @@
 #include <llarp/util/logging/logger_syslog.hpp>
 #include <llarp/util/logging/logger.hpp>
 #include <llarp/util/meta/memfn.hpp>
+#include <llarp/util/packet_pool.hpp>
 #include <llarp/util/str.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/tooling/peer_stats_event.hpp>
@@ -29,8 +31,10 @@
 
 #include <fstream>
 #include <cstdlib>
+#include <algorithm>
 #include <iterator>
 #include <unordered_map>
+#include <thread>
 #include <utility>
 #if defined(ANDROID) || defined(IOS)
 #include <unistd.h>
@@ -95,7 +99,11 @@ namespace llarp
           {"services", _hiddenServiceContext.ExtractStatus()},
           {"exit", _exitContext.ExtractStatus()},
           {"links", _linkManager.ExtractStatus()},
+          {"paths", paths.ExtractStatus()},
+          {"cryptoLanes", m_CryptoLanes->ExtractStatus()},
+          {"ephemeralKeys", m_EphemeralKeys->ExtractStatus()},
           {"outboundMessages", _outboundMessageHandler.ExtractStatus()},
+          {"packetPool", packet_pool::ExtractStatus()},
           {"peerStats", peerStatsObj}};
     }
     else
@@ -105,7 +113,7 @@ namespace llarp
   }
 
   bool
-  Router::HandleRecvLinkMessageBuffer(ILinkSession* session, const llarp_buffer_t& buf)
+  Router::HandleRecvLinkMessageBuffer(ILinkSession* session, std::vector<byte_t> msg)
   {
     if (_stopping)
       return true;
@@ -115,7 +123,11 @@ namespace llarp
       LogWarn("no link session");
       return false;
     }
-    return inbound_link_msg_parser.ProcessFrom(session, buf);
+    // relayed traffic goes straight to its hop without being decoded
+    RelayFrame frame{std::move(msg)};
+    if (frame.Parse())
+      return _pathContext.HandleRelayFrame(session->GetPubKey(), std::move(frame));
+    return inbound_link_msg_parser.ProcessFrom(session, llarp_buffer_t{frame.buf});
   }
 
   void
@@ -189,13 +201,14 @@ namespace llarp
     paths.PumpUpstream();
     _outboundMessageHandler.Tick();
     _linkManager.PumpLinks();
+    paths.PumpCommits();
     llarp::LogTrace("Router::PumpLL() end");
   }
 
   bool
   Router::SendToOrQueue(const RouterID& remote, const ILinkMessage* msg, SendStatusHandler handler)
   {
-    return _outboundMessageHandler.QueueMessage(remote, msg, handler);
+    return _outboundMessageHandler.QueueMessage(remote, msg, std::move(handler));
   }
 
   void
@@ -302,9 +315,18 @@ namespace llarp
     if (conf.router.m_workerThreads > 0)
       m_lmq->set_general_threads(conf.router.m_workerThreads);
 
+    m_CryptoLanes = std::make_shared<iwp::CryptoLanes>(conf.router.m_cryptoLanes);
+    m_EventLoops = conf.router.m_eventLoops > 0
+        ? static_cast<size_t>(conf.router.m_eventLoops)
+        : std::max<size_t>(1, std::thread::hardware_concurrency());
+    m_EphemeralKeys =
+        std::make_shared<EphemeralKeyPool>(util::memFn(&AbstractRouter::QueueWork, this));
+
     m_lmq->start();
+    m_EphemeralKeys->Refill();
 
     _nodedb = std::move(nodedb);
+    _nodedb->HopCandidates().SetUniqueNetmask(conf.paths.m_UniqueHopsNetmaskSize);
 
     m_isServiceNode = conf.router.m_isRelay;
 
@@ -455,6 +477,8 @@ namespace llarp
     _rc.SetNick(conf.router.m_nickname);
     _outboundSessionMaker.maxConnectedRouters = conf.router.m_maxConnectedRouters;
     _outboundSessionMaker.minConnectedRouters = conf.router.m_minConnectedRouters;
+    if (conf.router.m_maxPendingPathBuilds)
+      paths.SetMaxPendingCommits(conf.router.m_maxPendingPathBuilds);
 
     encryption_keyfile = m_keyManager->m_encKeyPath;
     our_rc_file = m_keyManager->m_rcPath;
@@ -612,12 +636,13 @@ namespace llarp
           util::memFn(&Router::ConnectionTimedOut, this),
           util::memFn(&AbstractRouter::SessionClosed, this),
           util::memFn(&AbstractRouter::PumpLL, this),
-          util::memFn(&AbstractRouter::QueueWork, this));
+          util::memFn(&AbstractRouter::QueueWork, this),
+          m_CryptoLanes);
 
       const std::string& key = serverConfig.interface;
       int af = serverConfig.addressFamily;
       uint16_t port = serverConfig.port;
-      if (!server->Configure(loop(), key, af, port))
+      if (!server->Configure(loop(), key, af, port, m_EventLoops))
       {
         throw std::runtime_error(stringify("failed to bind inbound link on ", key, " port ", port));
       }
@@ -747,6 +772,8 @@ namespace llarp
 #endif
 
     routerProfiling().Tick();
+    nodedb()->HopCandidates().RefreshBad(
+        [this](const RouterID& router) { return routerProfiling().IsBadForPath(router); });
 
     if (ShouldReportStats(now))
     {
@@ -953,10 +980,7 @@ namespace llarp
   void
   Router::HandleDHTLookupForExplore(RouterID /*remote*/, const std::vector<RouterContact>& results)
   {
-    for (const auto& rc : results)
-    {
-      _rcLookupHandler.CheckRC(rc);
-    }
+    _rcLookupHandler.CheckRCs(results);
   }
 
   // TODO: refactor callers and remove this function
@@ -1152,6 +1176,8 @@ namespace llarp
   Router::AfterStopLinks()
   {
     Close();
+    if (m_CryptoLanes)
+      m_CryptoLanes->Stop();
     m_lmq.reset();
   }
 
@@ -1316,14 +1342,15 @@ namespace llarp
         util::memFn(&Router::ConnectionTimedOut, this),
         util::memFn(&AbstractRouter::SessionClosed, this),
         util::memFn(&AbstractRouter::PumpLL, this),
-        util::memFn(&AbstractRouter::QueueWork, this));
+        util::memFn(&AbstractRouter::QueueWork, this),
+        m_CryptoLanes);
 
     if (!link)
       throw std::runtime_error("NewOutboundLink() failed to provide a link");
 
     for (const auto af : {AF_INET, AF_INET6})
     {
-      if (not link->Configure(loop(), "*", af, m_OutboundPort))
+      if (not link->Configure(loop(), "*", af, m_OutboundPort, m_EventLoops))
         continue;
 
 #if defined(ANDROID)
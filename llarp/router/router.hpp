@@ -6,9 +6,11 @@
 #include <llarp/config/config.hpp>
 #include <llarp/config/key_manager.hpp>
 #include <llarp/constants/link_layer.hpp>
+#include <llarp/crypto/key_pool.hpp>
 #include <llarp/crypto/types.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/exit/context.hpp>
+#include <llarp/iwp/crypto_lanes.hpp>
 #include <llarp/handlers/tun.hpp>
 #include <llarp/link/link_manager.hpp>
 #include <llarp/link/server.hpp>
@@ -74,6 +76,20 @@ namespace llarp
 
     LMQ_ptr m_lmq;
 
+    /// threads that do iwp packet crypto, shared by all of our links
+    std::shared_ptr<iwp::CryptoLanes> m_CryptoLanes;
+
+    /// how many event loops each link's udp socket is spread over
+    size_t m_EventLoops = 1;
+
+    std::shared_ptr<EphemeralKeyPool> m_EphemeralKeys;
+
+    const std::shared_ptr<EphemeralKeyPool>&
+    ephemeralKeys() const override
+    {
+      return m_EphemeralKeys;
+    }
+
     const LMQ_ptr&
     lmq() const override
     {
@@ -320,7 +336,7 @@ namespace llarp
     ~Router() override;
 
     bool
-    HandleRecvLinkMessageBuffer(ILinkSession* from, const llarp_buffer_t& msg) override;
+    HandleRecvLinkMessageBuffer(ILinkSession* from, std::vector<byte_t> msg) override;
 
     bool
     InitOutboundLinks();
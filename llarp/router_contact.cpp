@@ -449,6 +449,19 @@ namespace llarp
 
   bool
   RouterContact::Verify(llarp_time_t now, bool allowExpired) const
+  {
+    if (not VerifyExceptSignature(now, allowExpired))
+      return false;
+    if (!VerifySignature())
+    {
+      llarp::LogError("invalid signature: ", *this);
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  RouterContact::VerifyExceptSignature(llarp_time_t now, bool allowExpired) const
   {
     if (netID != NetID::DefaultValue())
     {
@@ -473,11 +486,6 @@ namespace llarp
         return false;
       }
     }
-    if (!VerifySignature())
-    {
-      llarp::LogError("invalid signature: ", *this);
-      return false;
-    }
     return true;
   }
 
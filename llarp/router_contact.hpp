@@ -187,6 +187,10 @@ namespace llarp
     bool
     Verify(llarp_time_t now, bool allowExpired = true) const;
 
+    /// all of Verify's checks but the signature, for rcs whose signature we know is good
+    bool
+    VerifyExceptSignature(llarp_time_t now, bool allowExpired = true) const;
+
     bool
     Sign(const llarp::SecretKey& secret);
 
@@ -723,7 +723,8 @@ namespace llarp
           Router()->QueueWork([this, rc, msg]() mutable {
             bool valid = rc.Verify(llarp::time_now_ms());
             Router()->loop()->call([this, valid, rc = std::move(rc), msg] {
-              Router()->nodedb()->PutIfNewer(rc);
+              if (valid)
+                Router()->nodedb()->PutIfNewer(rc);
               HandleVerifyGotRouter(msg, rc.pubkey, valid);
             });
           });
@@ -0,0 +1,346 @@
+#include "packet_pool.hpp"
+
+#include "thread/annotations.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace llarp
+{
+  namespace packet_pool
+  {
+    namespace
+    {
+      /// slots carved out of one allocation
+      constexpr size_t SlotsPerSlab = 256;
+      /// a thread keeps at most this many free slots to itself
+      constexpr size_t ThreadCacheMax = 256;
+      /// slots moved between a thread's cache and the shared free list at once
+      constexpr size_t TransferBatch = 64;
+      /// 256 slabs of 256 slots is a bit over 128MB of packets before we fall back to the heap
+      constexpr size_t DefaultMaxSlabs = 256;
+
+      constexpr size_t HeaderSize = (sizeof(Slot) + 15) & ~size_t{15};
+      constexpr size_t Stride = HeaderSize + SlotSize;
+      static_assert(HeaderSize == sizeof(Slot), "slot data must directly follow the header");
+
+      struct Central
+      {
+        std::mutex mutex;
+        Slot* free GUARDED_BY(mutex) = nullptr;
+        size_t numFree GUARDED_BY(mutex) = 0;
+        std::vector<std::unique_ptr<byte_t[]>> slabs GUARDED_BY(mutex);
+        size_t maxSlabs GUARDED_BY(mutex) = DefaultMaxSlabs;
+
+        std::atomic<uint64_t> inUse{0};
+        std::atomic<uint64_t> peakInUse{0};
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> missOversized{0};
+        std::atomic<uint64_t> missExhausted{0};
+        std::atomic<uint64_t> heapInUse{0};
+
+        /// carve up one more slab onto the free list, false if we are at the limit
+        bool
+        Grow() REQUIRES(mutex)
+        {
+          if (slabs.size() >= maxSlabs)
+            return false;
+          auto& slab = slabs.emplace_back(new byte_t[Stride * SlotsPerSlab]);
+          for (size_t idx = 0; idx < SlotsPerSlab; ++idx)
+          {
+            auto* slot = new (slab.get() + idx * Stride) Slot{};
+            slot->capacity = SlotSize;
+            slot->pooled = true;
+            slot->next = free;
+            free = slot;
+          }
+          numFree += SlotsPerSlab;
+          return true;
+        }
+
+        /// take back a chain of count free slots
+        void
+        Put(Slot* head, Slot* tail, size_t count)
+        {
+          std::lock_guard lock{mutex};
+          tail->next = free;
+          free = head;
+          numFree += count;
+        }
+      };
+
+      /// the shared free list.  never destroyed, so buffers that are still alive when statics
+      /// get torn down at exit stay valid.
+      Central&
+      central()
+      {
+        static auto* c = new Central{};
+        return *c;
+      }
+
+      /// a thread's private free list, trivially destructible so it is safe to touch at any point
+      /// during thread exit
+      struct Cache
+      {
+        Slot* free = nullptr;
+        size_t count = 0;
+      };
+
+      thread_local Cache t_cache;
+      thread_local bool t_exited = false;
+
+      /// move up to count slots from the front of the cache back to the shared free list
+      void
+      GiveBack(Cache& cache, size_t count)
+      {
+        if (cache.free == nullptr or count == 0)
+          return;
+        Slot* head = cache.free;
+        Slot* tail = head;
+        size_t moved = 1;
+        while (moved < count and tail->next)
+        {
+          tail = tail->next;
+          moved++;
+        }
+        cache.free = tail->next;
+        cache.count -= moved;
+        central().Put(head, tail, moved);
+      }
+
+      /// gives everything a thread has cached back when the thread exits
+      struct CacheFlusher
+      {
+        ~CacheFlusher()
+        {
+          GiveBack(t_cache, t_cache.count);
+          t_exited = true;
+        }
+      };
+
+      thread_local CacheFlusher t_flusher;
+
+      void
+      Refill(Cache& cache)
+      {
+        auto& c = central();
+        std::lock_guard lock{c.mutex};
+        if (c.free == nullptr and not c.Grow())
+          return;
+        while (c.free and cache.count < TransferBatch)
+        {
+          auto* slot = c.free;
+          c.free = slot->next;
+          c.numFree--;
+          slot->next = cache.free;
+          cache.free = slot;
+          cache.count++;
+        }
+      }
+
+      Slot*
+      FromHeap(size_t sz)
+      {
+        const size_t capacity = std::max(sz, SlotSize);
+        auto* slot = new (new byte_t[HeaderSize + capacity]) Slot{};
+        slot->capacity = capacity;
+        central().heapInUse++;
+        return slot;
+      }
+    }  // namespace
+
+    Slot*
+    Acquire(size_t sz)
+    {
+      auto& c = central();
+      if (sz > SlotSize)
+      {
+        c.missOversized++;
+        return FromHeap(sz);
+      }
+      // make sure this thread's cache gets flushed when the thread goes away
+      static_cast<void>(&t_flusher);
+      auto& cache = t_cache;
+      if (cache.free == nullptr and not t_exited)
+        Refill(cache);
+      if (cache.free == nullptr)
+      {
+        c.missExhausted++;
+        return FromHeap(sz);
+      }
+      auto* slot = cache.free;
+      cache.free = slot->next;
+      cache.count--;
+      slot->next = nullptr;
+      slot->size = 0;
+      slot->refs.store(1, std::memory_order_relaxed);
+      c.hits++;
+      const auto used = ++c.inUse;
+      auto peak = c.peakInUse.load(std::memory_order_relaxed);
+      while (peak < used and not c.peakInUse.compare_exchange_weak(peak, used))
+      {}
+      return slot;
+    }
+
+    void
+    Release(Slot* slot)
+    {
+      if (slot == nullptr or slot->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+      auto& c = central();
+      if (not slot->pooled)
+      {
+        c.heapInUse--;
+        slot->~Slot();
+        delete[] reinterpret_cast<byte_t*>(slot);
+        return;
+      }
+      c.inUse--;
+      if (t_exited)
+      {
+        c.Put(slot, slot, 1);
+        return;
+      }
+      auto& cache = t_cache;
+      slot->next = cache.free;
+      cache.free = slot;
+      cache.count++;
+      if (cache.count > ThreadCacheMax)
+        GiveBack(cache, TransferBatch);
+    }
+
+    void
+    SetMaxSlabs(size_t slabs)
+    {
+      auto& c = central();
+      std::lock_guard lock{c.mutex};
+      c.maxSlabs = slabs;
+    }
+
+    util::StatusObject
+    ExtractStatus()
+    {
+      auto& c = central();
+      size_t slabs, numFree, maxSlabs;
+      {
+        std::lock_guard lock{c.mutex};
+        slabs = c.slabs.size();
+        numFree = c.numFree;
+        maxSlabs = c.maxSlabs;
+      }
+      return util::StatusObject{
+          {"slotSize", SlotSize},
+          {"slabs", slabs},
+          {"maxSlabs", maxSlabs},
+          {"slots", slabs * SlotsPerSlab},
+          {"sharedFree", numFree},
+          {"inUse", c.inUse.load()},
+          {"peakInUse", c.peakInUse.load()},
+          {"heapInUse", c.heapInUse.load()},
+          {"hits", c.hits.load()},
+          {"missOversized", c.missOversized.load()},
+          {"missExhausted", c.missExhausted.load()}};
+    }
+  }  // namespace packet_pool
+
+  PacketBuffer::PacketBuffer(size_t sz)
+  {
+    resize(sz);
+  }
+
+  PacketBuffer::PacketBuffer(const PacketBuffer& other) : m_Slot{other.m_Slot}
+  {
+    if (m_Slot)
+      m_Slot->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  PacketBuffer&
+  PacketBuffer::operator=(const PacketBuffer& other)
+  {
+    if (other.m_Slot)
+      other.m_Slot->refs.fetch_add(1, std::memory_order_relaxed);
+    packet_pool::Release(m_Slot);
+    m_Slot = other.m_Slot;
+    return *this;
+  }
+
+  PacketBuffer&
+  PacketBuffer::operator=(PacketBuffer&& other) noexcept
+  {
+    std::swap(m_Slot, other.m_Slot);
+    return *this;
+  }
+
+  PacketBuffer::~PacketBuffer()
+  {
+    packet_pool::Release(m_Slot);
+  }
+
+  PacketBuffer
+  PacketBuffer::uninitialized(size_t sz)
+  {
+    if (sz == 0)
+      return PacketBuffer{};
+    auto* slot = packet_pool::Acquire(sz);
+    slot->size = sz;
+    return PacketBuffer{slot};
+  }
+
+  PacketBuffer
+  PacketBuffer::copy_from(const llarp_buffer_t& buf)
+  {
+    auto pkt = uninitialized(buf.sz);
+    if (buf.sz)
+      std::memcpy(pkt.m_Slot->data(), buf.base, buf.sz);
+    return pkt;
+  }
+
+  void
+  PacketBuffer::MakeUnique()
+  {
+    if (m_Slot == nullptr or m_Slot->refs.load(std::memory_order_acquire) == 1)
+      return;
+    auto* slot = packet_pool::Acquire(m_Slot->size);
+    slot->size = m_Slot->size;
+    std::memcpy(slot->data(), m_Slot->data(), m_Slot->size);
+    packet_pool::Release(m_Slot);
+    m_Slot = slot;
+  }
+
+  void
+  PacketBuffer::resize(size_t sz)
+  {
+    if (m_Slot == nullptr)
+    {
+      if (sz == 0)
+        return;
+      m_Slot = packet_pool::Acquire(sz);
+      std::memset(m_Slot->data(), 0, sz);
+      m_Slot->size = sz;
+      return;
+    }
+    MakeUnique();
+    if (sz > m_Slot->capacity)
+    {
+      auto* slot = packet_pool::Acquire(sz);
+      std::memcpy(slot->data(), m_Slot->data(), m_Slot->size);
+      slot->size = m_Slot->size;
+      packet_pool::Release(m_Slot);
+      m_Slot = slot;
+    }
+    if (sz > m_Slot->size)
+      std::memset(m_Slot->data() + m_Slot->size, 0, sz - m_Slot->size);
+    m_Slot->size = sz;
+  }
+
+  bool
+  PacketBuffer::operator==(const PacketBuffer& other) const
+  {
+    return size() == other.size()
+        and (size() == 0 or std::memcmp(data(), other.data(), size()) == 0);
+  }
+}  // namespace llarp
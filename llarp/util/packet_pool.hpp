@@ -0,0 +1,199 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "status.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace llarp
+{
+  namespace packet_pool
+  {
+    /// every pooled buffer has room for this many bytes, enough for any datagram we send or
+    /// accept on the link layer
+    static constexpr size_t SlotSize = 2048;
+
+    /// header in front of the bytes of every buffer, pooled or not
+    struct alignas(16) Slot
+    {
+      std::atomic<uint32_t> refs{1};
+      uint32_t size = 0;
+      uint32_t capacity = 0;
+      /// false if this came from the heap because the pool could not give us one
+      bool pooled = false;
+      /// free list link while sitting in a cache
+      Slot* next = nullptr;
+
+      byte_t*
+      data()
+      {
+        return reinterpret_cast<byte_t*>(this + 1);
+      }
+
+      const byte_t*
+      data() const
+      {
+        return reinterpret_cast<const byte_t*>(this + 1);
+      }
+    };
+
+    /// get a slot with room for at least sz bytes, from this thread's cache when we can
+    Slot*
+    Acquire(size_t sz);
+
+    /// drop a reference to a slot, it goes back to the pool when it was the last one
+    void
+    Release(Slot* slot);
+
+    /// cap how many slabs the pool may allocate, past that buffers come from the heap
+    void
+    SetMaxSlabs(size_t slabs);
+
+    /// occupancy and miss counters
+    util::StatusObject
+    ExtractStatus();
+  }  // namespace packet_pool
+
+  /// a refcounted handle on a fixed size packet buffer from the packet pool.
+  ///
+  /// acts like the std::vector<byte_t> it replaces: copies are cheap and share the buffer until
+  /// one of them is written through, at which point that one gets its own copy.  moves never touch
+  /// the bytes.  buffers are handed out from per-thread caches of slabs that are allocated once
+  /// and reused, so the datagram path does not hit malloc and does not fragment the heap.
+  class PacketBuffer
+  {
+   public:
+    PacketBuffer() = default;
+
+    /// sz zeroed bytes
+    explicit PacketBuffer(size_t sz);
+
+    PacketBuffer(const PacketBuffer& other);
+
+    PacketBuffer(PacketBuffer&& other) noexcept : m_Slot{other.m_Slot}
+    {
+      other.m_Slot = nullptr;
+    }
+
+    PacketBuffer&
+    operator=(const PacketBuffer& other);
+
+    PacketBuffer&
+    operator=(PacketBuffer&& other) noexcept;
+
+    ~PacketBuffer();
+
+    /// copy the bytes of a buffer into a new pooled buffer
+    static PacketBuffer
+    copy_from(const llarp_buffer_t& buf);
+
+    /// a pooled buffer of sz bytes that are not zeroed, for when they are about to be overwritten
+    static PacketBuffer
+    uninitialized(size_t sz);
+
+    size_t
+    size() const
+    {
+      return m_Slot ? m_Slot->size : 0;
+    }
+
+    size_t
+    capacity() const
+    {
+      return m_Slot ? m_Slot->capacity : 0;
+    }
+
+    bool
+    empty() const
+    {
+      return size() == 0;
+    }
+
+    /// number of handles sharing this buffer
+    size_t
+    use_count() const
+    {
+      return m_Slot ? m_Slot->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    const byte_t*
+    data() const
+    {
+      return m_Slot ? m_Slot->data() : nullptr;
+    }
+
+    /// writable bytes, copies the buffer first if another handle shares it
+    byte_t*
+    data()
+    {
+      MakeUnique();
+      return m_Slot ? m_Slot->data() : nullptr;
+    }
+
+    const byte_t*
+    begin() const
+    {
+      return data();
+    }
+
+    const byte_t*
+    end() const
+    {
+      return data() + size();
+    }
+
+    byte_t*
+    begin()
+    {
+      return data();
+    }
+
+    byte_t*
+    end()
+    {
+      return data() + size();
+    }
+
+    byte_t
+    operator[](size_t idx) const
+    {
+      return data()[idx];
+    }
+
+    byte_t&
+    operator[](size_t idx)
+    {
+      return data()[idx];
+    }
+
+    /// grow or shrink, new bytes are zeroed
+    void
+    resize(size_t sz);
+
+    void
+    clear()
+    {
+      resize(0);
+    }
+
+    bool
+    operator==(const PacketBuffer& other) const;
+
+    bool
+    operator!=(const PacketBuffer& other) const
+    {
+      return not(*this == other);
+    }
+
+   private:
+    explicit PacketBuffer(packet_pool::Slot* slot) : m_Slot{slot}
+    {}
+
+    void
+    MakeUnique();
+
+    packet_pool::Slot* m_Slot = nullptr;
+  };
+}  // namespace llarp
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <llarp/ev/vpn.hpp>
+#include <llarp/util/logging/logger.hpp>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <fcntl.h>
 #include "common.hpp"
+#include "offload.hpp"
 #include <linux/if.h>
 #include <linux/if_tun.h>
+#include <sys/uio.h>
+
+#include <vector>
 
 namespace llarp::vpn
 {
@@ -20,26 +25,71 @@ namespace llarp::vpn
 
   class LinuxInterface : public NetworkInterface
   {
-    const int m_fd;
+    /// one fd per queue, a single queue unless we were asked for more
+    std::vector<int> m_fds;
     const InterfaceInfo m_Info;
 
-   public:
-    LinuxInterface(InterfaceInfo info)
-        : NetworkInterface{}, m_fd{::open("/dev/net/tun", O_RDWR)}, m_Info{std::move(info)}
+    /// what a queue of an offloading interface keeps between reads
+    struct OffloadQueue
+    {
+      std::vector<byte_t> readBuf = std::vector<byte_t>(sizeof(VNetHdr) + MaxOffloadSize);
+      /// the segments of the last packet read that we have not handed out yet
+      std::vector<net::IPPacket> segments;
+      size_t next = 0;
+    };
+    /// one per queue when offloading, each used only by whoever reads that queue
+    std::vector<OffloadQueue> m_Offload;
+    /// packets held back by WritePacket until Flush when offloading
+    std::vector<net::IPPacket> m_PendingWrites;
+    TCPCoalescer m_Coalescer;
 
+    /// most packets WritePacket holds back before it flushes on its own
+    static constexpr size_t MaxPendingWrites = 64;
+
+    /// open one more queue of the interface named in ifr, which gets the kernel's name for it
+    void
+    OpenQueue(ifreq& ifr)
     {
-      if (m_fd == -1)
+      const int fd = ::open("/dev/net/tun", O_RDWR);
+      if (fd == -1)
         throw std::runtime_error("cannot open /dev/net/tun " + std::string{strerror(errno)});
+      m_fds.push_back(fd);
+      if (::ioctl(fd, TUNSETIFF, &ifr) == -1)
+        throw std::runtime_error("cannot set interface name: " + std::string{strerror(errno)});
+    }
 
+    void
+    CloseQueues()
+    {
+      for (const int fd : m_fds)
+        ::close(fd);
+      m_fds.clear();
+    }
+
+    void
+    Setup()
+    {
       ifreq ifr{};
       in6_ifreq ifr6{};
       ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+      if (m_Info.queues > 1)
+        ifr.ifr_flags |= IFF_MULTI_QUEUE;
+      if (m_Info.offload)
+        ifr.ifr_flags |= IFF_VNET_HDR;
       std::copy_n(
           m_Info.ifname.c_str(),
           std::min(m_Info.ifname.size(), sizeof(ifr.ifr_name)),
           ifr.ifr_name);
-      if (::ioctl(m_fd, TUNSETIFF, &ifr) == -1)
-        throw std::runtime_error("cannot set interface name: " + std::string{strerror(errno)});
+      for (size_t queue = 0; queue < std::max(m_Info.queues, size_t{1}); ++queue)
+      {
+        // later queues attach to the interface the first one made, by the name it was given
+        ifreq queueReq = ifr;
+        OpenQueue(queueReq);
+        if (queue == 0)
+          std::copy_n(queueReq.ifr_name, sizeof(ifr.ifr_name), ifr.ifr_name);
+      }
+      if (m_Info.offload)
+        SetupOffload();
       IOCTL control{AF_INET};
 
       control.ioctl(SIOCGIFFLAGS, &ifr);
@@ -73,23 +123,109 @@ namespace llarp::vpn
       control.ioctl(SIOCSIFFLAGS, &ifr);
     }
 
+    void
+    SetupOffload()
+    {
+      int hdrSize = sizeof(VNetHdr);
+      for (const int fd : m_fds)
+      {
+        if (::ioctl(fd, TUNSETVNETHDRSZ, &hdrSize) == -1)
+          throw std::runtime_error("cannot set vnet header size: " + std::string{strerror(errno)});
+      }
+      // without these the kernel sends us mtu sized packets with finished checksums, which we
+      // still read fine
+      if (::ioctl(m_fds[0], TUNSETOFFLOAD, TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6) == -1)
+        LogWarn(m_Info.ifname, " cannot enable tcp segmentation offload: ", strerror(errno));
+      m_Offload.resize(m_fds.size());
+    }
+
+    net::IPPacket
+    ReadOffloaded(size_t queue)
+    {
+      auto& state = m_Offload[queue];
+      while (state.next == state.segments.size())
+      {
+        state.segments.clear();
+        state.next = 0;
+        const auto sz = read(m_fds[queue], state.readBuf.data(), state.readBuf.size());
+        if (sz < 0 and (errno == EAGAIN || errno == EWOULDBLOCK))
+          return net::IPPacket{};
+        if (sz < 0)
+          throw std::error_code{errno, std::system_category()};
+        if (size_t(sz) < sizeof(VNetHdr))
+          continue;
+        VNetHdr hdr;
+        std::memcpy(&hdr, state.readBuf.data(), sizeof(hdr));
+        if (not SplitOffloaded(
+                hdr, state.readBuf.data() + sizeof(hdr), sz - sizeof(hdr), state.segments))
+          LogDebug(m_Info.ifname, " dropped an offloaded packet we cannot split");
+      }
+      return std::move(state.segments[state.next++]);
+    }
+
+    /// write one packet with its vnet header, returns false if it did not all go out
+    bool
+    WriteOffloaded(const VNetHdr& hdr, const byte_t* data, size_t sz)
+    {
+      iovec iov[2];
+      iov[0].iov_base = const_cast<VNetHdr*>(&hdr);
+      iov[0].iov_len = sizeof(hdr);
+      iov[1].iov_base = const_cast<byte_t*>(data);
+      iov[1].iov_len = sz;
+      const auto n = ::writev(m_fds[0], iov, 2);
+      return n == static_cast<ssize_t>(sizeof(hdr) + sz);
+    }
+
+   public:
+    LinuxInterface(InterfaceInfo info) : NetworkInterface{}, m_Info{std::move(info)}
+    {
+      try
+      {
+        Setup();
+      }
+      catch (...)
+      {
+        CloseQueues();
+        throw;
+      }
+    }
+
     virtual ~LinuxInterface()
     {
-      if (m_fd != -1)
-        ::close(m_fd);
+      CloseQueues();
     }
 
     int
     PollFD() const override
     {
-      return m_fd;
+      return m_fds[0];
+    }
+
+    size_t
+    NumQueues() const override
+    {
+      return m_fds.size();
+    }
+
+    int
+    QueueFD(size_t queue) const override
+    {
+      return m_fds[queue];
     }
 
     net::IPPacket
     ReadNextPacket() override
     {
+      return ReadNextPacketFrom(0);
+    }
+
+    net::IPPacket
+    ReadNextPacketFrom(size_t queue) override
+    {
+      if (not m_Offload.empty())
+        return ReadOffloaded(queue);
       net::IPPacket pkt;
-      const auto sz = read(m_fd, pkt.buf, sizeof(pkt.buf));
+      const auto sz = read(m_fds[queue], pkt.buf, sizeof(pkt.buf));
       if (sz >= 0)
         pkt.sz = std::min(sz, ssize_t{sizeof(pkt.buf)});
       else if (errno == EAGAIN || errno == EWOULDBLOCK)
@@ -102,12 +238,34 @@ namespace llarp::vpn
     bool
     WritePacket(net::IPPacket pkt) override
     {
-      const auto sz = write(m_fd, pkt.buf, pkt.sz);
+      if (not m_Offload.empty())
+      {
+        m_PendingWrites.emplace_back(std::move(pkt));
+        if (m_PendingWrites.size() >= MaxPendingWrites)
+          return Flush();
+        return true;
+      }
+      const auto sz = write(m_fds[0], pkt.buf, pkt.sz);
       if (sz <= 0)
         return false;
       return sz == static_cast<ssize_t>(pkt.sz);
     }
 
+    bool
+    Flush() override
+    {
+      if (m_PendingWrites.empty())
+        return true;
+      bool ok = true;
+      m_Coalescer.Coalesce(
+          m_PendingWrites, [this, &ok](const auto& hdr, const auto* data, size_t sz) {
+            if (not WriteOffloaded(hdr, data, sz))
+              ok = false;
+          });
+      m_PendingWrites.clear();
+      return ok;
+    }
+
     std::string
     IfName() const override
     {
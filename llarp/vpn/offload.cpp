@@ -0,0 +1,334 @@
+#include "offload.hpp"
+
+#include <llarp/net/checksum.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace llarp::vpn
+{
+  namespace
+  {
+    constexpr uint8_t ProtoTCP = 6;
+
+    constexpr uint8_t TCPFin = 0x01;
+    constexpr uint8_t TCPPush = 0x08;
+    constexpr uint8_t TCPAck = 0x10;
+    constexpr uint8_t TCPCwr = 0x80;
+
+    /// offsets into the tcp header
+    constexpr size_t TCPSeq = 4;
+    constexpr size_t TCPFlags = 13;
+    constexpr size_t TCPCheck = 16;
+
+    uint16_t
+    Load16(const byte_t* ptr)
+    {
+      return (uint16_t{ptr[0]} << 8) | ptr[1];
+    }
+
+    uint32_t
+    Load32(const byte_t* ptr)
+    {
+      return (uint32_t{Load16(ptr)} << 16) | Load16(ptr + 2);
+    }
+
+    void
+    Store16(byte_t* ptr, uint16_t val)
+    {
+      ptr[0] = val >> 8;
+      ptr[1] = val;
+    }
+
+    void
+    Store32(byte_t* ptr, uint32_t val)
+    {
+      Store16(ptr, val >> 16);
+      Store16(ptr + 2, val);
+    }
+
+    /// ones complement sum of big endian 16 bit words, unfolded.  the folded sum of the words in
+    /// memory order is the same sum with its bytes in memory order.
+    uint64_t
+    Sum(const byte_t* ptr, size_t sz, uint64_t sum = 0)
+    {
+      return sum + ntohs(net::ChecksumFold(net::ChecksumPartial(ptr, sz)));
+    }
+
+    uint16_t
+    Fold(uint64_t sum)
+    {
+      while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+      return sum;
+    }
+
+    /// where the headers of a tcp packet end
+    struct TCPLayout
+    {
+      bool v4;
+      size_t l3Len;
+      size_t l4Len;
+    };
+
+    std::optional<TCPLayout>
+    ParseTCP(const byte_t* data, size_t sz)
+    {
+      if (sz < 20)
+        return std::nullopt;
+      TCPLayout layout{};
+      const int version = data[0] >> 4;
+      if (version == 4)
+      {
+        layout.v4 = true;
+        layout.l3Len = (data[0] & 0x0f) * 4;
+        if (layout.l3Len < 20 or data[9] != ProtoTCP)
+          return std::nullopt;
+      }
+      else if (version == 6)
+      {
+        // we do not walk extension headers, tcp has to come right after the fixed header
+        layout.l3Len = 40;
+        if (sz < layout.l3Len or data[6] != ProtoTCP)
+          return std::nullopt;
+      }
+      else
+        return std::nullopt;
+      if (sz < layout.l3Len + 20)
+        return std::nullopt;
+      layout.l4Len = (data[layout.l3Len + 12] >> 4) * 4;
+      if (layout.l4Len < 20 or sz < layout.l3Len + layout.l4Len)
+        return std::nullopt;
+      return layout;
+    }
+
+    /// sum of the tcp pseudo header for a tcp header and payload of tcpLen bytes
+    uint64_t
+    PseudoHeaderSum(const byte_t* ip, bool v4, size_t tcpLen)
+    {
+      const auto sum = v4 ? Sum(ip + 12, 8) : Sum(ip + 8, 32);
+      return sum + ProtoTCP + tcpLen;
+    }
+
+    /// set the length fields of the ip header of a packet that is now sz bytes long
+    void
+    SetIPLength(byte_t* ip, const TCPLayout& layout, size_t sz)
+    {
+      if (layout.v4)
+      {
+        Store16(ip + 2, sz);
+        Store16(ip + 10, 0);
+        Store16(ip + 10, ~Fold(Sum(ip, layout.l3Len)));
+      }
+      else
+        Store16(ip + 4, sz - layout.l3Len);
+    }
+
+    bool
+    ValidTCPChecksum(const byte_t* data, size_t sz, const TCPLayout& layout)
+    {
+      const size_t tcpLen = sz - layout.l3Len;
+      return Fold(PseudoHeaderSum(data, layout.v4, tcpLen) + Sum(data + layout.l3Len, tcpLen))
+          == 0xffff;
+    }
+  }  // namespace
+
+  bool
+  SplitOffloaded(const VNetHdr& hdr, const byte_t* data, size_t sz, std::vector<net::IPPacket>& out)
+  {
+    const uint8_t gsoType = hdr.gsoType & ~VNetHdr::GSOECN;
+    if (gsoType == VNetHdr::GSONone)
+    {
+      if (sz == 0 or sz > net::IPPacket::MaxSize)
+        return false;
+      auto& pkt = out.emplace_back();
+      std::copy_n(data, sz, pkt.buf);
+      pkt.sz = sz;
+      if (hdr.flags & VNetHdr::NeedsCsum)
+      {
+        const size_t at = size_t{hdr.csumStart} + hdr.csumOffset;
+        if (at + 2 > sz)
+        {
+          out.pop_back();
+          return false;
+        }
+        // the kernel left the pseudo header sum in the checksum field
+        Store16(pkt.buf + at, ~Fold(Sum(pkt.buf + hdr.csumStart, sz - hdr.csumStart)));
+      }
+      return true;
+    }
+    if (gsoType != VNetHdr::GSOTCPv4 and gsoType != VNetHdr::GSOTCPv6)
+      return false;
+
+    const auto layout = ParseTCP(data, sz);
+    if (not layout or layout->v4 != (gsoType == VNetHdr::GSOTCPv4) or hdr.gsoSize == 0)
+      return false;
+    const size_t hdrsLen = layout->l3Len + layout->l4Len;
+    if (hdrsLen + hdr.gsoSize > net::IPPacket::MaxSize)
+      return false;
+
+    const byte_t* payload = data + hdrsLen;
+    const size_t payloadLen = sz - hdrsLen;
+    const uint32_t seq = Load32(data + layout->l3Len + TCPSeq);
+    const uint16_t id = layout->v4 ? Load16(data + 4) : 0;
+    const uint8_t flags = data[layout->l3Len + TCPFlags];
+    size_t offset = 0;
+    uint16_t segment = 0;
+    do
+    {
+      const size_t len = std::min<size_t>(hdr.gsoSize, payloadLen - offset);
+      const bool last = offset + len == payloadLen;
+      auto& pkt = out.emplace_back();
+      std::copy_n(data, hdrsLen, pkt.buf);
+      std::copy_n(payload + offset, len, pkt.buf + hdrsLen);
+      pkt.sz = hdrsLen + len;
+
+      byte_t* ip = pkt.buf;
+      byte_t* tcp = pkt.buf + layout->l3Len;
+      if (layout->v4)
+        Store16(ip + 4, id + segment);
+      SetIPLength(ip, *layout, pkt.sz);
+      // like the kernel: FIN and PSH only on the last segment, CWR only on the first
+      uint8_t segFlags = flags;
+      if (not last)
+        segFlags &= ~(TCPFin | TCPPush);
+      if (segment)
+        segFlags &= ~TCPCwr;
+      tcp[TCPFlags] = segFlags;
+      Store32(tcp + TCPSeq, seq + offset);
+      const size_t tcpLen = pkt.sz - layout->l3Len;
+      Store16(tcp + TCPCheck, 0);
+      Store16(
+          tcp + TCPCheck,
+          ~Fold(PseudoHeaderSum(ip, layout->v4, tcpLen) + Sum(tcp, tcpLen)));
+
+      offset += len;
+      segment++;
+    } while (offset < payloadLen);
+    return true;
+  }
+
+  void
+  TCPCoalescer::Coalesce(const std::vector<net::IPPacket>& pkts, const Write_t& write)
+  {
+    for (const auto& pkt : pkts)
+    {
+      if (m_First and Extends(pkt))
+      {
+        Append(pkt);
+        continue;
+      }
+      Emit(write);
+      const auto layout = ParseTCP(pkt.buf, pkt.sz);
+      const bool mergeable = layout and pkt.sz > layout->l3Len + layout->l4Len
+          and (not layout->v4 or (Load16(pkt.buf + 6) & 0x3fff) == 0)
+          and (pkt.buf[layout->l3Len + TCPFlags] & ~TCPPush) == TCPAck
+          and ValidTCPChecksum(pkt.buf, pkt.sz, *layout);
+      if (mergeable)
+        Start(pkt);
+      else
+        write(VNetHdr{}, pkt.buf, pkt.sz);
+    }
+    Emit(write);
+  }
+
+  bool
+  TCPCoalescer::Extends(const net::IPPacket& pkt) const
+  {
+    if (m_Closed)
+      return false;
+    const auto layout = ParseTCP(pkt.buf, pkt.sz);
+    if (not layout or layout->l3Len != m_L3Len or layout->l4Len != m_L4Len)
+      return false;
+    const size_t len = pkt.sz - m_L3Len - m_L4Len;
+    if (len == 0 or len > m_SegmentSize or m_Merged.size() + len > MaxOffloadSize)
+      return false;
+
+    const byte_t* ip = pkt.buf;
+    const byte_t* firstIP = m_First->buf;
+    if (layout->v4)
+    {
+      // version, header length, tos, ttl, protocol and addresses, plus any options
+      if (std::memcmp(ip, firstIP, 2) or std::memcmp(ip + 8, firstIP + 8, 2)
+          or std::memcmp(ip + 12, firstIP + 12, m_L3Len - 12)
+          or (Load16(ip + 6) & 0x3fff) != 0)
+        return false;
+    }
+    // version, traffic class, flow label, next header, hop limit and addresses
+    else if (std::memcmp(ip, firstIP, 4) or std::memcmp(ip + 6, firstIP + 6, 34))
+      return false;
+
+    const byte_t* tcp = ip + m_L3Len;
+    const byte_t* firstTCP = firstIP + m_L3Len;
+    // ports, then ack, data offset and window, urgent pointer and options
+    if (std::memcmp(tcp, firstTCP, 4) or std::memcmp(tcp + 8, firstTCP + 8, 5)
+        or std::memcmp(tcp + 14, firstTCP + 14, 2)
+        or std::memcmp(tcp + 18, firstTCP + 18, m_L4Len - 18))
+      return false;
+    if ((tcp[TCPFlags] & ~TCPPush) != TCPAck or Load32(tcp + TCPSeq) != m_NextSeq)
+      return false;
+    return ValidTCPChecksum(pkt.buf, pkt.sz, *layout);
+  }
+
+  void
+  TCPCoalescer::Start(const net::IPPacket& pkt)
+  {
+    const auto layout = ParseTCP(pkt.buf, pkt.sz);
+    m_First = &pkt;
+    m_Segments = 1;
+    m_L3Len = layout->l3Len;
+    m_L4Len = layout->l4Len;
+    m_SegmentSize = pkt.sz - m_L3Len - m_L4Len;
+    m_NextSeq = Load32(pkt.buf + m_L3Len + TCPSeq) + m_SegmentSize;
+    m_Push = pkt.buf[m_L3Len + TCPFlags] & TCPPush;
+    m_Closed = m_Push;
+  }
+
+  void
+  TCPCoalescer::Append(const net::IPPacket& pkt)
+  {
+    if (m_Segments == 1)
+      m_Merged.assign(m_First->buf, m_First->buf + m_First->sz);
+    const size_t hdrsLen = m_L3Len + m_L4Len;
+    const size_t len = pkt.sz - hdrsLen;
+    m_Merged.insert(m_Merged.end(), pkt.buf + hdrsLen, pkt.buf + pkt.sz);
+    m_Segments++;
+    m_NextSeq += len;
+    m_Push = pkt.buf[m_L3Len + TCPFlags] & TCPPush;
+    m_Closed = m_Push or len < m_SegmentSize;
+  }
+
+  void
+  TCPCoalescer::Emit(const Write_t& write)
+  {
+    if (m_First == nullptr)
+      return;
+    if (m_Segments == 1)
+      write(VNetHdr{}, m_First->buf, m_First->sz);
+    else
+    {
+      const TCPLayout layout{(m_Merged[0] >> 4) == 4, m_L3Len, m_L4Len};
+      byte_t* ip = m_Merged.data();
+      byte_t* tcp = ip + m_L3Len;
+      SetIPLength(ip, layout, m_Merged.size());
+      if (m_Push)
+        tcp[TCPFlags] |= TCPPush;
+      // the kernel finishes the checksum from the pseudo header sum we leave in it
+      Store16(
+          tcp + TCPCheck, Fold(PseudoHeaderSum(ip, layout.v4, m_Merged.size() - m_L3Len)));
+
+      VNetHdr hdr;
+      hdr.flags = VNetHdr::NeedsCsum;
+      hdr.gsoType = layout.v4 ? VNetHdr::GSOTCPv4 : VNetHdr::GSOTCPv6;
+      hdr.hdrLen = m_L3Len + m_L4Len;
+      hdr.gsoSize = m_SegmentSize;
+      hdr.csumStart = m_L3Len;
+      hdr.csumOffset = TCPCheck;
+      write(hdr, m_Merged.data(), m_Merged.size());
+    }
+    m_First = nullptr;
+    m_Segments = 0;
+    m_Merged.clear();
+  }
+}  // namespace llarp::vpn
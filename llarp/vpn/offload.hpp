@@ -0,0 +1,92 @@
+#pragma once
+
+#include <llarp/net/ip_packet.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace llarp::vpn
+{
+  /// the header in front of every packet on a tun opened with IFF_VNET_HDR, laid out like linux's
+  /// struct virtio_net_hdr in host byte order
+  struct VNetHdr
+  {
+    static constexpr uint8_t NeedsCsum = 1;
+
+    static constexpr uint8_t GSONone = 0;
+    static constexpr uint8_t GSOTCPv4 = 1;
+    static constexpr uint8_t GSOTCPv6 = 4;
+    static constexpr uint8_t GSOECN = 0x80;
+
+    uint8_t flags = 0;
+    uint8_t gsoType = GSONone;
+    /// length of the ip and tcp headers of a gso packet
+    uint16_t hdrLen = 0;
+    /// payload bytes per segment of a gso packet
+    uint16_t gsoSize = 0;
+    /// where the checksum of a NeedsCsum packet starts summing, and where to put it from there
+    uint16_t csumStart = 0;
+    uint16_t csumOffset = 0;
+  };
+  static_assert(sizeof(VNetHdr) == 10);
+
+  /// the largest packet the kernel hands us or takes from us with a vnet header
+  static constexpr size_t MaxOffloadSize = 65535;
+
+  /// turn a packet read from a tun with vnet headers into regular packets with full checksums.
+  /// a tcp gso packet is cut into one packet per gsoSize bytes of payload, anything else is
+  /// passed through with its checksum completed if it needs it.
+  /// returns false and appends nothing if the packet is malformed or we do not handle its gso
+  /// type.
+  bool
+  SplitOffloaded(
+      const VNetHdr& hdr, const byte_t* data, size_t sz, std::vector<net::IPPacket>& out);
+
+  /// merges runs of consecutive tcp segments of one flow into gso packets to write to a tun with
+  /// vnet headers, the reverse of SplitOffloaded.
+  ///
+  /// segments only merge when the kernel could have cut them from one packet itself: same
+  /// addresses, ports, ack, window and options, sequence numbers that follow on from each other,
+  /// no flags but ACK (and PSH on the last one), equal sized payloads with only the last one
+  /// allowed to be shorter, and a valid checksum on each.  the merged packet leaves its tcp
+  /// checksum to the kernel.
+  class TCPCoalescer
+  {
+   public:
+    using Write_t = std::function<void(const VNetHdr&, const byte_t*, size_t)>;
+
+    /// call write once per packet to write, in the order of pkts
+    void
+    Coalesce(const std::vector<net::IPPacket>& pkts, const Write_t& write);
+
+   private:
+    /// the segment the current run started with, nullptr if there is no run
+    const net::IPPacket* m_First = nullptr;
+    /// the first segment followed by the payloads of the rest, once there is more than one
+    std::vector<byte_t> m_Merged;
+    size_t m_Segments = 0;
+    /// header lengths and payload size of every segment of the run but the last
+    size_t m_L3Len = 0;
+    size_t m_L4Len = 0;
+    size_t m_SegmentSize = 0;
+    uint32_t m_NextSeq = 0;
+    /// true once a segment came that nothing can follow: a short one or one with PSH set
+    bool m_Closed = false;
+    bool m_Push = false;
+
+    /// whether pkt can be appended to the current run
+    bool
+    Extends(const net::IPPacket& pkt) const;
+
+    void
+    Start(const net::IPPacket& pkt);
+
+    void
+    Append(const net::IPPacket& pkt);
+
+    /// write out and forget the current run
+    void
+    Emit(const Write_t& write);
+  };
+}  // namespace llarp::vpn
@@ -0,0 +1,187 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+  /// the count of the live AllocationCounter on this thread, if any
+  thread_local size_t* allocationCount = nullptr;
+
+  void*
+  Allocate(std::size_t sz)
+  {
+    if (allocationCount)
+      ++*allocationCount;
+    return std::malloc(sz ? sz : 1);
+  }
+
+  void*
+  AllocateAligned(std::size_t sz, std::align_val_t align)
+  {
+    if (allocationCount)
+      ++*allocationCount;
+#ifdef _WIN32
+    return _aligned_malloc(sz ? sz : 1, static_cast<std::size_t>(align));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, static_cast<std::size_t>(align), sz ? sz : 1))
+      return nullptr;
+    return ptr;
+#endif
+  }
+
+  void
+  FreeAligned(void* ptr)
+  {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+  }
+}  // namespace
+
+// every form of operator new and delete is replaced for this binary so AllocationCounter sees
+// them all; they still go through malloc and free so nothing else changes
+
+void*
+operator new(std::size_t sz)
+{
+  if (auto ptr = Allocate(sz))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+void*
+operator new[](std::size_t sz)
+{
+  return operator new(sz);
+}
+
+void*
+operator new(std::size_t sz, const std::nothrow_t&) noexcept
+{
+  return Allocate(sz);
+}
+
+void*
+operator new[](std::size_t sz, const std::nothrow_t&) noexcept
+{
+  return Allocate(sz);
+}
+
+void*
+operator new(std::size_t sz, std::align_val_t align)
+{
+  if (auto ptr = AllocateAligned(sz, align))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+void*
+operator new[](std::size_t sz, std::align_val_t align)
+{
+  return operator new(sz, align);
+}
+
+void*
+operator new(std::size_t sz, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(sz, align);
+}
+
+void*
+operator new[](std::size_t sz, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(sz, align);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void
+operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void
+operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void
+operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void
+operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(ptr);
+}
+
+namespace llarp::test
+{
+  AllocationCounter::AllocationCounter()
+  {
+    allocationCount = &count;
+  }
+
+  AllocationCounter::~AllocationCounter()
+  {
+    allocationCount = nullptr;
+  }
+}  // namespace llarp::test
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace llarp::test
+{
+  /// counts the heap allocations made with any form of operator new on the calling thread for as
+  /// long as it lives; only one per thread at a time.  operator new is only replaced in the
+  /// testAllocations binary, and direct calls to malloc, such as those from C libraries, are not
+  /// counted.
+  struct AllocationCounter
+  {
+    AllocationCounter();
+
+    ~AllocationCounter();
+
+    size_t
+    Count() const
+    {
+      return count;
+    }
+
+   private:
+    size_t count = 0;
+  };
+}  // namespace llarp::test
@@ -0,0 +1,127 @@
+#include "allocation_counter.hpp"
+
+#include <iwp/iwp_link_context.hpp>
+#include <link/link_manager.hpp>
+#include <path/hop_index_routers.hpp>
+#include <router/outbound_message_handler.hpp>
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using llarp::path::HopIndex;
+using llarp::test::AllocationCounter;
+
+namespace
+{
+  void* volatile sink;
+
+  /// pass an allocation through somewhere the compiler cannot see into, so it cannot leave out
+  /// a new that is only deleted again
+  template <typename T>
+  T*
+  Keep(T* ptr)
+  {
+    sink = ptr;
+    return static_cast<T*>(sink);
+  }
+}  // namespace
+
+TEST_CASE("AllocationCounter sees every form of operator new", "[alloc]")
+{
+  struct alignas(64) Wide
+  {
+    char bytes[64];
+  };
+
+  AllocationCounter counter;
+  delete Keep(new int{1});
+  delete[] Keep(new int[4]);
+  delete Keep(new (std::nothrow) int{1});
+  delete[] Keep(new (std::nothrow) int[4]);
+  delete Keep(new Wide{});
+  delete[] Keep(new Wide[2]);
+  {
+    auto shared = std::make_shared<Wide>();
+  }
+  CHECK(counter.Count() == 7);
+}
+
+TEST_CASE("Picking hops does not allocate", "[alloc][path][hops]")
+{
+  llarp::test::Routers routers;
+  for (uint16_t id = 1; id <= 1000; ++id)
+    routers.Add(id, id % 250);
+  routers.index.SetUniqueNetmask(16);
+  routers.index.RefreshBad([](const llarp::RouterID& router) { return router[0] % 10 == 0; });
+
+  size_t picked = 0;
+  AllocationCounter counter;
+  for (int build = 0; build < 100; ++build)
+  {
+    HopIndex::Taken taken{routers.index};
+    for (int hop = 0; hop < 4; ++hop)
+      picked += routers.index.Pick(taken) != nullptr;
+  }
+  CHECK(counter.Count() == 0);
+  CHECK(picked == 400);
+}
+
+/// not run by default; run with `testAllocations "[bench]"` to count the heap allocations the
+/// outbound message handler, the link manager and an iwp session make per relayed message.  the
+/// frames are made before counting, as a transit hop hands over the buffer the message came in;
+/// that buffer is one more allocation per relayed message, made where the message was received.
+TEST_CASE("IWP relayed message allocations", "[.][bench][alloc][iwp]")
+{
+  constexpr size_t numSend = 256;
+  llarp::LinkManager linkManager;
+  llarp::OutboundMessageHandler handler;
+  size_t allocations = 0;
+  RunIWPTest([&](std::function<llarp::EventLoop_ptr(void)> start,
+                 std::function<void(void)> endIfDone,
+                 [[maybe_unused]] std::function<void(void)> endTestNow,
+                 Context_ptr alice,
+                 Context_ptr bob) {
+    alice->InitLink<false>([&, endIfDone, alice, bob](auto) {
+      alice->Call([&, endIfDone, alice, bob]() {
+        linkManager.Init(nullptr);
+        linkManager.AddLink(alice->link, false);
+        handler.Init(&linkManager, nullptr, alice->m_Loop);
+        // relay sized frames, like the ones a transit hop hands over, spread over a few paths
+        std::vector<std::vector<byte_t>> frames(numSend, std::vector<byte_t>(1500));
+        std::vector<llarp::PathID_t> paths(8);
+        for (auto& pathid : paths)
+          pathid.Randomize();
+        const auto sent = [&handler] {
+          return handler.ExtractStatus()["queueStats"]["sent"].get<size_t>();
+        };
+        {
+          AllocationCounter counter;
+          for (size_t idx = 0; idx < numSend; ++idx)
+            handler.QueueEncodedMessage(
+                llarp::RouterID(bob->rc.pubkey),
+                std::move(frames[idx]),
+                paths[idx % paths.size()],
+                0,
+                nullptr);
+          // a tick only sends so many bytes
+          for (int tick = 0; tick < 16 and sent() < numSend; ++tick)
+            handler.Tick();
+          allocations = counter.Count();
+        }
+        REQUIRE(sent() == numSend);
+        alice->gucci = true;
+        endIfDone();
+      });
+    });
+    bob->InitLink<true>([endIfDone, bob](auto) {
+      bob->gucci = true;
+      endIfDone();
+    });
+    auto loop = start();
+    loop->call([link = alice->link, rc = bob->rc]() { REQUIRE(link->TryEstablishTo(rc)); });
+  });
+  WARN("allocations per relayed message " << static_cast<double>(allocations) / numSend);
+}
@@ -0,0 +1,104 @@
+#include <crypto/crypto_libsodium.hpp>
+#include <crypto/key_pool.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace llarp;
+
+namespace
+{
+  /// run the refill jobs right where they are queued
+  void
+  RunNow(std::function<void(void)> job)
+  {
+    job();
+  }
+}  // namespace
+
+TEST_CASE("Pooled keys are never handed out twice", "[crypto][keypool]")
+{
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  auto pool = std::make_shared<EphemeralKeyPool>(RunNow, 64);
+  pool->Refill();
+  CHECK(pool->Size() == 64);
+
+  std::set<SecretKey> keys;
+  for (int idx = 0; idx < 64 * 3; ++idx)
+  {
+    const auto key = pool->Take();
+    REQUIRE_FALSE(key.IsZero());
+    CHECK(keys.insert(key).second);
+  }
+  // it was topped up before it ran dry every time
+  const auto status = pool->ExtractStatus();
+  CHECK(status["taken"] == 64 * 3);
+  CHECK(status["missed"] == 0);
+  CHECK(pool->Size() >= 64 / 4);
+}
+
+TEST_CASE("An empty key pool makes keys on the spot", "[crypto][keypool]")
+{
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  std::vector<std::function<void(void)>> jobs;
+  auto pool = std::make_shared<EphemeralKeyPool>(
+      [&jobs](auto job) { jobs.push_back(std::move(job)); }, 16);
+
+  const auto first = pool->Take();
+  const auto second = pool->Take();
+  CHECK_FALSE(first.IsZero());
+  CHECK(first != second);
+  CHECK(pool->ExtractStatus()["missed"] == 2);
+  // one refill at a time
+  REQUIRE(jobs.size() == 1);
+
+  jobs.front()();
+  CHECK(pool->Size() == 16);
+  CHECK(pool->ExtractStatus()["made"] == 16);
+  pool->Take();
+  CHECK(pool->ExtractStatus()["missed"] == 2);
+
+  SECTION("a refill queued for a pool that is gone does nothing")
+  {
+    pool->Refill();
+    REQUIRE(jobs.size() == 2);
+    pool.reset();
+    jobs.back()();
+  }
+}
+
+TEST_CASE("Keys taken from many threads are distinct", "[crypto][keypool]")
+{
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  auto pool = std::make_shared<EphemeralKeyPool>(RunNow, 32);
+  pool->Refill();
+
+  std::mutex mutex;
+  std::set<SecretKey> keys;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 4; ++thread)
+  {
+    threads.emplace_back([&] {
+      std::vector<SecretKey> taken;
+      for (int idx = 0; idx < 200; ++idx)
+        taken.push_back(pool->Take());
+      std::lock_guard lock{mutex};
+      keys.insert(taken.begin(), taken.end());
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  CHECK(keys.size() == 800);
+  CHECK(pool->ExtractStatus()["taken"] == 800);
+}
@@ -0,0 +1,160 @@
+#include <crypto/crypto_libsodium.hpp>
+#include <crypto/multibuffer.hpp>
+
+#include <sodium/crypto_generichash.h>
+#include <sodium/crypto_stream_xchacha20.h>
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  struct Packets
+  {
+    std::vector<std::vector<byte_t>> bufs;
+    std::vector<SharedSecret> keys;
+    std::vector<TunnelNonce> nonces;
+
+    /// num random packets of random sizes up to maxSize bytes, with a mix of keys
+    Packets(size_t num, size_t maxSize, std::mt19937& rng)
+        : bufs(num), keys(num), nonces(num)
+    {
+      for (size_t idx = 0; idx < num; ++idx)
+      {
+        // sizes around block boundaries are the interesting ones, so make sure there are some
+        const size_t sz = idx % 4 == 0 ? (idx * 64) % (maxSize + 1) : rng() % (maxSize + 1);
+        bufs[idx].resize(sz);
+        for (auto& b : bufs[idx])
+          b = rng();
+        keys[idx].Randomize();
+        nonces[idx].Randomize();
+      }
+    }
+  };
+}  // namespace
+
+TEST_CASE("xchacha20_many matches libsodium", "[crypto][multibuffer]")
+{
+  sodium::CryptoLibSodium crypto;
+  // once with the scalar fallback and once with whichever simd kernel this cpu picks
+  const bool simd = GENERATE(false, true);
+  multibuffer::Init(not simd);
+  INFO("kernel: " << multibuffer::KernelName());
+  std::mt19937 rng{Catch::rngSeed()};
+  const size_t num = GENERATE(1, 3, 8, 9, 16, 17, 64);
+  Packets pkts{num, 1500, rng};
+  auto expected = pkts.bufs;
+
+  std::vector<XChaCha20Job> jobs;
+  for (size_t idx = 0; idx < num; ++idx)
+    jobs.push_back(XChaCha20Job{
+        pkts.bufs[idx].data(), pkts.bufs[idx].size(), &pkts.keys[idx], pkts.nonces[idx].data()});
+  REQUIRE(crypto.xchacha20_many(jobs.data(), jobs.size()));
+
+  for (size_t idx = 0; idx < num; ++idx)
+  {
+    auto& ref = expected[idx];
+    crypto_stream_xchacha20_xor(
+        ref.data(), ref.data(), ref.size(), pkts.nonces[idx].data(), pkts.keys[idx].data());
+    INFO("packet " << idx << " of " << num << ", " << ref.size() << " bytes");
+    CHECK(pkts.bufs[idx] == ref);
+  }
+  multibuffer::Init(false);
+}
+
+TEST_CASE("hmac_many matches libsodium", "[crypto][multibuffer]")
+{
+  sodium::CryptoLibSodium crypto;
+  // once with the scalar fallback and once with whichever simd kernel this cpu picks
+  const bool simd = GENERATE(false, true);
+  multibuffer::Init(not simd);
+  INFO("kernel: " << multibuffer::KernelName());
+  std::mt19937 rng{Catch::rngSeed()};
+  const size_t num = GENERATE(1, 3, 4, 5, 8, 9, 64);
+  Packets pkts{num, 1500, rng};
+
+  std::vector<ShortHash> digests(num);
+  std::vector<HMACJob> jobs;
+  for (size_t idx = 0; idx < num; ++idx)
+    jobs.push_back(HMACJob{
+        digests[idx].data(), pkts.bufs[idx].data(), pkts.bufs[idx].size(), &pkts.keys[idx]});
+  REQUIRE(crypto.hmac_many(jobs.data(), jobs.size()));
+
+  for (size_t idx = 0; idx < num; ++idx)
+  {
+    const auto& buf = pkts.bufs[idx];
+    ShortHash expected;
+    crypto_generichash_blake2b(
+        expected.data(),
+        HMACSIZE,
+        buf.data(),
+        buf.size(),
+        pkts.keys[idx].data(),
+        HMACSECSIZE);
+    INFO("packet " << idx << " of " << num << ", " << buf.size() << " bytes");
+    CHECK(digests[idx] == expected);
+  }
+  multibuffer::Init(false);
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare per packet and batched crypto
+TEST_CASE("multibuffer crypto throughput", "[.][bench][crypto]")
+{
+  using Clock_t = std::chrono::steady_clock;
+  sodium::CryptoLibSodium crypto;
+  constexpr size_t batch = 64;
+  constexpr auto runFor = std::chrono::seconds{1};
+  std::mt19937 rng{Catch::rngSeed()};
+
+  for (const size_t pktsize : {64, 512, 1400})
+  {
+    Packets pkts{batch, pktsize, rng};
+    for (auto& buf : pkts.bufs)
+      buf.resize(pktsize);
+    std::vector<XChaCha20Job> ciphers;
+    std::vector<std::array<byte_t, HMACSIZE>> digests(batch);
+    std::vector<HMACJob> hashes;
+    for (size_t idx = 0; idx < batch; ++idx)
+    {
+      auto& buf = pkts.bufs[idx];
+      ciphers.push_back(
+          XChaCha20Job{buf.data(), buf.size(), &pkts.keys[idx], pkts.nonces[idx].data()});
+      hashes.push_back(HMACJob{digests[idx].data(), buf.data(), buf.size(), &pkts.keys[idx]});
+    }
+
+    const auto gbits = [&](auto&& func) {
+      size_t rounds = 0;
+      const auto started = Clock_t::now();
+      while (Clock_t::now() - started < runFor)
+      {
+        func();
+        rounds++;
+      }
+      const std::chrono::duration<double> elapsed = Clock_t::now() - started;
+      return (rounds * batch * pktsize * 8) / elapsed.count() / 1e9;
+    };
+
+    const auto perPacketCipher = gbits([&] {
+      for (size_t idx = 0; idx < batch; ++idx)
+        crypto.xchacha20(llarp_buffer_t{pkts.bufs[idx]}, pkts.keys[idx], pkts.nonces[idx]);
+    });
+    const auto batchedCipher = gbits([&] { crypto.xchacha20_many(ciphers.data(), batch); });
+    const auto perPacketHash = gbits([&] {
+      for (size_t idx = 0; idx < batch; ++idx)
+        crypto.hmac(digests[idx].data(), llarp_buffer_t{pkts.bufs[idx]}, pkts.keys[idx]);
+    });
+    const auto batchedHash = gbits([&] { crypto.hmac_many(hashes.data(), batch); });
+
+    WARN(
+        pktsize << " byte packets, " << multibuffer::KernelName()
+                << " kernel, Gbit/s per core: xchacha20 " << perPacketCipher << " per packet, "
+                << batchedCipher << " batched; hmac " << perPacketHash << " per packet, "
+                << batchedHash << " batched");
+  }
+}
@@ -0,0 +1,112 @@
+#include <dht/bucket.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using llarp::dht::Bucket;
+using llarp::dht::Key_t;
+
+namespace
+{
+  struct TestNode
+  {
+    Key_t ID;
+    uint64_t version = 0;
+
+    llarp::util::StatusObject
+    ExtractStatus() const
+    {
+      return llarp::util::StatusObject{{"version", version}};
+    }
+
+    bool
+    operator<(const TestNode& other) const
+    {
+      return version < other.version;
+    }
+  };
+
+  Key_t
+  RandomKey(std::mt19937_64& rng)
+  {
+    Key_t key;
+    for (auto& b : key)
+      b = rng();
+    return key;
+  }
+}  // namespace
+
+TEST_CASE("Bucket put, replace and delete", "[dht]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  Bucket<TestNode> bucket{[&rng]() -> uint64_t { return rng(); }};
+  const auto key = RandomKey(rng);
+
+  bucket.PutNode(TestNode{key, 2});
+  CHECK(bucket.size() == 1);
+  CHECK(bucket.HasNode(key));
+
+  // older values do not replace newer ones
+  bucket.PutNode(TestNode{key, 1});
+  REQUIRE(bucket.GetNode(key) != nullptr);
+  CHECK(bucket.GetNode(key)->version == 2);
+  bucket.PutNode(TestNode{key, 3});
+  CHECK(bucket.GetNode(key)->version == 3);
+  CHECK(bucket.size() == 1);
+
+  bucket.DelNode(key);
+  CHECK(bucket.size() == 0);
+  CHECK_FALSE(bucket.HasNode(key));
+  Key_t result;
+  CHECK_FALSE(bucket.FindClosest(key, result));
+}
+
+TEST_CASE("Bucket finds the same closest keys as sorting", "[dht]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  Bucket<TestNode> bucket{[&rng]() -> uint64_t { return rng(); }};
+  std::vector<Key_t> keys;
+  for (size_t idx = 0; idx < 2000; ++idx)
+  {
+    keys.emplace_back(RandomKey(rng));
+    bucket.PutNode(TestNode{keys.back()});
+  }
+  // drop every third key through RemoveIf
+  std::set<Key_t> removed;
+  for (size_t idx = 0; idx < keys.size(); idx += 3)
+    removed.insert(keys[idx]);
+  bucket.RemoveIf([&removed](const Key_t& key) { return removed.count(key) > 0; });
+  keys.erase(
+      std::remove_if(
+          keys.begin(), keys.end(), [&removed](const auto& key) { return removed.count(key) > 0; }),
+      keys.end());
+  REQUIRE(bucket.size() == keys.size());
+
+  for (size_t round = 0; round < 50; ++round)
+  {
+    const auto target = RandomKey(rng);
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end(), [&target](const auto& a, const auto& b) {
+      return (a ^ target) < (b ^ target);
+    });
+
+    Key_t closest;
+    REQUIRE(bucket.FindClosest(target, closest));
+    CHECK(closest == sorted[0]);
+
+    const std::array<Key_t, 2> exclude{sorted[0], sorted[2]};
+    std::set<Key_t> near;
+    REQUIRE(bucket.GetManyNearExcluding(target, near, 4, exclude));
+    CHECK(near == std::set<Key_t>{sorted[1], sorted[3], sorted[4], sorted[5]});
+  }
+
+  std::set<Key_t> random;
+  REQUIRE(bucket.GetManyRandom(random, 10));
+  CHECK(random.size() == 10);
+  for (const auto& key : random)
+    CHECK(bucket.HasNode(key));
+}
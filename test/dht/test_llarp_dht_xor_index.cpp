@@ -0,0 +1,142 @@
+#include <dht/xor_index.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using llarp::dht::Key_t;
+using llarp::dht::XorIndex;
+
+namespace
+{
+  Key_t
+  RandomKey(std::mt19937_64& rng)
+  {
+    Key_t key;
+    for (auto& b : key)
+      b = rng();
+    // share long prefixes now and then so deep splits get exercised
+    if (rng() % 4 == 0)
+    {
+      key[0] = 0;
+      key[1] = rng() % 2;
+    }
+    return key;
+  }
+
+  /// what NodeDB did before: sort everything by distance to target
+  std::vector<Key_t>
+  SortClosest(std::vector<Key_t> keys, const Key_t& target, size_t n)
+  {
+    const auto mid = keys.begin() + std::min(n, keys.size());
+    std::partial_sort(keys.begin(), mid, keys.end(), [&target](const auto& a, const auto& b) {
+      return (a ^ target) < (b ^ target);
+    });
+    keys.erase(mid, keys.end());
+    return keys;
+  }
+}  // namespace
+
+TEST_CASE("XorIndex insert and remove", "[dht]")
+{
+  XorIndex index;
+  Key_t a, b;
+  a.Fill(0x01);
+  b.Fill(0x02);
+  CHECK(index.Empty());
+  CHECK(index.Insert(a));
+  CHECK_FALSE(index.Insert(a));
+  CHECK(index.Insert(b));
+  CHECK(index.Size() == 2);
+  CHECK(index.Contains(a));
+  CHECK(index.Remove(a));
+  CHECK_FALSE(index.Remove(a));
+  CHECK_FALSE(index.Contains(a));
+  CHECK(index.Contains(b));
+  index.Clear();
+  CHECK(index.Empty());
+  CHECK_FALSE(index.Contains(b));
+}
+
+TEST_CASE("XorIndex finds the same closest keys as sorting", "[dht]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  XorIndex index;
+  std::set<Key_t> keys;
+  for (size_t round = 0; round < 10'000; ++round)
+  {
+    if (keys.empty() or rng() % 3 != 0)
+    {
+      const auto key = RandomKey(rng);
+      REQUIRE(index.Insert(key) == keys.insert(key).second);
+    }
+    else
+    {
+      auto itr = keys.begin();
+      std::advance(itr, rng() % keys.size());
+      REQUIRE(index.Remove(*itr));
+      keys.erase(itr);
+    }
+    REQUIRE(index.Size() == keys.size());
+
+    if (round % 97 == 0)
+    {
+      const auto target = RandomKey(rng);
+      const size_t n = rng() % 20;
+      std::vector<Key_t> found;
+      index.FindClosest(target, n, found);
+      REQUIRE(found == SortClosest({keys.begin(), keys.end()}, target, n));
+    }
+  }
+  for (const auto& key : keys)
+    REQUIRE(index.Contains(key));
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare against sorting the whole set the
+/// way NodeDB used to for every lookup
+TEST_CASE("XorIndex closest lookup throughput", "[.][bench][dht]")
+{
+  using Clock_t = std::chrono::steady_clock;
+  constexpr size_t numLookups = 200;
+  constexpr size_t numClosest = 8;
+  std::mt19937_64 rng{Catch::rngSeed()};
+
+  for (const size_t numKeys : {10'000, 100'000})
+  {
+    std::vector<Key_t> keys;
+    XorIndex index;
+    for (size_t idx = 0; idx < numKeys; ++idx)
+    {
+      keys.emplace_back(RandomKey(rng));
+      index.Insert(keys.back());
+    }
+    std::vector<Key_t> targets;
+    for (size_t idx = 0; idx < numLookups; ++idx)
+      targets.emplace_back(RandomKey(rng));
+
+    const auto rate = [&](auto&& lookup) {
+      size_t found = 0;
+      const auto started = Clock_t::now();
+      for (const auto& target : targets)
+        found += lookup(target).size();
+      const std::chrono::duration<double> elapsed = Clock_t::now() - started;
+      REQUIRE(found == numLookups * numClosest);
+      return numLookups / elapsed.count();
+    };
+
+    const auto before =
+        rate([&](const Key_t& target) { return SortClosest(keys, target, numClosest); });
+    const auto after = rate([&](const Key_t& target) {
+      std::vector<Key_t> found;
+      index.FindClosest(target, numClosest, found);
+      return found;
+    });
+    WARN(
+        numKeys << " keys, " << numClosest << " closest, lookups/s: " << before << " sorting, "
+                << after << " xor index");
+  }
+}
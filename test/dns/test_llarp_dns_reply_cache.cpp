@@ -0,0 +1,164 @@
+#include <catch2/catch.hpp>
+#include <dns/dns.hpp>
+#include <dns/message.hpp>
+#include <dns/reply_cache.hpp>
+#include <net/net.hpp>
+#include <net/ip.hpp>
+#include <util/endian.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+using namespace llarp::dns;
+
+namespace
+{
+  constexpr auto name = "55fxrybf3jtausbnmxpgwcsz9t8qkf5pr8t5f4xyto4omjrkorpy.loki";
+
+  /// a query for name as a resolver would send it, optionally with an edns opt record after
+  llarp::OwnedBuffer
+  MakeQuery(MsgID_t id, Fields_t fields, QType_t qtype, bool edns = false)
+  {
+    std::array<byte_t, 512> tmp{};
+    llarp_buffer_t buf{tmp};
+    MessageHeader hdr;
+    hdr.id = id;
+    hdr.fields = fields;
+    hdr.qd_count = 1;
+    hdr.an_count = 0;
+    hdr.ns_count = 0;
+    hdr.ar_count = edns ? 1 : 0;
+    Question question;
+    question.qname = name;
+    question.qtype = qtype;
+    question.qclass = qClassIN;
+    REQUIRE(hdr.Encode(&buf));
+    REQUIRE(question.Encode(&buf));
+    if (edns)
+    {
+      // root name, type OPT, 1232 byte payload, no extended rcode or flags, no options
+      const byte_t opt[] = {0, 0, 41, 0x04, 0xd0, 0, 0, 0, 0, 0, 0};
+      REQUIRE(buf.write(std::begin(opt), std::end(opt)));
+    }
+    return llarp::OwnedBuffer::copy_used(buf);
+  }
+
+  /// what the full path answers the query with
+  Message
+  MakeReply(const llarp::OwnedBuffer& query)
+  {
+    llarp_buffer_t buf{query.buf.get(), query.sz};
+    MessageHeader hdr;
+    hdr.Decode(&buf);
+    Message msg{hdr};
+    msg.Decode(&buf);
+    msg.AddINReply(llarp::net::ExpandV4(llarp::ipaddr_ipv4_bits(10, 0, 0, 7)), false);
+    return msg;
+  }
+
+}  // namespace
+
+TEST_CASE("Queries are viewed in place", "[dns]")
+{
+  const auto query = MakeQuery(0x1234, flags_RD, qTypeA);
+  const auto view = ViewQuery(query.buf.get(), query.sz);
+  REQUIRE(view);
+  CHECK(view->id == 0x1234);
+  CHECK(view->fields == flags_RD);
+  // length prefixed labels, the empty root label, qtype and qclass
+  CHECK(view->question.size() == 52 + 1 + 4 + 1 + 1 + 4);
+  CHECK(reinterpret_cast<const byte_t*>(view->question.data()) == query.buf.get() + 12);
+
+  CHECK(ViewQuery(MakeQuery(1, 0, qTypeA, true).buf.get(), query.sz + 11));
+  // responses, other opcodes and cut off names are left to the full decode
+  CHECK_FALSE(ViewQuery(MakeQuery(1, flags_QR, qTypeA).buf.get(), query.sz));
+  CHECK_FALSE(ViewQuery(MakeQuery(1, 1 << 11, qTypeA).buf.get(), query.sz));
+  CHECK_FALSE(ViewQuery(query.buf.get(), query.sz - 1));
+  CHECK_FALSE(ViewQuery(query.buf.get(), 11));
+  // a compression pointer instead of a label
+  auto compressed = MakeQuery(1, 0, qTypeA);
+  compressed.buf[12] = 0xc0;
+  CHECK_FALSE(ViewQuery(compressed.buf.get(), compressed.sz));
+}
+
+TEST_CASE("Cached replies match the full path", "[dns]")
+{
+  ReplyCache cache;
+  const auto now = 1000s;
+  std::array<byte_t, 1500> out;
+
+  const auto first = MakeQuery(0x1111, flags_RD, qTypeA);
+  CHECK_FALSE(cache.Answer(first.buf.get(), first.sz, out.data(), out.size(), now));
+  const auto reply = MakeReply(first);
+  auto wire = reply.ToBuffer();
+  cache.Put(wire, flags_RD, now, 10s);
+  CHECK(cache.Size() == 1);
+
+  SECTION("same question with another id and flags")
+  {
+    // no recursion desired this time, and an edns record that the full path ignores too
+    const auto again = MakeQuery(0x2222, 0, qTypeA, true);
+    REQUIRE(cache.Has(again.buf.get(), again.sz, now + 1s));
+    const auto sz = cache.Answer(again.buf.get(), again.sz, out.data(), out.size(), now + 1s);
+    REQUIRE(sz);
+    // byte for byte what decoding, handling and encoding it would have sent
+    auto expect = MakeReply(MakeQuery(0x2222, 0, qTypeA)).ToBuffer();
+    REQUIRE(*sz == expect.sz);
+    CHECK(std::equal(out.begin(), out.begin() + *sz, expect.buf.get()));
+    CHECK(bufbe16toh(out.data()) == 0x2222);
+    CHECK(bufbe16toh(out.data() + 2) == (flags_QR | flags_AA | flags_RA));
+  }
+
+  SECTION("other questions miss")
+  {
+    const auto aaaa = MakeQuery(0x3333, flags_RD, qTypeAAAA);
+    CHECK_FALSE(cache.Answer(aaaa.buf.get(), aaaa.sz, out.data(), out.size(), now));
+    auto other = MakeQuery(0x3333, flags_RD, qTypeA);
+    other.buf[13] = 'x';
+    CHECK_FALSE(cache.Has(other.buf.get(), other.sz, now));
+  }
+
+  SECTION("replies expire and can be cleared")
+  {
+    CHECK(cache.Has(first.buf.get(), first.sz, now + 9s));
+    CHECK_FALSE(cache.Answer(first.buf.get(), first.sz, out.data(), out.size(), now + 10s));
+    CHECK(cache.Size() == 0);
+    cache.Put(wire, flags_RD, now, 10s);
+    cache.Clear();
+    CHECK_FALSE(cache.Has(first.buf.get(), first.sz, now));
+  }
+
+  SECTION("a reply that does not fit is not given")
+  {
+    CHECK_FALSE(cache.Answer(first.buf.get(), first.sz, out.data(), wire.sz - 1, now));
+  }
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare a cached reply against decoding
+/// and encoding the message
+TEST_CASE("Reply cache speed", "[.][bench][dns]")
+{
+  ReplyCache cache;
+  const auto query = MakeQuery(0x1111, flags_RD, qTypeA, true);
+  auto wire = MakeReply(query).ToBuffer();
+  cache.Put(wire, flags_RD, 0s, 1h);
+  std::array<byte_t, 1500> out;
+  constexpr int rounds = 1'000'000;
+
+  size_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int idx = 0; idx < rounds; ++idx)
+    sink += *cache.Answer(query.buf.get(), query.sz, out.data(), out.size(), 1s);
+  const std::chrono::duration<double, std::nano> cached = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int idx = 0; idx < rounds; ++idx)
+    sink += MakeReply(query).ToBuffer().sz;
+  const std::chrono::duration<double, std::nano> full = std::chrono::steady_clock::now() - start;
+
+  WARN(
+      "cached reply " << cached.count() / rounds << "ns, decode and encode "
+                      << full.count() / rounds << "ns");
+  CHECK(sink > 0);
+}
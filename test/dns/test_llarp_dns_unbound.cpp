@@ -0,0 +1,150 @@
+#include <catch2/catch.hpp>
+
+#include <dns/dns.hpp>
+#include <dns/reply_cache.hpp>
+#include <dns/unbound_resolver.hpp>
+#include <ev/ev.hpp>
+#include <ev/udp_handle.hpp>
+#include <net/sock_addr.hpp>
+#include <util/endian.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+using namespace llarp::dns;
+using llarp::OwnedBuffer;
+using llarp::SockAddr;
+
+namespace
+{
+  /// an upstream resolver on the loop that answers every query with 10.0.0.1 right away
+  std::shared_ptr<llarp::UDPHandle>
+  MakeMockUpstream(const llarp::EventLoop_ptr& loop, const SockAddr& addr)
+  {
+    auto upstream = loop->make_udp([](llarp::UDPHandle& udp, SockAddr src, OwnedBuffer buf) {
+      const auto query = ViewQuery(buf.buf.get(), buf.sz);
+      if (not query)
+        return;
+      // the question back, then one answer that points at its name
+      std::vector<byte_t> reply(12);
+      htobe16buf(reply.data(), query->id);
+      htobe16buf(reply.data() + 2, flags_QR | flags_RD | flags_RA);
+      htobe16buf(reply.data() + 4, 1);
+      htobe16buf(reply.data() + 6, 1);
+      reply.insert(reply.end(), query->question.begin(), query->question.end());
+      const byte_t answer[] = {0xc0, 12, 0, 1, 0, 1, 0, 0, 0, 0, 0, 4, 10, 0, 0, 1};
+      reply.insert(reply.end(), std::begin(answer), std::end(answer));
+      udp.send(src, llarp_buffer_t{reply});
+    });
+    REQUIRE(upstream->listen(addr));
+    return upstream;
+  }
+
+  Message
+  MakeLookup(std::string name)
+  {
+    MessageHeader hdr{};
+    hdr.id = 0x4242;
+    hdr.fields = flags_RD;
+    hdr.qd_count = 1;
+    Message msg{hdr};
+    msg.questions[0].qname = std::move(name);
+    msg.questions[0].qtype = qTypeA;
+    msg.questions[0].qclass = qClassIN;
+    return msg;
+  }
+
+  struct LookupResult
+  {
+    size_t answered = 0;
+    size_t failed = 0;
+    bool onLoop = true;
+    /// from Lookup to the reply function, per lookup
+    std::vector<std::chrono::duration<double, std::milli>> latency;
+  };
+
+  /// resolve `count` different names through unbound and a mock upstream on `port`, one every
+  /// `spacing`
+  LookupResult
+  RunLookups(uint16_t port, size_t count, llarp_time_t spacing)
+  {
+    LookupResult result;
+    result.latency.resize(count);
+    std::vector<std::chrono::steady_clock::time_point> sent(count);
+
+    auto loop = llarp::EventLoop::create();
+    auto upstream = MakeMockUpstream(loop, SockAddr{"127.0.0.1", port});
+    const auto done = [&] {
+      if (result.answered + result.failed == count)
+        loop->stop();
+    };
+    // which lookup a reply is for rides along in the asker's port
+    auto resolver = std::make_shared<UnboundResolver>(
+        loop,
+        [&](const SockAddr&, const SockAddr& asker, OwnedBuffer buf) {
+          result.onLoop = result.onLoop and loop->inEventLoop();
+          const size_t idx = asker.getPort() - 1;
+          result.latency[idx] = std::chrono::steady_clock::now() - sent[idx];
+          const byte_t mocked[] = {10, 0, 0, 1};
+          const auto end = buf.buf.get() + buf.sz;
+          if (buf.sz > 12 and bufbe16toh(buf.buf.get() + 6) == 1
+              and std::search(buf.buf.get(), end, std::begin(mocked), std::end(mocked)) != end)
+            result.answered++;
+          else
+            result.failed++;
+          done();
+        },
+        [&](const SockAddr&, const SockAddr&, Message) {
+          result.failed++;
+          done();
+        });
+    REQUIRE(resolver->Init());
+    REQUIRE(resolver->AddUpstreamResolver("127.0.0.1@" + std::to_string(port)));
+
+    size_t next = 0;
+    auto keepalive = std::make_shared<int>(0);
+    loop->call_every(spacing, keepalive, [&] {
+      if (next == count)
+        return;
+      sent[next] = std::chrono::steady_clock::now();
+      // unique names so every lookup goes upstream; not under .test, which unbound answers itself
+      resolver->Lookup(
+          SockAddr{"127.0.0.1", 53},
+          SockAddr{"127.0.0.1", static_cast<uint16_t>(next + 1)},
+          MakeLookup(
+              "n" + std::to_string(next) + "-" + std::to_string(port) + ".lokinet.example."));
+      next++;
+    });
+    loop->call_later(30s, [&] { loop->stop(); });
+    loop->run();
+    resolver->Stop();
+    return result;
+  }
+}  // namespace
+
+TEST_CASE("Unbound replies are handled on the event loop", "[dns]")
+{
+  const auto result = RunLookups(25353, 20, 1ms);
+  CHECK(result.answered == 20);
+  CHECK(result.failed == 0);
+  CHECK(result.onLoop);
+}
+
+/// not run by default; run with `testAll "[bench]"` to see how long an upstream answer takes to
+/// reach us once the upstream has sent it
+TEST_CASE("Unbound resolve latency", "[.][bench][dns]")
+{
+  auto result = RunLookups(25354, 1000, 2ms);
+  REQUIRE(result.answered == 1000);
+  std::sort(result.latency.begin(), result.latency.end());
+  const auto percentile = [&](double p) {
+    return result.latency[static_cast<size_t>(p * (result.latency.size() - 1))].count();
+  };
+  WARN(
+      "resolve latency p50 " << percentile(0.5) << "ms, p90 " << percentile(0.9) << "ms, p99 "
+                             << percentile(0.99) << "ms, max " << result.latency.back().count()
+                             << "ms");
+}
@@ -0,0 +1,97 @@
+#ifdef __linux__
+#include <catch2/catch.hpp>
+
+#include <ev/netif_queues.hpp>
+#include <vpn/linux.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+  /// packets per second that reach the readers of a tun interface with numQueues queues while
+  /// numSenders threads blast udp at it from their own ports. the tun is made in a network
+  /// namespace of its own, so this needs CAP_NET_ADMIN; nullopt if we could not set it up.
+  std::optional<double>
+  TunThroughput(size_t numQueues, size_t numSenders, std::chrono::milliseconds duration)
+  {
+    std::optional<double> pps;
+    // network namespaces are per thread, keep ours off the thread running the other tests
+    std::thread{[&] {
+      if (::unshare(CLONE_NEWNET) == -1)
+        return;
+      llarp::vpn::InterfaceInfo info;
+      info.ifname = "lokinet-bench";
+      info.queues = numQueues;
+      llarp::IPRange range;
+      range.FromString("10.99.0.1/24");
+      info.addrs.emplace(range);
+      std::shared_ptr<llarp::vpn::NetworkInterface> netif;
+      try
+      {
+        netif = std::make_shared<llarp::vpn::LinuxInterface>(std::move(info));
+      }
+      catch (std::exception&)
+      {
+        return;
+      }
+
+      std::atomic<size_t> received{0};
+      llarp::uv::NetIfQueueReaders readers{
+          netif, [&received](llarp::net::IPPacket) { received++; }, [] {}};
+
+      std::atomic<bool> sending{true};
+      std::vector<std::thread> senders;
+      for (size_t idx = 0; idx < numSenders; ++idx)
+      {
+        senders.emplace_back([&sending] {
+          const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+          sockaddr_in dst{};
+          dst.sin_family = AF_INET;
+          dst.sin_port = htons(9000);
+          ::inet_pton(AF_INET, "10.99.0.2", &dst.sin_addr);
+          const std::vector<char> payload(1200, 0x42);
+          while (sending)
+            ::sendto(fd, payload.data(), payload.size(), 0, (const sockaddr*)&dst, sizeof(dst));
+          ::close(fd);
+        });
+      }
+      std::this_thread::sleep_for(duration);
+      sending = false;
+      for (auto& sender : senders)
+        sender.join();
+      readers.Stop();
+      pps = received / std::chrono::duration<double>{duration}.count();
+    }}.join();
+    return pps;
+  }
+}  // namespace
+
+/// not run by default and needs CAP_NET_ADMIN; run with `testAll "[bench]"` as root to compare a
+/// single tun queue with several queues read on their own threads
+TEST_CASE("Multi-queue tun throughput", "[.][bench][ev]")
+{
+  const size_t numSenders = std::max(4u, std::thread::hardware_concurrency());
+  for (const size_t numQueues : {1, 2, 4})
+  {
+    const auto pps = TunThroughput(numQueues, numSenders, 3s);
+    if (not pps)
+    {
+      WARN("cannot make a tun interface in a new network namespace, skipping");
+      return;
+    }
+    CHECK(*pps > 0);
+    WARN(numQueues << " tun queues: " << *pps << " packets/s");
+  }
+}
+#endif
@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+
+#include <ev/ev.hpp>
+#include <ev/udp_handle.hpp>
+#include <net/sock_addr.hpp>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+  struct LoopbackResult
+  {
+    size_t sent = 0;
+    size_t received = 0;
+    std::chrono::duration<double> elapsed{};
+    llarp::util::StatusObject recvStats;
+    llarp::util::StatusObject sendStats;
+  };
+
+  /// send packets of `pktsize` bytes from one udp handle to another over loopback, `burst` packets
+  /// per millisecond, until `maxPackets` have been received or `duration` has passed
+  LoopbackResult
+  RunLoopback(
+      bool batched,
+      uint16_t port,
+      size_t pktsize,
+      size_t burst,
+      size_t maxPackets,
+      llarp_time_t duration)
+  {
+    LoopbackResult result;
+    auto loop = llarp::EventLoop::create();
+    const auto make_udp = [&](std::function<void(size_t)> recv) {
+      if (batched)
+        return loop->make_batched_udp(
+            [recv](llarp::UDPHandle&, llarp::SockAddr, llarp::PacketBuffer pkt) {
+              recv(pkt.size());
+            });
+      return loop->make_udp([recv](llarp::UDPHandle&, llarp::SockAddr, llarp::OwnedBuffer buf) {
+        recv(buf.sz);
+      });
+    };
+
+    const llarp::SockAddr recvAddr{"127.0.0.1", port};
+    const llarp::SockAddr sendAddr{"127.0.0.1", static_cast<uint16_t>(port + 1)};
+
+    auto receiver = make_udp([&](size_t sz) {
+      if (sz == pktsize)
+        result.received++;
+      if (result.received == maxPackets)
+        loop->stop();
+    });
+    auto sender = make_udp([](size_t) {});
+    REQUIRE(receiver->listen(recvAddr));
+    REQUIRE(sender->listen(sendAddr));
+
+    std::vector<byte_t> payload(pktsize, 0x42);
+    auto keepalive = std::make_shared<int>(0);
+    loop->call_every(1ms, keepalive, [&] {
+      for (size_t n = 0; n < burst and result.sent < maxPackets; ++n)
+      {
+        sender->queue_send(recvAddr, llarp_buffer_t{payload});
+        result.sent++;
+      }
+      sender->flush();
+    });
+    loop->call_later(duration, [&] { loop->stop(); });
+
+    const auto started = std::chrono::steady_clock::now();
+    loop->run();
+    result.elapsed = std::chrono::steady_clock::now() - started;
+    result.recvStats = receiver->ExtractStatus();
+    result.sendStats = sender->ExtractStatus();
+    return result;
+  }
+}  // namespace
+
+TEST_CASE("UDP loopback delivery", "[ev][udp]")
+{
+  const bool batched = GENERATE(false, true);
+  constexpr size_t numPackets = 256;
+  const auto result = RunLoopback(batched, batched ? 4100 : 4102, 1024, 32, numPackets, 5s);
+  CHECK(result.sent == numPackets);
+  CHECK(result.received == numPackets);
+#ifdef __linux__
+  if (batched)
+  {
+    REQUIRE(result.recvStats["batched"] == true);
+    CHECK(result.recvStats["rxPackets"] == numPackets);
+    CHECK(result.sendStats["txPackets"] == numPackets);
+    // we flush once per 32 queued packets so every sendmmsg should carry more than one
+    CHECK(result.sendStats["txBatches"] < numPackets);
+  }
+#endif
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare the batched and per packet paths
+TEST_CASE("UDP loopback throughput", "[.][bench][udp]")
+{
+  constexpr size_t pktsize = 1200;
+  constexpr size_t maxPackets = 2'000'000;
+  for (const bool batched : {false, true})
+  {
+    const auto result = RunLoopback(batched, 4104, pktsize, 1024, maxPackets, 3s);
+    const auto pps = result.received / result.elapsed.count();
+    WARN(
+        (batched ? "batched" : "per packet")
+        << ": sent=" << result.sent << " received=" << result.received << " in "
+        << result.elapsed.count() << "s, " << static_cast<uint64_t>(pps) << " pkt/s, "
+        << (pps * pktsize * 8) / 1e6 << " Mbit/s, rx stats: " << result.recvStats.dump()
+        << ", tx stats: " << result.sendStats.dump());
+  }
+}
@@ -0,0 +1,196 @@
+#ifdef __linux__
+#include <catch2/catch.hpp>
+
+#include <ev/ev.hpp>
+#include <ev/udp_handle.hpp>
+#include <net/sock_addr.hpp>
+#include <util/endian.hpp>
+
+#include <sys/socket.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+  struct ShardedResult
+  {
+    size_t sent = 0;
+    size_t received = 0;
+    size_t echoed = 0;
+    size_t outOfOrder = 0;
+    bool onLoop = true;
+    std::chrono::duration<double> elapsed{};
+    /// cpu time spent by the thread running the owning loop, the one sessions would run on
+    std::chrono::duration<double> loopCPU{};
+    /// taken before the loop stops, as stopping it tears down the extra loops
+    llarp::util::StatusObject stats;
+  };
+
+  /// where a handle told to listen on port 0 ended up
+  llarp::SockAddr
+  BoundAddr(llarp::UDPHandle& udp)
+  {
+    sockaddr_storage local{};
+    socklen_t len = sizeof(local);
+    REQUIRE(udp.file_descriptor());
+    REQUIRE(
+        ::getsockname(*udp.file_descriptor(), reinterpret_cast<sockaddr*>(&local), &len) == 0);
+    return llarp::SockAddr{*reinterpret_cast<const sockaddr*>(&local)};
+  }
+
+  std::chrono::duration<double>
+  ThreadCPU()
+  {
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+  }
+
+  /// `senders` sockets each send sequenced packets of `pktsize` bytes to one socket spread over
+  /// `loops` event loops, `burst` packets per sender per millisecond, which sends every packet
+  /// back; runs until `perSender` packets from every sender have come back or `duration` passed
+  ShardedResult
+  RunSharded(
+      size_t loops,
+      size_t senders,
+      size_t pktsize,
+      size_t burst,
+      size_t perSender,
+      llarp_time_t duration)
+  {
+    ShardedResult result;
+    const size_t total = senders * perSender;
+    auto loop = llarp::EventLoop::create();
+    // the senders get a loop and thread of their own, so the owning loop's cpu time is only what
+    // the receiving side costs
+    auto senderLoop = llarp::EventLoop::create();
+    std::atomic<size_t> echoed{0};
+    std::atomic<bool> stopSenders{false};
+
+    std::shared_ptr<llarp::UDPHandle> receiver;
+    bool finished = false;
+    const auto finish = [&] {
+      if (std::exchange(finished, true))
+        return;
+      result.stats = receiver->ExtractStatus();
+      stopSenders = true;
+      loop->stop();
+    };
+
+    std::map<uint16_t, uint32_t> nextSeq;
+    receiver = loop->make_sharded_udp(
+        loops, [&](llarp::UDPHandle& udp, llarp::SockAddr src, llarp::PacketBuffer pkt) {
+          result.onLoop = result.onLoop and loop->inEventLoop();
+          if (pkt.size() != pktsize)
+            return;
+          auto& expected = nextSeq[src.getPort()];
+          if (bufbe32toh(pkt.data()) != expected)
+            result.outOfOrder++;
+          expected = bufbe32toh(pkt.data()) + 1;
+          result.received++;
+          udp.queue_send(src, llarp_buffer_t{pkt.data(), pkt.size()});
+        });
+    REQUIRE(receiver->listen(llarp::SockAddr{"127.0.0.1", 0}));
+    const auto recvAddr = BoundAddr(*receiver);
+
+    std::vector<std::shared_ptr<llarp::UDPHandle>> sockets;
+    for (size_t idx = 0; idx < senders; ++idx)
+    {
+      sockets.emplace_back(
+          senderLoop->make_udp([&](llarp::UDPHandle&, llarp::SockAddr, llarp::OwnedBuffer buf) {
+            if (buf.sz == pktsize)
+              echoed++;
+          }));
+      REQUIRE(sockets.back()->listen(llarp::SockAddr{"127.0.0.1", 0}));
+    }
+
+    std::vector<byte_t> payload(pktsize, 0x42);
+    uint32_t seq = 0;
+    auto keepalive = std::make_shared<int>(0);
+    senderLoop->call_every(1ms, keepalive, [&] {
+      if (stopSenders)
+        return senderLoop->stop();
+      for (size_t n = 0; n < burst and seq < perSender; ++n, ++seq)
+      {
+        htobe32buf(payload.data(), seq);
+        for (const auto& sender : sockets)
+        {
+          sender->send(recvAddr, llarp_buffer_t{payload});
+          result.sent++;
+        }
+      }
+    });
+    loop->call_every(1ms, keepalive, [&] {
+      receiver->flush();
+      if (result.received == total and echoed == total)
+        finish();
+    });
+    loop->call_later(duration, finish);
+
+    std::thread senderThread{[&] { senderLoop->run(); }};
+    const auto started = std::chrono::steady_clock::now();
+    const auto startedCPU = ThreadCPU();
+    loop->run();
+    result.loopCPU = ThreadCPU() - startedCPU;
+    result.elapsed = std::chrono::steady_clock::now() - started;
+    senderThread.join();
+    result.echoed = echoed;
+    return result;
+  }
+}  // namespace
+
+TEST_CASE("Sharded UDP delivers in order on the owning loop", "[ev][udp]")
+{
+  constexpr size_t senders = 16;
+  constexpr size_t perSender = 64;
+  const auto result = RunSharded(4, senders, 256, 8, perSender, 5s);
+  CHECK(result.sent == senders * perSender);
+  CHECK(result.received == senders * perSender);
+  CHECK(result.echoed == senders * perSender);
+  CHECK(result.outOfOrder == 0);
+  CHECK(result.onLoop);
+  // the kernel spreads the senders over the loops' sockets, and replies go out on all of them
+  const auto& loops = result.stats.at("loops");
+  REQUIRE(loops.size() == 4);
+  size_t receiving = 0;
+  size_t sending = 0;
+  for (const auto& stats : loops)
+  {
+    receiving += stats["rxPackets"] > 0;
+    sending += stats["txPackets"] > 0;
+  }
+  CHECK(receiving > 1);
+  CHECK(sending > 1);
+  CHECK(result.stats["dropped"] == 0);
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare one event loop with several.  the
+/// owning loop's cpu time per packet is what is left of the datagram i/o on the loop sessions run
+/// on, which is what the extra loops are there to take away
+TEST_CASE("Sharded UDP throughput", "[.][bench][udp]")
+{
+  constexpr size_t senders = 32;
+  constexpr size_t pktsize = 1200;
+  for (const size_t loops : {1, 2, 4})
+  {
+    const auto result = RunSharded(loops, senders, pktsize, 64, 20'000, 5s);
+    const auto pps = result.received / result.elapsed.count();
+    const auto cpuPerPkt = result.loopCPU.count() * 1e6 / std::max<size_t>(result.received, 1);
+    WARN(
+        loops << " loops: sent=" << result.sent << " received=" << result.received
+              << " echoed=" << result.echoed << " in " << result.elapsed.count() << "s, "
+              << static_cast<uint64_t>(pps) << " pkt/s, " << (pps * pktsize * 8) / 1e6
+              << " Mbit/s, owning loop cpu " << cpuPerPkt
+              << "us/pkt, stats: " << result.stats.dump());
+  }
+}
+#endif
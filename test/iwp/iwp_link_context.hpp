@@ -0,0 +1,187 @@
+#pragma once
+
+#include <catch2/catch.hpp>
+#include <crypto/crypto.hpp>
+#include <crypto/crypto_libsodium.hpp>
+#include <string_view>
+
+#include <router_contact.hpp>
+#include <iwp/iwp.hpp>
+#include <util/meta/memfn.hpp>
+#include <messages/link_message_parser.hpp>
+#include <util/time.hpp>
+
+#include <net/net_if.hpp>
+#include "ev/ev.hpp"
+
+/// make an iwp link
+template <bool inbound, typename... Args>
+llarp::LinkLayer_ptr
+make_link(Args&&... args)
+{
+  if (inbound)
+    return llarp::iwp::NewInboundLink(std::forward<Args>(args)...);
+  return llarp::iwp::NewOutboundLink(std::forward<Args>(args)...);
+}
+
+/// a single iwp link with associated keys and members to make unit tests work
+struct IWPLinkContext
+{
+  llarp::RouterContact rc;
+  llarp::IpAddress localAddr;
+  llarp::LinkLayer_ptr link;
+  std::shared_ptr<llarp::KeyManager> keyManager;
+  llarp::LinkMessageParser m_Parser;
+  llarp::EventLoop_ptr m_Loop;
+  /// is the test done on this context ?
+  bool gucci = false;
+
+  IWPLinkContext(std::string_view addr, llarp::EventLoop_ptr loop)
+      : localAddr{std::move(addr)}
+      , keyManager{std::make_shared<llarp::KeyManager>()}
+      , m_Parser{nullptr}
+      , m_Loop{std::move(loop)}
+  {
+    // generate keys
+    llarp::CryptoManager::instance()->identity_keygen(keyManager->identityKey);
+    llarp::CryptoManager::instance()->encryption_keygen(keyManager->encryptionKey);
+    llarp::CryptoManager::instance()->encryption_keygen(keyManager->transportKey);
+
+    // set keys in rc
+    rc.pubkey = keyManager->identityKey.toPublic();
+    rc.enckey = keyManager->encryptionKey.toPublic();
+  }
+
+  template <typename Func_t>
+  void
+  Call(Func_t work)
+  {
+    m_Loop->call_soon(std::move(work));
+  }
+
+  bool
+  HandleMessage(llarp::ILinkSession* from, llarp::ILinkSession::Message_t msg)
+  {
+    return m_Parser.ProcessFrom(from, llarp_buffer_t{msg});
+  }
+
+  /// initialize link
+  template <bool inbound>
+  void
+  InitLink(std::function<void(llarp::ILinkSession*)> established)
+  {
+    link = make_link<inbound>(
+        keyManager,
+        m_Loop,
+        // getrc
+        [&]() -> const llarp::RouterContact& { return rc; },
+        // link message handler
+        llarp::util::memFn(&IWPLinkContext::HandleMessage, this),
+        // sign buffer
+        [&](llarp::Signature& sig, const llarp_buffer_t& buf) {
+          REQUIRE(llarp::CryptoManager::instance()->sign(sig, keyManager->identityKey, buf));
+          return true;
+        },
+        // before connect
+        nullptr,
+        // established handler
+        [established](llarp::ILinkSession* s, bool linkIsInbound) {
+          REQUIRE(s != nullptr);
+          REQUIRE(inbound == linkIsInbound);
+          established(s);
+          return true;
+        },
+        // renegotiate handler
+        [](llarp::RouterContact newrc, llarp::RouterContact oldrc) {
+          REQUIRE(newrc.pubkey == oldrc.pubkey);
+          return true;
+        },
+        // timeout handler
+        [&](llarp::ILinkSession*) {
+          m_Loop->stop();
+          FAIL("session timeout");
+        },
+        // session closed handler
+        [](llarp::RouterID) {},
+        // pump done handler
+        []() {},
+        // do work function
+        [l = m_Loop](llarp::Work_t work) { l->call_soon(work); });
+    REQUIRE(link->Configure(
+        m_Loop, llarp::net::LoopbackInterfaceName(), AF_INET, *localAddr.getPort()));
+
+    if (inbound)
+    {
+      // only add address info on the recipient's rc
+      rc.addrs.emplace_back();
+      REQUIRE(link->GetOurAddressInfo(rc.addrs.back()));
+    }
+    // sign rc
+    REQUIRE(rc.Sign(keyManager->identityKey));
+    REQUIRE(keyManager != nullptr);
+  }
+};
+
+using Context_ptr = std::shared_ptr<IWPLinkContext>;
+
+/// run an iwp unit test after setup
+/// call take 2 parameters, test and a timeout
+///
+/// test is a callable that takes 5 arguments:
+/// 0) std::function<EventLoop_ptr(void)> that starts the iwp links and gives an event loop to call with
+/// 1) std::function<void(void)> that ends the unit test if we are done
+/// 2) std::function<void(void)> that ends the unit test right now as a success
+/// 3) client iwp link context (shared_ptr)
+/// 4) relay iwp link context (shared_ptr)
+///
+/// timeout is a std::chrono::duration that tells the driver how long to run the unit test for
+/// before it should assume failure of unit test
+template <typename Func_t, typename Duration_t = std::chrono::milliseconds>
+void
+RunIWPTest(Func_t test, Duration_t timeout = 10s)
+{
+  // shut up logs
+  llarp::LogSilencer shutup;
+  // set up event loop
+  auto loop = llarp::EventLoop::create();
+
+  llarp::LogContext::Instance().Initialize(
+      llarp::eLogDebug, llarp::LogType::File, "stdout", "unit test", [loop](auto work) {
+        loop->call_soon(work);
+      });
+
+  // turn off bogon blocking
+  auto oldBlockBogons = llarp::RouterContact::BlockBogons;
+  llarp::RouterContact::BlockBogons = false;
+
+  // set up cryptography
+  llarp::sodium::CryptoLibSodium crypto{};
+  llarp::CryptoManager manager{&crypto};
+
+  // set up client
+  auto initiator = std::make_shared<IWPLinkContext>("127.0.0.1:3001", loop);
+  // set up server
+  auto recipient = std::make_shared<IWPLinkContext>("127.0.0.1:3002", loop);
+
+  // function for ending unit test on success
+  auto endIfDone = [initiator, recipient, loop]() {
+    if (initiator->gucci and recipient->gucci)
+    {
+      loop->stop();
+    }
+  };
+  // function to start test and give loop to unit test
+  auto start = [initiator, recipient, loop]() {
+    REQUIRE(initiator->link->Start());
+    REQUIRE(recipient->link->Start());
+    return loop;
+  };
+
+  // function to end test immediately
+  auto endTest = [loop] { loop->stop(); };
+
+  loop->call_later(timeout, [] { FAIL("test timeout"); });
+  test(start, endIfDone, endTest, initiator, recipient);
+  loop->run();
+  llarp::RouterContact::BlockBogons = oldBlockBogons;
+}
@@ -0,0 +1,193 @@
+#include <net/address_table.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using llarp::AlignedBuffer;
+using llarp::huint128_t;
+using llarp::net::AddressTable;
+
+namespace
+{
+  AlignedBuffer<32>
+  Remote(std::mt19937_64& rng)
+  {
+    AlignedBuffer<32> remote;
+    for (size_t idx = 0; idx < remote.size(); ++idx)
+      remote.data()[idx] = rng();
+    return remote;
+  }
+
+  huint128_t
+  IP(uint64_t n)
+  {
+    return huint128_t{llarp::uint128_t{0, 0x0000'ffff'0a00'0000UL + n}};
+  }
+}  // namespace
+
+TEST_CASE("AddressTable hands out every ip in its range once", "[net]")
+{
+  std::mt19937_64 rng{1};
+  AddressTable table{rng()};
+  table.SetRange(IP(1), IP(10));
+  // someone mapped an ip in the middle of the range by hand
+  const auto manual = Remote(rng);
+  table.Map(IP(5), manual, true);
+
+  std::vector<AlignedBuffer<32>> remotes;
+  for (int n = 1; n <= 9; ++n)
+  {
+    remotes.emplace_back(Remote(rng));
+    const auto* entry = table.Allocate(remotes.back(), false);
+    REQUIRE(entry);
+    CHECK(entry->ip == IP(n < 5 ? n : n + 1));
+    CHECK(entry->remote == remotes.back());
+    CHECK_FALSE(entry->snode);
+  }
+  CHECK_FALSE(table.Allocate(Remote(rng), false));
+  CHECK(table.Size() == 10);
+
+  REQUIRE(table.FindByIP(IP(5)));
+  CHECK(table.FindByIP(IP(5))->remote == manual);
+  CHECK(table.FindByIP(IP(5))->snode);
+  CHECK(table.FindByRemote(remotes[3])->ip == IP(4));
+  CHECK_FALSE(table.FindByIP(IP(11)));
+
+  // released ips get handed out again
+  CHECK(table.EraseRemote(remotes[3]));
+  CHECK_FALSE(table.FindByIP(IP(4)));
+  CHECK_FALSE(table.FindByRemote(remotes[3]));
+  CHECK_FALSE(table.EraseIP(IP(4)));
+  const auto again = Remote(rng);
+  REQUIRE(table.Allocate(again, false));
+  CHECK(table.FindByRemote(again)->ip == IP(4));
+
+  // mapping by hand takes the ip and remote away from whatever had them
+  table.Map(IP(7), again, false);
+  CHECK(table.FindByRemote(again)->ip == IP(7));
+  CHECK_FALSE(table.FindByIP(IP(4)));
+  CHECK(table.Size() == 9);
+}
+
+TEST_CASE("AddressTable finds the least active entry", "[net]")
+{
+  std::mt19937_64 rng{2};
+  AddressTable table{rng()};
+  table.SetRange(IP(1), IP(100));
+  CHECK_FALSE(table.LeastActive());
+  table.Map(IP(0), Remote(rng), false).lastActive = llarp_time_t::max();
+  CHECK_FALSE(table.LeastActive());
+  for (int n = 0; n < 50; ++n)
+    table.Allocate(Remote(rng), false)->lastActive = llarp_time_t{1000 - n};
+  REQUIRE(table.LeastActive());
+  CHECK(table.LeastActive()->lastActive == llarp_time_t{951});
+  CHECK(table.LeastActive()->ip == IP(50));
+}
+
+TEST_CASE("AddressTable agrees with a pair of maps", "[net]")
+{
+  std::mt19937_64 rng{3};
+  AddressTable table{rng()};
+  table.SetRange(IP(1), IP(5000));
+  std::unordered_map<huint128_t, AlignedBuffer<32>> byIP;
+  std::unordered_map<AlignedBuffer<32>, huint128_t, AlignedBuffer<32>::Hash> byRemote;
+  std::vector<AlignedBuffer<32>> known;
+
+  for (int step = 0; step < 100'000; ++step)
+  {
+    const auto op = rng() % 3;
+    if (op == 0 or known.empty())
+    {
+      const auto remote = Remote(rng);
+      const auto* entry = table.Allocate(remote, false);
+      if (entry == nullptr)
+      {
+        REQUIRE(byIP.size() == 5000);
+        continue;
+      }
+      REQUIRE(byIP.count(entry->ip) == 0);
+      byIP[entry->ip] = remote;
+      byRemote[remote] = entry->ip;
+      known.emplace_back(remote);
+    }
+    else if (op == 1)
+    {
+      const auto remote = known[rng() % known.size()];
+      const bool erased = table.EraseRemote(remote);
+      REQUIRE(erased == (byRemote.count(remote) == 1));
+      if (erased)
+      {
+        byIP.erase(byRemote[remote]);
+        byRemote.erase(remote);
+      }
+    }
+    else
+    {
+      const auto ip = IP(rng() % 5002);
+      const auto* entry = table.FindByIP(ip);
+      const auto itr = byIP.find(ip);
+      REQUIRE((entry != nullptr) == (itr != byIP.end()));
+      if (entry)
+      {
+        REQUIRE(entry->remote == itr->second);
+        REQUIRE(table.FindByRemote(itr->second) == entry);
+      }
+    }
+    REQUIRE(table.Size() == byIP.size());
+  }
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare against the unordered_maps the
+/// endpoints used before
+TEST_CASE("AddressTable lookup speed", "[.][bench][net]")
+{
+  std::mt19937_64 rng{4};
+  for (const size_t numClients : {10'000, 100'000})
+  {
+    AddressTable table{rng()};
+    table.SetRange(IP(1), IP(numClients));
+    std::unordered_map<huint128_t, AlignedBuffer<32>> byIP;
+    std::unordered_map<AlignedBuffer<32>, huint128_t, AlignedBuffer<32>::Hash> byRemote;
+    std::unordered_map<huint128_t, llarp_time_t> activity;
+    std::vector<AlignedBuffer<32>> remotes;
+    for (size_t idx = 0; idx < numClients; ++idx)
+    {
+      remotes.emplace_back(Remote(rng));
+      const auto ip = table.Allocate(remotes.back(), false)->ip;
+      byIP[ip] = remotes.back();
+      byRemote[remotes.back()] = ip;
+      activity[ip] = 0s;
+    }
+    std::vector<size_t> order;
+    for (int idx = 0; idx < 2'000'000; ++idx)
+      order.emplace_back(rng() % numClients);
+
+    // what a packet each way costs: look up the remote by ip and the ip by remote, and mark
+    // the ip active
+    auto start = std::chrono::steady_clock::now();
+    for (const auto n : order)
+    {
+      auto* entry = table.FindByIP(IP(n + 1));
+      entry->lastActive = std::max(entry->lastActive, llarp_time_t{n});
+      table.FindByRemote(remotes[n])->lastActive = llarp_time_t{n};
+    }
+    const std::chrono::duration<double, std::nano> flat = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (const auto n : order)
+    {
+      const auto& remote = byIP.at(IP(n + 1));
+      activity[byRemote.at(remote)] = std::max(activity[IP(n + 1)], llarp_time_t{n});
+      activity[byRemote.at(remotes[n])] = llarp_time_t{n};
+    }
+    const std::chrono::duration<double, std::nano> maps = std::chrono::steady_clock::now() - start;
+
+    WARN(
+        numClients << " clients: " << flat.count() / order.size() << "ns per packet pair, "
+                   << maps.count() / order.size() << "ns with unordered_maps");
+  }
+}
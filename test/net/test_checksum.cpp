@@ -0,0 +1,324 @@
+#include <net/checksum.hpp>
+#include <net/ip.hpp>
+#include <net/ip_packet.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using llarp::net::ChecksumFold;
+using llarp::net::ChecksumKernels;
+
+namespace
+{
+  /// ipchksum as it was before the kernels, a 16 bit word at a time
+  uint16_t
+  ReferenceChecksum(const byte_t* buf, size_t sz, uint32_t sum)
+  {
+    while (sz > 1)
+    {
+      uint16_t word;
+      std::memcpy(&word, buf, sizeof(word));
+      sum += word;
+      sz -= sizeof(uint16_t);
+      buf += sizeof(uint16_t);
+    }
+    if (sz != 0)
+    {
+      uint16_t x = 0;
+      *(byte_t*)&x = *buf;
+      sum += x;
+    }
+    sum = (sum & 0xFFff) + (sum >> 16);
+    sum += sum >> 16;
+    return uint16_t((~sum) & 0xFFff);
+  }
+
+  using llarp::huint128_t;
+  using llarp::net::IPPacket;
+
+  /// where the l4 header of a packet made by MakePacket starts
+  size_t
+  L4Offset(const IPPacket& pkt)
+  {
+    if (pkt.IsV4())
+      return 20;
+    // a hop by hop options header comes first when the next header field says so
+    return pkt.buf[6] == 0 ? 48 : 40;
+  }
+
+  /// checksum of the l4 part of pkt with its pseudo header, 0 if the checksum in it is right
+  uint16_t
+  L4Checksum(const IPPacket& pkt)
+  {
+    const size_t l4 = L4Offset(pkt);
+    const size_t len = pkt.sz - l4;
+    std::vector<byte_t> pseudo;
+    if (pkt.IsV4())
+    {
+      pseudo.assign(pkt.buf + 12, pkt.buf + 20);
+      pseudo.insert(pseudo.end(), {0, pkt.buf[9], byte_t(len >> 8), byte_t(len)});
+    }
+    else
+    {
+      pseudo.assign(pkt.buf + 8, pkt.buf + 40);
+      pseudo.insert(pseudo.end(), {0, 0, byte_t(len >> 8), byte_t(len), 0, 0, 0, 0});
+      pseudo.back() = pkt.buf[6] == 0 ? pkt.buf[40] : pkt.buf[6];
+    }
+    pseudo.insert(pseudo.end(), pkt.buf + l4, pkt.buf + pkt.sz);
+    return llarp::net::ipchksum(pseudo.data(), pseudo.size());
+  }
+
+  /// a tcp or udp packet of either family with random addresses from a small set, so that runs
+  /// of them share addresses, and every checksum filled in
+  IPPacket
+  MakePacket(std::mt19937_64& rng, size_t payload)
+  {
+    IPPacket pkt{};
+    const bool v4 = rng() % 2;
+    const bool tcp = rng() % 2;
+    const size_t l4Len = (tcp ? 20 : 8) + payload;
+    size_t l4 = 20;
+    if (v4)
+    {
+      const byte_t hdr[20] = {0x45, 0, byte_t((20 + l4Len) >> 8), byte_t(20 + l4Len), 0, 1, 0, 0,
+                              64, byte_t(tcp ? 6 : 17), 0, 0, 10, 0, 0, byte_t(rng() % 3), 10, 0,
+                              byte_t(rng() % 3), 1};
+      std::copy(hdr, hdr + sizeof(hdr), pkt.buf);
+    }
+    else
+    {
+      l4 = rng() % 4 ? 40 : 48;
+      pkt.buf[0] = 0x60;
+      pkt.buf[4] = (l4 - 40 + l4Len) >> 8;
+      pkt.buf[5] = l4 - 40 + l4Len;
+      pkt.buf[6] = l4 == 48 ? 0 : (tcp ? 6 : 17);
+      pkt.buf[7] = 64;
+      pkt.buf[8] = pkt.buf[24] = 0xfd;
+      pkt.buf[23] = rng() % 3;
+      pkt.buf[39] = rng() % 3;
+      if (l4 == 48)
+        pkt.buf[40] = tcp ? 6 : 17;
+    }
+    pkt.sz = l4 + l4Len;
+    for (size_t idx = l4; idx < pkt.sz; ++idx)
+      pkt.buf[idx] = rng();
+    const size_t check = l4 + (tcp ? 16 : 6);
+    pkt.buf[check] = pkt.buf[check + 1] = 0;
+    if (tcp)
+      pkt.buf[l4 + 12] = 5 << 4;
+    else
+    {
+      pkt.buf[l4 + 4] = l4Len >> 8;
+      pkt.buf[l4 + 5] = l4Len;
+    }
+    auto sum = L4Checksum(pkt);
+    // udp sends an all zero checksum as all ones
+    if (sum == 0 and not tcp)
+      sum = 0xffff;
+    std::memcpy(pkt.buf + check, &sum, sizeof(sum));
+    if (v4)
+    {
+      const auto hdrSum = llarp::net::ipchksum(pkt.buf, 20);
+      std::memcpy(pkt.buf + 10, &hdrSum, sizeof(hdrSum));
+    }
+    return pkt;
+  }
+
+  huint128_t
+  RandomAddress(std::mt19937_64& rng)
+  {
+    // a few addresses, v4 mapped ones among them
+    const uint64_t pick = rng() % 4;
+    if (pick == 0)
+      return huint128_t{0};
+    if (pick == 1)
+      return huint128_t{llarp::uint128_t{0, 0xffff'0a00'0000 + rng() % 3}};
+    return huint128_t{llarp::uint128_t{0xfd00'0000'0000'0000, rng() % 3}};
+  }
+}  // namespace
+
+TEST_CASE("Checksum kernels agree with the scalar checksum", "[net]")
+{
+  std::mt19937_64 rng{42};
+  std::vector<byte_t> data(70'000);
+  for (auto& byte : data)
+    byte = rng();
+  // runs of 0xff push the sums through every carry
+  std::fill(data.begin() + 1000, data.begin() + 5000, 0xff);
+
+  for (int round = 0; round < 5000; ++round)
+  {
+    // mostly packet sized, sometimes as big as a gso packet, at every alignment
+    const size_t sz = round % 10 ? rng() % 1600 : rng() % 65536;
+    const size_t offset = rng() % (data.size() - sz);
+    const uint32_t seed = round % 3 ? 0 : rng() % 0x40000;
+    const auto* buf = data.data() + offset;
+
+    const auto expect = ReferenceChecksum(buf, sz, seed);
+    REQUIRE(llarp::net::ipchksum(buf, sz, seed) == expect);
+    for (const auto& kernel : ChecksumKernels())
+    {
+      INFO(kernel.name << " over " << sz << " bytes at " << offset);
+      REQUIRE(uint16_t(~ChecksumFold(kernel.partial(buf, sz, seed))) == expect);
+    }
+  }
+}
+
+TEST_CASE("Checksum of a checksummed header is zero", "[net]")
+{
+  // an ipv4 header with its checksum filled in sums to all ones
+  byte_t hdr[20] = {0x45, 0, 0, 60, 0x1c, 0x46, 0x40, 0, 0x40, 6, 0, 0, 0xac, 0x10, 0x0a, 0x63,
+                    0xac, 0x10, 0x0a, 0x0c};
+  const uint16_t check = llarp::net::ipchksum(hdr, sizeof(hdr));
+  std::memcpy(hdr + 10, &check, sizeof(check));
+  CHECK(hdr[10] == 0xb1);
+  CHECK(hdr[11] == 0xe6);
+  CHECK(llarp::net::ipchksum(hdr, sizeof(hdr)) == 0);
+}
+
+TEST_CASE("Rewriting a queue of addresses matches rewriting them one at a time", "[net]")
+{
+  std::mt19937_64 rng{1234};
+  for (int round = 0; round < 200; ++round)
+  {
+    // flushes where runs of packets share their old and new addresses, as they do per remote
+    std::vector<IPPacket> one, queued;
+    std::vector<std::pair<huint128_t, huint128_t>> addrs;
+    llarp::net::AddressRewriter rewriter;
+    huint128_t src, dst;
+    const size_t num = 1 + rng() % 64;
+    for (size_t idx = 0; idx < num; ++idx)
+      one.push_back(MakePacket(rng, rng() % 1000));
+    queued = one;
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      if (idx == 0 or rng() % 4 == 0)
+      {
+        src = RandomAddress(rng);
+        dst = RandomAddress(rng);
+      }
+      auto& pkt = one[idx];
+      if (pkt.IsV4())
+      {
+        pkt.UpdateIPv4Address(
+            llarp::xhtonl(llarp::net::TruncateV6(src)), llarp::xhtonl(llarp::net::TruncateV6(dst)));
+      }
+      else
+        pkt.UpdateIPv6Address(src, dst);
+      addrs.emplace_back(src, dst);
+      rewriter.Rewrite(queued[idx], src, dst);
+    }
+
+    for (size_t idx = 0; idx < num; ++idx)
+    {
+      INFO("packet " << idx << " of round " << round);
+      REQUIRE(one[idx].sz == queued[idx].sz);
+      REQUIRE(std::memcmp(one[idx].buf, queued[idx].buf, one[idx].sz) == 0);
+      CHECK(L4Checksum(queued[idx]) == 0);
+      if (queued[idx].IsV4())
+      {
+        CHECK(queued[idx].dstv4() == llarp::net::TruncateV6(addrs[idx].second));
+        CHECK(llarp::net::ipchksum(queued[idx].buf, 20) == 0);
+      }
+      else
+        CHECK(queued[idx].srcv6() == addrs[idx].first);
+    }
+  }
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare the kernels
+TEST_CASE("Checksum speed", "[.][bench][net]")
+{
+  std::mt19937_64 rng{7};
+  std::vector<byte_t> data(65536);
+  for (auto& byte : data)
+    byte = rng();
+
+  for (const size_t sz : {64, 1500, 65535})
+  {
+    const size_t rounds = (256 << 20) / sz;
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t idx = 0; idx < rounds; ++idx)
+      sink += ReferenceChecksum(data.data() + (idx & 1), sz, 0);
+    const std::chrono::duration<double> reference = std::chrono::steady_clock::now() - start;
+    WARN(sz << " bytes, 16 bit words: " << (rounds * sz >> 20) / reference.count() << " MiB/s");
+
+    for (const auto& kernel : ChecksumKernels())
+    {
+      start = std::chrono::steady_clock::now();
+      for (size_t idx = 0; idx < rounds; ++idx)
+        sink += ChecksumFold(kernel.partial(data.data() + (idx & 1), sz, 0));
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      WARN(sz << " bytes, " << kernel.name << ": " << (rounds * sz >> 20) / elapsed.count()
+              << " MiB/s");
+    }
+    CHECK(sink != 1);
+  }
+}
+
+/// not run by default; run with `testAll "[bench]"` to see what rewriting a whole flush with one
+/// AddressRewriter saves over rewriting every packet on its own
+TEST_CASE("Address rewrite speed", "[.][bench][net]")
+{
+  std::mt19937_64 rng{99};
+  constexpr size_t flush = 64;
+  constexpr size_t rounds = 100'000;
+  const huint128_t ours{llarp::uint128_t{0xfd00'0000'0000'0000, 1}};
+  const huint128_t remote{llarp::uint128_t{0xfd00'0000'0000'0000, 2}};
+  for (const bool v4 : {true, false})
+  {
+    std::vector<IPPacket> pkts;
+    while (pkts.size() < flush)
+    {
+      if (auto pkt = MakePacket(rng, 1200); pkt.IsV4() == v4)
+        pkts.push_back(pkt);
+    }
+    // what a flush of packets from one remote looks like: zeroed by the sender, then given the
+    // remote's address and ours
+    const auto target = [&](size_t round) {
+      return round % 2 ? std::make_pair(remote, ours)
+                       : std::make_pair(huint128_t{0}, huint128_t{0});
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round)
+    {
+      const auto [src, dst] = target(round);
+      for (auto& pkt : pkts)
+      {
+        if (v4)
+        {
+          pkt.UpdateIPv4Address(
+              llarp::xhtonl(llarp::net::TruncateV6(src)),
+              llarp::xhtonl(llarp::net::TruncateV6(dst)));
+        }
+        else
+          pkt.UpdateIPv6Address(src, dst);
+      }
+    }
+    const std::chrono::duration<double, std::nano> single =
+        std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round)
+    {
+      const auto [src, dst] = target(round);
+      llarp::net::AddressRewriter rewriter;
+      for (auto& pkt : pkts)
+        rewriter.Rewrite(pkt, src, dst);
+    }
+    const std::chrono::duration<double, std::nano> rewritten =
+        std::chrono::steady_clock::now() - start;
+
+    CHECK(L4Checksum(pkts[0]) == 0);
+    WARN(
+        (v4 ? "ipv4" : "ipv6") << ": " << single.count() / (rounds * flush)
+                               << "ns per packet one at a time, "
+                               << rewritten.count() / (rounds * flush) << "ns with one rewriter");
+  }
+}
@@ -0,0 +1,167 @@
+#include <net/ip_range_map.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using llarp::IPRange;
+using llarp::huint128_t;
+using llarp::net::IPRangeMap;
+
+namespace
+{
+  IPRange
+  Range(const std::string& str)
+  {
+    IPRange range;
+    REQUIRE(range.FromString(str));
+    return range;
+  }
+
+  huint128_t
+  IP(const std::string& str)
+  {
+    return Range(str).addr;
+  }
+
+  /// a random range, ipv4 three times out of four
+  IPRange
+  RandomRange(std::mt19937_64& rng)
+  {
+    if (rng() % 4)
+    {
+      const auto bits = 8 + rng() % 25;
+      const uint32_t ip = rng();
+      return IPRange{
+          llarp::net::ExpandV4(llarp::huint32_t{ip}), llarp::netmask_ipv6_bits(96 + bits)};
+    }
+    const auto bits = 16 + rng() % 113;
+    return IPRange{
+        huint128_t{llarp::uint128_t{0xfd00'0000'0000'0000UL | (rng() >> 8), rng()}},
+        llarp::netmask_ipv6_bits(bits)};
+  }
+
+  /// a random address, close to one of the ranges most of the time so lookups hit something
+  huint128_t
+  RandomIP(std::mt19937_64& rng, const std::vector<IPRange>& ranges)
+  {
+    auto ip = ranges[rng() % ranges.size()].addr;
+    ip.h.lower ^= rng() & 0xffff;
+    return ip;
+  }
+}  // namespace
+
+TEST_CASE("IPRangeMap longest match", "[net]")
+{
+  IPRangeMap<int> map;
+  map.Insert(Range("::/0"), 0);
+  map.Insert(Range("10.0.0.0/8"), 1);
+  map.Insert(Range("10.1.0.0/16"), 2);
+  map.Insert(Range("10.1.2.0/24"), 3);
+  map.Insert(Range("10.1.2.0/24"), 4);
+  map.Insert(Range("fd00::/8"), 5);
+
+  CHECK(map.FindLongest(IP("10.1.2.3/32")) == 3);
+  CHECK(map.FindLongest(IP("10.1.3.3/32")) == 2);
+  CHECK(map.FindLongest(IP("10.2.0.1/32")) == 1);
+  CHECK(map.FindLongest(IP("192.168.0.1/32")) == 0);
+  CHECK(map.FindLongest(IP("fd00::1/128")) == 5);
+  CHECK(map.FindLongest(IP("fe00::1/128")) == 0);
+
+  CHECK(map.FindAll(IP("10.1.2.3/32")) == std::set<int>{0, 1, 2, 3, 4});
+  CHECK(map.FindAll(IP("fd00::1/128")) == std::set<int>{0, 5});
+  CHECK(map.Matches(IP("10.1.2.3/32"), 1));
+  CHECK_FALSE(map.Matches(IP("10.2.0.1/32"), 2));
+
+  auto snapshot = map.Table();
+  map.RemoveIf([](const auto& entry) { return entry.second == 0; });
+  CHECK_FALSE(map.FindLongest(IP("192.168.0.1/32")));
+  CHECK(map.FindAll(IP("10.1.2.3/32")) == std::set<int>{1, 2, 3, 4});
+  // an old table does not see later changes
+  CHECK(*snapshot->FindLongest(IP("192.168.0.1/32")) == 0);
+
+  map.Insert(Range("10.1.2.128/25"), 6);
+  CHECK(map.FindLongest(IP("10.1.2.200/32")) == 6);
+  CHECK(map.FindLongest(IP("10.1.2.100/32")) == 3);
+}
+
+TEST_CASE("IPRangeMap agrees with a linear scan", "[net]")
+{
+  std::mt19937_64 rng{1234};
+  IPRangeMap<int> map;
+  std::vector<IPRange> ranges;
+  for (int idx = 0; idx < 2000; ++idx)
+  {
+    ranges.emplace_back(RandomRange(rng));
+    map.Insert(ranges.back(), idx);
+  }
+
+  for (int idx = 0; idx < 20000; ++idx)
+  {
+    const auto ip = RandomIP(rng, ranges);
+    std::set<int> all;
+    std::optional<int> longest;
+    int longestBits = -1;
+    for (size_t val = 0; val < ranges.size(); ++val)
+    {
+      if (not ranges[val].Contains(ip))
+        continue;
+      all.insert(val);
+      const int bits = llarp::bits::count_bits(ranges[val].netmask_bits);
+      if (bits > longestBits)
+      {
+        longestBits = bits;
+        longest = val;
+      }
+    }
+    REQUIRE(map.FindAll(ip) == all);
+    // ties go to the smaller value, which is the one we saw first
+    REQUIRE(map.FindLongest(ip) == longest);
+  }
+}
+
+/// not run by default; run with `testAll "[bench]"` to compare against scanning every range
+TEST_CASE("IPRangeMap lookup speed", "[.][bench][net]")
+{
+  std::mt19937_64 rng{5678};
+  for (const size_t numRanges : {10'000, 100'000})
+  {
+    IPRangeMap<int> map;
+    std::vector<IPRange> ranges;
+    for (size_t idx = 0; idx < numRanges; ++idx)
+    {
+      ranges.emplace_back(RandomRange(rng));
+      map.Insert(ranges.back(), idx);
+    }
+    std::vector<huint128_t> ips;
+    for (int idx = 0; idx < 1'000'000; ++idx)
+      ips.emplace_back(RandomIP(rng, ranges));
+
+    auto start = std::chrono::steady_clock::now();
+    map.Table();
+    const std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - start;
+
+    size_t hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& ip : ips)
+      hits += map.FindLongest(ip).has_value();
+    const std::chrono::duration<double, std::nano> table = std::chrono::steady_clock::now() - start;
+    CHECK(hits > 0);
+
+    // the old lookup, on a sample as it is far too slow to do them all
+    constexpr size_t sample = 1000;
+    start = std::chrono::steady_clock::now();
+    for (size_t idx = 0; idx < sample; ++idx)
+    {
+      for (const auto& range : ranges)
+        hits += range.Contains(ips[idx]);
+    }
+    const std::chrono::duration<double, std::nano> scan = std::chrono::steady_clock::now() - start;
+
+    WARN(
+        numRanges << " ranges: built in " << build.count() << "ms, " << table.count() / ips.size()
+                  << "ns per lookup, linear scan " << scan.count() / sample << "ns per lookup");
+  }
+}
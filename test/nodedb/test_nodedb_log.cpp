@@ -0,0 +1,217 @@
+#include <nodedb.hpp>
+#include <nodedb_log.hpp>
+
+#include <crypto/crypto.hpp>
+#include <llarp_test.hpp>
+#include <test_util.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  struct NodeDBLogTest : public test::LlarpTest<>
+  {
+    const fs::path file{test::randFilename()};
+    test::FileGuard guard{file};
+
+    RouterContact
+    MakeRC(std::string nick = "")
+    {
+      SecretKey sign, encr;
+      CryptoManager::instance()->identity_keygen(sign);
+      CryptoManager::instance()->encryption_keygen(encr);
+      RouterContact rc;
+      rc.pubkey = sign.toPublic();
+      rc.enckey = encr.toPublic();
+      rc.SetNick(nick);
+      REQUIRE(rc.Sign(sign));
+      return rc;
+    }
+
+    /// load into a map, keeping everything
+    std::map<RouterID, std::pair<RouterContact, bool>>
+    LoadAll(NodeDBLog& log)
+    {
+      std::map<RouterID, std::pair<RouterContact, bool>> loaded;
+      REQUIRE(log.Load([&loaded](const auto& rcs, const auto& checked) {
+        for (size_t idx = 0; idx < rcs.size(); ++idx)
+          loaded.emplace(RouterID(rcs[idx].pubkey), std::make_pair(rcs[idx], bool{checked[idx]}));
+        return std::vector<bool>(rcs.size(), true);
+      }));
+      return loaded;
+    }
+  };
+}  // namespace
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog keeps the newest rc per router", "[nodedb]")
+{
+  const auto a = MakeRC("a"), b = MakeRC("b");
+  {
+    NodeDBLog log{file};
+    REQUIRE(LoadAll(log).empty());
+    REQUIRE(log.Append({a, b}, {}));
+    auto newer = a;
+    newer.SetNick("newer");
+    REQUIRE(log.Append({newer}, {}));
+    REQUIRE(log.Append({}, {b.pubkey}));
+  }
+  NodeDBLog log{file};
+  const auto loaded = LoadAll(log);
+  REQUIRE(loaded.size() == 1);
+  const auto& rc = loaded.at(a.pubkey).first;
+  CHECK(rc.Nick() == "newer");
+  CHECK(log.LiveBytes() < log.FileSize());
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog remembers checked signatures", "[nodedb]")
+{
+  const auto rc = MakeRC();
+  {
+    // as a flush does with an rc that was put in the nodedb
+    NodeDBLog log{file};
+    REQUIRE(log.Append({rc}, {}));
+  }
+  {
+    NodeDBLog log{file};
+    auto loaded = LoadAll(log);
+    REQUIRE(loaded.size() == 1);
+    CHECK(loaded.begin()->second.second);
+    REQUIRE(log.Compact());
+  }
+  // and so does a compacted file
+  NodeDBLog log{file};
+  CHECK(LoadAll(log).begin()->second.second);
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDB carries per rc files over to a single file", "[nodedb]")
+{
+  const auto countFiles = [this] {
+    return std::count_if(
+        fs::recursive_directory_iterator{file},
+        fs::recursive_directory_iterator{},
+        [](const auto& entry) { return entry.path().extension() == ".signed"; });
+  };
+  const auto rc = MakeRC();
+  {
+    NodeDB nodedb{file, nullptr};
+    nodedb.Put(rc);
+    nodedb.SaveToDisk();
+  }
+  REQUIRE(countFiles() == 1);
+
+  {
+    NodeDB nodedb{file, nullptr, true};
+    nodedb.LoadFromDisk();
+    CHECK(nodedb.NumLoaded() == 1);
+  }
+  CHECK(countFiles() == 0);
+
+  NodeDB nodedb{file, nullptr, true};
+  nodedb.LoadFromDisk();
+  CHECK(nodedb.Has(rc.pubkey));
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog drops a torn record at the end", "[nodedb]")
+{
+  const auto a = MakeRC(), b = MakeRC();
+  size_t goodSize;
+  {
+    NodeDBLog log{file};
+    REQUIRE(log.Append({a}, {}));
+    goodSize = log.FileSize();
+    REQUIRE(log.Append({b}, {}));
+  }
+  // part of b's rc made it out before the crash
+  fs::resize_file(file, goodSize + 10);
+
+  NodeDBLog log{file};
+  const auto loaded = LoadAll(log);
+  CHECK(loaded.size() == 1);
+  CHECK(loaded.count(a.pubkey) == 1);
+  CHECK(fs::file_size(file) == goodSize);
+
+  // and appends carry on from there
+  REQUIRE(log.Append({b}, {}));
+  NodeDBLog reloaded{file};
+  CHECK(LoadAll(reloaded).size() == 2);
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog skips a damaged record in the middle", "[nodedb]")
+{
+  const auto a = MakeRC(), b = MakeRC(), c = MakeRC();
+  size_t damageAt, fileSize;
+  {
+    NodeDBLog log{file};
+    REQUIRE(log.Append({a}, {}));
+    damageAt = log.FileSize() + 50;
+    REQUIRE(log.Append({b}, {}));
+    REQUIRE(log.Append({c}, {}));
+    fileSize = log.FileSize();
+  }
+  // scribble on b's rc
+  {
+    std::fstream f{file.string(), std::ios::binary | std::ios::in | std::ios::out};
+    f.seekg(damageAt);
+    const auto ch = f.get();
+    f.seekp(damageAt);
+    f.put(static_cast<char>(ch ^ 0xff));
+  }
+
+  NodeDBLog log{file};
+  const auto loaded = LoadAll(log);
+  CHECK(loaded.size() == 2);
+  CHECK(loaded.count(a.pubkey) == 1);
+  CHECK(loaded.count(c.pubkey) == 1);
+  // the good records after it are kept
+  CHECK(fs::file_size(file) == fileSize);
+  CHECK(log.FileSize() == fileSize);
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog refuses files that are not a log", "[nodedb]")
+{
+  {
+    std::ofstream f{file.string()};
+    f << "d1:k32:";
+  }
+  NodeDBLog log{file};
+  CHECK_FALSE(log.Load([](const auto& rcs, const auto&) { return std::vector<bool>(rcs.size()); }));
+}
+
+TEST_CASE_METHOD(NodeDBLogTest, "NodeDBLog compacts to only the live records", "[nodedb]")
+{
+  std::vector<RouterContact> rcs;
+  for (size_t idx = 0; idx < 20; ++idx)
+    rcs.push_back(MakeRC());
+  NodeDBLog log{file};
+  for (size_t round = 0; round < 5; ++round)
+    REQUIRE(log.Append(rcs, {}));
+  REQUIRE(log.Append({}, {rcs[0].pubkey, rcs[1].pubkey}));
+
+  // a dropped rc is left out of the compacted file
+  REQUIRE(log.Load([&rcs](const auto& loaded, const auto&) {
+    std::vector<bool> keep;
+    for (const auto& rc : loaded)
+      keep.push_back(not(rc.pubkey == rcs[2].pubkey));
+    return keep;
+  }));
+  const auto before = log.FileSize();
+  REQUIRE(log.Compact());
+  CHECK(log.FileSize() < before);
+  CHECK(fs::file_size(file) == log.FileSize());
+
+  NodeDBLog reloaded{file};
+  const auto loaded = LoadAll(reloaded);
+  CHECK(loaded.size() == rcs.size() - 3);
+  for (const auto& [id, item] : loaded)
+  {
+    // all of them were marked as checked when they were appended
+    CHECK(item.second);
+    CHECK(item.first.Verify(time_now_ms()));
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <path/hop_index.hpp>
+#include <net/ip.hpp>
+#include <net/net_bits.hpp>
+#include <router_contact.hpp>
+
+#include <deque>
+
+namespace llarp::test
+{
+  /// a router whose id starts with id and whose one address is 10.<net>.<id>
+  inline RouterContact
+  MakeRouter(uint16_t id, uint8_t net)
+  {
+    RouterContact rc;
+    rc.pubkey[0] = id & 0xff;
+    rc.pubkey[1] = id >> 8;
+    AddressInfo addr;
+    addr.ip = net::HUIntToIn6(net::ExpandV4(ipaddr_ipv4_bits(10, net, id >> 8, id & 0xff)));
+    rc.addrs.emplace_back(std::move(addr));
+    return rc;
+  }
+
+  /// the index refers to rcs where they are, so keep them in a container that does not move them
+  struct Routers
+  {
+    std::deque<RouterContact> rcs;
+    path::HopIndex index;
+
+    const RouterContact&
+    Add(uint16_t id, uint8_t net)
+    {
+      const auto& rc = rcs.emplace_back(MakeRouter(id, net));
+      index.Insert(rc);
+      return rc;
+    }
+  };
+}  // namespace llarp::test
@@ -0,0 +1,160 @@
+#include "hop_index_routers.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <map>
+#include <set>
+
+using llarp::RouterContact;
+using llarp::path::HopIndex;
+using llarp::test::MakeRouter;
+using llarp::test::Routers;
+
+TEST_CASE("Hop picks are distinct and skip bad routers", "[path][hops]")
+{
+  Routers routers;
+  for (uint16_t id = 1; id <= 20; ++id)
+    routers.Add(id, id);
+  routers.index.RefreshBad([](const llarp::RouterID& router) { return router[0] % 4 == 0; });
+  CHECK(routers.index.NumBad() == 5);
+
+  std::map<byte_t, size_t> seen;
+  for (int build = 0; build < 500; ++build)
+  {
+    HopIndex::Taken taken{routers.index};
+    std::set<byte_t> picked;
+    for (int hop = 0; hop < 4; ++hop)
+    {
+      const auto* rc = routers.index.Pick(
+          taken, [](const RouterContact& rc) { return rc.pubkey[0] != 1; });
+      REQUIRE(rc);
+      CHECK(rc->pubkey[0] % 4 != 0);
+      CHECK(rc->pubkey[0] != 1);
+      CHECK(picked.insert(rc->pubkey[0]).second);
+      seen[rc->pubkey[0]]++;
+    }
+  }
+  // every router that may be picked is, and about as often as the rest
+  CHECK(seen.size() == 14);
+  for (const auto& [id, count] : seen)
+    CHECK(count == Approx(2000.0 / 14).margin(70));
+
+  SECTION("runs dry once everything usable is taken")
+  {
+    HopIndex::Taken taken{routers.index};
+    for (int hop = 0; hop < 8; ++hop)
+      REQUIRE(routers.index.Pick(taken));
+    // the taken hops are full
+    CHECK_FALSE(routers.index.Pick(taken));
+  }
+}
+
+TEST_CASE("Hops come from distinct networks", "[path][hops]")
+{
+  Routers routers;
+  // four routers in each of five /16s
+  for (uint16_t id = 1; id <= 20; ++id)
+    routers.Add(id, id % 5);
+
+  SECTION("with the check off any router will do")
+  {
+    HopIndex::Taken taken{routers.index};
+    for (int hop = 0; hop < 8; ++hop)
+      CHECK(routers.index.Pick(taken));
+  }
+
+  routers.index.SetUniqueNetmask(16);
+  for (int build = 0; build < 100; ++build)
+  {
+    HopIndex::Taken taken{routers.index};
+    std::set<uint8_t> nets;
+    for (int hop = 0; hop < 5; ++hop)
+    {
+      const auto* rc = routers.index.Pick(taken);
+      REQUIRE(rc);
+      CHECK(nets.insert(rc->pubkey[0] % 5).second);
+    }
+    CHECK_FALSE(routers.index.Pick(taken));
+  }
+
+  SECTION("ends that share a network do not get along")
+  {
+    HopIndex::Taken taken{routers.index};
+    CHECK(taken.Add(MakeRouter(1, 1)));
+    // the same router again is fine
+    CHECK(taken.Add(MakeRouter(1, 1)));
+    CHECK_FALSE(taken.Add(MakeRouter(6, 1)));
+  }
+
+  SECTION("a router with two addresses in one network is never picked")
+  {
+    Routers two;
+    auto rc = MakeRouter(1, 1);
+    rc.addrs.push_back(rc.addrs.front());
+    two.index.Insert(two.rcs.emplace_back(std::move(rc)));
+    two.index.SetUniqueNetmask(16);
+    HopIndex::Taken taken{two.index};
+    CHECK_FALSE(two.index.Pick(taken));
+  }
+}
+
+TEST_CASE("Removed routers are not picked", "[path][hops]")
+{
+  Routers routers;
+  for (uint16_t id = 1; id <= 50; ++id)
+    routers.Add(id, id);
+  for (uint16_t id = 1; id <= 50; id += 2)
+    routers.index.Remove(MakeRouter(id, 0).pubkey);
+  // removing one that is not there does nothing
+  routers.index.Remove(MakeRouter(1, 0).pubkey);
+  CHECK(routers.index.Size() == 25);
+
+  // a newer rc for a router takes the place of the old one
+  routers.index.RefreshBad([](const llarp::RouterID& router) { return router[0] == 2; });
+  const auto& newer = routers.rcs.emplace_back(MakeRouter(2, 2));
+  routers.index.Insert(newer);
+  CHECK(routers.index.Size() == 25);
+  CHECK(routers.index.NumBad() == 1);
+  routers.index.RefreshBad([](const llarp::RouterID&) { return false; });
+
+  std::set<const RouterContact*> seen;
+  for (int build = 0; build < 200; ++build)
+  {
+    HopIndex::Taken taken{routers.index};
+    for (int hop = 0; hop < 8; ++hop)
+    {
+      const auto* rc = routers.index.Pick(taken);
+      REQUIRE(rc);
+      CHECK(rc->pubkey[0] % 2 == 0);
+      seen.insert(rc);
+    }
+  }
+  CHECK(seen.size() == 25);
+  CHECK(seen.count(&newer) == 1);
+}
+
+/// not run by default; run with `testAll "[bench]"` to see what picking the middle hops of a
+/// path costs with a realistically sized nodedb
+TEST_CASE("Hop selection speed", "[.][bench][path]")
+{
+  Routers routers;
+  for (uint16_t id = 1; id <= 2000; ++id)
+    routers.Add(id, id % 200);
+  routers.index.SetUniqueNetmask(16);
+  routers.index.RefreshBad([](const llarp::RouterID& router) { return router[0] % 20 == 0; });
+
+  constexpr size_t builds = 100'000;
+  const auto started = std::chrono::steady_clock::now();
+  size_t picked = 0;
+  for (size_t build = 0; build < builds; ++build)
+  {
+    HopIndex::Taken taken{routers.index};
+    for (int hop = 0; hop < 3; ++hop)
+      picked += routers.index.Pick(taken) != nullptr;
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - started;
+  REQUIRE(picked == builds * 3);
+  WARN("picked 3 hops out of 2000 in " << elapsed.count() / builds << "us per path");
+}
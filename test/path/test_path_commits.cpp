@@ -0,0 +1,794 @@
+#include <path/path_context.hpp>
+
+#include <constants/proto.hpp>
+#include <crypto/crypto.hpp>
+#include <link/session.hpp>
+#include <llarp_test.hpp>
+#include <messages/relay_commit.hpp>
+#include <messages/relay_status.hpp>
+#include <router/abstractrouter.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  [[noreturn]] void
+  NotUsed(const char* func)
+  {
+    throw std::logic_error{std::string{func} + " is not used by path builds"};
+  }
+
+  /// an event loop that keeps what it is asked to call until the test runs it
+  struct CommitLoop : public EventLoop
+  {
+    std::vector<std::function<void(void)>> calls;
+
+    void
+    call_soon(std::function<void(void)> f) override
+    {
+      calls.emplace_back(std::move(f));
+    }
+
+    bool
+    inEventLoop() const override
+    {
+      return false;
+    }
+
+    void
+    run() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    running() const override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    wakeup() override
+    {}
+
+    void
+    call_later(llarp_time_t, std::function<void(void)>) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    add_network_interface(
+        std::shared_ptr<vpn::NetworkInterface>, std::function<void(net::IPPacket)>) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    add_ticker(std::function<void(void)>) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    stop() override
+    {}
+
+    std::shared_ptr<UDPHandle>
+    make_udp(UDPReceiveFunc) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    set_pump_function(std::function<void(void)>) override
+    {
+      NotUsed(__func__);
+    }
+
+    std::shared_ptr<EventLoopWakeup>
+    make_waker(std::function<void()>) override
+    {
+      NotUsed(__func__);
+    }
+
+    std::shared_ptr<EventLoopPoller>
+    make_poller(int, std::function<void()>) override
+    {
+      NotUsed(__func__);
+    }
+
+    std::shared_ptr<EventLoopRepeater>
+    make_repeater() override
+    {
+      NotUsed(__func__);
+    }
+  };
+
+  /// a session to us from a client or a relay, the path builds in these tests come in over them
+  struct CommitSession : public ILinkSession
+  {
+    PubKey remote;
+    SockAddr addr;
+    /// a relay's rc is public, a client's is empty
+    RouterContact rc;
+
+    PubKey
+    GetPubKey() const override
+    {
+      return remote;
+    }
+
+    const SockAddr&
+    GetRemoteEndpoint() const override
+    {
+      return addr;
+    }
+
+    RouterContact
+    GetRemoteRC() const override
+    {
+      return rc;
+    }
+
+    void
+    Pump() override
+    {
+      NotUsed(__func__);
+    }
+
+    void Tick(llarp_time_t) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    SendMessageBuffer(Message_t, CompletionHandler) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    Start() override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    Close() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    SendKeepAlive() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    IsEstablished() const override
+    {
+      return true;
+    }
+
+    bool
+    TimedOut(llarp_time_t) const override
+    {
+      return false;
+    }
+
+    bool
+    IsInbound() const override
+    {
+      return true;
+    }
+
+    size_t
+    SendQueueBacklog() const override
+    {
+      NotUsed(__func__);
+    }
+
+    ILinkLayer*
+    GetLinkLayer() const override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    RenegotiateSession() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    ShouldPing() const override
+    {
+      NotUsed(__func__);
+    }
+
+    SessionStats
+    GetSessionStats() const override
+    {
+      NotUsed(__func__);
+    }
+
+    util::StatusObject
+    ExtractStatus() const override
+    {
+      NotUsed(__func__);
+    }
+  };
+
+  /// just enough of a router for path builds to go from being queued to being answered; worker
+  /// jobs are kept until the test runs them and messages are kept instead of sent
+  struct CommitRouter : public AbstractRouter
+  {
+    SecretKey identityKey, encryptionKey;
+    PubKey ourKey;
+    EventLoop_ptr eventLoop = std::make_shared<CommitLoop>();
+    std::vector<std::function<void(void)>> work;
+    /// who we sent to, and whether it was a status message or a forwarded build
+    std::vector<std::pair<RouterID, bool>> sent;
+
+    CommitRouter()
+    {
+      CryptoManager::instance()->identity_keygen(identityKey);
+      CryptoManager::instance()->encryption_keygen(encryptionKey);
+      ourKey = identityKey.toPublic();
+    }
+
+    /// run worker jobs and event loop calls until there are none left
+    void
+    RunAll()
+    {
+      auto& calls = static_cast<CommitLoop&>(*eventLoop).calls;
+      while (not work.empty() or not calls.empty())
+      {
+        auto jobs = std::move(work);
+        for (auto& job : jobs)
+          job();
+        auto called = std::move(calls);
+        for (auto& call : called)
+          call();
+      }
+    }
+
+    const EventLoop_ptr&
+    loop() const override
+    {
+      return eventLoop;
+    }
+
+    void
+    QueueWork(std::function<void(void)> job) override
+    {
+      work.emplace_back(std::move(job));
+    }
+
+    const SecretKey&
+    encryption() const override
+    {
+      return encryptionKey;
+    }
+
+    const SecretKey&
+    identity() const override
+    {
+      return identityKey;
+    }
+
+    const byte_t*
+    pubkey() const override
+    {
+      return ourKey.data();
+    }
+
+    llarp_time_t
+    Now() const override
+    {
+      return time_now_ms();
+    }
+
+    bool
+    SendToOrQueue(const RouterID& remote, const ILinkMessage* msg, SendStatusHandler) override
+    {
+      sent.emplace_back(remote, dynamic_cast<const LR_StatusMessage*>(msg) != nullptr);
+      return true;
+    }
+
+    void
+    PersistSessionUntil(const RouterID&, llarp_time_t) override
+    {}
+
+    bool
+    ConnectionToRouterAllowed(const RouterID&) const override
+    {
+      return true;
+    }
+
+    void
+    HandleRouterEvent(tooling::RouterEventPtr) const override
+    {}
+
+    bool
+    HandleRecvLinkMessageBuffer(ILinkSession*, std::vector<byte_t>) override
+    {
+      NotUsed(__func__);
+    }
+
+    const LMQ_ptr&
+    lmq() const override
+    {
+      NotUsed(__func__);
+    }
+
+    vpn::Platform*
+    GetVPNPlatform() const override
+    {
+      NotUsed(__func__);
+    }
+
+    const std::shared_ptr<rpc::LokidRpcClient>&
+    RpcClient() const override
+    {
+      NotUsed(__func__);
+    }
+
+    llarp_dht_context*
+    dht() const override
+    {
+      NotUsed(__func__);
+    }
+
+    const std::shared_ptr<NodeDB>&
+    nodedb() const override
+    {
+      NotUsed(__func__);
+    }
+
+    const path::PathContext&
+    pathContext() const override
+    {
+      NotUsed(__func__);
+    }
+
+    path::PathContext&
+    pathContext() override
+    {
+      NotUsed(__func__);
+    }
+
+    const RouterContact&
+    rc() const override
+    {
+      NotUsed(__func__);
+    }
+
+    exit::Context&
+    exitContext() override
+    {
+      NotUsed(__func__);
+    }
+
+    const std::shared_ptr<KeyManager>&
+    keyManager() const override
+    {
+      NotUsed(__func__);
+    }
+
+    const std::shared_ptr<EphemeralKeyPool>&
+    ephemeralKeys() const override
+    {
+      NotUsed(__func__);
+    }
+
+    Profiling&
+    routerProfiling() override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    QueueDiskIO(std::function<void(void)>) override
+    {
+      NotUsed(__func__);
+    }
+
+    service::Context&
+    hiddenServiceContext() override
+    {
+      NotUsed(__func__);
+    }
+
+    const service::Context&
+    hiddenServiceContext() const override
+    {
+      NotUsed(__func__);
+    }
+
+    IOutboundMessageHandler&
+    outboundMessageHandler() override
+    {
+      NotUsed(__func__);
+    }
+
+    IOutboundSessionMaker&
+    outboundSessionMaker() override
+    {
+      NotUsed(__func__);
+    }
+
+    ILinkManager&
+    linkManager() override
+    {
+      NotUsed(__func__);
+    }
+
+    RoutePoker&
+    routePoker() override
+    {
+      NotUsed(__func__);
+    }
+
+    I_RCLookupHandler&
+    rcLookupHandler() override
+    {
+      NotUsed(__func__);
+    }
+
+    std::shared_ptr<PeerDb>
+    peerDb() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    Sign(Signature&, const llarp_buffer_t&) const override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    Configure(std::shared_ptr<Config>, bool, std::shared_ptr<NodeDB>) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    IsServiceNode() const override
+    {
+      return true;
+    }
+
+    bool
+    StartRpcServer() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    Run() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    IsRunning() const override
+    {
+      return true;
+    }
+
+    bool
+    LooksAlive() const override
+    {
+      return true;
+    }
+
+    void
+    Stop() override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    Thaw() override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    Die() override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    PumpLL() override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    IsBootstrapNode(RouterID) const override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    ConnectToRandomRouters(int) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    TryConnectAsync(RouterContact, uint16_t) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    SessionClosed(RouterID) override
+    {
+      NotUsed(__func__);
+    }
+
+    llarp_time_t
+    Uptime() const override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    GetRandomGoodRouter(RouterID&) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    ParseRoutingMessageBuffer(
+        const llarp_buffer_t&, routing::IMessageHandler*, const PathID_t&) override
+    {
+      NotUsed(__func__);
+    }
+
+    size_t
+    NumberOfConnectedRouters() const override
+    {
+      NotUsed(__func__);
+    }
+
+    size_t
+    NumberOfConnectedClients() const override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    GetRandomConnectedRouter(RouterContact&) const override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    HandleDHTLookupForExplore(RouterID, const std::vector<RouterContact>&) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    LookupRouter(RouterID, RouterLookupHandler) override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    CheckRenegotiateValid(RouterContact, RouterContact) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    SetRouterWhitelist(const std::vector<RouterID>) override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    ForEachPeer(std::function<void(const ILinkSession*, bool)>, bool) const override
+    {
+      NotUsed(__func__);
+    }
+
+    bool
+    HasSessionTo(const RouterID&) const override
+    {
+      NotUsed(__func__);
+    }
+
+    uint32_t
+    NextPathBuildNumber() override
+    {
+      NotUsed(__func__);
+    }
+
+    std::string
+    ShortName() const override
+    {
+      return "commit test";
+    }
+
+    util::StatusObject
+    ExtractStatus() const override
+    {
+      NotUsed(__func__);
+    }
+
+    void
+    GossipRCIfNeeded(const RouterContact) override
+    {
+      NotUsed(__func__);
+    }
+  };
+
+  struct PathCommitTest : public test::LlarpTest<>
+  {
+    CommitRouter router;
+    path::PathContext context{&router};
+    std::deque<CommitSession> sessions;
+
+    /// a session from a client, which has its builds ip limited, or from a relay, each at an ip
+    /// of its own
+    CommitSession&
+    AddSession(bool relay = false)
+    {
+      SecretKey key;
+      CryptoManager::instance()->identity_keygen(key);
+      auto& session = sessions.emplace_back();
+      session.remote = key.toPublic();
+      session.addr = SockAddr{"10.0.0." + std::to_string(sessions.size()) + ":1090"};
+      if (relay)
+      {
+        session.rc.routerVersion = RouterVersion{};
+        session.rc.addrs.emplace_back();
+      }
+      return session;
+    }
+
+    /// a path build over a session, either one that we can decrypt that goes on to nextHop or
+    /// one that is junk to us
+    LR_CommitMessage
+    MakeCommit(CommitSession& session, std::optional<RouterID> nextHop)
+    {
+      LR_CommitMessage msg;
+      msg.session = &session;
+      for (auto& frame : msg.frames)
+        frame.Randomize();
+      if (not nextHop)
+        return msg;
+
+      auto crypto = CryptoManager::instance();
+      SecretKey commkey, ephemeral;
+      crypto->encryption_keygen(commkey);
+      crypto->encryption_keygen(ephemeral);
+
+      LR_CommitRecord record;
+      record.commkey = commkey.toPublic();
+      record.nextHop = *nextHop;
+      record.tunnelNonce.Randomize();
+      record.txid.Randomize();
+      record.rxid.Randomize();
+      record.version = LLARP_PROTO_VERSION;
+      record.lifetime = path::default_lifetime;
+
+      auto& frame = msg.frames[0];
+      auto buf = frame.Buffer();
+      buf->cur = buf->base + EncryptedFrameOverheadSize;
+      REQUIRE(record.BEncode(buf));
+      REQUIRE(frame.EncryptInPlace(ephemeral, router.encryptionKey.toPublic()));
+      return msg;
+    }
+
+    uint64_t
+    Stat(const char* name)
+    {
+      return context.ExtractStatus()["commits"][name].get<uint64_t>();
+    }
+  };
+}  // namespace
+
+TEST_CASE_METHOD(PathCommitTest, "Path builds are decrypted in batches", "[path][commit]")
+{
+  RouterID nextHop;
+  nextHop.Randomize();
+  // one path build ends with us, one goes on, the rest are junk
+  auto& last = AddSession();
+  auto& client = AddSession();
+  std::vector<LR_CommitMessage> commits;
+  commits.push_back(MakeCommit(last, RouterID{router.pubkey()}));
+  commits.push_back(MakeCommit(client, nextHop));
+  while (commits.size() < path::PathContext::MaxCommitBatch * 2 + 5)
+    commits.push_back(MakeCommit(AddSession(), std::nullopt));
+
+  for (const auto& msg : commits)
+    REQUIRE(msg.AsyncDecrypt(&context));
+  CHECK(Stat("queued") == commits.size());
+  CHECK(router.work.empty());
+
+  // another one from the same client is over its path build limit and is never decrypted
+  REQUIRE(MakeCommit(client, nextHop).AsyncDecrypt(&context));
+  CHECK(Stat("limited") == 1);
+  CHECK(Stat("queued") == commits.size());
+
+  context.PumpCommits();
+  CHECK(router.work.size() == 3);
+  CHECK(Stat("batches") == 3);
+  CHECK(context.ExtractStatus()["commitsInFlight"] == commits.size());
+
+  router.RunAll();
+  CHECK(Stat("finished") == commits.size());
+  CHECK(Stat("failed") == commits.size() - 2);
+  CHECK(context.ExtractStatus()["commitsInFlight"] == 0);
+  CHECK(context.CurrentTransitPaths() == 2);
+
+  // a confirmation for the path that ends with us and the build that goes on
+  std::vector<std::pair<RouterID, bool>> expect{{last.remote, true}, {nextHop, false}};
+  std::sort(router.sent.begin(), router.sent.end());
+  std::sort(expect.begin(), expect.end());
+  CHECK(router.sent == expect);
+}
+
+TEST_CASE_METHOD(PathCommitTest, "Path builds past the pending limit are dropped", "[path][commit]")
+{
+  context.SetMaxPendingCommits(8);
+  for (size_t idx = 0; idx < 10; ++idx)
+    REQUIRE(MakeCommit(AddSession(), std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("queued") == 8);
+  CHECK(Stat("dropped") == 2);
+
+  // builds being decrypted still count until they are back on the event loop
+  context.PumpCommits();
+  REQUIRE(MakeCommit(AddSession(), std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("dropped") == 3);
+
+  router.RunAll();
+  CHECK(Stat("finished") == 8);
+  REQUIRE(MakeCommit(AddSession(), std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("queued") == 9);
+  CHECK(Stat("dropped") == 3);
+}
+
+TEST_CASE_METHOD(
+    PathCommitTest, "Path builds from one ip get a share of the pending limit", "[path][commit]")
+{
+  context.SetMaxPendingCommits(path::PathContext::PendingCommitShare * 2);
+  // a relay's builds are not ip limited, but it can only have its share waiting at once
+  auto& relay = AddSession(true);
+  for (size_t idx = 0; idx < 3; ++idx)
+    REQUIRE(MakeCommit(relay, std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("queued") == 2);
+  CHECK(Stat("dropped") == 1);
+  CHECK(Stat("limited") == 0);
+
+  // which leaves room for everyone else
+  REQUIRE(MakeCommit(AddSession(), std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("queued") == 3);
+
+  // and its share is given back once they have been decrypted
+  context.PumpCommits();
+  router.RunAll();
+  REQUIRE(MakeCommit(relay, std::nullopt).AsyncDecrypt(&context));
+  CHECK(Stat("queued") == 4);
+  CHECK(Stat("dropped") == 1);
+}
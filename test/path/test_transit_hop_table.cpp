@@ -0,0 +1,230 @@
+#include <path/transit_hop.hpp>
+#include <path/transit_hop_table.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using llarp::PathID_t;
+using llarp::RouterID;
+using llarp::path::TransitHop;
+using llarp::path::TransitHop_ptr;
+using llarp::path::TransitHopTable;
+
+namespace
+{
+  TransitHop_ptr
+  MakeHop(std::mt19937_64& rng)
+  {
+    auto hop = std::make_shared<TransitHop>();
+    for (auto* buf : {hop->info.txID.data(), hop->info.rxID.data()})
+      for (size_t idx = 0; idx < PathID_t::SIZE; ++idx)
+        buf[idx] = rng();
+    for (auto* buf : {hop->info.upstream.data(), hop->info.downstream.data()})
+      for (size_t idx = 0; idx < RouterID::SIZE; ++idx)
+        buf[idx] = rng();
+    return hop;
+  }
+}  // namespace
+
+TEST_CASE("TransitHopTable finds hops by path id and direction", "[path][transit]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  TransitHopTable table;
+  auto hop = MakeHop(rng);
+  const auto& info = hop->info;
+  REQUIRE_FALSE(table.Has(info));
+  REQUIRE(table.Put(hop));
+  REQUIRE(table.Size() == 1);
+  REQUIRE(table.Has(info));
+
+  for (const auto& id : {info.txID, info.rxID})
+  {
+    CHECK(table.GetByUpstream(info.upstream, id) == hop);
+    CHECK(table.GetByDownstream(info.downstream, id) == hop);
+    // the right path id from the wrong side is not a match
+    CHECK(table.GetByUpstream(info.downstream, id) == nullptr);
+    CHECK(table.GetByDownstream(info.upstream, id) == nullptr);
+  }
+  CHECK(table.GetByUpstream(info.upstream, PathID_t{}) == nullptr);
+
+  size_t visited = 0;
+  table.ForEach([&](const TransitHop_ptr& h) {
+    CHECK(h == hop);
+    visited++;
+  });
+  CHECK(visited == 1);
+
+  table.Remove(hop);
+  CHECK(table.Size() == 0);
+  CHECK_FALSE(table.Has(info));
+  CHECK(table.GetByUpstream(info.upstream, info.txID) == nullptr);
+}
+
+TEST_CASE("TransitHopTable refuses hops that clash", "[path][transit]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  TransitHopTable table;
+  auto first = MakeHop(rng);
+  REQUIRE(table.Put(first));
+
+  auto clash = MakeHop(rng);
+  clash->info.rxID = first->info.txID;
+  clash->info.downstream = first->info.downstream;
+  CHECK(table.Has(clash->info));
+  CHECK_FALSE(table.Put(clash));
+  CHECK(table.Size() == 1);
+  CHECK(table.GetByUpstream(clash->info.upstream, clash->info.txID) == nullptr);
+
+  // removing a hop that never went in leaves the one that did alone
+  table.Remove(clash);
+  CHECK(table.GetByDownstream(first->info.downstream, first->info.txID) == first);
+
+  // same path ids via different routers do not clash
+  auto other = MakeHop(rng);
+  other->info.txID = first->info.txID;
+  other->info.rxID = first->info.rxID;
+  CHECK(table.Put(other));
+  CHECK(table.GetByUpstream(other->info.upstream, other->info.txID) == other);
+  CHECK(table.GetByUpstream(first->info.upstream, first->info.txID) == first);
+  CHECK(table.Size() == 2);
+}
+
+TEST_CASE("TransitHopTable stays consistent through churn", "[path][transit]")
+{
+  std::mt19937_64 rng{Catch::rngSeed()};
+  TransitHopTable table;
+  std::vector<TransitHop_ptr> live, dead;
+  for (size_t round = 0; round < 5000; ++round)
+  {
+    if (live.empty() or rng() % 3)
+    {
+      live.push_back(MakeHop(rng));
+      REQUIRE(table.Put(live.back()));
+    }
+    else
+    {
+      const auto idx = rng() % live.size();
+      table.Remove(live[idx]);
+      dead.push_back(live[idx]);
+      live.erase(live.begin() + idx);
+    }
+  }
+  REQUIRE(table.Size() == live.size());
+  for (const auto& hop : live)
+  {
+    REQUIRE(table.GetByUpstream(hop->info.upstream, hop->info.rxID) == hop);
+    REQUIRE(table.GetByDownstream(hop->info.downstream, hop->info.txID) == hop);
+  }
+  for (const auto& hop : dead)
+    REQUIRE_FALSE(table.Has(hop->info));
+  size_t visited = 0;
+  table.ForEach([&visited](const TransitHop_ptr&) { visited++; });
+  CHECK(visited == live.size());
+}
+
+/// not run by default; run with `testAll "[bench]"` to see lookup rates with a busy relay's worth
+/// of transit hops
+TEST_CASE("TransitHopTable lookup throughput", "[.][bench][path]")
+{
+  using Clock_t = std::chrono::steady_clock;
+  constexpr size_t numHops = 100'000;
+  constexpr auto runFor = std::chrono::seconds{1};
+  std::mt19937_64 rng{Catch::rngSeed()};
+
+  std::vector<TransitHop_ptr> hops;
+  TransitHopTable table;
+  // what PathContext used before: a multimap of path id to hop searched with a predicate
+  std::unordered_multimap<PathID_t, TransitHop_ptr, PathID_t::Hash> multimap;
+  for (size_t idx = 0; idx < numHops; ++idx)
+  {
+    auto hop = hops.emplace_back(MakeHop(rng));
+    REQUIRE(table.Put(hop));
+    multimap.emplace(hop->info.txID, hop);
+    multimap.emplace(hop->info.rxID, hop);
+  }
+  REQUIRE(table.Size() == numHops);
+
+  const auto multimapGet = [&multimap](
+                               const PathID_t& id,
+                               std::function<bool(const TransitHop_ptr&)> check) -> TransitHop_ptr {
+    auto range = multimap.equal_range(id);
+    for (auto itr = range.first; itr != range.second; ++itr)
+    {
+      if (check(itr->second))
+        return itr->second;
+    }
+    return nullptr;
+  };
+
+  const auto rate = [&](auto&& lookup) {
+    size_t found = 0, lookups = 0;
+    const auto started = Clock_t::now();
+    while (Clock_t::now() - started < runFor)
+    {
+      for (size_t n = 0; n < 1024; ++n, ++lookups)
+      {
+        const auto& hop = hops[(lookups * 7919) % numHops];
+        found += lookup(hop) != nullptr;
+      }
+    }
+    const std::chrono::duration<double> elapsed = Clock_t::now() - started;
+    REQUIRE(found == lookups);
+    return lookups / elapsed.count() / 1e6;
+  };
+
+  const auto before = rate([&](const TransitHop_ptr& hop) {
+    const auto remote = hop->info.upstream;
+    return multimapGet(
+        hop->info.txID, [remote](const TransitHop_ptr& h) { return h->info.upstream == remote; });
+  });
+  const auto after = rate([&](const TransitHop_ptr& hop) {
+    return table.GetByUpstream(hop->info.upstream, hop->info.txID);
+  });
+
+  // readers on every core while one thread keeps adding and removing hops
+  const size_t numReaders = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  std::atomic<bool> done{false};
+  std::atomic<size_t> totalLookups{0};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < numReaders; ++t)
+  {
+    readers.emplace_back([&, t] {
+      size_t lookups = 0;
+      while (not done)
+      {
+        for (size_t n = 0; n < 1024; ++n, ++lookups)
+        {
+          const auto& hop = hops[(lookups * 7919 + t * 104729) % numHops];
+          table.GetByDownstream(hop->info.downstream, hop->info.rxID);
+        }
+      }
+      totalLookups += lookups;
+    });
+  }
+  size_t churned = 0;
+  const auto started = Clock_t::now();
+  while (Clock_t::now() - started < runFor)
+  {
+    auto hop = MakeHop(rng);
+    table.Put(hop);
+    table.Remove(hop);
+    churned++;
+  }
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+  const std::chrono::duration<double> elapsed = Clock_t::now() - started;
+
+  WARN(
+      numHops << " transit hops, Mlookups/s on one thread: " << before << " multimap, " << after
+              << " sharded table; " << numReaders << " reader threads: "
+              << totalLookups / elapsed.count() / 1e6 << " Mlookups/s total while "
+              << churned / elapsed.count() << " hops/s were added and removed");
+}
@@ -1,6 +1,7 @@
 #include <peerstats/peer_db.hpp>
 #include <test_util.hpp>
 
+#include <chrono>
 #include <numeric>
 #include <catch2/catch.hpp>
 #include "peerstats/types.hpp"
@@ -222,3 +223,125 @@ TEST_CASE("Test PeerDb handleGossipedRC expiry calcs", "[PeerDb]")
   CHECK(stats3->numDistinctRCsReceived == 3);
   CHECK(stats3->lastRCUpdated == s3);
 }
+
+TEST_CASE("Test PeerDb evicts cold peers and reads them back", "[PeerDb]")
+{
+  llarp::LogSilencer shutup;
+  const std::string filename = "/tmp/peerdb_test_tmp3.db.sqlite";
+
+  std::vector<llarp::RouterID> ids;
+  for (int i = 1; i <= 100; ++i)
+    ids.push_back(llarp::test::makeBuf<llarp::RouterID>(i));
+
+  {
+    llarp::PeerDb db;
+    db.setCacheSize(10);
+    db.loadDatabase(filename);
+
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      llarp::PeerStats delta(ids[i]);
+      delta.numPathBuilds = i;
+      db.accumulatePeerStats(ids[i], delta);
+    }
+    // nothing is dropped before it is written
+    CHECK(db.ExtractStatus()["numCached"] == 100);
+
+    db.flushDatabase();
+    CHECK(db.ExtractStatus()["numCached"] == 10);
+    CHECK(db.ExtractStatus()["numEvicted"] == 90);
+    CHECK(db.ExtractStatus()["numStored"] == 100);
+    // the status still lists the peers that were dropped
+    CHECK(db.ExtractStatus()["stats"].size() == 100);
+
+    // the first peers were used longest ago
+    auto stats = db.getCurrentPeerStats(ids[0]);
+    REQUIRE(stats.has_value());
+    CHECK(stats->numPathBuilds == 0);
+    CHECK(db.ExtractStatus()["numReloaded"] == 1);
+
+    // a peer that was never stored is not found
+    CHECK_FALSE(db.getCurrentPeerStats(llarp::test::makeBuf<llarp::RouterID>(0xEE)));
+    CHECK(db.ExtractStatus()["numReloaded"] == 1);
+
+    // changes to a peer that was dropped add to what was written, not replace it
+    llarp::PeerStats delta(ids[1]);
+    delta.numPathBuilds = 5;
+    db.accumulatePeerStats(ids[1], delta);
+    CHECK(db.getCurrentPeerStats(ids[1])->numPathBuilds == 6);
+
+    db.flushDatabase();
+    CHECK(db.ExtractStatus()["numCached"] == 10);
+    CHECK(db.getCurrentPeerStats(ids[1])->numPathBuilds == 6);
+
+    const auto all = db.listAllPeerStats();
+    CHECK(all.size() == 100);
+    const auto builds = std::accumulate(
+        all.begin(), all.end(), int64_t{0}, [](int64_t sum, const llarp::PeerStats& stats) {
+          return sum + stats.numPathBuilds;
+        });
+    CHECK(builds == 99 * 100 / 2 + 5);
+  }
+
+  for (auto suffix : {"", "-wal", "-shm"})
+    fs::remove(filename + suffix);
+}
+
+TEST_CASE("Test PeerDb memory-backed database keeps every peer", "[PeerDb]")
+{
+  llarp::LogSilencer shutup;
+
+  llarp::PeerDb db;
+  db.setCacheSize(1);
+  db.loadDatabase(std::nullopt);
+
+  for (int i = 1; i <= 10; ++i)
+  {
+    const auto id = llarp::test::makeBuf<llarp::RouterID>(i);
+    db.modifyPeerStats(id, [](llarp::PeerStats& stats) { stats.numPathBuilds++; });
+  }
+  db.flushDatabase();
+  CHECK(db.ExtractStatus()["numCached"] == 10);
+  CHECK(db.ExtractStatus()["numEvicted"] == 0);
+}
+
+/// not run by default; run with `testAll "[bench]"` to see how long flushing a large database
+/// takes, first with every peer new and then with a tenth of them changed
+TEST_CASE("Test PeerDb flush latency", "[.][bench][PeerDb]")
+{
+  llarp::LogSilencer shutup;
+  const std::string filename = "/tmp/peerdb_test_bench.db.sqlite";
+  constexpr size_t numPeers = 50'000;
+
+  std::vector<llarp::RouterID> ids(numPeers);
+  for (auto& id : ids)
+    id.Randomize();
+
+  {
+    llarp::PeerDb db;
+    db.loadDatabase(filename);
+
+    for (const auto& id : ids)
+      db.modifyPeerStats(id, [](llarp::PeerStats& stats) { stats.numConnectionAttempts++; });
+
+    auto start = std::chrono::steady_clock::now();
+    db.flushDatabase();
+    const std::chrono::duration<double, std::milli> full = std::chrono::steady_clock::now() - start;
+
+    for (size_t i = 0; i < numPeers; i += 10)
+      db.modifyPeerStats(ids[i], [](llarp::PeerStats& stats) { stats.numConnectionSuccesses++; });
+
+    start = std::chrono::steady_clock::now();
+    db.flushDatabase();
+    const std::chrono::duration<double, std::milli> partial =
+        std::chrono::steady_clock::now() - start;
+
+    WARN(
+        "flushed " << numPeers << " new peers in " << full.count() << "ms and "
+                   << numPeers / 10 << " changed peers in " << partial.count() << "ms");
+    CHECK(db.ExtractStatus()["numCached"] == llarp::PeerDb::DefaultCacheSize);
+  }
+
+  for (auto suffix : {"", "-wal", "-shm"})
+    fs::remove(filename + suffix);
+}
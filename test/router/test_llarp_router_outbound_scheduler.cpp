@@ -0,0 +1,187 @@
+#include <router/outbound_scheduler.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <map>
+
+using namespace std::literals;
+using llarp::OutboundQueueEntry;
+using llarp::OutboundScheduler;
+
+namespace
+{
+  llarp::PathID_t
+  MakePath(byte_t id)
+  {
+    llarp::PathID_t pathid;
+    pathid[0] = id;
+    return pathid;
+  }
+
+  llarp::RouterID
+  MakeRouter(byte_t id)
+  {
+    llarp::RouterID router;
+    router[0] = id;
+    return router;
+  }
+
+  OutboundQueueEntry
+  MakeEntry(byte_t router, byte_t path, size_t size, llarp_time_t queued, uint16_t priority = 0)
+  {
+    OutboundQueueEntry entry;
+    entry.priority = priority;
+    entry.message.first.resize(size);
+    entry.pathid = path ? MakePath(path) : llarp::PathID_t{};
+    entry.router = MakeRouter(router);
+    entry.queued = queued;
+    return entry;
+  }
+
+  /// what one Schedule call handed out, by router and by path
+  struct Scheduled
+  {
+    std::vector<OutboundQueueEntry> sent;
+    size_t dropped = 0;
+    std::map<byte_t, size_t> routerBytes;
+    std::map<byte_t, size_t> pathBytes;
+  };
+
+  Scheduled
+  Schedule(OutboundScheduler& scheduler, llarp_time_t now, size_t maxMessages, size_t maxBytes)
+  {
+    Scheduled result;
+    scheduler.Schedule(
+        now,
+        maxMessages,
+        maxBytes,
+        [&](OutboundQueueEntry entry) {
+          result.routerBytes[entry.router[0]] += entry.message.first.size();
+          result.pathBytes[entry.pathid[0]] += entry.message.first.size();
+          result.sent.emplace_back(std::move(entry));
+        },
+        [&](OutboundQueueEntry) { result.dropped++; });
+    return result;
+  }
+}  // namespace
+
+TEST_CASE("Control messages go out before data in priority order", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  REQUIRE(scheduler.Push(MakeEntry(1, 1, 1000, 0s)));
+  REQUIRE(scheduler.Push(MakeEntry(2, 0, 100, 0s, 1)));
+  // a path build carries no path id, relay status does and is still control
+  REQUIRE(scheduler.Push(MakeEntry(3, 0, 100, 0s, 5)));
+  REQUIRE(scheduler.Push(MakeEntry(3, 2, 100, 0s, 6)));
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Control) == 3);
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Data) == 1);
+
+  const auto result = Schedule(scheduler, 0s, 100, 1'000'000);
+  REQUIRE(result.sent.size() == 4);
+  // lowest value first, as the per session queues do
+  CHECK(result.sent[0].priority == 1);
+  CHECK(result.sent[1].priority == 5);
+  CHECK(result.sent[2].priority == 6);
+  CHECK(result.sent[3].priority == 0);
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Control) == 0);
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Data) == 0);
+}
+
+TEST_CASE("Data is shared fairly between routers and their paths", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  // router 1 has one path of big messages, router 2 has four paths of small ones
+  for (int i = 0; i < 90; ++i)
+    REQUIRE(scheduler.Push(MakeEntry(1, 1, 1500, 0s)));
+  for (byte_t path = 2; path < 6; ++path)
+    for (int i = 0; i < 90; ++i)
+      REQUIRE(scheduler.Push(MakeEntry(2, path, 300, 0s)));
+
+  const auto result = Schedule(scheduler, 0s, 1000, 64 * 1024);
+  CHECK(result.dropped == 0);
+  // each router gets about half the bytes despite router 2 sending five times the messages
+  const double r1 = result.routerBytes.at(1);
+  const double r2 = result.routerBytes.at(2);
+  CHECK(r1 / (r1 + r2) == Approx(0.5).margin(0.1));
+  // and router 2 splits its share between its paths
+  for (byte_t path = 2; path < 6; ++path)
+    CHECK(result.pathBytes.at(path) / r2 == Approx(0.25).margin(0.05));
+}
+
+TEST_CASE("The per tick budget is respected and the rest waits", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  for (int i = 0; i < 50; ++i)
+    REQUIRE(scheduler.Push(MakeEntry(1, 1, 1000, 0s)));
+
+  CHECK(Schedule(scheduler, 0s, 10, 1'000'000).sent.size() == 10);
+  CHECK(Schedule(scheduler, 0s, 100, 5000).sent.size() == 5);
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Data) == 35);
+}
+
+TEST_CASE("Full path queues refuse more data", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  for (size_t i = 0; i < llarp::MAX_PATH_QUEUE_SIZE; ++i)
+    REQUIRE(scheduler.Push(MakeEntry(1, 1, 100, 0s)));
+  auto entry = MakeEntry(1, 1, 100, 0s);
+  CHECK_FALSE(scheduler.Push(std::move(entry)));
+  // left alone so the caller can tell its sender
+  CHECK(entry.message.first.size() == 100);
+  // other paths and control are not affected
+  CHECK(scheduler.Push(MakeEntry(1, 2, 100, 0s)));
+  CHECK(scheduler.Push(MakeEntry(1, 0, 100, 0s, 1)));
+}
+
+TEST_CASE("Standing path queues drop what waited too long", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  llarp_time_t now = 1000s;
+  // a path that gets 20 messages a tick but may only send 10
+  size_t dropped = 0;
+  size_t sent = 0;
+  for (int tick = 0; tick < 100; ++tick)
+  {
+    for (int i = 0; i < 20; ++i)
+      scheduler.Push(MakeEntry(1, 1, 1000, now));
+    const auto result = Schedule(scheduler, now, 10, 1'000'000);
+    dropped += result.dropped;
+    sent += result.sent.size();
+    now += 10ms;
+  }
+  CHECK(sent == 1000);
+  CHECK(dropped > 0);
+
+  SECTION("a queue that empties every tick is left alone however slow the tick")
+  {
+    OutboundScheduler quiet;
+    for (int tick = 0; tick < 100; ++tick)
+    {
+      for (int i = 0; i < 10; ++i)
+        quiet.Push(MakeEntry(1, 1, 1000, now));
+      CHECK(Schedule(quiet, now + 20ms, 10, 1'000'000).dropped == 0);
+      now += 10ms;
+    }
+  }
+}
+
+TEST_CASE("Removed paths lose their queue", "[router][outbound]")
+{
+  OutboundScheduler scheduler;
+  for (int i = 0; i < 10; ++i)
+  {
+    REQUIRE(scheduler.Push(MakeEntry(1, 1, 100, 0s)));
+    REQUIRE(scheduler.Push(MakeEntry(1, 2, 100, 0s)));
+  }
+  scheduler.RemovePath(MakePath(1));
+  CHECK(scheduler.Depth(OutboundScheduler::Class::Data) == 10);
+  const auto result = Schedule(scheduler, 0s, 100, 1'000'000);
+  CHECK(result.sent.size() == 10);
+  CHECK(result.pathBytes.count(1) == 0);
+
+  const auto status = scheduler.ExtractStatus();
+  CHECK(status["data"]["queued"] == 20);
+  CHECK(status["data"]["sent"] == 10);
+  CHECK(status["data"]["depth"] == 0);
+  CHECK(status["paths"] == 0);
+}
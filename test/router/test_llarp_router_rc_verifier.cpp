@@ -0,0 +1,51 @@
+#include <router/rc_verifier.hpp>
+
+#include <crypto/crypto.hpp>
+#include <llarp_test.hpp>
+#include <util/logging/logger.hpp>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  struct RCVerifierTest : public test::LlarpTest<>
+  {
+    RouterContact
+    MakeRC()
+    {
+      SecretKey sign, encr;
+      CryptoManager::instance()->identity_keygen(sign);
+      CryptoManager::instance()->encryption_keygen(encr);
+      RouterContact rc;
+      rc.pubkey = sign.toPublic();
+      rc.enckey = encr.toPublic();
+      REQUIRE(rc.Sign(sign));
+      return rc;
+    }
+  };
+}  // namespace
+
+TEST_CASE_METHOD(RCVerifierTest, "VerifyRCs matches checking one at a time", "[RC][verify]")
+{
+  LogSilencer shutup;
+  std::vector<RouterContact> rcs;
+  for (size_t idx = 0; idx < 100; ++idx)
+  {
+    auto& rc = rcs.emplace_back(MakeRC());
+    // spoil every seventh signature
+    if (idx % 7 == 3)
+      rc.signature[0] ^= 1;
+  }
+
+  const auto now = time_now_ms();
+  for (const size_t threads : {size_t{0}, size_t{1}, size_t{3}, size_t{64}})
+  {
+    const auto valid = VerifyRCs(rcs, now, threads);
+    REQUIRE(valid.size() == rcs.size());
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+      CHECK(valid[idx] == (idx % 7 != 3));
+  }
+  CHECK(VerifyRCs({}, now).empty());
+}
@@ -56,3 +56,48 @@ TEST_CASE_METHOD(FrameTest, "Frame crypto")
   REQUIRE(otherRecord.BDecode(buf));
   REQUIRE(otherRecord == record);
 }
+
+TEST_CASE_METHOD(FrameTest, "Frames decrypted together")
+{
+  auto crypto = CryptoManager::instance();
+  std::vector<EncryptedFrame> frames(6);
+  std::vector<LRCR> records(frames.size());
+  for (size_t idx = 0; idx < frames.size(); ++idx)
+  {
+    auto& record = records[idx];
+    record.nextHop.Fill(idx);
+    record.tunnelNonce.Randomize();
+    record.rxid.Randomize();
+    record.txid.Randomize();
+
+    auto buf = frames[idx].Buffer();
+    buf->cur = buf->base + EncryptedFrameOverheadSize;
+    REQUIRE(record.BEncode(buf));
+    SecretKey ephemeral;
+    crypto->encryption_keygen(ephemeral);
+    // one of them is not for bob
+    const auto& to = idx == 4 ? alice : bob;
+    REQUIRE(frames[idx].EncryptInPlace(ephemeral, to.toPublic()));
+  }
+  // and one was tampered with on the way
+  frames[1].data()[EncryptedFrameOverheadSize + 3] ^= 1;
+
+  std::vector<EncryptedFrame*> ptrs;
+  for (auto& frame : frames)
+    ptrs.push_back(&frame);
+  bool ok[6];
+  EncryptedFrame::DecryptManyInPlace(ptrs.data(), ptrs.size(), bob, ok);
+
+  for (size_t idx = 0; idx < frames.size(); ++idx)
+  {
+    INFO("frame " << idx);
+    CHECK(ok[idx] == (idx != 1 and idx != 4));
+    if (not ok[idx])
+      continue;
+    auto buf = frames[idx].Buffer();
+    buf->cur = buf->base + EncryptedFrameOverheadSize;
+    LRCR decoded;
+    REQUIRE(decoded.BDecode(buf));
+    CHECK(decoded == records[idx]);
+  }
+}
@@ -0,0 +1,354 @@
+#include <profiling.hpp>
+
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using llarp::Profiling;
+using llarp::RouterID;
+
+namespace
+{
+  std::vector<RouterID>
+  MakeRouters(size_t num)
+  {
+    std::vector<RouterID> routers(num);
+    for (auto& router : routers)
+      router.Randomize();
+    return routers;
+  }
+}  // namespace
+
+TEST_CASE("Router profiles count what happened", "[profiling]")
+{
+  Profiling profiling;
+  const auto routers = MakeRouters(3);
+  const auto &bad = routers[0], &good = routers[1], &unknown = routers[2];
+
+  for (int idx = 0; idx < 10; ++idx)
+  {
+    profiling.MarkConnectTimeout(bad);
+    profiling.MarkHopFail(bad);
+    profiling.MarkConnectSuccess(good);
+  }
+  CHECK(profiling.Size() == 2);
+  CHECK(profiling.IsBadForConnect(bad));
+  CHECK(profiling.IsBadForPath(bad));
+  CHECK_FALSE(profiling.IsBadForConnect(good));
+  CHECK_FALSE(profiling.IsBadForPath(good));
+  CHECK_FALSE(profiling.IsBad(unknown));
+  CHECK_FALSE(profiling.GetProfile(unknown));
+
+  const auto profile = profiling.GetProfile(bad);
+  REQUIRE(profile);
+  CHECK(profile->connectTimeoutCount == 10);
+  CHECK(profile->pathFailCount == 10);
+  CHECK(profile->lastUpdated > 0s);
+
+  SECTION("a cleared profile starts over")
+  {
+    profiling.ClearProfile(bad);
+    CHECK_FALSE(profiling.GetProfile(bad));
+    CHECK_FALSE(profiling.IsBadForConnect(bad));
+    CHECK(profiling.Size() == 1);
+    profiling.MarkConnectTimeout(bad);
+    CHECK(profiling.GetProfile(bad)->connectTimeoutCount == 1);
+  }
+
+  SECTION("disabled profiling thinks well of everyone")
+  {
+    profiling.Disable();
+    CHECK_FALSE(profiling.IsBadForConnect(bad));
+    profiling.Enable();
+    CHECK(profiling.IsBadForConnect(bad));
+  }
+}
+
+TEST_CASE("Router profiles survive bencoding", "[profiling]")
+{
+  Profiling profiling;
+  // enough that every shard has to grow its table a few times
+  const auto routers = MakeRouters(5000);
+  for (size_t idx = 0; idx < routers.size(); ++idx)
+  {
+    for (size_t mark = 0; mark < idx % 7; ++mark)
+      profiling.MarkConnectSuccess(routers[idx]);
+    profiling.MarkHopFail(routers[idx]);
+  }
+  REQUIRE(profiling.Size() == routers.size());
+
+  std::vector<byte_t> data(routers.size() * 300);
+  llarp_buffer_t buf{data};
+  REQUIRE(profiling.BEncode(&buf));
+  buf.sz = buf.cur - buf.base;
+  buf.cur = buf.base;
+
+  Profiling loaded;
+  REQUIRE(loaded.BDecode(&buf));
+  CHECK(loaded.Size() == routers.size());
+  for (size_t idx = 0; idx < routers.size(); ++idx)
+  {
+    const auto profile = loaded.GetProfile(routers[idx]);
+    REQUIRE(profile);
+    CHECK(profile->connectGoodCount == idx % 7);
+    CHECK(profile->pathFailCount == 1);
+  }
+}
+
+TEST_CASE("Router profiles save only what changed", "[profiling]")
+{
+  const fs::path file{llarp::test::randFilename()};
+  llarp::test::FileGuard guard{file};
+  Profiling profiling;
+  const auto routers = MakeRouters(1000);
+  for (const auto& router : routers)
+    profiling.MarkConnectSuccess(router);
+  REQUIRE(profiling.Save(file));
+  const auto full = fs::file_size(file);
+
+  SECTION("a changed profile is appended")
+  {
+    profiling.MarkHopFail(routers[0]);
+    REQUIRE(profiling.Save(file));
+    const auto appended = fs::file_size(file) - full;
+    CHECK(appended > 0);
+    CHECK(appended < full / 100);
+
+    Profiling loaded;
+    REQUIRE(loaded.Load(file));
+    CHECK(loaded.Size() == routers.size());
+    CHECK(loaded.GetProfile(routers[0])->pathFailCount == 1);
+    CHECK(loaded.GetProfile(routers[1])->connectGoodCount == 1);
+
+    // appending to what was loaded picks up where the file left off
+    loaded.MarkHopFail(routers[1]);
+    REQUIRE(loaded.Save(file));
+    Profiling reloaded;
+    REQUIRE(reloaded.Load(file));
+    CHECK(reloaded.GetProfile(routers[0])->pathFailCount == 1);
+    CHECK(reloaded.GetProfile(routers[1])->pathFailCount == 1);
+  }
+
+  SECTION("nothing changed leaves the file alone")
+  {
+    REQUIRE(profiling.Save(file));
+    CHECK(fs::file_size(file) == full);
+  }
+
+  SECTION("a cleared profile rewrites the file")
+  {
+    profiling.MarkHopFail(routers[0]);
+    REQUIRE(profiling.Save(file));
+    profiling.ClearProfile(routers[1]);
+    REQUIRE(profiling.Save(file));
+    CHECK(fs::file_size(file) < full);
+
+    Profiling loaded;
+    REQUIRE(loaded.Load(file));
+    CHECK(loaded.Size() == routers.size() - 1);
+    CHECK_FALSE(loaded.GetProfile(routers[1]));
+    CHECK(loaded.GetProfile(routers[0])->pathFailCount == 1);
+  }
+
+  SECTION("appended changes are folded in once they double the file")
+  {
+    for (int round = 0; round < 200; ++round)
+    {
+      for (size_t idx = 0; idx < 10; ++idx)
+        profiling.MarkHopFail(routers[idx]);
+      REQUIRE(profiling.Save(file));
+      REQUIRE(fs::file_size(file) <= 2 * full);
+    }
+    Profiling loaded;
+    REQUIRE(loaded.Load(file));
+    CHECK(loaded.GetProfile(routers[9])->pathFailCount == 200);
+  }
+
+  SECTION("a torn append is dropped on load")
+  {
+    profiling.MarkHopFail(routers[0]);
+    REQUIRE(profiling.Save(file));
+    const auto saved = fs::file_size(file);
+    {
+      std::ofstream f{file.string(), std::ios::binary | std::ios::app};
+      f << "d32:" << std::string(10, 'x');
+    }
+    Profiling loaded;
+    REQUIRE(loaded.Load(file));
+    CHECK(loaded.Size() == routers.size());
+    CHECK(loaded.GetProfile(routers[0])->pathFailCount == 1);
+    // and the next save does not append after it
+    REQUIRE(loaded.Save(file));
+    CHECK(fs::file_size(file) < saved);
+  }
+}
+
+TEST_CASE("Router profiles free what they no longer need", "[profiling]")
+{
+  const fs::path file{llarp::test::randFilename()};
+  llarp::test::FileGuard guard{file};
+  Profiling profiling;
+  const auto routers = MakeRouters(2000);
+  for (const auto& router : routers)
+    profiling.MarkConnectSuccess(router);
+  // every shard outgrew its first table on the way
+  CHECK(profiling.Held().tables > Profiling::NumShards);
+
+  REQUIRE(profiling.Save(file));
+  CHECK(profiling.Held().entries == routers.size());
+  CHECK(profiling.Held().tables == Profiling::NumShards);
+
+  for (size_t idx = 100; idx < routers.size(); ++idx)
+    profiling.ClearProfile(routers[idx]);
+  // cleared profiles are kept until they are saved as cleared
+  REQUIRE(profiling.Held().entries == routers.size());
+  REQUIRE(profiling.Save(file));
+  CHECK(profiling.Held().entries == 100);
+  CHECK(profiling.Held().tables == Profiling::NumShards);
+  CHECK(profiling.Size() == 100);
+  for (size_t idx = 0; idx < routers.size(); ++idx)
+    CHECK(bool{profiling.GetProfile(routers[idx])} == (idx < 100));
+
+  // and a router that comes back starts over
+  profiling.MarkConnectTimeout(routers[100]);
+  CHECK(profiling.GetProfile(routers[100])->connectTimeoutCount == 1);
+  CHECK(profiling.GetProfile(routers[100])->connectGoodCount == 0);
+
+  SECTION("loading drops what is not in the file")
+  {
+    Profiling other;
+    for (const auto& router : MakeRouters(500))
+      other.MarkConnectSuccess(router);
+    REQUIRE(other.Load(file));
+    CHECK(other.Size() == 100);
+    CHECK(other.Held().entries == 100);
+  }
+}
+
+TEST_CASE("Router profiles are freed while they are being used", "[profiling]")
+{
+  const fs::path file{llarp::test::randFilename()};
+  llarp::test::FileGuard guard{file};
+  Profiling profiling;
+  const auto routers = MakeRouters(2000);
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 2; ++thread)
+  {
+    // one keeps marking and checking routers while the other keeps clearing them
+    threads.emplace_back([&, thread] {
+      while (not done)
+      {
+        for (const auto& router : routers)
+        {
+          if (thread)
+            profiling.ClearProfile(router);
+          else if (not profiling.IsBadForPath(router))
+            profiling.MarkHopFail(router);
+        }
+      }
+    });
+  }
+  for (int saves = 0; saves < 50; ++saves)
+    REQUIRE(profiling.Save(file));
+  done = true;
+  for (auto& thread : threads)
+    thread.join();
+
+  REQUIRE(profiling.Save(file));
+  Profiling loaded;
+  REQUIRE(loaded.Load(file));
+  CHECK(loaded.Size() == profiling.Size());
+  CHECK(profiling.Held().entries >= profiling.Size());
+}
+
+TEST_CASE("Router profiles are safe to use from many threads", "[profiling]")
+{
+  Profiling profiling;
+  const auto routers = MakeRouters(2000);
+  constexpr int writers = 4;
+
+  std::atomic<bool> done{false};
+  std::thread reader{[&] {
+    while (not done)
+    {
+      for (const auto& router : routers)
+        profiling.IsBadForPath(router);
+    }
+  }};
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < writers; ++thread)
+  {
+    // each writer meets the routers in a different order so they race to add them
+    threads.emplace_back([&, thread] {
+      for (size_t idx = 0; idx < routers.size(); ++idx)
+        profiling.MarkConnectSuccess(routers[(idx * (thread + 1) * 7) % routers.size()]);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  done = true;
+  reader.join();
+
+  CHECK(profiling.Size() == routers.size());
+  size_t marks = 0;
+  for (const auto& router : routers)
+  {
+    const auto profile = profiling.GetProfile(router);
+    REQUIRE(profile);
+    marks += profile->connectGoodCount;
+  }
+  CHECK(marks == routers.size() * writers);
+}
+
+/// not run by default; run with `testAll "[bench]"` to see how checking routers holds up when
+/// many threads do it at once while paths are being marked
+TEST_CASE("Router profile contention", "[.][bench][profiling]")
+{
+  Profiling profiling;
+  const auto routers = MakeRouters(2000);
+  for (const auto& router : routers)
+    profiling.MarkConnectSuccess(router);
+
+  const size_t readers = std::max(4u, std::thread::hardware_concurrency());
+  constexpr size_t checks = 1'000'000;
+  std::atomic<bool> done{false};
+  std::thread writer{[&] {
+    while (not done)
+    {
+      for (const auto& router : routers)
+        profiling.MarkHopFail(router);
+    }
+  }};
+
+  std::atomic<size_t> bad{0};
+  const auto started = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread < readers; ++thread)
+  {
+    threads.emplace_back([&] {
+      size_t found = 0;
+      for (size_t idx = 0; idx < checks; ++idx)
+        found += profiling.IsBadForPath(routers[idx % routers.size()]);
+      bad += found;
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - started;
+  done = true;
+  writer.join();
+
+  WARN(
+      readers << " threads checked " << checks << " routers each in "
+              << elapsed.count() / checks << "ns per check, " << bad << " were bad");
+}
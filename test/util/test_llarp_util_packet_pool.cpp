@@ -0,0 +1,112 @@
+#include <util/packet_pool.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  uint64_t
+  PoolStat(const char* name)
+  {
+    return packet_pool::ExtractStatus()[name].get<uint64_t>();
+  }
+}  // namespace
+
+TEST_CASE("PacketBuffer acts like a vector", "[packet-pool]")
+{
+  PacketBuffer pkt{100};
+  REQUIRE(pkt.size() == 100);
+  REQUIRE(pkt.capacity() == packet_pool::SlotSize);
+  for (const auto b : pkt)
+    REQUIRE(b == 0);
+
+  pkt[5] = 7;
+  pkt.resize(10);
+  CHECK(pkt.size() == 10);
+  CHECK(pkt[5] == 7);
+  pkt.resize(20);
+  CHECK(pkt[15] == 0);
+
+  const std::vector<byte_t> bytes{1, 2, 3};
+  const auto copy = PacketBuffer::copy_from(llarp_buffer_t{bytes});
+  REQUIRE(copy.size() == bytes.size());
+  CHECK(std::equal(copy.begin(), copy.end(), bytes.begin()));
+
+  pkt.clear();
+  CHECK(pkt.empty());
+  CHECK(PacketBuffer{} == pkt);
+}
+
+TEST_CASE("PacketBuffer copies share until written", "[packet-pool]")
+{
+  PacketBuffer first{64};
+  first[0] = 1;
+  PacketBuffer second = first;
+  const PacketBuffer& ro = second;
+  REQUIRE(first.use_count() == 2);
+  CHECK(ro.data() == static_cast<const PacketBuffer&>(first).data());
+
+  second[0] = 2;
+  CHECK(first.use_count() == 1);
+  CHECK(second.use_count() == 1);
+  CHECK(first[0] == 1);
+  CHECK(second[0] == 2);
+
+  PacketBuffer third = std::move(first);
+  CHECK(first.empty());
+  CHECK(third.size() == 64);
+  CHECK(third[0] == 1);
+}
+
+TEST_CASE("PacketBuffer larger than a slot", "[packet-pool]")
+{
+  const auto oversized = PoolStat("missOversized");
+  PacketBuffer pkt{16};
+  pkt[15] = 0xff;
+  pkt.resize(packet_pool::SlotSize * 2);
+  CHECK(pkt.capacity() >= packet_pool::SlotSize * 2);
+  CHECK(pkt[15] == 0xff);
+  CHECK(PoolStat("missOversized") == oversized + 1);
+  CHECK(PoolStat("heapInUse") > 0);
+}
+
+TEST_CASE("packet pool slots are returned across threads", "[packet-pool]")
+{
+  const auto inUse = PoolStat("inUse");
+  std::vector<PacketBuffer> pkts;
+  for (size_t idx = 0; idx < 1000; ++idx)
+    pkts.emplace_back(1000);
+  CHECK(PoolStat("inUse") == inUse + 1000);
+
+  std::thread other{[&pkts] {
+    pkts.clear();
+    std::vector<PacketBuffer> mine;
+    for (size_t idx = 0; idx < 500; ++idx)
+      mine.emplace_back(500);
+  }};
+  other.join();
+  CHECK(PoolStat("inUse") == inUse);
+}
+
+TEST_CASE("packet pool falls back to the heap when exhausted", "[packet-pool]")
+{
+  const auto maxSlabs = PoolStat("maxSlabs");
+  const auto exhausted = PoolStat("missExhausted");
+  const auto heapInUse = PoolStat("heapInUse");
+  packet_pool::SetMaxSlabs(PoolStat("slabs"));
+
+  std::vector<PacketBuffer> pkts;
+  const auto wanted = PoolStat("slots") + 100;
+  for (size_t idx = 0; idx < wanted; ++idx)
+    pkts.emplace_back(10);
+  CHECK(PoolStat("missExhausted") >= exhausted + 100);
+  CHECK(PoolStat("heapInUse") > heapInUse);
+
+  pkts.clear();
+  CHECK(PoolStat("heapInUse") == heapInUse);
+  packet_pool::SetMaxSlabs(maxSlabs);
+}
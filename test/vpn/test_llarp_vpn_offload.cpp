@@ -0,0 +1,196 @@
+#include <catch2/catch.hpp>
+
+#include <vpn/offload.hpp>
+
+#include <cstring>
+#include <vector>
+
+using llarp::net::IPPacket;
+using llarp::vpn::SplitOffloaded;
+using llarp::vpn::TCPCoalescer;
+using llarp::vpn::VNetHdr;
+
+namespace
+{
+  uint32_t
+  Sum(const byte_t* ptr, size_t sz, uint32_t sum = 0)
+  {
+    for (; sz > 1; sz -= 2, ptr += 2)
+      sum += (ptr[0] << 8) | ptr[1];
+    if (sz)
+      sum += ptr[0] << 8;
+    return sum;
+  }
+
+  uint16_t
+  Fold(uint32_t sum)
+  {
+    while (sum >> 16)
+      sum = (sum & 0xffff) + (sum >> 16);
+    return sum;
+  }
+
+  uint32_t
+  Seq(const byte_t* pkt, size_t l3Len)
+  {
+    const byte_t* ptr = pkt + l3Len + 4;
+    return (uint32_t{ptr[0]} << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+  }
+
+  /// whether the ip header (for v4) and tcp checksums of a packet check out
+  bool
+  ChecksumsValid(const byte_t* pkt, size_t sz, bool v4)
+  {
+    const size_t l3Len = v4 ? 20 : 40;
+    if (v4 and Fold(Sum(pkt, 20)) != 0xffff)
+      return false;
+    const uint32_t pseudo = (v4 ? Sum(pkt + 12, 8) : Sum(pkt + 8, 32)) + 6 + (sz - l3Len);
+    return Fold(Sum(pkt + l3Len, sz - l3Len, pseudo)) == 0xffff;
+  }
+
+  /// a tcp packet with a 20 byte tcp header and payload of byte values counting up from seq
+  std::vector<byte_t>
+  MakeTCP(bool v4, uint32_t seq, size_t payloadLen, uint8_t flags = 0x10)
+  {
+    const size_t l3Len = v4 ? 20 : 40;
+    std::vector<byte_t> pkt(l3Len + 20 + payloadLen);
+    byte_t* ip = pkt.data();
+    if (v4)
+    {
+      ip[0] = 0x45;
+      ip[2] = pkt.size() >> 8;
+      ip[3] = pkt.size();
+      ip[8] = 64;
+      ip[9] = 6;
+      std::memcpy(ip + 12, "\x0a\x00\x00\x01\x0a\x00\x00\x02", 8);
+      const uint16_t check = ~Fold(Sum(ip, 20));
+      ip[10] = check >> 8;
+      ip[11] = check;
+    }
+    else
+    {
+      ip[0] = 0x60;
+      ip[4] = (pkt.size() - 40) >> 8;
+      ip[5] = pkt.size() - 40;
+      ip[6] = 6;
+      ip[7] = 64;
+      ip[23] = 1;
+      ip[39] = 2;
+    }
+    byte_t* tcp = ip + l3Len;
+    tcp[1] = 80;
+    tcp[3] = 81;
+    tcp[4] = seq >> 24;
+    tcp[5] = seq >> 16;
+    tcp[6] = seq >> 8;
+    tcp[7] = seq;
+    tcp[11] = 1;
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+    tcp[14] = 0xff;
+    for (size_t idx = 0; idx < payloadLen; ++idx)
+      tcp[20 + idx] = seq + idx;
+    const uint32_t pseudo = (v4 ? Sum(ip + 12, 8) : Sum(ip + 8, 32)) + 6 + (pkt.size() - l3Len);
+    const uint16_t check = ~Fold(Sum(tcp, pkt.size() - l3Len, pseudo));
+    tcp[16] = check >> 8;
+    tcp[17] = check;
+    return pkt;
+  }
+
+  IPPacket
+  ToPacket(const std::vector<byte_t>& data)
+  {
+    IPPacket pkt;
+    std::copy(data.begin(), data.end(), pkt.buf);
+    pkt.sz = data.size();
+    return pkt;
+  }
+}  // namespace
+
+TEST_CASE("Offloaded tcp packets split and merge back", "[vpn]")
+{
+  const bool v4 = GENERATE(true, false);
+  const size_t l3Len = v4 ? 20 : 40;
+  constexpr uint16_t gsoSize = 1000;
+  constexpr uint32_t seq = 5000;
+
+  // what the kernel would hand us for 4500 bytes of payload: one packet, psh set
+  auto super = MakeTCP(v4, seq, 4500, 0x18);
+  VNetHdr hdr;
+  hdr.gsoType = v4 ? VNetHdr::GSOTCPv4 : VNetHdr::GSOTCPv6;
+  hdr.gsoSize = gsoSize;
+
+  std::vector<IPPacket> segments;
+  REQUIRE(SplitOffloaded(hdr, super.data(), super.size(), segments));
+  REQUIRE(segments.size() == 5);
+  for (size_t idx = 0; idx < segments.size(); ++idx)
+  {
+    const auto& pkt = segments[idx];
+    const bool last = idx + 1 == segments.size();
+    CHECK(pkt.sz == l3Len + 20 + (last ? 500 : gsoSize));
+    CHECK(Seq(pkt.buf, l3Len) == seq + idx * gsoSize);
+    // psh only on the last segment
+    CHECK(pkt.buf[l3Len + 13] == (last ? 0x18 : 0x10));
+    CHECK(ChecksumsValid(pkt.buf, pkt.sz, v4));
+  }
+
+  std::vector<std::pair<VNetHdr, std::vector<byte_t>>> written;
+  TCPCoalescer coalescer;
+  coalescer.Coalesce(segments, [&](const VNetHdr& hdr, const byte_t* data, size_t sz) {
+    written.emplace_back(hdr, std::vector<byte_t>{data, data + sz});
+  });
+  REQUIRE(written.size() == 1);
+  const auto& [merged, data] = written.front();
+  CHECK(merged.flags == VNetHdr::NeedsCsum);
+  CHECK(merged.gsoType == hdr.gsoType);
+  CHECK(merged.gsoSize == gsoSize);
+  CHECK(merged.csumStart == l3Len);
+  CHECK(merged.csumOffset == 16);
+  REQUIRE(data.size() == super.size());
+  // same packet apart from the tcp checksum, which is left for the kernel to finish
+  CHECK(std::equal(data.begin(), data.begin() + l3Len + 16, super.begin()));
+  CHECK(std::equal(data.begin() + l3Len + 18, data.end(), super.begin() + l3Len + 18));
+}
+
+TEST_CASE("Coalescer leaves packets alone that it cannot merge", "[vpn]")
+{
+  std::vector<IPPacket> pkts;
+  pkts.emplace_back(ToPacket(MakeTCP(true, 100, 100)));
+  // a gap in the sequence numbers
+  pkts.emplace_back(ToPacket(MakeTCP(true, 300, 100)));
+  // a bad checksum
+  auto corrupt = MakeTCP(true, 400, 100);
+  corrupt.back() ^= 1;
+  pkts.emplace_back(ToPacket(corrupt));
+  // a fin
+  pkts.emplace_back(ToPacket(MakeTCP(true, 500, 100, 0x11)));
+
+  std::vector<size_t> sizes;
+  TCPCoalescer coalescer;
+  coalescer.Coalesce(pkts, [&](const VNetHdr& hdr, const byte_t*, size_t sz) {
+    CHECK(hdr.gsoType == VNetHdr::GSONone);
+    CHECK(hdr.flags == 0);
+    sizes.push_back(sz);
+  });
+  CHECK(sizes == std::vector<size_t>(4, 140));
+}
+
+TEST_CASE("Offloaded packets get their checksums finished", "[vpn]")
+{
+  auto pkt = MakeTCP(true, 1, 50);
+  // what the kernel sends for a partial checksum: the folded pseudo header sum
+  pkt[36] = 0;
+  pkt[37] = 0;
+  const uint16_t pseudo = Fold(Sum(pkt.data() + 12, 8) + 6 + 70);
+  pkt[36] = pseudo >> 8;
+  pkt[37] = pseudo;
+
+  VNetHdr hdr;
+  hdr.flags = VNetHdr::NeedsCsum;
+  hdr.csumStart = 20;
+  hdr.csumOffset = 16;
+  std::vector<IPPacket> out;
+  REQUIRE(SplitOffloaded(hdr, pkt.data(), pkt.size(), out));
+  REQUIRE(out.size() == 1);
+  CHECK(ChecksumsValid(out[0].buf, out[0].sz, true));
+}